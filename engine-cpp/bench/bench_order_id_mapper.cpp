@@ -0,0 +1,60 @@
+// Broker -> local lookups, as done for every fill, against a mapper holding
+// 100k open orders. Run with several threads to see shard contention.
+//
+//   cmake -DTRADING_BUILD_BENCHMARKS=ON ... && ./trading_bench
+
+#include <benchmark/benchmark.h>
+#include <trading/utils/order_id_generator.h>
+#include <trading/utils/order_id_mapper.h>
+
+#include <string>
+#include <vector>
+
+namespace quarcc {
+namespace {
+
+constexpr std::size_t kOpenOrders = 100'000;
+
+struct MapperState {
+  MapperState() {
+    OrderIdGenerator local(0), broker(1);
+    for (std::size_t i = 0; i < kOpenOrders; ++i) {
+      brokers.push_back(broker.generate());
+      mapper.add_mapping(local.generate(), brokers.back());
+    }
+  }
+
+  OrderIdMapper mapper;
+  std::vector<BrokerOrderId> brokers;
+};
+
+MapperState &shared_state() {
+  static MapperState state;
+  return state;
+}
+
+void BM_Mapper_GetLocalId(benchmark::State &state) {
+  MapperState &s = shared_state();
+  std::size_t i = static_cast<std::size_t>(state.thread_index()) * 7919;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        s.mapper.get_local_id(s.brokers[i++ % kOpenOrders]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Mapper_GetLocalId)->Threads(1)->Threads(4)->Threads(8);
+
+// Submit then fill: one add and one remove per order
+void BM_Mapper_AddRemove(benchmark::State &state) {
+  OrderIdMapper mapper;
+  OrderIdGenerator local(0), broker(1);
+  for (auto _ : state) {
+    const LocalOrderId id = local.generate();
+    mapper.add_mapping(id, broker.generate());
+    mapper.remove_mapping(id);
+  }
+}
+BENCHMARK(BM_Mapper_AddRemove);
+
+} // namespace
+} // namespace quarcc
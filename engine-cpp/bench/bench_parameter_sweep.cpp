@@ -0,0 +1,82 @@
+// Scaling of run_sweep with thread count: the same 32 backtests over one
+// shared 50k-quote tick file, run on 1, 2, 4 and 8 threads. With in-memory
+// journal and order store the runs share no locks, so wall time should fall
+// close to linearly until the threads outnumber the cores.
+//
+//   cmake -DTRADING_BUILD_BENCHMARKS=ON ... && ./trading_bench
+
+#include <benchmark/benchmark.h>
+#include <trading/backtest/parameter_sweep.h>
+
+#include <cmath>
+#include <filesystem>
+
+namespace quarcc {
+namespace {
+
+using namespace fixed_point_literals;
+
+constexpr std::size_t kTicks = 50'000;
+constexpr std::size_t kRuns = 32;
+
+std::shared_ptr<const TickFile> sweep_ticks() {
+  static const auto ticks = [] {
+    const auto path =
+        std::filesystem::temp_directory_path() / "bench_parameter_sweep.bin";
+    TickFileWriter writer;
+    std::int64_t t = 1704205800000000000;
+    for (std::size_t i = 0; i < kTicks; ++i) {
+      const double mid = 100.0 + std::sin(static_cast<double>(i) / 50.0);
+      writer.add_quote(t, "SWEEP", Price::from_double(mid - 0.01), 100_qty,
+                       Price::from_double(mid + 0.01), 100_qty);
+      t += 1'000'000;
+    }
+    writer.write(path);
+    auto file = std::make_shared<const TickFile>(path);
+    std::filesystem::remove(path); // the mapping outlives the name
+    return file;
+  }();
+  return ticks;
+}
+
+// Buys when flat and sells once the mid is `target` above the entry
+BacktestStrategy take_profit(double target) {
+  return [target](BacktestDriver &driver, const TickRecord &tick,
+                  SymbolId symbol) {
+    const double mid = (tick.bid().to_double() + tick.ask().to_double()) / 2;
+    const auto position = driver.positions().getPosition(symbol);
+    const bool flat = !position || position->quantity() == 0;
+    if (!flat && mid < position->avg_price() + target)
+      return;
+    v1::StrategySignal signal;
+    signal.set_strategy_id("BACKTEST");
+    signal.set_symbol("SWEEP");
+    signal.set_side(flat ? v1::Side::BUY : v1::Side::SELL);
+    signal.set_target_quantity(10.0);
+    driver.submit(signal);
+  };
+}
+
+void BM_Sweep_Threads(benchmark::State &state) {
+  const auto ticks = sweep_ticks();
+  const auto threads = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    std::vector<SweepRun> runs;
+    for (std::size_t i = 0; i < kRuns; ++i)
+      runs.push_back({"run", take_profit(0.05 + 0.05 * static_cast<double>(i)),
+                      {}});
+    auto results = run_sweep(ticks, std::move(runs), {.threads = threads});
+    benchmark::DoNotOptimize(results.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kRuns * kTicks);
+}
+BENCHMARK(BM_Sweep_Threads)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace quarcc
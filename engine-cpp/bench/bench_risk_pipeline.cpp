@@ -0,0 +1,165 @@
+// Static (RiskPipeline) against dynamic (DynamicRiskPipeline) dispatch of the
+// built-in risk checks, alone and on the OrderManager::processSignal path.
+// Every limit is set so each check does its full work.
+//
+//   cmake -DTRADING_BUILD_BENCHMARKS=ON ... && ./trading_bench
+
+#include <benchmark/benchmark.h>
+#include <trading/core/order_manager.h>
+#include <trading/core/risk_manager.h>
+
+#include <memory>
+#include <string>
+
+namespace quarcc {
+namespace {
+
+using namespace fixed_point_literals;
+
+// Collaborators that do no work, so only OrderManager's own cost remains
+class NullGateway final : public IExecutionGateway {
+public:
+  Result<BrokerOrderId> submit_order(const v1::Order &) override {
+    return BrokerOrderId{"B"};
+  }
+  Result<std::monostate> cancel_order(const BrokerOrderId &) override {
+    return std::monostate{};
+  }
+  Result<BrokerOrderId> replace_order(const BrokerOrderId &,
+                                      const v1::Order &) override {
+    return BrokerOrderId{"B"};
+  }
+  std::vector<v1::ExecutionReport> get_fills() override { return {}; }
+};
+
+class NullJournal final : public IJournal {
+public:
+  void log(Event, const std::string &, const std::string &) override {}
+  std::vector<LogEntry> get_history(Timestamp, Timestamp,
+                                    std::optional<Event>) override {
+    return {};
+  }
+  std::vector<LogEntry> get_order_history(const std::string &) override {
+    return {};
+  }
+  void flush() override {}
+  std::uint64_t last_id() override { return 0; }
+};
+
+class NullOrderStore final : public IOrderStore {
+public:
+  Result<std::monostate> store_order(const StoredOrder &) override {
+    return std::monostate{};
+  }
+  Result<std::monostate> update_order_status(const std::string &,
+                                             OrderStatus) override {
+    return std::monostate{};
+  }
+  Result<std::monostate> update_broker_id(const std::string &,
+                                          const std::string &) override {
+    return std::monostate{};
+  }
+  Result<std::monostate> update_fill_info(const std::string &, Quantity,
+                                          Price) override {
+    return std::monostate{};
+  }
+  Result<std::monostate> apply_fill(const std::string &, Quantity, Price,
+                                    OrderStatus) override {
+    return std::monostate{};
+  }
+  Result<std::monostate>
+  apply_fills(const std::vector<FillUpdate> &) override {
+    return std::monostate{};
+  }
+  Result<StoredOrder> get_order(const std::string &) override {
+    return std::unexpected(Error{"none", ErrorType::Error});
+  }
+  std::vector<StoredOrder> get_open_orders() override { return {}; }
+  std::vector<StoredOrder> get_orders_by_status(OrderStatus) override {
+    return {};
+  }
+  Result<std::monostate>
+  save_position_snapshot(const PositionSnapshot &) override {
+    return std::monostate{};
+  }
+  Result<PositionSnapshot> load_position_snapshot() override {
+    return std::unexpected(Error{"none", ErrorType::Error});
+  }
+};
+
+std::unique_ptr<IRiskCheck> dynamic_checks() {
+  auto checks = std::make_unique<DynamicRiskPipeline>();
+  checks->add(MaxOrderQuantityCheck{});
+  checks->add(MaxOrderNotionalCheck{});
+  checks->add(SymbolPositionCheck{});
+  checks->add(StrategyPositionCheck{});
+  checks->add(GrossExposureCheck{});
+  checks->add(NetExposureCheck{});
+  return checks;
+}
+
+// Limits, marks and positions shared by every benchmark
+struct RiskState {
+  RiskState() {
+    RiskLimits l;
+    l.default_symbol = {.max_order_quantity = 1'000'000_qty,
+                        .max_order_notional = 1'000'000'000_money,
+                        .max_position = 1'000'000'000_qty};
+    l.default_strategy.max_position = 1'000'000'000_qty;
+    l.max_gross_exposure = 1'000'000'000_money;
+    l.max_net_exposure = 1'000'000'000_money;
+    limits.publish(l);
+    marks.update(symbols.intern("AAPL"), 150_px);
+  }
+
+  std::unique_ptr<RiskManager> make(const PositionKeeper *keeper,
+                                    bool dynamic) {
+    auto risk = std::make_unique<RiskManager>("BENCH", limits, keeper, &book,
+                                              &marks, symbols);
+    if (dynamic)
+      risk->set_checks(dynamic_checks());
+    return risk;
+  }
+
+  SymbolTable symbols;
+  MarkPriceCache marks;
+  AggregatePositionBook book{&marks, symbols};
+  SharedRiskLimits limits;
+};
+
+void BM_RiskCheck(benchmark::State &state, bool dynamic) {
+  RiskState s;
+  PositionKeeper keeper(&s.book, &s.marks, s.symbols);
+  auto risk = s.make(&keeper, dynamic);
+  const RiskOrder order{.symbol = s.symbols.intern("AAPL"),
+                        .side = v1::Side::BUY,
+                        .quantity = 10_qty,
+                        .reference_price = 150_px};
+  for (auto _ : state)
+    benchmark::DoNotOptimize(risk->check(order));
+}
+BENCHMARK_CAPTURE(BM_RiskCheck, Static, false);
+BENCHMARK_CAPTURE(BM_RiskCheck, Dynamic, true);
+
+void BM_ProcessSignal(benchmark::State &state, bool dynamic) {
+  RiskState s;
+  auto keeper = std::make_unique<PositionKeeper>(&s.book, &s.marks, s.symbols);
+  auto risk = s.make(keeper.get(), dynamic);
+  auto manager = OrderManager::CreateOrderManager(
+      std::move(keeper), std::make_unique<NullGateway>(),
+      std::make_unique<NullJournal>(), std::make_unique<NullOrderStore>(),
+      std::move(risk));
+
+  v1::StrategySignal signal;
+  signal.set_strategy_id("BENCH");
+  signal.set_symbol("AAPL");
+  signal.set_side(v1::Side::BUY);
+  signal.set_target_quantity(10.0);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(manager->processSignal(signal));
+}
+BENCHMARK_CAPTURE(BM_ProcessSignal, Static, false);
+BENCHMARK_CAPTURE(BM_ProcessSignal, Dynamic, true);
+
+} // namespace
+} // namespace quarcc
@@ -0,0 +1,77 @@
+// Order throughput of the simulated venue behind PaperGateway: marketable
+// orders against static synthetic liquidity, and limit orders that rest and
+// are cancelled, with no latency so each one is processed as it is sent.
+//
+//   cmake -DTRADING_BUILD_BENCHMARKS=ON ... && ./trading_bench
+
+#include <benchmark/benchmark.h>
+#include <trading/gateways/simulated_venue.h>
+
+#include <vector>
+
+namespace quarcc {
+namespace {
+
+using namespace fixed_point_literals;
+
+VenueOrder make(v1::Side side, v1::OrderType type, Price price = {}) {
+  return VenueOrder{.symbol = 0,
+                    .side = side,
+                    .type = type,
+                    .time_in_force = v1::DAY,
+                    .quantity = 10_qty,
+                    .price = price};
+}
+
+void BM_Venue_MarketOrders(benchmark::State &state) {
+  SimulatedVenue venue;
+  std::vector<VenueReport> reports;
+  VenueTime now{};
+  std::uint64_t tag = 0;
+  for (auto _ : state) {
+    const auto side = tag % 2 ? v1::SELL : v1::BUY;
+    venue.submit(make(side, v1::MARKET), ++tag, now);
+    venue.advance(now);
+    reports.clear();
+    venue.drain(now, reports);
+    benchmark::DoNotOptimize(reports.data());
+    now += VenueTime{1};
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Venue_MarketOrders);
+
+// Keeps 1000 client orders resting across 20 price levels
+void BM_Venue_RestAndCancel(benchmark::State &state) {
+  constexpr std::size_t kResting = 1000;
+  SimulatedVenue venue;
+  std::vector<VenueReport> reports;
+  std::vector<VenueOrderId> resting(kResting);
+  VenueTime now{};
+  std::uint64_t tag = 0;
+
+  for (std::size_t i = 0; i < kResting; ++i) {
+    const Price price = 99_px - Price::from_raw(static_cast<Price::rep>(
+                                    (i % 20) * Price::scale / 100));
+    resting[i] = *venue.submit(make(v1::BUY, v1::LIMIT, price), ++tag, now);
+  }
+  venue.advance(now);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const Price price = 99_px - Price::from_raw(static_cast<Price::rep>(
+                                    (i % 20) * Price::scale / 100));
+    venue.cancel(resting[i], now);
+    resting[i] = *venue.submit(make(v1::BUY, v1::LIMIT, price), ++tag, now);
+    venue.advance(now);
+    reports.clear();
+    venue.drain(now, reports);
+    i = (i + 1) % kResting;
+    now += VenueTime{1};
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_Venue_RestAndCancel);
+
+} // namespace
+} // namespace quarcc
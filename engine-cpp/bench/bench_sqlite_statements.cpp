@@ -0,0 +1,132 @@
+// Per-operation cost of preparing a statement on every call (the old store
+// behaviour) against reusing one prepared at construction.
+//
+//   cmake -DTRADING_BUILD_BENCHMARKS=ON ... && ./trading_bench
+
+#include <benchmark/benchmark.h>
+#include <trading/persistence/sqlite_journal.h>
+#include <trading/persistence/sqlite_order_store.h>
+#include <trading/persistence/sqlite_statement.h>
+
+#include <string>
+
+namespace quarcc {
+namespace {
+
+constexpr const char *kUpdateStatusSql = R"(
+    UPDATE orders 
+    SET status = ?, updated_at = ?
+    WHERE local_id = ?
+  )";
+
+constexpr const char *kGetOrderSql = R"(
+    SELECT local_id, broker_id, status, created_at, updated_at, 
+           filled_quantity, avg_fill_price, order_proto
+    FROM orders 
+    WHERE local_id = ?
+  )";
+
+// Bare in-memory orders table holding a single row
+struct Fixture {
+  Fixture() {
+    sqlite3_open(":memory:", &db);
+    sqlite3_exec(db, R"(
+      CREATE TABLE orders (
+        local_id TEXT PRIMARY KEY, broker_id TEXT, status INTEGER,
+        created_at INTEGER, updated_at INTEGER, filled_quantity REAL,
+        avg_fill_price REAL, order_proto BLOB);
+      INSERT INTO orders VALUES ('ORD_1', NULL, 0, 0, NULL, 0, 0, x'');
+    )",
+                 nullptr, nullptr, nullptr);
+  }
+  ~Fixture() { sqlite3_close(db); }
+
+  sqlite3 *db = nullptr;
+};
+
+void bind_update(sqlite3_stmt *stmt, int status) {
+  sqlite3_bind_int(stmt, 1, status);
+  sqlite3_bind_int64(stmt, 2, LogEntry::to_nanos(LogEntry::now()));
+  sqlite3_bind_text(stmt, 3, "ORD_1", -1, SQLITE_STATIC);
+}
+
+void BM_UpdateStatus_PreparePerCall(benchmark::State &state) {
+  Fixture f;
+  int status = 0;
+  for (auto _ : state) {
+    sqlite3_stmt *stmt = nullptr;
+    sqlite3_prepare_v2(f.db, kUpdateStatusSql, -1, &stmt, nullptr);
+    bind_update(stmt, ++status & 7);
+    benchmark::DoNotOptimize(sqlite3_step(stmt));
+    sqlite3_finalize(stmt);
+  }
+}
+BENCHMARK(BM_UpdateStatus_PreparePerCall);
+
+void BM_UpdateStatus_Cached(benchmark::State &state) {
+  Fixture f;
+  {
+    SQLiteStatement cached(f.db, kUpdateStatusSql);
+    int status = 0;
+    for (auto _ : state) {
+      auto stmt = cached.use();
+      bind_update(stmt, ++status & 7);
+      benchmark::DoNotOptimize(sqlite3_step(stmt));
+    }
+  }
+}
+BENCHMARK(BM_UpdateStatus_Cached);
+
+void BM_GetOrder_PreparePerCall(benchmark::State &state) {
+  Fixture f;
+  for (auto _ : state) {
+    sqlite3_stmt *stmt = nullptr;
+    sqlite3_prepare_v2(f.db, kGetOrderSql, -1, &stmt, nullptr);
+    sqlite3_bind_text(stmt, 1, "ORD_1", -1, SQLITE_STATIC);
+    benchmark::DoNotOptimize(sqlite3_step(stmt));
+    sqlite3_finalize(stmt);
+  }
+}
+BENCHMARK(BM_GetOrder_PreparePerCall);
+
+void BM_GetOrder_Cached(benchmark::State &state) {
+  Fixture f;
+  {
+    SQLiteStatement cached(f.db, kGetOrderSql);
+    for (auto _ : state) {
+      auto stmt = cached.use();
+      sqlite3_bind_text(stmt, 1, "ORD_1", -1, SQLITE_STATIC);
+      benchmark::DoNotOptimize(sqlite3_step(stmt));
+    }
+  }
+}
+BENCHMARK(BM_GetOrder_Cached);
+
+// End to end through the stores, which now use cached statements
+void BM_OrderStore_UpdateOrderStatus(benchmark::State &state) {
+  SQLiteOrderStore store(":memory:");
+  StoredOrder order;
+  order.local_id = "ORD_1";
+  order.order.set_symbol("AAPL");
+  order.created_at = LogEntry::now();
+  store.store_order(order);
+
+  int status = 0;
+  for (auto _ : state)
+    benchmark::DoNotOptimize(store.update_order_status(
+        "ORD_1", static_cast<OrderStatus>(++status & 7)));
+}
+BENCHMARK(BM_OrderStore_UpdateOrderStatus);
+
+void BM_Journal_Log(benchmark::State &state) {
+  SQLiteJournal journal(":memory:");
+  std::size_t i = 0;
+  for (auto _ : state)
+    journal.log(Event::ORDER_SUBMITTED, "bench", "ORD_" + std::to_string(++i));
+}
+BENCHMARK(BM_Journal_Log);
+
+} // namespace
+} // namespace quarcc
+
+BENCHMARK_MAIN();
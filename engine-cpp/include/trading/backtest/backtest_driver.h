@@ -0,0 +1,95 @@
+#pragma once
+
+#include <trading/core/mark_price_cache.h>
+#include <trading/core/order_manager.h>
+#include <trading/gateways/replay_gateway.h>
+#include <trading/utils/clock.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace quarcc {
+
+class BacktestDriver;
+
+// The strategy under test. Called after each replayed tick, once the fills
+// the tick caused have been applied; it trades through the driver.
+using BacktestStrategy = std::function<void(
+    BacktestDriver &driver, const TickRecord &tick, SymbolId symbol)>;
+
+struct BacktestOptions {
+  std::string strategy_id = "BACKTEST";
+  // The driver sets the clock, and feeds replayed prices to its marks
+  // before calling on_price
+  ReplayGatewayOptions gateway;
+  RiskLimits risk;
+  // The driver sets the clock
+  OrderManagerOptions orders;
+};
+
+struct BacktestStats {
+  std::size_t ticks = 0;
+  std::size_t orders = 0;   // new and replacement orders accepted
+  std::size_t rejected = 0; // refused by risk checks or the venue
+  std::size_t fills = 0;
+};
+
+// Runs one strategy's OrderManager against a ReplayGateway on a
+// SimulatedClock, event by event on the calling thread: the clock moves to
+// each tick as it is replayed, fills are applied as soon as the venue
+// reports them, and nothing sleeps or waits on real time. A run therefore
+// goes as fast as the CPU allows, and the same ticks, strategy and options
+// give the same order ids, fills, journal and positions every time.
+class BacktestDriver {
+public:
+  // `journal` and `store` should stamp from `clock`, which must outlive the
+  // driver, and start empty unless resuming a previous run
+  BacktestDriver(std::shared_ptr<const TickFile> ticks, SimulatedClock &clock,
+                 std::unique_ptr<IJournal> journal,
+                 std::unique_ptr<IOrderStore> store, BacktestStrategy strategy,
+                 BacktestOptions options = {},
+                 SymbolTable &symbols = SymbolTable::global());
+  ~BacktestDriver();
+
+  BacktestDriver(const BacktestDriver &) = delete;
+  BacktestDriver &operator=(const BacktestDriver &) = delete;
+
+  // Replays the next tick, then runs the strategy on it; false at the end
+  bool step();
+  // Steps to the end of the file, then checkpoints positions
+  const BacktestStats &run();
+
+  // For the strategy. Orders reach the venue at the current simulated time
+  // and any fills are applied before these return.
+  Result<LocalOrderId> submit(const v1::StrategySignal &signal);
+  Result<std::monostate> cancel(const v1::CancelSignal &signal);
+  Result<LocalOrderId> replace(const v1::ReplaceSignal &signal);
+
+  IClock::WallTime now() const { return clock_->now(); }
+  const OrderManager &orders() const { return *orders_; }
+  const PositionKeeper &positions() const { return *positions_; }
+  // Last trade price or quote mid per symbol
+  const MarkPriceCache &marks() const { return marks_; }
+  const BacktestStats &stats() const { return stats_; }
+  // Realized PnL plus open positions marked to marks()
+  Money pnl() const;
+
+private:
+  template <typename T> Result<T> count_order(Result<T> result);
+  void apply_fills();
+
+  SimulatedClock *clock_;
+  BacktestStrategy strategy_;
+  MarkPriceCache marks_;
+  SharedRiskLimits risk_limits_;
+  // Owned by orders_
+  PositionKeeper *positions_ = nullptr;
+  ReplayGateway *gateway_ = nullptr;
+  std::unique_ptr<OrderManager> orders_;
+
+  bool fills_pending_ = false;
+  BacktestStats stats_;
+};
+
+} // namespace quarcc
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <trading/backtest/backtest_driver.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace quarcc {
+
+// One backtest in a sweep: typically the same strategy built with a
+// different parameter set
+struct SweepRun {
+  std::string name;
+  BacktestStrategy strategy;
+  BacktestOptions options;
+};
+
+struct SweepResult {
+  std::string name;
+  BacktestStats stats;
+  Money pnl;        // realized plus open positions at the last marks
+  Quantity volume;  // filled quantity, buys and sells
+  std::chrono::nanoseconds elapsed{}; // wall time the run took
+  std::string error; // why the run stopped early, if it did
+};
+
+struct SweepOptions {
+  // 0 means one per hardware thread; never more than there are runs
+  std::size_t threads = 0;
+};
+
+// Runs every run to the end of `ticks` on a WorkStealingPool and returns
+// their results in the order given. Each run gets a stack of its own - a
+// BacktestDriver with its OrderManager, PositionKeeper and ReplayGateway, a
+// SimulatedClock, a SymbolTable, and MemoryJournal and MemoryOrderStore
+// backends - so runs share nothing but the read-only tick mapping, never
+// wait on one another, and give the same results however many threads run
+// them. A strategy that throws ends only its own run.
+std::vector<SweepResult> run_sweep(std::shared_ptr<const TickFile> ticks,
+                                   std::vector<SweepRun> runs,
+                                   SweepOptions options = {});
+
+// One line per result under a header, columns aligned
+std::string format_sweep_table(const std::vector<SweepResult> &results);
+
+} // namespace quarcc
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "execution_service.pb.h"
+
+#include <trading/core/mark_price_cache.h>
+#include <trading/utils/dense_id_map.h>
+#include <trading/utils/fixed_point.h>
+#include <trading/utils/result.h>
+#include <trading/utils/seqlock.h>
+#include <trading/utils/symbol_table.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace quarcc {
+
+// Quantity still working in open orders, per side. Both are non-negative.
+struct WorkingQuantity {
+  Quantity buy;
+  Quantity sell;
+
+  // What orders on `side` could still add to a position, signed like one
+  Quantity toward(v1::Side side) const {
+    return side == v1::Side::SELL ? -sell : buy;
+  }
+
+  void add(v1::Side side, Quantity delta) {
+    (side == v1::Side::SELL ? sell : buy) += delta;
+  }
+};
+
+// Firm-wide positions summed across every strategy. Each strategy's
+// PositionKeeper reports its position changes here as they happen, so a
+// per-symbol query is a single seqlock read instead of a merge over all
+// strategies. Quantities are summed; the average price is the
+// quantity-weighted average of the strategies' average prices.
+//
+// Firm-wide PnL and exposure totals are kept up to date on every position
+// change and mark tick, so reading them never walks the symbols.
+class AggregatePositionBook {
+public:
+  // One strategy's position in a symbol
+  struct Contribution {
+    Quantity quantity;
+    Price avg_price;
+    Money realized_pnl;
+  };
+
+  struct FirmPnl {
+    Money realized;
+    Money unrealized;
+  };
+
+  // Market value summed over symbols (net) and over their absolute values
+  // (gross). Symbols without a mark are valued at cost.
+  struct Exposure {
+    Money gross;
+    Money net;
+  };
+
+  // Every symbol's aggregate as of `version`
+  struct Snapshot {
+    std::uint64_t version = 0;
+    v1::PositionList positions;
+    FirmPnl pnl;
+  };
+
+  // Subscribes to `marks` for unrealized PnL; without it unrealized PnL stays
+  // zero. The cache must outlive the book.
+  explicit AggregatePositionBook(MarkPriceCache *marks = nullptr,
+                                 SymbolTable &symbols = SymbolTable::global());
+  ~AggregatePositionBook();
+
+  AggregatePositionBook(const AggregatePositionBook &) = delete;
+  AggregatePositionBook &operator=(const AggregatePositionBook &) = delete;
+
+  // Replaces one strategy's contribution for `symbol`. Safe to call from any
+  // strategy's thread.
+  void apply(SymbolId symbol, const Contribution &before,
+             const Contribution &after);
+
+  // Revalues `symbol` at a new mark price. Called by the mark cache.
+  void on_mark(SymbolId symbol, Price price);
+
+  // Adds `delta` (negative once orders fill or close) to the quantity
+  // working on `side`. Kept apart from positions, so it never shows up in
+  // get() or snapshots. Safe to call from any strategy's thread.
+  void apply_working(SymbolId symbol, v1::Side side, Quantity delta);
+
+  Result<v1::Position> get(SymbolId symbol) const;
+
+  FirmPnl pnl() const;
+  Exposure exposure() const;
+
+  // Lock-free reads for the pre-trade checks; zero for symbols nobody holds
+  Quantity quantity(SymbolId symbol) const;
+  Money market_value(SymbolId symbol) const;
+  WorkingQuantity working(SymbolId symbol) const;
+
+  // Rebuilt at most once per version and shared between callers until the
+  // next change
+  std::shared_ptr<const Snapshot> snapshot() const;
+
+  // Number of changes applied so far
+  std::uint64_t version() const;
+
+private:
+  struct Aggregate {
+    Quantity quantity;
+    Money cost; // sum of quantity * avg price over strategies
+    Money realized;
+    Price mark;
+    bool has_mark = false;
+
+    Money unrealized() const {
+      return has_mark ? quantity * mark - cost : Money{};
+    }
+    Money market_value() const { return has_mark ? quantity * mark : cost; }
+  };
+
+  struct Totals {
+    FirmPnl pnl;
+    Exposure exposure;
+  };
+
+  // Caller holds write_mutex_
+  void store(Seqlocked<Aggregate> &cell, const Aggregate &before,
+             const Aggregate &after);
+
+  v1::Position to_proto(SymbolId symbol, const Aggregate &aggregate) const;
+
+  MarkPriceCache *marks_;
+  SymbolTable &symbols_;
+  DenseIdMap<Seqlocked<Aggregate>> aggregates_;
+  DenseIdMap<Seqlocked<WorkingQuantity>> working_;
+  Seqlocked<Totals> totals_;
+  std::atomic<std::uint64_t> version_{0};
+
+  std::mutex write_mutex_; // serializes strategies; readers never touch it
+  std::vector<std::unique_ptr<Seqlocked<Aggregate>>> owned_;
+  std::vector<std::unique_ptr<Seqlocked<WorkingQuantity>>> owned_working_;
+
+  mutable std::mutex snapshot_mutex_; // guards cached_; taken by readers only
+  mutable std::shared_ptr<const Snapshot> cached_;
+};
+
+} // namespace quarcc
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <trading/utils/dense_id_map.h>
+#include <trading/utils/fixed_point.h>
+#include <trading/utils/symbol_table.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace quarcc {
+
+// Last known price per symbol, updated by market-data sources and used to
+// mark positions to market. A tick for a known symbol is one atomic store plus
+// the listener call, if any; get() is lock-free.
+class MarkPriceCache {
+public:
+  // Runs on the updating thread after the new price is visible
+  using Listener = std::function<void(SymbolId symbol, Price price)>;
+
+  MarkPriceCache() = default;
+
+  MarkPriceCache(const MarkPriceCache &) = delete;
+  MarkPriceCache &operator=(const MarkPriceCache &) = delete;
+
+  void update(SymbolId symbol, Price price);
+  std::optional<Price> get(SymbolId symbol) const;
+
+  // Must be set before the first update(). While a listener is set, updates
+  // are serialized so it observes prices in the order they were stored.
+  void set_listener(Listener listener);
+
+private:
+  void store_locked(SymbolId symbol, Price price);
+
+  DenseIdMap<std::atomic<Price>> prices_;
+  Listener listener_;
+
+  std::mutex mutex_; // guards owned_ and serializes notifying updates
+  std::vector<std::unique_ptr<std::atomic<Price>>> owned_;
+};
+
+} // namespace quarcc
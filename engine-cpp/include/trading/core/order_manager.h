@@ -4,36 +4,69 @@
 #include "strategy_signal.pb.h"
 
 #include <trading/core/position_keeper.h>
+#include <trading/core/risk_manager.h>
 #include <trading/interfaces/i_execution_gateway.h>
 #include <trading/interfaces/i_journal.h>
 #include <trading/interfaces/i_order_store.h>
-#include <trading/interfaces/i_risk_check.h>
+#include <trading/utils/clock.h>
 #include <trading/utils/order_id_generator.h>
-#include <trading/utils/order_id_types.h>
+#include <trading/utils/order_id_mapper.h>
 #include <trading/utils/result.h>
+#include <trading/utils/timer_wheel.h>
+
+#include <chrono>
+#include <unordered_map>
+#include <vector>
 
 namespace quarcc {
 
+struct OrderManagerOptions {
+  // Each manager sharing an order id space needs its own shard
+  std::uint32_t id_shard = 0;
+  // How long the broker id of a filled, cancelled or replaced order keeps
+  // resolving late fills before its mapping is dropped
+  std::chrono::milliseconds mapping_grace{std::chrono::seconds{60}};
+  // Source of order ids, timestamps and grace deadlines; must outlive the
+  // manager. Give the journal and order store the same one.
+  const IClock *clock = &SystemClock::instance();
+};
+
 class OrderManager {
 public:
+  // Recovers state left by a previous run before returning: open orders from
+  // the store are mapped back to their broker ids, and positions are rebuilt
+  // from the last position snapshot plus the journal fills logged after it.
   static std::unique_ptr<OrderManager> CreateOrderManager(
       std::unique_ptr<PositionKeeper> pk, std::unique_ptr<IExecutionGateway> gw,
       std::unique_ptr<IJournal> lj, std::unique_ptr<IOrderStore> os,
-      std::unique_ptr<RiskManager> rm);
+      std::unique_ptr<RiskManager> rm, OrderManagerOptions options = {});
 
+  // New and replacement orders go through the RiskManager before reaching
+  // the gateway; refused ones fail with ErrorType::RiskRejected.
   Result<LocalOrderId> processSignal(const v1::StrategySignal &signal);
   Result<std::monostate> processSignal(const v1::CancelSignal &signal);
   Result<LocalOrderId> processSignal(const v1::ReplaceSignal &signal);
 
   // Poll the gateway for new fills and apply them to the order store and
-  // position keeper. Called periodically from TradingEngine::Run().
-  void process_fills();
+  // position keeper. Called by the owning StrategyWorker whenever the gateway
+  // signals new fills, or periodically for gateways that cannot push.
+  // Returns how many fills were applied.
+  std::size_t process_fills();
+
+  // Forwards the push-delivery callback to the gateway. Returns false if the
+  // gateway cannot push and process_fills() has to be polled instead.
+  bool set_fill_listener(IExecutionGateway::FillListener listener);
 
   // Cancel every open order through the gateway and journal the kill-switch
-  // event. Called from TradingEngine::ActivateKillSwitch().
+  // event. Posted by TradingEngine::ActivateKillSwitch().
   void cancel_all(const std::string &reason, const std::string &initiated_by);
 
+  // Saves the current positions as the recovery snapshot. Also done every
+  // kFillsPerCheckpoint fills and when the owning StrategyWorker stops.
+  Result<std::monostate> checkpoint();
+
   // Position queries delegated to the internal PositionKeeper.
+  Result<v1::Position> get_position(SymbolId symbol) const;
   Result<v1::Position> get_position(const std::string &symbol) const;
   v1::PositionList get_all_positions() const;
 
@@ -41,19 +74,60 @@ private:
   OrderManager(std::unique_ptr<PositionKeeper> pk,
                std::unique_ptr<IExecutionGateway> gw,
                std::unique_ptr<IJournal> lj, std::unique_ptr<IOrderStore> os,
-               std::unique_ptr<RiskManager> rm);
+               std::unique_ptr<RiskManager> rm, OrderManagerOptions options);
 
-  v1::Order createOrderFromSignal(const v1::StrategySignal &signal);
-  v1::Order createOrderFromSignal(const v1::ReplaceSignal &signal);
+  Result<v1::Order> createOrderFromSignal(const v1::StrategySignal &signal);
+  Result<v1::Order> createOrderFromSignal(const v1::ReplaceSignal &signal);
+  // Symbol validation, then the risk checks
+  Result<std::monostate> pre_trade_check(const v1::Order &order);
+
+  void notify_mapping_added();
+  // Stops `local_id` resolving and schedules its broker id for removal once
+  // the grace period has passed
+  void retire_mapping(const std::string &local_id);
+  void expire_retired_mappings();
+  void recover();
+  Quantity reconcile_fills(const StoredOrder &stored);
+
+  // Working quantity of submitted orders, reported to the PositionKeeper so
+  // the position checks see it
+  void add_working(const std::string &local_id, const v1::Order &order,
+                   Quantity leaves);
+  void reduce_working(const std::string &local_id, Quantity filled);
+  void close_working(const std::string &local_id);
 
 private:
+  // A fill whose broker id is not mapped yet. Push-capable gateways can
+  // report a fill before submit_order() has returned the broker id to us, so
+  // such fills are retried until the grace deadline passes.
+  struct UnresolvedFill {
+    v1::ExecutionReport report;
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  // What an order still has working, until it fills or closes
+  struct WorkingOrder {
+    SymbolId symbol;
+    v1::Side side;
+    Quantity leaves;
+  };
+
   std::unique_ptr<PositionKeeper> position_keeper_;
   std::unique_ptr<IExecutionGateway> gateway_;
   std::unique_ptr<IJournal> journal_;
   std::unique_ptr<IOrderStore> order_store_;
   std::unique_ptr<RiskManager> risk_manager_;
+  const IClock *clock_;
   std::unique_ptr<OrderIdGenerator> id_generator_;
   std::unique_ptr<OrderIdMapper> id_mapper_;
+  // Broker ids of retired mappings, by when they stop resolving
+  std::chrono::milliseconds mapping_grace_;
+  TimerWheel<BrokerOrderId> retired_mappings_;
+
+  IExecutionGateway::FillListener fill_listener_;
+  std::vector<UnresolvedFill> unresolved_fills_;
+  std::unordered_map<LocalOrderId, WorkingOrder> working_orders_;
+  std::size_t fills_since_checkpoint_ = 0;
 };
 
 } // namespace quarcc
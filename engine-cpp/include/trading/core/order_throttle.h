@@ -0,0 +1,159 @@
+#pragma once
+
+#include "strategy_signal.pb.h"
+
+#include <trading/utils/dense_id_map.h>
+#include <trading/utils/result.h>
+#include <trading/utils/symbol_table.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace quarcc {
+
+// `per_second` sustained, up to `burst` at once. A zero rate means no limit.
+struct RateLimit {
+  double per_second = 0.0;
+  double burst = 1.0;
+};
+
+struct ThrottleLimits {
+  RateLimit orders; // new orders and replaces
+  RateLimit cancels;
+  // Replaces per new order over the last ReplaceRatioWindow; 0 means no limit
+  double max_replace_ratio = 0.0;
+  // Replaces allowed in a window regardless of the ratio, so a strategy that
+  // has sent few orders can still amend them
+  std::uint32_t replace_allowance = 10;
+};
+
+struct ThrottleConfig {
+  ThrottleLimits per_strategy;
+  ThrottleLimits per_symbol; // each symbol, summed over every strategy
+};
+
+// Token bucket kept as a single atomic "theoretical arrival time" (GCRA):
+// each message pushes it one interval into the future, and a message is
+// refused if that would put it more than the burst ahead of now.
+class RateLimiter {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit RateLimiter(RateLimit limit);
+
+  // Lock-free; safe to call from any thread
+  bool try_acquire(Clock::time_point now);
+  // Returns a token try_acquire() took, for a message that a later check
+  // refused after all
+  void refund();
+
+private:
+  std::int64_t interval_ns_ = 0; // zero: unlimited
+  std::int64_t tolerance_ns_ = 0;
+  std::atomic<std::int64_t> tat_ns_{0};
+};
+
+// New orders and replaces over the last second, in a ring of ten 100 ms
+// slots. Each slot packs its epoch and both counts into one atomic word.
+class ReplaceRatioWindow {
+public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr std::size_t kSlots = 10;
+  static constexpr std::chrono::milliseconds kSlotWidth{100};
+
+  void record_order(Clock::time_point now);
+  // Whether one more replace keeps the window's replaces within
+  // max_ratio * orders + allowance. Concurrent replaces may each see the
+  // other's slot as not yet counted, so the limit is approximate under races.
+  bool allows_replace(Clock::time_point now, double max_ratio,
+                      std::uint32_t allowance) const;
+  void record_replace(Clock::time_point now);
+  // Both of the above
+  bool try_replace(Clock::time_point now, double max_ratio,
+                   std::uint32_t allowance);
+
+private:
+  struct Counts {
+    std::uint32_t orders = 0;
+    std::uint32_t replaces = 0;
+  };
+
+  static std::uint32_t epoch_of(Clock::time_point now);
+  void add(std::uint32_t epoch, bool replace);
+  Counts totals(std::uint32_t epoch) const;
+
+  std::array<std::atomic<std::uint64_t>, kSlots> slots_{};
+};
+
+// Message-rate limits, checked by TradingEngine before a signal is handed to
+// the strategy's worker, so a flood is refused before any journaling or
+// order-store work. A check is a few atomic operations; a mutex is only
+// taken the first time a symbol is seen.
+//
+// Symbols are looked up, never interned, since they come straight from
+// clients: one not in the SymbolTable yet (it gets an id once an order for
+// it reaches a gateway) shares a single per-symbol bucket with every other
+// unknown symbol. Cancels carry no symbol, so they are only limited per
+// strategy.
+class OrderThrottle {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit OrderThrottle(ThrottleConfig config = {},
+                         SymbolTable &symbols = SymbolTable::global());
+  ~OrderThrottle();
+
+  OrderThrottle(const OrderThrottle &) = delete;
+  OrderThrottle &operator=(const OrderThrottle &) = delete;
+
+  // Registers a strategy's counters. Must happen before any check; signals
+  // from unregistered strategies are only limited per symbol.
+  void add_strategy(const std::string &strategy_id);
+
+  // Fail with ErrorType::Throttled. Only a passing check counts the message:
+  // one refused by any limit uses up none of the others.
+  Result<std::monostate> check(const v1::StrategySignal &signal,
+                               Clock::time_point now = Clock::now());
+  Result<std::monostate> check(const v1::CancelSignal &signal,
+                               Clock::time_point now = Clock::now());
+  Result<std::monostate> check(const v1::ReplaceSignal &signal,
+                               Clock::time_point now = Clock::now());
+
+private:
+  struct Counters {
+    explicit Counters(const ThrottleLimits &limits)
+        : orders(limits.orders), cancels(limits.cancels) {}
+
+    RateLimiter orders;
+    RateLimiter cancels;
+    ReplaceRatioWindow replaces;
+  };
+
+  Counters *strategy(const std::string &strategy_id) const;
+  Counters &symbol(const std::string &symbol);
+  // Takes an order token from the strategy's bucket (if any) and the
+  // symbol's, or from neither
+  Result<std::monostate> acquire_order(Counters *by_strategy,
+                                       Counters &by_symbol,
+                                       const std::string &strategy_id,
+                                       const std::string &symbol,
+                                       Clock::time_point now);
+
+  ThrottleConfig config_;
+  SymbolTable &symbols_;
+  std::unordered_map<std::string, std::unique_ptr<Counters>> strategies_;
+
+  Counters unknown_symbols_;
+  DenseIdMap<Counters> by_symbol_;
+  std::mutex symbol_mutex_; // guards symbol_storage_ and by_symbol_.set()
+  std::vector<std::unique_ptr<Counters>> symbol_storage_;
+};
+
+} // namespace quarcc
@@ -3,34 +3,98 @@
 #include "common.pb.h"
 #include "execution_service.pb.h"
 
+#include <trading/core/aggregate_position_book.h>
+#include <trading/core/mark_price_cache.h>
+#include <trading/utils/dense_id_map.h>
+#include <trading/utils/fixed_point.h>
 #include <trading/utils/order_id_generator.h>
 #include <trading/utils/result.h>
+#include <trading/utils/seqlock.h>
+#include <trading/utils/symbol_table.h>
 
-#include <shared_mutex>
-#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace quarcc {
 
+// Positions are written by the owning OrderManager's fill path and read
+// concurrently by position queries. Positions are kept in a flat table indexed
+// by SymbolId; each one sits behind its own seqlock, so readers never take a
+// lock and never make the writer wait.
+//
+// Realized PnL accumulates as fills reduce or flip a position. Unrealized PnL
+// is computed when a position is read, against the mark cache if one is given.
+//
+// When given an AggregatePositionBook, every position change is also folded
+// into it. The book and the mark cache must outlive the keeper.
 class PositionKeeper {
 public:
+  struct Position {
+    Quantity quantity;
+    Price avgPrice;
+    Money realizedPnl;
+  };
+
+  explicit PositionKeeper(AggregatePositionBook *book = nullptr,
+                          const MarkPriceCache *marks = nullptr,
+                          SymbolTable &symbols = SymbolTable::global());
+  ~PositionKeeper();
+
+  PositionKeeper(const PositionKeeper &) = delete;
+  PositionKeeper &operator=(const PositionKeeper &) = delete;
+
   // Called by OrderManager::process_fills() whenever a fill arrives from the
   // gateway. Updates the in-memory position with a signed-quantity weighted-
   // average price calculation.
-  void on_fill(const std::string &symbol, double fill_qty, double fill_price,
+  void on_fill(SymbolId symbol, Quantity fill_qty, Price fill_price,
                v1::Side side);
 
+  // Adds `delta` to the quantity this strategy has working on `side`: the
+  // order quantity on submit, less each fill, and the leaves on cancel. The
+  // pre-trade checks count it as if it had filled.
+  void add_working(SymbolId symbol, v1::Side side, Quantity delta);
+
+  // Overwrites a position with a persisted value. Used by recovery before any
+  // fills are applied.
+  void restore_position(SymbolId symbol, Quantity quantity, Price avg_price,
+                        Money realized_pnl = {});
+
+  Result<v1::Position> getPosition(SymbolId symbol) const;
+  // For callers holding a raw symbol; never interns it
   Result<v1::Position> getPosition(const std::string &symbol) const;
   v1::PositionList getAllPositions() const;
+  // Lock-free, without building a proto; zero if there is no position
+  Quantity quantity(SymbolId symbol) const;
+  WorkingQuantity working(SymbolId symbol) const;
+  // Visits every position in SymbolId order without leaving fixed point
+  void for_each_position(
+      const std::function<void(SymbolId, const Position &)> &visit) const;
+
+  SymbolTable &symbols() const { return symbols_; }
 
 private:
-  struct Position {
-    std::string symbol;
-    double quantity = 0.0;
-    double avgPrice = 0.0;
+  struct Slot {
+    explicit Slot(const Position &p) : value(p) {}
+
+    Seqlocked<Position> value;
   };
 
-  mutable std::shared_mutex mutex_;
-  std::unordered_map<std::string, Position> positions_;
+  // Writer only
+  void store(SymbolId symbol, const Position &position);
+
+  v1::Position to_proto(SymbolId symbol, const Position &position) const;
+
+  AggregatePositionBook *book_;
+  const MarkPriceCache *marks_;
+  SymbolTable &symbols_;
+  DenseIdMap<Slot> slots_;
+  DenseIdMap<Seqlocked<WorkingQuantity>> working_;
+
+  std::mutex write_mutex_; // serializes writers; readers never touch it
+  std::vector<std::unique_ptr<Slot>> owned_slots_;
+  std::vector<std::unique_ptr<Seqlocked<WorkingQuantity>>> owned_working_;
 };
 
 }; // namespace quarcc
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <trading/interfaces/i_risk_check.h>
+
+#include <limits>
+#include <optional>
+
+namespace quarcc {
+
+// The built-in pre-trade checks. They are plain types rather than
+// IRiskCheck implementations so a RiskPipeline can inline them; wrap one in a
+// RiskCheckAdapter to use it behind the interface.
+//
+// Position and exposure checks only refuse orders that make things worse, so
+// an order that reduces a position already over a (newly lowered) limit still
+// goes through.
+
+namespace detail {
+
+// A position limit is only breached by an order that moves the position
+// further from flat past the limit.
+constexpr bool breaches(Quantity before, Quantity after, Quantity limit) {
+  return abs(after) > limit && abs(after) > abs(before);
+}
+
+// Rejections are rare, so the reasons are formatted out of line to keep the
+// passing path of each check small enough to inline.
+[[gnu::cold]] Result<std::monostate> reject(std::string reason);
+[[gnu::cold]] Result<std::monostate> order_quantity_exceeded(Quantity quantity,
+                                                             Quantity limit);
+[[gnu::cold]] Result<std::monostate>
+order_notional_exceeded(std::optional<Money> notional, Money limit);
+[[gnu::cold]] Result<std::monostate>
+position_exceeded(const char *whose, Quantity after, Quantity limit);
+[[gnu::cold]] Result<std::monostate>
+exposure_exceeded(const char *which, Money after, Money limit);
+[[gnu::cold]] Result<std::monostate> unpriced_order();
+
+// a + b where either may come from an unvalidated order; nullopt if the sum
+// overflows or is the one value abs() cannot negate
+template <typename T> constexpr std::optional<T> add(T a, T b) {
+  const auto sum = checked_add(a, b);
+  if (!sum ||
+      sum->raw() == std::numeric_limits<typename T::rep>::min()) [[unlikely]]
+    return std::nullopt;
+  return sum;
+}
+
+// Market value the order adds to its symbol; nullopt on overflow. The
+// reference price must be set.
+inline std::optional<Money> order_value(const RiskOrder &order) {
+  return checked_mul(order.signed_quantity(), order.reference_price);
+}
+
+} // namespace detail
+
+struct MaxOrderQuantityCheck {
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const {
+    const Quantity limit = context.symbol_limits.max_order_quantity;
+    if (order.quantity > limit) [[unlikely]]
+      return detail::order_quantity_exceeded(order.quantity, limit);
+    return std::monostate{};
+  }
+};
+
+// Needs a reference price unless the symbol has no notional limit
+struct MaxOrderNotionalCheck {
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const {
+    const Money limit = context.symbol_limits.max_order_notional;
+    if (limit == Money::max())
+      return std::monostate{};
+    if (order.reference_price.is_zero()) [[unlikely]]
+      return detail::unpriced_order();
+    const auto notional = checked_mul(order.quantity, order.reference_price);
+    if (!notional || *notional > limit) [[unlikely]]
+      return detail::order_notional_exceeded(notional, limit);
+    return std::monostate{};
+  }
+};
+
+// Firm-wide position in the symbol, counting orders still working on the
+// order's side
+struct SymbolPositionCheck {
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const {
+    const Quantity limit = context.symbol_limits.max_position;
+    const auto before =
+        detail::add(context.firm_position, context.firm_working);
+    const auto after =
+        before ? detail::add(*before, order.signed_quantity()) : std::nullopt;
+    if (!after) [[unlikely]]
+      return detail::reject("firm position overflows");
+    if (detail::breaches(*before, *after, limit)) [[unlikely]]
+      return detail::position_exceeded("firm", *after, limit);
+    return std::monostate{};
+  }
+};
+
+// This strategy's position in the symbol, counting its working orders on the
+// order's side
+struct StrategyPositionCheck {
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const {
+    const Quantity limit = context.strategy_limits.max_position;
+    const auto before =
+        detail::add(context.strategy_position, context.strategy_working);
+    const auto after =
+        before ? detail::add(*before, order.signed_quantity()) : std::nullopt;
+    if (!after) [[unlikely]]
+      return detail::reject("strategy position overflows");
+    if (detail::breaches(*before, *after, limit)) [[unlikely]]
+      return detail::position_exceeded("strategy", *after, limit);
+    return std::monostate{};
+  }
+};
+
+// The order is valued at its reference price; existing positions at their
+// marks (or cost when unmarked).
+struct GrossExposureCheck {
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const {
+    const Money limit = context.limits.max_gross_exposure;
+    if (limit == Money::max())
+      return std::monostate{};
+    if (order.reference_price.is_zero()) [[unlikely]]
+      return detail::unpriced_order();
+    const auto value = detail::order_value(order);
+    if (!value) [[unlikely]]
+      return detail::reject("order value overflows");
+
+    const Money before = context.firm_market_value;
+    const auto moved = detail::add(before, *value);
+    const auto after =
+        moved ? detail::add(context.gross_exposure - abs(before), abs(*moved))
+              : std::nullopt;
+    if (!after) [[unlikely]]
+      return detail::reject("gross exposure overflows");
+    if (*after > limit && *after > context.gross_exposure) [[unlikely]]
+      return detail::exposure_exceeded("gross", *after, limit);
+    return std::monostate{};
+  }
+};
+
+struct NetExposureCheck {
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const {
+    const Money limit = context.limits.max_net_exposure;
+    if (limit == Money::max())
+      return std::monostate{};
+    if (order.reference_price.is_zero()) [[unlikely]]
+      return detail::unpriced_order();
+    const auto value = detail::order_value(order);
+    if (!value) [[unlikely]]
+      return detail::reject("order value overflows");
+
+    const auto after = detail::add(context.net_exposure, *value);
+    if (!after) [[unlikely]]
+      return detail::reject("net exposure overflows");
+    if (abs(*after) > limit && abs(*after) > abs(context.net_exposure))
+        [[unlikely]]
+      return detail::exposure_exceeded("net", *after, limit);
+    return std::monostate{};
+  }
+};
+
+} // namespace quarcc
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "order.pb.h"
+
+#include <trading/core/aggregate_position_book.h>
+#include <trading/core/mark_price_cache.h>
+#include <trading/core/position_keeper.h>
+#include <trading/core/risk_checks.h>
+#include <trading/core/risk_pipeline.h>
+#include <trading/interfaces/i_risk_check.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace quarcc {
+
+// Publishes limit tables to the check path without locking it: a reader does
+// one atomic load and uses the table in place. Reloads are rare, so replaced
+// tables are kept until destruction instead of tracking when readers are
+// done with them.
+class SharedRiskLimits {
+public:
+  explicit SharedRiskLimits(RiskLimits initial = {});
+
+  SharedRiskLimits(const SharedRiskLimits &) = delete;
+  SharedRiskLimits &operator=(const SharedRiskLimits &) = delete;
+
+  const RiskLimits &current() const {
+    return *current_.load(std::memory_order_acquire);
+  }
+
+  // Later current() calls see `limits`; tables already handed out stay valid
+  void publish(RiskLimits limits);
+
+private:
+  std::atomic<const RiskLimits *> current_;
+  std::mutex publish_mutex_; // guards versions_
+  std::vector<std::unique_ptr<const RiskLimits>> versions_;
+};
+
+// The built-in checks, in the order RiskManager runs them by default
+using DefaultRiskPipeline =
+    RiskPipeline<MaxOrderQuantityCheck, MaxOrderNotionalCheck,
+                 SymbolPositionCheck, StrategyPositionCheck,
+                 GrossExposureCheck, NetExposureCheck>;
+
+// Pre-trade checks for one strategy's orders, run by OrderManager before an
+// order reaches the gateway. Only used from the strategy's worker thread.
+//
+// Position checks count quantity still working in open orders on the
+// order's side as if it had filled, so orders that only breach a limit
+// together are refused before either fills. Exposure checks use filled
+// positions only.
+class RiskManager {
+public:
+  // Lets every order through
+  RiskManager();
+  // Everything referenced must outlive the manager. Either position source
+  // may be null, in which case its positions read as flat.
+  RiskManager(std::string strategy_id, const SharedRiskLimits &limits,
+              const PositionKeeper *strategy_positions,
+              const AggregatePositionBook *firm_positions,
+              const MarkPriceCache *marks,
+              SymbolTable &symbols = SymbolTable::global());
+  ~RiskManager();
+
+  RiskManager(const RiskManager &) = delete;
+  RiskManager &operator=(const RiskManager &) = delete;
+
+  // Converts the order to fixed point, then runs the checks. The order is
+  // valued at its limit price, else the symbol's mark, else
+  // `fallback_price` (e.g. the gateway's reference price).
+  Result<std::monostate>
+  check(const v1::Order &order,
+        std::optional<Price> fallback_price = std::nullopt);
+  Result<std::monostate> check(const RiskOrder &order);
+
+  // Replaces the DefaultRiskPipeline, e.g. with a RiskPipeline of the
+  // checks a strategy type needs or a DynamicRiskPipeline built at runtime
+  void set_checks(std::unique_ptr<IRiskCheck> checks);
+  // Runs after the checks above
+  void add_check(std::unique_ptr<IRiskCheck> check);
+
+private:
+  const StrategyRiskLimits &strategy_limits(const RiskLimits &limits);
+
+  std::string strategy_id_;
+  const SharedRiskLimits *limits_ = nullptr;
+  const PositionKeeper *strategy_positions_ = nullptr;
+  const AggregatePositionBook *firm_positions_ = nullptr;
+  const MarkPriceCache *marks_ = nullptr;
+  SymbolTable *symbols_ = nullptr;
+
+  std::unique_ptr<IRiskCheck> checks_;
+  DynamicRiskPipeline extra_checks_;
+
+  // This strategy's entry in the last table seen; looked up again only when
+  // a new table is published
+  const RiskLimits *resolved_table_ = nullptr;
+  const StrategyRiskLimits *resolved_strategy_ = nullptr;
+};
+
+} // namespace quarcc
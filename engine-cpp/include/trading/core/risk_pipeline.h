@@ -0,0 +1,87 @@
+#pragma once
+
+#include <trading/interfaces/i_risk_check.h>
+
+#include <concepts>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace quarcc {
+
+// Anything with a const check(RiskOrder, RiskContext) -> Result<monostate>.
+// Plain types are preferred so a RiskPipeline can inline them.
+template <typename T>
+concept RiskCheck = requires(const T &check, const RiskOrder &order,
+                             const RiskContext &context) {
+  { check.check(order, context) } -> std::same_as<Result<std::monostate>>;
+};
+
+// A fixed list of checks, run in order and stopping at the first rejection.
+// The list is part of the type, so the calls are direct and the compiler can
+// inline every check; RiskManager reaches the whole pipeline through a single
+// virtual call per order.
+template <RiskCheck... Checks> class RiskPipeline final : public IRiskCheck {
+public:
+  RiskPipeline() = default;
+  explicit RiskPipeline(Checks... checks)
+    requires(sizeof...(Checks) > 0)
+      : checks_(std::move(checks)...) {}
+
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const override {
+    Result<std::monostate> result;
+    std::apply(
+        [&](const Checks &...checks) {
+          (void)(... && (result = checks.check(order, context)));
+        },
+        checks_);
+    return result;
+  }
+
+private:
+  std::tuple<Checks...> checks_;
+};
+
+// Puts a plain check behind the IRiskCheck interface
+template <RiskCheck Check> class RiskCheckAdapter final : public IRiskCheck {
+public:
+  explicit RiskCheckAdapter(Check check = {}) : check_(std::move(check)) {}
+
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const override {
+    return check_.check(order, context);
+  }
+
+private:
+  Check check_;
+};
+
+// Checks chosen at runtime, e.g. from configuration. Costs a virtual call per
+// check; prefer a RiskPipeline when the checks are known at compile time.
+class DynamicRiskPipeline final : public IRiskCheck {
+public:
+  void add(std::unique_ptr<IRiskCheck> check) {
+    checks_.push_back(std::move(check));
+  }
+  template <RiskCheck Check> void add(Check check) {
+    add(std::make_unique<RiskCheckAdapter<Check>>(std::move(check)));
+  }
+
+  bool empty() const { return checks_.empty(); }
+
+  Result<std::monostate> check(const RiskOrder &order,
+                               const RiskContext &context) const override {
+    for (const auto &check : checks_) {
+      if (auto result = check->check(order, context); !result)
+        return result;
+    }
+    return std::monostate{};
+  }
+
+private:
+  std::vector<std::unique_ptr<IRiskCheck>> checks_;
+};
+
+} // namespace quarcc
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <trading/core/order_manager.h>
+#include <trading/utils/event_notifier.h>
+#include <trading/utils/mpsc_queue.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <variant>
+
+namespace quarcc {
+
+// Owns one strategy's OrderManager and runs it on a dedicated thread. Every
+// mutation (signals, cancels, replaces, fills, kill switch) is posted to an
+// MPSC inbox and executed in arrival order by that thread, so OrderManager
+// state has a single writer and one strategy's slow persistence never stalls
+// another strategy.
+//
+// Position queries bypass the inbox: PositionKeeper is safe to read
+// concurrently with the worker's fill updates.
+class StrategyWorker {
+public:
+  template <typename T> using Completion = std::function<void(Result<T>)>;
+
+  explicit StrategyWorker(std::unique_ptr<OrderManager> manager);
+  ~StrategyWorker();
+
+  StrategyWorker(const StrategyWorker &) = delete;
+  StrategyWorker &operator=(const StrategyWorker &) = delete;
+
+  // Thread-safe. `done` is invoked on the worker thread once the message has
+  // been processed. After stop() nothing is processed any more: `done` runs
+  // right away on the caller's thread, with an error where it takes one.
+  void submit(v1::StrategySignal signal, Completion<LocalOrderId> done);
+  void cancel(v1::CancelSignal signal, Completion<std::monostate> done);
+  void replace(v1::ReplaceSignal signal, Completion<LocalOrderId> done);
+  void cancel_all(std::string reason, std::string initiated_by,
+                  std::function<void()> done);
+
+  // Drains the inbox, stops the worker thread and checkpoints positions.
+  // Called by the destructor.
+  void stop();
+
+  const OrderManager &manager() const { return *manager_; }
+
+private:
+  struct SubmitMsg {
+    v1::StrategySignal signal;
+    Completion<LocalOrderId> done;
+  };
+  struct CancelMsg {
+    v1::CancelSignal signal;
+    Completion<std::monostate> done;
+  };
+  struct ReplaceMsg {
+    v1::ReplaceSignal signal;
+    Completion<LocalOrderId> done;
+  };
+  struct CancelAllMsg {
+    std::string reason;
+    std::string initiated_by;
+    std::function<void()> done;
+  };
+  // At most one is queued at a time; see on_fills_ready()
+  struct FillsReadyMsg {};
+
+  using Message =
+      std::variant<SubmitMsg, CancelMsg, ReplaceMsg, CancelAllMsg, FillsReadyMsg>;
+
+  void post(Message msg);
+  static void reject(Message &msg);
+  void on_fills_ready();
+  void run();
+  void handle(Message &msg);
+
+private:
+  std::unique_ptr<OrderManager> manager_;
+  MpscQueue<Message> inbox_;
+  EventNotifier wakeup_;
+  std::atomic<bool> fills_queued_{false};
+  std::atomic<bool> stopping_{false};
+  // Posts between their stopping_ check and their push; the worker waits for
+  // these to land before its last drain
+  std::atomic<int> posting_{0};
+  bool gateway_pushes_fills_ = false;
+  std::thread thread_;
+  // thread_'s id, readable while stop() joins it
+  std::atomic<std::thread::id> worker_id_;
+};
+
+} // namespace quarcc
@@ -1,21 +1,64 @@
 #pragma once
 
+#include <trading/core/aggregate_position_book.h>
+#include <trading/core/mark_price_cache.h>
 #include <trading/core/order_manager.h>
+#include <trading/core/order_throttle.h>
+#include <trading/core/risk_manager.h>
+#include <trading/core/strategy_worker.h>
 #include <trading/gateways/alpaca_fix_gateway.h>
 #include <trading/grpc/grpc_server.h>
 #include <trading/interfaces/i_execution_service_handler.h>
+#include <trading/persistence/journal_factory.h>
+#include <trading/utils/clock.h>
+#include <trading/utils/event_notifier.h>
 #include <trading/utils/order_id_generator.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace quarcc {
 
+struct TradingEngineOptions {
+  // The symbols strategies may trade, interned at construction. Orders for
+  // any other symbol are rejected before the risk checks and the gateway.
+  std::vector<std::string> symbols;
+  // Backend and tuning of each strategy's journal
+  JournalConfig journal{
+      .backend = JournalBackend::SQLite,
+      .sqlite = {.async = true, .sync = JournalSyncMode::Normal},
+      .mmap = {},
+  };
+  // Pre-trade limits at startup; see TradingEngine::ReloadRiskLimits()
+  RiskLimits risk{};
+  // Message-rate limits applied before signals reach a strategy's worker
+  ThrottleConfig throttle{};
+  // Where the ExecutionService listens, and its completion-queue threading
+  std::string listen_address = "0.0.0.0:50051";
+  gRPCServerOptions server{.num_cqs = 2, .pollers_per_cq = 2};
+  // Read by the throttle and by every strategy's order manager, journal,
+  // order store and gateway; must outlive the engine
+  const IClock *clock = &SystemClock::instance();
+};
+
 class TradingEngine final : public IExecutionServiceHandler {
   using StrategyId = std::string;
 
 public:
+  explicit TradingEngine(TradingEngineOptions options = {});
+
   void Run();
 
+  // Swaps the limit table used by every strategy's pre-trade checks. Orders
+  // already being checked finish against the previous table.
+  void ReloadRiskLimits(RiskLimits limits);
+
+  // Marks `symbol` to market for PnL and for valuing unpriced orders in the
+  // risk checks. For market-data feeds; the paper gateway's fills are fed in
+  // already. Any thread.
+  void UpdateMarkPrice(const std::string &symbol, Price price);
+
 private:
   Result<BrokerOrderId> SubmitSignal(const v1::StrategySignal &req) override;
   Result<std::monostate> CancelOrder(const v1::CancelSignal &req) override;
@@ -25,10 +68,34 @@ private:
   Result<std::monostate>
   ActivateKillSwitch(const v1::KillSwitchRequest &req) override;
 
+  void SubmitSignalAsync(const v1::StrategySignal &req,
+                         Completion<BrokerOrderId> done) override;
+  void CancelOrderAsync(const v1::CancelSignal &req,
+                        Completion<std::monostate> done) override;
+  void ReplaceOrderAsync(const v1::ReplaceSignal &req,
+                         Completion<BrokerOrderId> done) override;
+  void ActivateKillSwitchAsync(const v1::KillSwitchRequest &req,
+                               Completion<std::monostate> done) override;
+
 private:
+  TradingEngineOptions options_;
   std::atomic<bool> running_{true};
+  // Signalled by the kill switch to release Run()
+  EventNotifier shutdown_notifier_;
   std::unique_ptr<gRPCServer> server_;
-  std::unordered_map<StrategyId, std::unique_ptr<OrderManager>> managers_;
+  // Last prices, from UpdateMarkPrice() and the paper gateway's fills; used
+  // to mark positions to market and to value orders for risk checks
+  MarkPriceCache marks_;
+  // Firm-wide positions and PnL, fed by every strategy's PositionKeeper.
+  // Declared before workers_ so it outlives them.
+  AggregatePositionBook positions_{&marks_};
+  // Read by every strategy's RiskManager; also declared before workers_
+  SharedRiskLimits risk_limits_;
+  // Checked on the calling (gRPC) thread before a signal is posted
+  OrderThrottle throttle_;
+  // Each OrderManager lives on its own worker thread; the engine only routes
+  // requests to the right worker by strategy id.
+  std::unordered_map<StrategyId, std::unique_ptr<StrategyWorker>> workers_;
 };
 
 } // namespace quarcc
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "common.pb.h"
+
+#include <trading/utils/fixed_point.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace quarcc {
+
+// Pool slot in the low 32 bits and the slot's generation in the high 32, so
+// a handle kept after its order left the book never matches the slot's next
+// occupant.
+using BookOrderId = std::uint64_t;
+
+// Price-time priority limit order book for one symbol.
+//
+// Orders live in a pooled node array and queue on an intrusive FIFO list per
+// price level. Each side's levels sit in a flat vector sorted best-last, so
+// taking from the top of the book and adding near it only touch the tail.
+// Once the pool and level vectors have grown, nothing allocates per order.
+//
+// Not thread-safe.
+class OrderBook {
+public:
+  struct Fill {
+    BookOrderId maker; // the resting order
+    std::uint64_t maker_tag;
+    Price price;
+    Quantity quantity;
+    Quantity maker_leaves; // left on the resting order after this fill
+  };
+
+  static constexpr BookOrderId kNoOrder = ~BookOrderId{0};
+
+  void reserve(std::size_t orders);
+
+  // Rests `quantity` at `price` behind everything already there. `tag` comes
+  // back in fills against the order. Does not match; callers take liquidity
+  // with match() first.
+  BookOrderId add(v1::Side side, Price price, Quantity quantity,
+                  std::uint64_t tag);
+  // false if the order is no longer in the book
+  bool cancel(BookOrderId id);
+  std::optional<Quantity> leaves(BookOrderId id) const;
+
+  // Takes up to `quantity` from the side opposite `side`, best price first
+  // and oldest first within a price, never trading through `limit` (none for
+  // a market order). Calls on_fill(const Fill &) per resting order hit, which
+  // must not modify the book. Returns the quantity left unfilled.
+  template <typename OnFill>
+  Quantity match(v1::Side side, std::optional<Price> limit, Quantity quantity,
+                 OnFill &&on_fill);
+
+  // What match() could take within `limit`, counted up to `wanted`
+  Quantity available(v1::Side side, std::optional<Price> limit,
+                     Quantity wanted) const;
+
+  std::optional<Price> best_bid() const;
+  std::optional<Price> best_ask() const;
+  // Total resting on `side` at `price`
+  Quantity depth(v1::Side side, Price price) const;
+  std::size_t level_count(v1::Side side) const;
+  std::size_t order_count() const { return live_; }
+
+private:
+  static constexpr std::uint32_t kNil = ~std::uint32_t{0};
+
+  struct Node {
+    Price price;
+    Quantity leaves;
+    std::uint64_t tag = 0;
+    std::uint32_t prev = kNil;
+    std::uint32_t next = kNil;
+    std::uint32_t generation = 0;
+    v1::Side side = v1::UNKNOWN_SIDE;
+    bool live = false;
+  };
+  struct Level {
+    Price price;
+    Quantity total;
+    std::uint32_t head = kNil;
+    std::uint32_t tail = kNil;
+  };
+  using Levels = std::vector<Level>;
+
+  static BookOrderId make_id(std::uint32_t slot, std::uint32_t generation) {
+    return std::uint64_t{generation} << 32 | slot;
+  }
+  static bool crosses(v1::Side side, Price limit, Price level) {
+    return side == v1::BUY ? level <= limit : level >= limit;
+  }
+
+  Levels &resting(v1::Side side) { return side == v1::BUY ? bids_ : asks_; }
+  const Levels &resting(v1::Side side) const {
+    return side == v1::BUY ? bids_ : asks_;
+  }
+  // Bids ascend and asks descend, so the best level is always last
+  Levels::iterator find_level(v1::Side side, Price price);
+  Levels::const_iterator find_level(v1::Side side, Price price) const;
+  const Node *lookup(BookOrderId id) const;
+
+  std::uint32_t allocate();
+  void release(std::uint32_t slot);
+  void unlink(Level &level, std::uint32_t slot);
+
+  std::vector<Node> nodes_;
+  std::vector<std::uint32_t> free_;
+  Levels bids_;
+  Levels asks_;
+  std::size_t live_ = 0;
+};
+
+template <typename OnFill>
+Quantity OrderBook::match(v1::Side side, std::optional<Price> limit,
+                          Quantity quantity, OnFill &&on_fill) {
+  Levels &book = side == v1::BUY ? asks_ : bids_;
+  while (quantity > Quantity{} && !book.empty()) {
+    Level &level = book.back();
+    if (limit && !crosses(side, *limit, level.price))
+      break;
+
+    while (quantity > Quantity{} && level.head != kNil) {
+      const std::uint32_t slot = level.head;
+      Node &node = nodes_[slot];
+      const Quantity traded = std::min(quantity, node.leaves);
+      node.leaves -= traded;
+      level.total -= traded;
+      quantity -= traded;
+
+      const Fill fill{make_id(slot, node.generation), node.tag, level.price,
+                      traded, node.leaves};
+      if (node.leaves.is_zero()) {
+        unlink(level, slot);
+        release(slot);
+      }
+      on_fill(fill);
+    }
+
+    if (level.head == kNil)
+      book.pop_back();
+  }
+  return quantity;
+}
+
+} // namespace quarcc
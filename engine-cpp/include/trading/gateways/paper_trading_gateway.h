@@ -1,25 +1,89 @@
 #pragma once
 
+#include <trading/gateways/simulated_venue.h>
 #include <trading/interfaces/i_execution_gateway.h>
+#include <trading/utils/clock.h>
+#include <trading/utils/symbol_table.h>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 namespace quarcc {
 
-// Instant submission/cancelation/replacement/fills with custom local ids
+struct PaperGatewayOptions {
+  SimulatedVenueOptions venue;
+  // Starting mid per symbol; others start at venue.market.reference_price
+  std::unordered_map<std::string, Price> reference_prices;
+  // Called with each fill's price as get_fills() reports it, under the
+  // gateway lock, e.g. to update a MarkPriceCache
+  std::function<void(SymbolId, Price)> on_price;
+  // When set, venue time is this clock's time of day, which also stamps
+  // fills and broker ids; it must outlive the gateway. Otherwise the venue
+  // runs on the steady clock from construction and fills are stamped with
+  // the wall clock.
+  const IClock *clock = nullptr;
+};
+
+// Paper trading against a SimulatedVenue, by default on the steady clock.
+// Orders match against the venue's synthetic liquidity and each other, and
+// every fill carries its price. Orders for symbols missing from the symbol
+// table are refused.
+//
+// With no latency and a static synthetic market, fills can only happen inside
+// submit_order() and replace_order(), so the gateway pushes them. Otherwise
+// the venue moves on its own and set_fill_listener() declines, leaving the
+// caller to poll get_fills(), which is what runs the venue forward.
 class PaperGateway : public IExecutionGateway {
 public:
-  PaperGateway();
+  explicit PaperGateway(PaperGatewayOptions options = {},
+                        SymbolTable &symbols = SymbolTable::global());
 
   Result<BrokerOrderId> submit_order(const v1::Order &order) override;
   Result<std::monostate> cancel_order(const BrokerOrderId &orderId) override;
+  // Cancel and new, losing queue priority as most venues do
   Result<BrokerOrderId> replace_order(const BrokerOrderId &orderId,
                                       const v1::Order &new_order) override;
   std::vector<v1::ExecutionReport> get_fills() override;
+  bool set_fill_listener(FillListener listener) override;
+  // The venue's last price, else the mid the symbol starts at
+  std::optional<Price> reference_price(const std::string &symbol) override;
+
+  // Expires resting and stopped DAY orders
+  void end_session();
+
+protected:
+  // Calls f(SimulatedVenue &, VenueTime now) under the venue lock
+  template <typename F> decltype(auto) with_venue(F &&f) {
+    std::lock_guard lk{venue_mutex_};
+    return f(venue_, now());
+  }
+  // Whether every fill happens inside a call the gateway can signal from
+  virtual bool pushes_fills() const { return pushes_fills_; }
+  void notify_fill_ready();
 
 private:
+  Result<BrokerOrderId> submit_locked(const v1::Order &order, VenueTime now);
+  Result<VenueOrderId> find_locked(const BrokerOrderId &orderId) const;
+  VenueTime now() const;
+
 private:
-  std::unordered_map<BrokerOrderId, v1::Order> pending_orders_;
-  std::mutex orders_mutex_;
+  SymbolTable *symbols_;
+  const bool pushes_fills_;
+  const std::chrono::steady_clock::time_point start_;
+  const IClock *clock_;
+
+  std::mutex venue_mutex_;
+  SimulatedVenue venue_;
+  // Broker id value -> venue order, until the venue reports the order closed
+  std::unordered_map<std::uint64_t, VenueOrderId> open_orders_;
+  std::vector<VenueReport> reports_; // reused by get_fills()
+
   OrderIdGenerator id_gen_;
+  FillListener fill_listener_;
+  std::function<void(SymbolId, Price)> on_price_;
 };
 
 } // namespace quarcc
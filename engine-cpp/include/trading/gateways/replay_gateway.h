@@ -0,0 +1,70 @@
+#pragma once
+
+#include <trading/gateways/paper_trading_gateway.h>
+#include <trading/marketdata/tick_replay.h>
+
+#include <functional>
+#include <memory>
+#include <optional>
+
+namespace quarcc {
+
+struct ReplayGatewayOptions {
+  // The synthetic market only prices symbols until their first quote; with
+  // no levels, orders find no liquidity before it
+  SimulatedVenueOptions venue{.market = {.levels = 0},
+                              .order_latency = {},
+                              .report_latency = {}};
+  // Called with each trade price and quote mid as it is replayed, under the
+  // gateway lock, e.g. to update a MarkPriceCache. One-sided quotes have no
+  // mid and are not reported.
+  std::function<void(SymbolId, Price)> on_price;
+  // Moved to each tick's time as it is replayed, so a backtest can run every
+  // component on it; must outlive the gateway. The gateway keeps its own
+  // when null.
+  SimulatedClock *clock = nullptr;
+};
+
+// Paper trading against historical trades and quotes from a TickFile. Each
+// quote replaces the venue's liquidity for its symbol and each trade fills
+// resting orders it prints through, so fills happen at replayed prices.
+//
+// Time is the replay's: the clock is moved to the first tick on construction
+// and then only with step() and replay_until(), which are what generate
+// fills. Fills are pushed to the listener from those calls.
+class ReplayGateway : public PaperGateway {
+public:
+  explicit ReplayGateway(std::shared_ptr<const TickFile> ticks,
+                         ReplayGatewayOptions options = {},
+                         SymbolTable &symbols = SymbolTable::global());
+
+  // Replays the next tick and returns it, or nullptr at the end of the file
+  const TickRecord *step();
+  // Replays every tick up to and including `until`, then moves the clock to
+  // `until`. Returns the ticks replayed.
+  std::size_t replay_until(VenueTime until);
+
+  VenueTime time() const;
+  const SimulatedClock &clock() const { return *clock_; }
+  // Timestamp of the next tick, if any
+  std::optional<VenueTime> next_time();
+  bool done();
+  SymbolId symbol(const TickRecord &record) const {
+    return replay_.symbol(record);
+  }
+
+protected:
+  bool pushes_fills() const override { return true; }
+
+private:
+  void replay_locked(SimulatedVenue &venue, const TickRecord &record);
+
+private:
+  std::mutex replay_mutex_; // serializes replay_ against concurrent steps
+  TickReplay replay_;
+  std::function<void(SymbolId, Price)> on_price_;
+  SimulatedClock own_clock_;
+  SimulatedClock *clock_;
+};
+
+} // namespace quarcc
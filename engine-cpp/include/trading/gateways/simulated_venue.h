@@ -0,0 +1,256 @@
+#pragma once
+
+#include "order.pb.h"
+
+#include <trading/gateways/order_book.h>
+#include <trading/utils/fixed_point.h>
+#include <trading/utils/result.h>
+#include <trading/utils/split_mix.h>
+#include <trading/utils/symbol_table.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace quarcc {
+
+// Venue time, from an epoch of the caller's choosing
+using VenueTime = std::chrono::nanoseconds;
+// Same packing as BookOrderId: pool slot low, generation high
+using VenueOrderId = std::uint64_t;
+
+// One-way delay of every message in one direction: `base` plus a uniform draw
+// from [0, jitter]. Messages still arrive in the order they were sent, as
+// over a single session.
+struct LatencyModel {
+  std::chrono::nanoseconds base{0};
+  std::chrono::nanoseconds jitter{0};
+
+  bool is_zero() const { return base.count() == 0 && jitter.count() == 0; }
+};
+
+// Liquidity the venue quotes itself around a mid price, so client orders have
+// something to trade against: `levels` price levels a side, `level_size`
+// each, the best `half_spread_ticks` from the mid.
+struct SyntheticMarket {
+  Price reference_price = Price::from_raw(100 * Price::scale); // starting mid
+  Price tick = Price::from_raw(Price::scale / 100);
+  std::uint32_t half_spread_ticks = 1;
+  std::uint32_t levels = 10;
+  Quantity level_size = Quantity::from_raw(1'000 * Quantity::scale);
+  // Zero keeps the mid fixed and tops up whatever was taken before each
+  // order. Otherwise the mid moves up to max_step_ticks either way every
+  // interval and the quotes are replaced, trading with any client orders
+  // they cross.
+  std::chrono::nanoseconds step_interval{0};
+  std::uint32_t max_step_ticks = 1;
+};
+
+struct SimulatedVenueOptions {
+  SyntheticMarket market;
+  LatencyModel order_latency;  // client to venue
+  LatencyModel report_latency; // venue to client
+  std::uint64_t seed = 0;
+};
+
+struct VenueOrder {
+  SymbolId symbol = 0;
+  v1::Side side = v1::UNKNOWN_SIDE;
+  v1::OrderType type = v1::MARKET;
+  v1::TimeInForce time_in_force = v1::DAY;
+  Quantity quantity;
+  // The limit for LIMIT, the trigger for STOP and both for STOP_LIMIT
+  Price price;
+};
+
+struct VenueReport {
+  enum class Kind : std::uint8_t {
+    Fill,
+    Cancelled, // by request, at end of session, or an IOC/FOK/market remainder
+  };
+
+  Kind kind = Kind::Fill;
+  VenueOrderId order = 0;
+  std::uint64_t tag = 0; // as given to submit()
+  SymbolId symbol = 0;
+  v1::Side side = v1::UNKNOWN_SIDE;
+  Price price;       // fills only
+  Quantity quantity; // filled, or cancelled
+  Quantity leaves;   // still open; zero once the order is closed
+  std::uint64_t execution_id = 0; // fills only, counting from 1
+  VenueTime time{};               // when it happened at the venue
+
+  bool closes() const { return kind == Kind::Cancelled || leaves.is_zero(); }
+};
+
+// Deterministic single-threaded exchange simulator: an OrderBook per symbol
+// seeded with synthetic liquidity, MARKET/LIMIT/STOP/STOP_LIMIT orders with
+// DAY/GTC/IOC/FOK time in force, partial fills, and latency in both
+// directions. Stops trigger on the last trade, or on the mid when the
+// synthetic market moves.
+//
+// Time only moves when the caller says so, and all randomness comes from the
+// seeded generator, so the same calls with the same times and seed produce
+// the same reports. Client orders sit in a pooled array alongside the books;
+// after warm-up nothing allocates per order.
+class SimulatedVenue {
+public:
+  // Throws std::runtime_error for a non-positive tick, reference price or
+  // level size, or a zero half spread
+  explicit SimulatedVenue(SimulatedVenueOptions options = {});
+
+  // Starting mid for `symbol`. Only takes effect before its first order.
+  void set_reference_price(SymbolId symbol, Price price);
+
+  // Sends an order, which reaches the venue after the order latency.
+  // Malformed orders fail here and never reach a book. `tag` is echoed in
+  // the order's reports.
+  Result<VenueOrderId> submit(const VenueOrder &order, std::uint64_t tag,
+                              VenueTime now);
+  // Fails once the venue has closed the order, even if the report saying so
+  // has not been delivered yet
+  Result<std::monostate> cancel(VenueOrderId id, VenueTime now);
+
+  // Runs the venue up to `now`, in time order: arriving orders and cancels,
+  // and steps of the synthetic market
+  void advance(VenueTime now);
+  // Appends the reports delivered by `now` in the order they happened and
+  // returns how many
+  std::size_t drain(VenueTime now, std::vector<VenueReport> &out);
+  // Runs up to `now`, then closes every DAY order, resting or stopped
+  void end_session(VenueTime now);
+
+  // Replayed market data, each running the venue up to `now` first. The
+  // first quote for a symbol turns off its synthetic market: from then on
+  // the venue's own liquidity is the quoted bid and ask, replaced by each
+  // quote and not refilled in between.
+  void quote(SymbolId symbol, Price bid, Quantity bid_size, Price ask,
+             Quantity ask_size, VenueTime now);
+  // A print at `price`. Client orders priced strictly better fill at their
+  // limit, up to `size` a side, and stops see it as the last trade.
+  void trade(SymbolId symbol, Price price, Quantity size, VenueTime now);
+
+  bool is_open(VenueOrderId id) const;
+  std::optional<Quantity> leaves(VenueOrderId id) const;
+  // Last trade, or the mid after the synthetic market last moved
+  std::optional<Price> last_price(SymbolId symbol) const;
+  // last_price(), or the mid the symbol's market starts at if it has none
+  // yet. Any id is accepted.
+  Price reference_price(SymbolId symbol) const;
+  const OrderBook *book(SymbolId symbol) const;
+  // Orders and cancels sent but not yet arrived
+  std::size_t in_flight() const { return inbound_.size(); }
+  // Reports not yet drained
+  std::size_t undelivered() const { return outbound_.size(); }
+
+private:
+  static constexpr std::uint64_t kSyntheticTag = ~std::uint64_t{0};
+
+  enum class State : std::uint8_t { Free, InFlight, Stopped, Resting };
+
+  struct ClientOrder {
+    VenueOrder order;
+    std::uint64_t tag = 0;
+    Quantity leaves;
+    BookOrderId resting = OrderBook::kNoOrder;
+    std::uint32_t generation = 0;
+    State state = State::Free;
+  };
+
+  struct Message {
+    VenueTime arrival;
+    VenueOrderId order;
+    bool cancel;
+  };
+
+  struct Delivery {
+    VenueTime visible;
+    VenueReport report;
+  };
+
+  struct Market {
+    OrderBook book;
+    Price mid;
+    std::optional<Price> last;
+    // Synthetic liquidity: the bid of level i at 2i and its ask at 2i + 1
+    std::vector<BookOrderId> quotes;
+    std::vector<std::size_t> hit; // quotes traded with since last posted
+    bool replayed = false;        // quotes come from quote(), not the mid
+    VenueTime next_step{};
+    std::vector<VenueOrderId> stops; // waiting to trigger, oldest first
+  };
+
+  // FIFO over a vector that is reused rather than reallocated once grown
+  template <typename T> class Fifo {
+  public:
+    bool empty() const { return head_ == items_.size(); }
+    std::size_t size() const { return items_.size() - head_; }
+    const T &front() const { return items_[head_]; }
+    void pop() {
+      if (++head_ == items_.size()) {
+        items_.clear();
+        head_ = 0;
+      }
+    }
+    void push(T item) {
+      if (head_ >= kCompactAfter && head_ * 2 >= items_.size()) {
+        items_.erase(items_.begin(),
+                     items_.begin() + static_cast<std::ptrdiff_t>(head_));
+        head_ = 0;
+      }
+      items_.push_back(std::move(item));
+    }
+
+  private:
+    static constexpr std::size_t kCompactAfter = 1024;
+    std::vector<T> items_;
+    std::size_t head_ = 0;
+  };
+
+  ClientOrder *lookup(VenueOrderId id);
+  const ClientOrder *lookup(VenueOrderId id) const;
+  static VenueOrderId make_id(std::uint32_t slot, std::uint32_t generation) {
+    return std::uint64_t{generation} << 32 | slot;
+  }
+  void release(VenueOrderId id);
+
+  VenueTime delay(const LatencyModel &latency);
+  Price starting_mid(SymbolId symbol) const;
+  Market &market(SymbolId symbol, VenueTime now);
+  void catch_up(Market &market, VenueTime now);
+  void step(Market &market, VenueTime now);
+  void requote(Market &market, VenueTime now);
+  void refill(Market &market, VenueTime now);
+  void post_quote(Market &market, std::size_t index, VenueTime now);
+  void post(Market &market, std::size_t index, v1::Side side, Price price,
+            Quantity size, VenueTime now);
+
+  void process(const Message &message);
+  void arrive(Market &market, VenueOrderId id, VenueTime now);
+  // Takes liquidity for an order that has arrived or whose stop triggered,
+  // then rests, cancels or releases what is left
+  void execute(Market &market, VenueOrderId id, VenueTime now);
+  void trigger_stops(Market &market, VenueTime now);
+  void on_fill(Market &market, VenueOrderId taker, const OrderBook::Fill &fill,
+               VenueTime now);
+  void close(Market &market, VenueOrderId id, VenueTime now);
+  void report(VenueReport report);
+
+  SimulatedVenueOptions options_;
+  SplitMix64 rng_;
+  std::unordered_map<SymbolId, Price> reference_prices_;
+  std::vector<std::unique_ptr<Market>> markets_; // by SymbolId
+  std::vector<ClientOrder> orders_;
+  std::vector<std::uint32_t> free_orders_;
+  Fifo<Message> inbound_;
+  Fifo<Delivery> outbound_;
+  VenueTime last_arrival_{};
+  VenueTime last_visible_{};
+  std::uint64_t executions_ = 0;
+};
+
+} // namespace quarcc
@@ -4,66 +4,114 @@
 #include "execution_service.pb.h"
 
 #include <grpcpp/grpcpp.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <trading/interfaces/i_execution_service_handler.h>
 
 namespace quarcc {
 
+struct gRPCServerOptions {
+  // Completion queues, each drained by `pollers_per_cq` threads. Calls never
+  // own a thread: order-path RPCs are handed to the strategy workers and
+  // completed from there.
+  int num_cqs = 1;
+  int pollers_per_cq = 2;
+  // HTTP/2 concurrent stream cap per client connection (0 = gRPC default)
+  int max_concurrent_streams = 0;
+};
+
+enum class RpcMethod : std::uint8_t {
+  SubmitSignal = 0,
+  CancelOrder,
+  ReplaceOrder,
+  StreamSignals,
+  GetPosition,
+  GetAllPositions,
+  ActivateKillSwitch,
+  Count
+};
+
+const char *rpc_method_to_string(RpcMethod method);
+
+// Per-method call counters. `in_flight` is the queue depth: calls accepted by
+// the server that have not been answered yet (including those waiting in a
+// strategy worker's inbox). For StreamSignals it counts open streams.
+struct RpcMethodStats {
+  std::uint64_t started = 0;
+  std::uint64_t completed = 0;
+  std::int64_t in_flight = 0;
+  std::int64_t peak_in_flight = 0;
+};
+
+// Async (completion-queue) implementation of v1::ExecutionService.
 class gRPCServer {
 public:
-  gRPCServer(std::string server_address, IExecutionServiceHandler &handler);
+  gRPCServer(std::string server_address, IExecutionServiceHandler &handler,
+             gRPCServerOptions options = {});
+  ~gRPCServer();
 
   void start();
   void wait();
   void shutdown();
 
-private:
-  class ExecutionServiceImpl final : public v1::ExecutionService::Service {
-  public:
-    explicit ExecutionServiceImpl(gRPCServer *owner);
-
-    grpc::Status SubmitSignal(grpc::ServerContext *context,
-                              const v1::StrategySignal *request,
-                              v1::SubmitSignalResponse *response) override;
-
-    grpc::Status CancelOrder(grpc::ServerContext *context,
-                             const v1::CancelSignal *request,
-                             v1::CancelOrderResponse *response) override;
+  // The port start() bound; the one the OS picked if the address gave 0
+  int port() const { return port_; }
 
-    grpc::Status ReplaceOrder(grpc::ServerContext *context,
-                              const v1::ReplaceSignal *request,
-                              v1::ReplaceOrderResponse *response) override;
+  RpcMethodStats method_stats(RpcMethod method) const;
 
-    grpc::Status StreamSignals(
-        grpc::ServerContext *context,
-        grpc::ServerReaderWriter<v1::SubmitSignalResponse, v1::StrategySignal>
-            *stream) override;
+private:
+  class CallBase;
+  template <typename Request, typename Response> class UnaryCall;
+  class StreamSignalsCall;
+
+  struct MethodCounters {
+    std::atomic<std::uint64_t> started{0};
+    std::atomic<std::uint64_t> completed{0};
+    std::atomic<std::int64_t> in_flight{0};
+    std::atomic<std::int64_t> peak_in_flight{0};
+  };
 
-    grpc::Status GetPosition(grpc::ServerContext *context,
-                             const v1::GetPositionRequest *request,
-                             v1::Position *response) override;
+  void arm_calls(grpc::ServerCompletionQueue *cq);
+  void poll(grpc::ServerCompletionQueue *cq);
 
-    grpc::Status GetAllPositions(grpc::ServerContext *context,
-                                 const v1::Empty *request,
-                                 v1::PositionList *response) override;
+  void on_call_started(RpcMethod method);
+  void on_call_completed(RpcMethod method);
 
-    grpc::Status ActivateKillSwitch(grpc::ServerContext *context,
-                                    const v1::KillSwitchRequest *request,
-                                    v1::Empty *response) override;
-
-  private:
-    gRPCServer *owner_ = nullptr;
-  };
+  void handle_submit_signal(UnaryCall<v1::StrategySignal,
+                                      v1::SubmitSignalResponse> &call);
+  void handle_cancel_order(UnaryCall<v1::CancelSignal,
+                                     v1::CancelOrderResponse> &call);
+  void handle_replace_order(UnaryCall<v1::ReplaceSignal,
+                                      v1::ReplaceOrderResponse> &call);
+  void handle_get_position(UnaryCall<v1::GetPositionRequest, v1::Position> &call);
+  void handle_get_all_positions(UnaryCall<v1::Empty, v1::PositionList> &call);
+  void handle_kill_switch(UnaryCall<v1::KillSwitchRequest, v1::Empty> &call);
 
 private:
-  friend class ExecutionServiceImpl;
-
   std::string server_address_;
+  int port_ = 0;
   IExecutionServiceHandler *handler_ = nullptr;
-  std::unique_ptr<ExecutionServiceImpl> service_;
+  gRPCServerOptions options_;
+
+  v1::ExecutionService::AsyncService service_;
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> cqs_;
+  std::vector<std::thread> pollers_;
   std::unique_ptr<grpc::Server> server_;
+
+  // Call objects still registered with a completion queue (armed, being
+  // handled or finishing). shutdown() waits for this to drop to zero before
+  // closing the queues, since late handlers still finish on them.
+  std::atomic<std::int64_t> live_calls_{0};
+  bool shut_down_ = false;
+  std::array<MethodCounters, static_cast<std::size_t>(RpcMethod::Count)>
+      counters_;
 };
 
 } // namespace quarcc
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+
+namespace quarcc {
+
+// Where components read the time instead of calling std::chrono clocks
+// directly, so a backtest can run them all on one simulated clock.
+class IClock {
+public:
+  using WallTime = std::chrono::system_clock::time_point;
+  using SteadyTime = std::chrono::steady_clock::time_point;
+
+  virtual ~IClock() = default;
+
+  // Time of day, for timestamps and order ids
+  virtual WallTime now() const = 0;
+  // Monotonic time, for timeouts and grace periods
+  virtual SteadyTime steady_now() const = 0;
+};
+
+} // namespace quarcc
@@ -1,15 +1,24 @@
 #pragma once
 
+#include <trading/utils/fixed_point.h>
 #include <trading/utils/order_id_generator.h>
 #include <trading/utils/result.h>
 
 #include "execution.pb.h"
 #include "order.pb.h"
 
+#include <functional>
+#include <optional>
+
 namespace quarcc {
 
 class IExecutionGateway {
 public:
+  // Invoked by push-capable gateways whenever a new execution report becomes
+  // available through get_fills(). Must be cheap and must not call back into
+  // the gateway.
+  using FillListener = std::function<void()>;
+
   virtual ~IExecutionGateway() = default;
 
   virtual Result<BrokerOrderId> submit_order(const v1::Order &order) = 0;
@@ -17,6 +26,21 @@ public:
   virtual Result<BrokerOrderId> replace_order(const BrokerOrderId &orderId,
                                               const v1::Order &new_order) = 0;
   virtual std::vector<v1::ExecutionReport> get_fills() = 0;
+
+  // Registers the push-delivery callback. Returns false when the gateway
+  // cannot push, in which case callers must keep polling get_fills().
+  virtual bool set_fill_listener(FillListener listener) {
+    (void)listener;
+    return false;
+  }
+
+  // The price a market order for `symbol` would be expected to trade near,
+  // if the gateway knows one. Used to value orders for risk checks before
+  // any market data has arrived.
+  virtual std::optional<Price> reference_price(const std::string &symbol) {
+    (void)symbol;
+    return std::nullopt;
+  }
 };
 
 } // namespace quarcc
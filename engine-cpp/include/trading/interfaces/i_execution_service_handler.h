@@ -5,11 +5,14 @@
 #include <trading/utils/order_id_generator.h>
 #include <trading/utils/result.h>
 
+#include <functional>
 #include <variant>
 
 namespace quarcc {
 
 struct IExecutionServiceHandler {
+  template <typename T> using Completion = std::function<void(Result<T>)>;
+
   virtual ~IExecutionServiceHandler() = default;
 
   virtual Result<BrokerOrderId> SubmitSignal(const v1::StrategySignal &req) = 0;
@@ -20,7 +23,26 @@ struct IExecutionServiceHandler {
   virtual Result<v1::PositionList> GetAllPositions(const v1::Empty &req) = 0;
   virtual Result<std::monostate>
   ActivateKillSwitch(const v1::KillSwitchRequest &req) = 0;
-  // TODO: Stream services(?)
+
+  // Non-blocking variants of the order-path calls and the kill switch, used
+  // by the async gRPC server. `done` may be invoked on any thread. The
+  // defaults simply run the blocking call inline.
+  virtual void SubmitSignalAsync(const v1::StrategySignal &req,
+                                 Completion<BrokerOrderId> done) {
+    done(SubmitSignal(req));
+  }
+  virtual void CancelOrderAsync(const v1::CancelSignal &req,
+                                Completion<std::monostate> done) {
+    done(CancelOrder(req));
+  }
+  virtual void ReplaceOrderAsync(const v1::ReplaceSignal &req,
+                                 Completion<BrokerOrderId> done) {
+    done(ReplaceOrder(req));
+  }
+  virtual void ActivateKillSwitchAsync(const v1::KillSwitchRequest &req,
+                                       Completion<std::monostate> done) {
+    done(ActivateKillSwitch(req));
+  }
 };
 
 } // namespace quarcc
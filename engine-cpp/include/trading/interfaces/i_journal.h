@@ -2,6 +2,8 @@
 
 #include <chrono>
 #include <cstdint>
+#include <cstdio>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -87,26 +89,54 @@ struct LogEntry {
   std::string data;
   std::string correlation_id;
 
+  // The system clock; journals stamp entries from the IClock they are given
   static Timestamp now() { return std::chrono::system_clock::now(); }
 
+  // Storage form: nanoseconds since the Unix epoch
+  static std::int64_t to_nanos(Timestamp ts) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               ts.time_since_epoch())
+        .count();
+  }
+
+  static Timestamp from_nanos(std::int64_t ns) {
+    return Timestamp(std::chrono::duration_cast<Timestamp::duration>(
+        std::chrono::nanoseconds{ns}));
+  }
+
+  // Display/export only: "YYYY-MM-DD HH:MM:SS.mmm" in UTC
   static std::string timestamp_to_string(Timestamp ts) {
-    auto time_t = std::chrono::system_clock::to_time_t(ts);
-    std::tm tm = *std::gmtime(&time_t);
-    char buffer[32];
-    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+    using namespace std::chrono;
+    const auto day = floor<days>(ts);
+    const year_month_day ymd{day};
+    const hh_mm_ss hms{floor<milliseconds>(ts - day)};
 
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                  ts.time_since_epoch()) %
-              1000;
-    return std::string(buffer) + "." + std::to_string(ms.count());
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u %02d:%02d:%02d.%03d",
+                  static_cast<int>(ymd.year()),
+                  static_cast<unsigned>(ymd.month()),
+                  static_cast<unsigned>(ymd.day()),
+                  static_cast<int>(hms.hours().count()),
+                  static_cast<int>(hms.minutes().count()),
+                  static_cast<int>(hms.seconds().count()),
+                  static_cast<int>(hms.subseconds().count()));
+    return buffer;
   }
 
-  // TODO: More robust parser
+  // Inverse of timestamp_to_string, read as UTC. The fraction is taken as a
+  // millisecond count, which also matches the unpadded form older builds
+  // wrote ("...:05.7" meaning 7 ms). Returns the epoch if `str` is malformed.
   static Timestamp string_to_timestamp(const std::string &str) {
-    std::tm tm = {};
-    std::istringstream ss(str);
-    ss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    using namespace std::chrono;
+    int y = 0, mo = 0, d = 0, h = 0, mi = 0, sec = 0, ms = 0;
+    if (std::sscanf(str.c_str(), "%d-%d-%d %d:%d:%d.%d", &y, &mo, &d, &h, &mi,
+                    &sec, &ms) < 6)
+      return Timestamp{};
+
+    const sys_days day = year{y} / month{static_cast<unsigned>(mo)} /
+                         std::chrono::day{static_cast<unsigned>(d)};
+    return time_point_cast<Timestamp::duration>(
+        day + hours{h} + minutes{mi} + seconds{sec} + milliseconds{ms});
   }
 };
 
@@ -125,6 +155,17 @@ public:
   get_order_history(const std::string &order_id) = 0;
 
   virtual void flush() = 0;
+
+  // Id of the newest entry, 0 while the journal is empty. Ids increase in
+  // log order, so unlike timestamps they tell apart entries logged at the
+  // same instant. Waits for entries still queued to be written.
+  virtual std::uint64_t last_id() = 0;
+
+  // Returns once everything logged so far has been written as far as a
+  // synchronous log() writes it, so it lands before anything the caller
+  // writes elsewhere next. Cheaper than flush(); journals whose log() writes
+  // through need not override it.
+  virtual void barrier() {}
 };
 
 } // namespace quarcc
@@ -2,6 +2,8 @@
 
 #include "order.pb.h"
 #include <optional>
+#include <trading/interfaces/i_journal.h>
+#include <trading/utils/fixed_point.h>
 #include <trading/utils/result.h>
 #include <vector>
 
@@ -44,15 +46,54 @@ inline const char *order_status_to_string(OrderStatus status) {
   }
 }
 
+// No further status changes or fills are expected once an order is here
+inline bool is_terminal(OrderStatus status) {
+  switch (status) {
+  case OrderStatus::FILLED:
+  case OrderStatus::CANCELLED:
+  case OrderStatus::REPLACED:
+  case OrderStatus::REJECTED:
+  case OrderStatus::EXPIRED:
+    return true;
+  default:
+    return false;
+  }
+}
+
 struct StoredOrder {
   v1::Order order;
   OrderStatus status;
   std::string local_id;
   std::optional<std::string> broker_id;
-  std::string created_at;
-  std::optional<std::string> updated_at;
-  double filled_quantity = 0.0;
-  double avg_fill_price = 0.0;
+  Timestamp created_at;
+  std::optional<Timestamp> updated_at;
+  Quantity filled_quantity;
+  Price avg_fill_price;
+};
+
+// One execution applied to a stored order
+struct FillUpdate {
+  std::string local_id;
+  Quantity delta_qty; // quantity of this execution, not the cumulative
+  Price price;
+  OrderStatus new_status = OrderStatus::PARTIALLY_FILLED;
+};
+
+// Positions as of `taken_at`, including every journal entry up to
+// `journal_id`. Journal fills logged after that entry are replayed on top of
+// it during recovery. Snapshots saved before journal ids were recorded have
+// none, and are replayed from fills logged after `taken_at`.
+struct PositionSnapshot {
+  struct Entry {
+    std::string symbol;
+    Quantity quantity;
+    Price avg_price;
+    Money realized_pnl;
+  };
+
+  Timestamp taken_at{};
+  std::vector<Entry> positions;
+  std::optional<std::uint64_t> journal_id;
 };
 
 class IOrderStore {
@@ -66,11 +107,25 @@ public:
   update_broker_id(const std::string &local_id,
                    const std::string &broker_id) = 0;
   virtual Result<std::monostate> update_fill_info(const std::string &local_id,
-                                                  double filled_quantity,
-                                                  double avg_price) = 0;
+                                                  Quantity filled_quantity,
+                                                  Price avg_price) = 0;
+  // Adds delta_qty to filled_quantity, folds price into the volume-weighted
+  // avg_fill_price and sets the status, all as one atomic update.
+  virtual Result<std::monostate> apply_fill(const std::string &local_id,
+                                            Quantity delta_qty, Price price,
+                                            OrderStatus new_status) = 0;
+  // apply_fill for every update, in order, in a single transaction
+  virtual Result<std::monostate>
+  apply_fills(const std::vector<FillUpdate> &updates) = 0;
   virtual Result<StoredOrder> get_order(const std::string &local_id) = 0;
   virtual std::vector<StoredOrder> get_open_orders() = 0;
   virtual std::vector<StoredOrder> get_orders_by_status(OrderStatus status) = 0;
+
+  // Replaces the stored snapshot atomically
+  virtual Result<std::monostate>
+  save_position_snapshot(const PositionSnapshot &snapshot) = 0;
+  // Fails if no snapshot was ever saved
+  virtual Result<PositionSnapshot> load_position_snapshot() = 0;
 };
 
 } // namespace quarcc
@@ -1,7 +1,95 @@
 #pragma once
 
+#include "common.pb.h"
+
+#include <trading/utils/fixed_point.h>
+#include <trading/utils/result.h>
+#include <trading/utils/symbol_table.h>
+
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
 namespace quarcc {
 
-class RiskManager {};
+// Limits on a single order, and on the firm-wide position, in one symbol.
+// Every limit defaults to "none".
+struct SymbolRiskLimits {
+  Quantity max_order_quantity = Quantity::max();
+  Money max_order_notional = Money::max();
+  Quantity max_position = Quantity::max(); // long or short
+};
+
+struct StrategyRiskLimits {
+  Quantity max_position = Quantity::max(); // in any one symbol, long or short
+};
+
+// Everything the pre-trade checks compare against. Per-symbol limits live in
+// a flat array indexed by SymbolId, so a check reads one small struct.
+struct RiskLimits {
+  SymbolRiskLimits default_symbol;
+  std::vector<SymbolRiskLimits> symbols;
+  StrategyRiskLimits default_strategy;
+  std::unordered_map<std::string, StrategyRiskLimits> strategies;
+  Money max_gross_exposure = Money::max();
+  Money max_net_exposure = Money::max(); // long or short
+
+  // Symbols the array grows past get default_symbol, so set that first
+  void set_symbol(SymbolId symbol, const SymbolRiskLimits &limits) {
+    if (symbol >= symbols.size())
+      symbols.resize(symbol + 1, default_symbol);
+    symbols[symbol] = limits;
+  }
+
+  const SymbolRiskLimits &for_symbol(SymbolId symbol) const {
+    return symbol < symbols.size() ? symbols[symbol] : default_symbol;
+  }
+
+  const StrategyRiskLimits &
+  for_strategy(const std::string &strategy_id) const {
+    auto it = strategies.find(strategy_id);
+    return it != strategies.end() ? it->second : default_strategy;
+  }
+};
+
+// An order as the checks see it, already converted to fixed point
+struct RiskOrder {
+  SymbolId symbol = 0;
+  v1::Side side = v1::Side::UNKNOWN_SIDE;
+  Quantity quantity;
+  // Limit price, else the symbol's last mark; zero if neither is known
+  Price reference_price;
+
+  Quantity signed_quantity() const {
+    return side == v1::Side::SELL ? -quantity : quantity;
+  }
+};
+
+// The limits and positions in effect for one order. Positions are read once,
+// lock-free, before the checks run.
+struct RiskContext {
+  const RiskLimits &limits;
+  const SymbolRiskLimits &symbol_limits;
+  const StrategyRiskLimits &strategy_limits;
+  Quantity strategy_position; // this strategy, in the order's symbol
+  Quantity firm_position;     // all strategies, in the order's symbol
+  Money firm_market_value;    // of the firm's position in the order's symbol
+  Money gross_exposure;
+  Money net_exposure;
+  // Open orders on the order's side, signed like a position; the position
+  // checks project the position as if they and the order had filled
+  Quantity strategy_working;
+  Quantity firm_working;
+};
+
+class IRiskCheck {
+public:
+  virtual ~IRiskCheck() = default;
+
+  // Fails with ErrorType::RiskRejected and the reason the order was refused
+  virtual Result<std::monostate> check(const RiskOrder &order,
+                                       const RiskContext &context) const = 0;
+};
 
 } // namespace quarcc
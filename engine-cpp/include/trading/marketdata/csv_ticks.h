@@ -0,0 +1,27 @@
+#pragma once
+
+#include <trading/marketdata/tick_file.h>
+#include <trading/utils/result.h>
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string_view>
+
+namespace quarcc {
+
+// Reads CSV ticks into `writer`, one per line:
+//
+//   timestamp,symbol,kind,price,size[,ask_price,ask_size]
+//
+// `kind` is T for a trade or Q for a quote, whose price and size are the bid
+// side. A first line that is not a tick is skipped as a header; any other
+// bad line fails the read with its line number. Returns the ticks read.
+Result<std::size_t> read_csv_ticks(std::istream &in, TickFileWriter &writer);
+
+// Integer nanoseconds since the Unix epoch, or ISO 8601 UTC with up to nine
+// fractional digits: 2024-01-02T14:30:00.123456789Z (the T may be a space,
+// the Z may be left out)
+std::optional<std::int64_t> parse_timestamp_ns(std::string_view text);
+
+} // namespace quarcc
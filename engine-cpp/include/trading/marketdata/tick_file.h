@@ -0,0 +1,96 @@
+#pragma once
+
+#include <trading/utils/fixed_point.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace quarcc {
+
+enum class TickKind : std::uint8_t {
+  Trade = 1,
+  Quote = 2,
+};
+
+// One record of a tick file, stored as is, so the mapped file is read in
+// place. Prices and sizes are the raw Price / Quantity representations.
+struct TickRecord {
+  std::int64_t timestamp_ns;  // since the Unix epoch
+  std::int64_t price_raw;     // trade price, or bid
+  std::int64_t size_raw;      // trade size, or bid size
+  std::int64_t ask_price_raw; // quotes only
+  std::int64_t ask_size_raw;  // quotes only
+  std::uint32_t symbol;       // index into the file's symbol list
+  TickKind kind;
+  std::uint8_t reserved[3];
+
+  Price price() const { return Price::from_raw(price_raw); }
+  Quantity size() const { return Quantity::from_raw(size_raw); }
+  Price bid() const { return price(); }
+  Quantity bid_size() const { return size(); }
+  Price ask() const { return Price::from_raw(ask_price_raw); }
+  Quantity ask_size() const { return Quantity::from_raw(ask_size_raw); }
+};
+static_assert(sizeof(TickRecord) == 48);
+
+// Read-only view of a tick file through a shared mmap:
+//
+//   | 64-byte header | symbols: 16 bytes each, NUL padded | records |
+//
+// Records are sorted by timestamp. Nothing is parsed or copied per record,
+// so any number of readers, in any number of threads, can share one
+// TickFile. Throws std::runtime_error if the file cannot be mapped or its
+// header does not describe it. Record symbol indexes are not checked up
+// front, which would page in the whole file; readers bounds-check them.
+class TickFile {
+public:
+  static constexpr std::size_t kMaxSymbolLength = 16;
+
+  explicit TickFile(const std::filesystem::path &path);
+  ~TickFile();
+
+  TickFile(const TickFile &) = delete;
+  TickFile &operator=(const TickFile &) = delete;
+
+  std::span<const TickRecord> records() const { return records_; }
+  std::size_t symbol_count() const { return symbols_.size(); }
+  std::string_view symbol(std::uint32_t index) const {
+    return symbols_[index];
+  }
+
+private:
+  void *base_ = nullptr;
+  std::size_t size_ = 0;
+  std::vector<std::string_view> symbols_; // into the mapping
+  std::span<const TickRecord> records_;
+};
+
+// Builds tick files. Ticks can be added in any order; write() sorts them by
+// timestamp, keeping the order of ticks with equal timestamps.
+class TickFileWriter {
+public:
+  // Symbols longer than TickFile::kMaxSymbolLength throw std::runtime_error
+  void add_trade(std::int64_t timestamp_ns, std::string_view symbol,
+                 Price price, Quantity size);
+  void add_quote(std::int64_t timestamp_ns, std::string_view symbol,
+                 Price bid, Quantity bid_size, Price ask, Quantity ask_size);
+
+  std::size_t size() const { return records_.size(); }
+
+  // Throws std::runtime_error on I/O failure
+  void write(const std::filesystem::path &path);
+
+private:
+  std::uint32_t symbol_index(std::string_view symbol);
+
+  std::vector<std::string> symbols_;
+  std::unordered_map<std::string, std::uint32_t> symbol_indexes_;
+  std::vector<TickRecord> records_;
+};
+
+} // namespace quarcc
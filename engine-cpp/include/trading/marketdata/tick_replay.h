@@ -0,0 +1,45 @@
+#pragma once
+
+#include <trading/marketdata/tick_file.h>
+#include <trading/utils/symbol_table.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace quarcc {
+
+// Forward-only cursor over a shared TickFile, yielding records in place with
+// their symbols resolved to SymbolIds. Cursors are cheap; give each replay
+// its own over the same file.
+class TickReplay {
+public:
+  // Interns every symbol of `file` into `symbols` up front
+  explicit TickReplay(std::shared_ptr<const TickFile> file,
+                      SymbolTable &symbols = SymbolTable::global());
+
+  // The next record, or nullptr at the end. Records naming a symbol the
+  // file does not list are skipped and counted.
+  const TickRecord *peek();
+  const TickRecord *next();
+  bool done() { return peek() == nullptr; }
+
+  SymbolId symbol(const TickRecord &record) const {
+    return symbol_ids_[record.symbol];
+  }
+
+  // Moves to the first record at or after `timestamp_ns`
+  void seek(std::int64_t timestamp_ns);
+
+  std::size_t position() const { return position_; }
+  std::size_t size() const { return file_->records().size(); }
+  std::size_t skipped() const { return skipped_; }
+
+private:
+  std::shared_ptr<const TickFile> file_;
+  std::vector<SymbolId> symbol_ids_; // by file symbol index
+  std::size_t position_ = 0;
+  std::size_t skipped_ = 0;
+};
+
+} // namespace quarcc
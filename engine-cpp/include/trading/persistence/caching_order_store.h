@@ -0,0 +1,59 @@
+#pragma once
+
+#include <trading/interfaces/i_order_store.h>
+#include <trading/utils/clock.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace quarcc {
+
+// Write-through cache in front of another IOrderStore. Every non-terminal
+// order is kept in memory, so the fill path never reads from disk. Writes go
+// to the backing store first and only touch the cache once they succeed;
+// orders are evicted as soon as they reach a terminal status, after which
+// reads fall through to the backing store.
+class CachingOrderStore : public IOrderStore {
+public:
+  // Warm-loads the backing store's open orders. Cached updated_at times are
+  // read from `clock`, which must outlive the store; give the backing store
+  // the same one.
+  explicit CachingOrderStore(std::unique_ptr<IOrderStore> backing,
+                             const IClock &clock = SystemClock::instance());
+
+  Result<std::monostate> store_order(const StoredOrder &order) override;
+  Result<std::monostate> update_order_status(const std::string &local_id,
+                                             OrderStatus new_status) override;
+  Result<std::monostate>
+  update_broker_id(const std::string &local_id,
+                   const std::string &broker_id) override;
+  Result<std::monostate> update_fill_info(const std::string &local_id,
+                                          Quantity filled_quantity,
+                                          Price avg_price) override;
+  Result<std::monostate> apply_fill(const std::string &local_id,
+                                    Quantity delta_qty, Price price,
+                                    OrderStatus new_status) override;
+  Result<std::monostate>
+  apply_fills(const std::vector<FillUpdate> &updates) override;
+  Result<StoredOrder> get_order(const std::string &local_id) override;
+  std::vector<StoredOrder> get_open_orders() override;
+  std::vector<StoredOrder> get_orders_by_status(OrderStatus status) override;
+  Result<std::monostate>
+  save_position_snapshot(const PositionSnapshot &snapshot) override;
+  Result<PositionSnapshot> load_position_snapshot() override;
+
+  std::size_t cached_count() const;
+
+private:
+  // Caller holds mutex_
+  void apply_fill_to_cache(const FillUpdate &update);
+
+  std::unique_ptr<IOrderStore> backing_;
+  const IClock *clock_;
+
+  mutable std::mutex mutex_; // guards open_orders_
+  std::unordered_map<std::string, StoredOrder> open_orders_;
+};
+
+} // namespace quarcc
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <trading/interfaces/i_journal.h>
+#include <trading/persistence/memory_journal.h>
+#include <trading/persistence/mmap_journal.h>
+#include <trading/persistence/sqlite_journal.h>
+
+#include <memory>
+#include <string>
+
+namespace quarcc {
+
+enum class JournalBackend : std::uint8_t {
+  SQLite = 0,
+  Mmap,
+  Memory, // nothing persisted; for backtests
+};
+
+struct JournalConfig {
+  JournalBackend backend = JournalBackend::SQLite;
+  JournalOptions sqlite;   // SQLite backend only
+  MmapJournalOptions mmap; // Mmap backend only
+};
+
+// `path` is a base name: SQLite opens `<path>.db`, Mmap uses `<path>/` as its
+// segment directory, Memory ignores it. Entries are stamped from `clock`.
+std::unique_ptr<IJournal>
+make_journal(const std::string &path, const JournalConfig &config,
+             const IClock &clock = SystemClock::instance());
+
+} // namespace quarcc
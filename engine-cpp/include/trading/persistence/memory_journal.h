@@ -0,0 +1,46 @@
+#pragma once
+
+#include <trading/interfaces/i_journal.h>
+#include <trading/utils/clock.h>
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace quarcc {
+
+// IJournal kept in process memory and lost with it, for backtests and sweeps
+// where nothing has to survive the run. Entries are appended to one vector
+// with non-decreasing timestamps, so get_history is a binary search, and
+// indexed by correlation id for get_order_history. flush() does nothing.
+class MemoryJournal : public IJournal {
+public:
+  // Entries are stamped from `clock`, which must outlive the journal
+  explicit MemoryJournal(const IClock &clock = SystemClock::instance());
+
+  void log(Event event, const std::string &data,
+           const std::string &correlation_id = "") override;
+
+  std::vector<LogEntry>
+  get_history(Timestamp from, Timestamp to,
+              std::optional<Event> event_filter = std::nullopt) override;
+
+  std::vector<LogEntry> get_order_history(const std::string &order_id) override;
+
+  void flush() override {}
+  std::uint64_t last_id() override;
+
+  std::size_t size() const;
+
+private:
+  const IClock *clock_;
+
+  mutable std::mutex mutex_;
+  std::vector<LogEntry> entries_; // entries_[i].id == i + 1
+  std::unordered_map<std::string, std::vector<std::size_t>> by_correlation_;
+};
+
+} // namespace quarcc
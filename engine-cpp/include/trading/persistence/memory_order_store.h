@@ -0,0 +1,62 @@
+#pragma once
+
+#include <trading/interfaces/i_order_store.h>
+#include <trading/utils/clock.h>
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace quarcc {
+
+// IOrderStore kept in process memory, for backtests and sweeps where nothing
+// has to survive the run. Behaves like SQLiteOrderStore: storing a local id
+// twice fails, updates to unknown ids succeed without effect, fills fold into
+// the same volume-weighted average, and listings come back in creation order
+// (ties in the order stored, so runs on a simulated clock are repeatable).
+class MemoryOrderStore : public IOrderStore {
+public:
+  // updated_at times are read from `clock`, which must outlive the store
+  explicit MemoryOrderStore(const IClock &clock = SystemClock::instance());
+
+  Result<std::monostate> store_order(const StoredOrder &order) override;
+  Result<std::monostate> update_order_status(const std::string &local_id,
+                                             OrderStatus new_status) override;
+  Result<std::monostate>
+  update_broker_id(const std::string &local_id,
+                   const std::string &broker_id) override;
+  Result<std::monostate> update_fill_info(const std::string &local_id,
+                                          Quantity filled_quantity,
+                                          Price avg_price) override;
+  Result<std::monostate> apply_fill(const std::string &local_id,
+                                    Quantity delta_qty, Price price,
+                                    OrderStatus new_status) override;
+  Result<std::monostate>
+  apply_fills(const std::vector<FillUpdate> &updates) override;
+  Result<StoredOrder> get_order(const std::string &local_id) override;
+  std::vector<StoredOrder> get_open_orders() override;
+  std::vector<StoredOrder> get_orders_by_status(OrderStatus status) override;
+  Result<std::monostate>
+  save_position_snapshot(const PositionSnapshot &snapshot) override;
+  Result<PositionSnapshot> load_position_snapshot() override;
+
+  // Every order stored, terminal or not, in the order stored
+  std::vector<StoredOrder> get_all_orders() const;
+
+private:
+  // Caller holds mutex_; nullptr for unknown ids
+  StoredOrder *find(const std::string &local_id);
+  void apply_fill_locked(const FillUpdate &update);
+  template <typename Pred>
+  std::vector<StoredOrder> collect(Pred pred) const;
+
+  const IClock *clock_;
+
+  mutable std::mutex mutex_;
+  std::vector<StoredOrder> orders_;
+  std::unordered_map<std::string, std::size_t> index_; // into orders_
+  std::optional<PositionSnapshot> snapshot_;
+};
+
+} // namespace quarcc
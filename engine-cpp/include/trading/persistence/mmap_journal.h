@@ -0,0 +1,106 @@
+#pragma once
+
+#include <trading/interfaces/i_journal.h>
+#include <trading/utils/clock.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace quarcc {
+
+struct MmapJournalOptions {
+  // Bytes pre-allocated (and mapped) per segment file
+  std::size_t segment_size = 64 * 1024 * 1024;
+  // When non-zero, log() schedules an msync(MS_ASYNC) of the dirty range at
+  // most this often. flush() always does a synchronous msync.
+  std::chrono::milliseconds sync_interval{0};
+  // One time index entry every `time_index_stride` records
+  std::size_t time_index_stride = 64;
+  // Correlation index entries (one per record with a correlation id) kept in
+  // memory. Past this, the oldest rolled segments drop their index and
+  // get_order_history scans them instead. The segment being written to is
+  // always indexed.
+  std::size_t max_correlation_entries = 1 << 20;
+};
+
+// Append-only binary journal over memory-mapped segment files
+// (journal-00000000.seg, ...) in one directory. Each record is a fixed
+// 32-byte header (length, CRC-32, id, timestamp in ns, event, correlation id
+// length) followed by the correlation id and data, so log() is a memcpy into
+// the mapping. Segments are pre-allocated and rolled when full.
+//
+// Reads use per-segment in-memory indexes rebuilt at open: a sparse
+// timestamp -> offset index for get_history and a correlation id -> offsets
+// index for get_order_history, bounded by max_correlation_entries. On open,
+// records are validated by CRC and anything after the first bad record of a
+// segment is discarded.
+//
+// The directory is flock()ed for the journal's lifetime; opening a journal
+// another MmapJournal still holds throws.
+class MmapJournal : public IJournal {
+public:
+  // Records are stamped from `clock`, which must outlive the journal.
+  // sync_interval is paced by the real steady clock whatever `clock` is.
+  explicit MmapJournal(std::filesystem::path directory,
+                       MmapJournalOptions options = {},
+                       const IClock &clock = SystemClock::instance());
+  ~MmapJournal() override;
+
+  MmapJournal(const MmapJournal &) = delete;
+  MmapJournal &operator=(const MmapJournal &) = delete;
+
+  void log(Event event, const std::string &data,
+           const std::string &correlation_id = "") override;
+
+  std::vector<LogEntry>
+  get_history(Timestamp from, Timestamp to,
+              std::optional<Event> event_filter = std::nullopt) override;
+
+  std::vector<LogEntry> get_order_history(const std::string &order_id) override;
+
+  // msync(MS_SYNC) of everything, in any segment, not yet synced that way
+  void flush() override;
+  std::uint64_t last_id() override;
+
+  std::size_t segment_count() const;
+  // Entries currently held by the correlation index
+  std::size_t correlation_index_size() const;
+  // Bytes written that a crash of the machine could still lose
+  std::size_t unsynced_bytes() const;
+
+private:
+  struct Segment;
+
+  static std::unique_ptr<Segment> map_segment(const std::filesystem::path &path,
+                                              std::uint32_t index,
+                                              std::size_t create_size);
+  void recover();
+  void scan_segment(Segment &segment);
+  void roll_segment();
+  void index_record(Segment &segment, std::uint32_t offset,
+                    std::int64_t timestamp_ns,
+                    const std::string &correlation_id);
+  void sync(Segment &segment, int flags);
+  void sync_all();
+  void sync_directory();
+  void trim_correlation_index();
+
+  std::filesystem::path directory_;
+  int directory_fd_ = -1; // holds the flock
+  MmapJournalOptions options_;
+  const IClock *clock_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Segment>> segments_; // last one is written to
+  std::size_t correlation_entries_ = 0;
+  std::uint64_t next_id_ = 1;
+  std::int64_t last_timestamp_ns_ = 0;
+  std::chrono::steady_clock::time_point last_sync_;
+};
+
+} // namespace quarcc
@@ -1,14 +1,46 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <sqlite3.h>
+#include <thread>
 #include <trading/interfaces/i_journal.h>
+#include <trading/persistence/sqlite_statement.h>
+#include <trading/utils/clock.h>
+#include <vector>
 
 namespace quarcc {
 
+// Maps to PRAGMA synchronous: how often SQLite fsyncs on commit.
+enum class JournalSyncMode : std::uint8_t {
+  Off = 0,    // leave it to the OS; fastest, may lose recent entries on crash
+  Normal = 1, // fsync at WAL checkpoints only
+  Full = 2,   // fsync every commit (SQLite default)
+};
+
+struct JournalOptions {
+  // When true, log() only enqueues the entry; a background writer commits
+  // queued entries in batched transactions (group commit).
+  bool async = false;
+
+  // Async mode only. log() blocks while the ring buffer is full.
+  std::size_t queue_capacity = 8192;
+  // Maximum entries committed in a single transaction.
+  std::size_t max_batch = 512;
+  // How long the writer lets a partial batch accumulate before committing.
+  std::chrono::milliseconds max_delay{2};
+
+  JournalSyncMode sync = JournalSyncMode::Full;
+};
+
 class SQLiteJournal : public IJournal {
 public:
-  explicit SQLiteJournal(const std::string &db_path);
+  // Entries are stamped from `clock`, which must outlive the journal
+  explicit SQLiteJournal(const std::string &db_path,
+                         JournalOptions options = {},
+                         const IClock &clock = SystemClock::instance());
   ~SQLiteJournal() override;
 
   SQLiteJournal(const SQLiteJournal &) = delete;
@@ -23,13 +55,63 @@ public:
 
   std::vector<LogEntry> get_order_history(const std::string &order_id) override;
 
+  // Durability barrier: returns once every entry logged before the call has
+  // been committed, then checkpoints the WAL.
   void flush() override;
+  // Async mode: waits for the writer to commit what is queued
+  void barrier() override;
+  std::uint64_t last_id() override;
 
 private:
+  struct PendingEntry {
+    Timestamp timestamp;
+    Event event;
+    std::string data;
+    std::string correlation_id;
+  };
+
   void create_schema();
+  void migrate(int from_version);
+  void apply_pragmas();
+  void prepare_statements();
+  // Callers hold mutex_
+  void insert_entry(const PendingEntry &entry);
+  std::vector<LogEntry> read_entries(sqlite3_stmt *stmt);
+
+  // Async mode
+  void writer_loop();
+  void commit_batch(std::vector<PendingEntry> &batch);
+  void wait_until_committed();
 
   sqlite3 *db_ = nullptr;
-  mutable std::mutex mutex_;
+  mutable std::mutex mutex_; // guards db_ and stmts_
+
+  // Prepared once at construction and reused for every call
+  struct Statements {
+    SQLiteStatement insert;
+    SQLiteStatement history;
+    SQLiteStatement history_by_event;
+    SQLiteStatement order_history;
+    SQLiteStatement last_id;
+  };
+  Statements stmts_;
+
+  JournalOptions options_;
+  const IClock *clock_;
+
+  // Async mode: fixed-capacity ring buffer drained by writer_
+  std::mutex queue_mutex_;
+  std::condition_variable queue_not_empty_;
+  std::condition_variable queue_not_full_;
+  std::condition_variable batch_committed_;
+  std::vector<PendingEntry> ring_;
+  std::size_t ring_head_ = 0;
+  std::size_t ring_size_ = 0;
+  std::uint64_t enqueued_ = 0;
+  std::uint64_t committed_ = 0;
+  std::uint64_t flush_target_ = 0;
+  bool stopping_ = false;
+  std::thread writer_;
 };
 
 } // namespace quarcc
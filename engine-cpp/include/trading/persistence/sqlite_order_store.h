@@ -3,12 +3,16 @@
 #include <mutex>
 #include <sqlite3.h>
 #include <trading/interfaces/i_order_store.h>
+#include <trading/persistence/sqlite_statement.h>
+#include <trading/utils/clock.h>
 
 namespace quarcc {
 
 class SQLiteOrderStore : public IOrderStore {
 public:
-  explicit SQLiteOrderStore(const std::string &db_path);
+  // updated_at is stamped from `clock`, which must outlive the store
+  explicit SQLiteOrderStore(const std::string &db_path,
+                            const IClock &clock = SystemClock::instance());
   ~SQLiteOrderStore() override;
 
   SQLiteOrderStore(const SQLiteOrderStore &) = delete;
@@ -21,18 +25,52 @@ public:
   update_broker_id(const std::string &local_id,
                    const std::string &broker_id) override;
   Result<std::monostate> update_fill_info(const std::string &local_id,
-                                          double filled_quantity,
-                                          double avg_price) override;
+                                          Quantity filled_quantity,
+                                          Price avg_price) override;
+  Result<std::monostate> apply_fill(const std::string &local_id,
+                                    Quantity delta_qty, Price price,
+                                    OrderStatus new_status) override;
+  Result<std::monostate>
+  apply_fills(const std::vector<FillUpdate> &updates) override;
   Result<StoredOrder> get_order(const std::string &local_id) override;
   std::vector<StoredOrder> get_open_orders() override;
   std::vector<StoredOrder> get_orders_by_status(OrderStatus status) override;
+  Result<std::monostate>
+  save_position_snapshot(const PositionSnapshot &snapshot) override;
+  Result<PositionSnapshot> load_position_snapshot() override;
 
 private:
   void create_schema();
+  void migrate(int from_version);
+  void prepare_statements();
   StoredOrder parse_order(sqlite3_stmt *stmt);
+  // Caller holds mutex_
+  Result<std::monostate> step_apply_fill(const FillUpdate &update);
 
+  const IClock *clock_;
   sqlite3 *db_ = nullptr;
-  mutable std::mutex mutex_;
+  mutable std::mutex mutex_; // guards db_ and stmts_
+
+  // Prepared once at construction and reused for every call
+  struct Statements {
+    SQLiteStatement insert;
+    SQLiteStatement update_status;
+    SQLiteStatement update_broker_id;
+    SQLiteStatement update_fill_info;
+    SQLiteStatement apply_fill;
+    SQLiteStatement begin;
+    SQLiteStatement commit;
+    SQLiteStatement rollback;
+    SQLiteStatement get_order;
+    SQLiteStatement open_orders;
+    SQLiteStatement orders_by_status;
+    SQLiteStatement clear_snapshot;
+    SQLiteStatement insert_snapshot_position;
+    SQLiteStatement set_snapshot_time;
+    SQLiteStatement get_snapshot_time;
+    SQLiteStatement get_snapshot_positions;
+  };
+  Statements stmts_;
 };
 
 } // namespace quarcc
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <string>
+
+namespace quarcc {
+
+// Schema versioning helpers shared by the SQLite stores. The version lives in
+// PRAGMA user_version; 0 means either a fresh database or one created before
+// versioning was introduced (tell them apart with table_exists()).
+
+int schema_version(sqlite3 *db);
+void set_schema_version(sqlite3 *db, int version);
+bool table_exists(sqlite3 *db, const char *name);
+bool column_exists(sqlite3 *db, const char *table, const char *column);
+
+// Runs `sql`, throwing std::runtime_error prefixed with `what` on failure
+void exec_or_throw(sqlite3 *db, const std::string &sql, const char *what);
+
+// Registers text_to_ns(TEXT) -> INTEGER, which converts the text timestamps
+// written by older builds (LogEntry::string_to_timestamp format, or SQLite's
+// datetime('now')) to nanoseconds since the epoch. NULL maps to NULL.
+void register_timestamp_functions(sqlite3 *db);
+
+} // namespace quarcc
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <sqlite3.h>
+
+namespace quarcc {
+
+// Owns a prepared statement for the lifetime of its connection so hot paths
+// only bind and step. Must be destroyed before the connection is closed.
+class SQLiteStatement {
+public:
+  SQLiteStatement() = default;
+  // Throws std::runtime_error if the statement fails to compile
+  SQLiteStatement(sqlite3 *db, const char *sql);
+  ~SQLiteStatement();
+
+  SQLiteStatement(SQLiteStatement &&other) noexcept;
+  SQLiteStatement &operator=(SQLiteStatement &&other) noexcept;
+  SQLiteStatement(const SQLiteStatement &) = delete;
+  SQLiteStatement &operator=(const SQLiteStatement &) = delete;
+
+  sqlite3_stmt *get() const { return stmt_; }
+
+  // Hands out the statement and resets it (including bindings) on scope exit,
+  // so an early return cannot leave it mid-step for the next caller.
+  class Use {
+  public:
+    explicit Use(sqlite3_stmt *stmt) : stmt_(stmt) {}
+    ~Use() {
+      sqlite3_reset(stmt_);
+      sqlite3_clear_bindings(stmt_);
+    }
+
+    Use(const Use &) = delete;
+    Use &operator=(const Use &) = delete;
+
+    operator sqlite3_stmt *() const { return stmt_; }
+
+  private:
+    sqlite3_stmt *stmt_;
+  };
+
+  Use use() const { return Use{stmt_}; }
+
+private:
+  sqlite3_stmt *stmt_ = nullptr;
+};
+
+} // namespace quarcc
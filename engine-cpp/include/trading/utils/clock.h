@@ -0,0 +1,47 @@
+#pragma once
+
+#include <trading/interfaces/i_clock.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace quarcc {
+
+// The std::chrono system and steady clocks
+class SystemClock final : public IClock {
+public:
+  // The clock every component uses unless given another
+  static SystemClock &instance();
+
+  WallTime now() const override { return std::chrono::system_clock::now(); }
+  SteadyTime steady_now() const override {
+    return std::chrono::steady_clock::now();
+  }
+};
+
+// A clock that only moves when told to, for backtests. Both times read the
+// same count of nanoseconds since the Unix epoch, so a timeout of N seconds
+// expires after N seconds of simulated time. Reads are lock-free and may
+// come from any thread.
+class SimulatedClock final : public IClock {
+public:
+  explicit SimulatedClock(WallTime start = {}) { set(start); }
+
+  WallTime now() const override {
+    return WallTime{std::chrono::duration_cast<WallTime::duration>(
+        std::chrono::nanoseconds{ns_.load(std::memory_order_acquire)})};
+  }
+  SteadyTime steady_now() const override {
+    return SteadyTime{std::chrono::duration_cast<SteadyTime::duration>(
+        std::chrono::nanoseconds{ns_.load(std::memory_order_acquire)})};
+  }
+
+  // Moves the clock to `t`; never backwards, so earlier times are ignored
+  void set(WallTime t);
+  void advance(std::chrono::nanoseconds by) { set(now() + by); }
+
+private:
+  std::atomic<std::int64_t> ns_{0};
+};
+
+} // namespace quarcc
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace quarcc {
+
+namespace detail {
+constexpr std::array<std::uint32_t, 256> make_crc32_table() {
+  std::array<std::uint32_t, 256> table{};
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    std::uint32_t c = i;
+    for (int k = 0; k < 8; ++k)
+      c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    table[i] = c;
+  }
+  return table;
+}
+
+inline constexpr auto kCrc32Table = make_crc32_table();
+} // namespace detail
+
+// CRC-32 (IEEE 802.3). Pass a previous result as `crc` to extend it over
+// another buffer.
+inline std::uint32_t crc32(const void *data, std::size_t size,
+                           std::uint32_t crc = 0) {
+  const auto *p = static_cast<const unsigned char *>(data);
+  crc = ~crc;
+  while (size--)
+    crc = detail::kCrc32Table[(crc ^ *p++) & 0xFFu] ^ (crc >> 8);
+  return ~crc;
+}
+
+} // namespace quarcc
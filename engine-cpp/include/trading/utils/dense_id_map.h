@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+namespace quarcc {
+
+// Maps dense integer ids to pointers. Storage grows in fixed-size chunks that
+// never move, so get() is two acquire loads and is safe to call concurrently
+// with set(). set() must only be called by one thread at a time. The map does
+// not own the pointees.
+template <typename T, std::size_t ChunkSize = 1024,
+          std::size_t MaxChunks = 4096>
+class DenseIdMap {
+public:
+  DenseIdMap() = default;
+  ~DenseIdMap() {
+    for (auto &chunk : chunks_)
+      delete chunk.load(std::memory_order_relaxed);
+  }
+
+  DenseIdMap(const DenseIdMap &) = delete;
+  DenseIdMap &operator=(const DenseIdMap &) = delete;
+
+  static constexpr std::size_t capacity() { return ChunkSize * MaxChunks; }
+
+  T *get(std::uint32_t id) const {
+    if (id >= capacity())
+      return nullptr;
+    const Chunk *chunk = chunks_[id / ChunkSize].load(std::memory_order_acquire);
+    return chunk ? chunk->slots[id % ChunkSize].load(std::memory_order_acquire)
+                 : nullptr;
+  }
+
+  void set(std::uint32_t id, T *value) {
+    if (id >= capacity())
+      throw std::out_of_range("DenseIdMap id out of range");
+
+    auto &chunk_ptr = chunks_[id / ChunkSize];
+    Chunk *chunk = chunk_ptr.load(std::memory_order_relaxed);
+    if (!chunk) {
+      chunk = new Chunk;
+      chunk_ptr.store(chunk, std::memory_order_release);
+    }
+    chunk->slots[id % ChunkSize].store(value, std::memory_order_release);
+
+    if (id >= end_.load(std::memory_order_relaxed))
+      end_.store(id + 1, std::memory_order_release);
+  }
+
+  // One past the highest id ever set
+  std::uint32_t end() const { return end_.load(std::memory_order_acquire); }
+
+private:
+  struct Chunk {
+    std::array<std::atomic<T *>, ChunkSize> slots{};
+  };
+
+  std::array<std::atomic<Chunk *>, MaxChunks> chunks_{};
+  std::atomic<std::uint32_t> end_{0};
+};
+
+} // namespace quarcc
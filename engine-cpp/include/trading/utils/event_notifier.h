@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace quarcc {
+
+// Wakes a single consumer thread when producers report that work is pending.
+// Notifications coalesce: any number of notify() calls between two waits
+// produce exactly one wakeup.
+class EventNotifier {
+public:
+  void notify() {
+    {
+      std::lock_guard lock(mutex_);
+      pending_ = true;
+    }
+    cv_.notify_one();
+  }
+
+  // Blocks until notify() has been called since the last wait.
+  void wait() {
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [this] { return pending_; });
+    pending_ = false;
+  }
+
+  // Same as wait() but gives up after `timeout`. Returns true if woken by a
+  // notification, false on timeout.
+  template <typename Rep, typename Period>
+  bool wait_for(std::chrono::duration<Rep, Period> timeout) {
+    std::unique_lock lock(mutex_);
+    const bool notified =
+        cv_.wait_for(lock, timeout, [this] { return pending_; });
+    pending_ = false;
+    return notified;
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool pending_ = false;
+};
+
+} // namespace quarcc
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <cmath>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace quarcc {
+
+namespace detail {
+
+// Overflow-checked int64 arithmetic: the compiler builtins where there are
+// any, plain range checks elsewhere (MSVC). True on overflow, as for the
+// builtins.
+constexpr bool mul_overflows(std::int64_t a, std::int64_t b,
+                             std::int64_t *out) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_mul_overflow(a, b, out);
+#else
+  constexpr auto lo = std::numeric_limits<std::int64_t>::min();
+  constexpr auto hi = std::numeric_limits<std::int64_t>::max();
+  if (a != 0 && b != 0 &&
+      (a > 0 ? (b > 0 ? a > hi / b : b < lo / a)
+             : (b > 0 ? a < lo / b : a < hi / b)))
+    return true;
+  *out = a * b;
+  return false;
+#endif
+}
+
+constexpr bool add_overflows(std::int64_t a, std::int64_t b,
+                             std::int64_t *out) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_add_overflow(a, b, out);
+#else
+  constexpr auto lo = std::numeric_limits<std::int64_t>::min();
+  constexpr auto hi = std::numeric_limits<std::int64_t>::max();
+  if (b > 0 ? a > hi - b : a < lo - b)
+    return true;
+  *out = a + b;
+  return false;
+#endif
+}
+
+constexpr bool is_power_of_ten(std::int64_t n) {
+  while (n % 10 == 0)
+    n /= 10;
+  return n == 1;
+}
+
+// Decimal places a power of ten scale holds, e.g. 4 for 10'000
+constexpr std::size_t fraction_digits(std::int64_t scale) {
+  std::size_t digits = 0;
+  for (; scale > 1; scale /= 10)
+    ++digits;
+  return digits;
+}
+
+// n / d rounded half away from zero
+constexpr std::int64_t div_round(std::int64_t n, std::int64_t d) {
+  return ((n < 0) == (d < 0) ? n + d / 2 : n - d / 2) / d;
+}
+
+} // namespace detail
+
+// A decimal held as an integer number of 1/Scale units. Sums, differences and
+// comparisons are plain int64 operations, so they are exact and repeated fills
+// cannot drift. The tag keeps prices, quantities and money from being mixed.
+template <typename Tag, std::int64_t Scale> class FixedPoint {
+  static_assert(Scale > 0 && detail::is_power_of_ten(Scale));
+
+public:
+  using rep = std::int64_t;
+  static constexpr rep scale = Scale;
+
+  constexpr FixedPoint() = default;
+
+  static constexpr FixedPoint from_raw(rep raw) {
+    FixedPoint value;
+    value.raw_ = raw;
+    return value;
+  }
+  // Rounds to the nearest unit. Only for values known to fit, such as
+  // constants and test data: anything else is undefined. Input from outside
+  // goes through checked_from_double().
+  static FixedPoint from_double(double value) {
+    return from_raw(std::llround(value * Scale));
+  }
+  // nullopt for NaN, infinities and values outside the representable range
+  static std::optional<FixedPoint> checked_from_double(double value) {
+    const double units = std::round(value * Scale);
+    // 2^63 is exact as a double; anything at or past it does not fit
+    if (!(std::abs(units) < 9223372036854775808.0))
+      return std::nullopt;
+    return from_raw(static_cast<rep>(units));
+  }
+  // Largest representable value; used for "no limit"
+  static constexpr FixedPoint max() {
+    return from_raw(std::numeric_limits<rep>::max());
+  }
+
+  constexpr rep raw() const { return raw_; }
+  constexpr double to_double() const {
+    return static_cast<double>(raw_) / Scale;
+  }
+  constexpr bool is_zero() const { return raw_ == 0; }
+
+  // Exact decimal with trailing zeros dropped, e.g. "150.25" or "-3"
+  std::string to_string() const {
+    const std::uint64_t magnitude =
+        raw_ < 0 ? 0 - static_cast<std::uint64_t>(raw_) : raw_;
+    std::string out = raw_ < 0 ? "-" : "";
+    out += std::to_string(magnitude / Scale);
+
+    std::uint64_t frac = magnitude % Scale;
+    if (frac == 0)
+      return out;
+    std::string digits(std::to_string(Scale).size() - 1, '0');
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it, frac /= 10)
+      *it = static_cast<char>('0' + frac % 10);
+    digits.erase(digits.find_last_not_of('0') + 1);
+    return out + "." + digits;
+  }
+
+  // Inverse of to_string(): "[-]digits[.digits]" with at most as many
+  // decimal places as the scale holds, parsed without going through double.
+  // nullopt for anything else, or if the value is out of range.
+  static constexpr std::optional<FixedPoint>
+  from_string(std::string_view text) {
+    constexpr std::size_t kPlaces = detail::fraction_digits(Scale);
+    const bool negative = text.starts_with('-');
+    if (negative)
+      text.remove_prefix(1);
+    const auto point = text.find('.');
+    const auto whole = text.substr(0, point);
+    const auto fraction = point == std::string_view::npos
+                              ? std::string_view{}
+                              : text.substr(point + 1);
+    if (whole.empty() || fraction.size() > kPlaces ||
+        (point != std::string_view::npos && fraction.empty()))
+      return std::nullopt;
+
+    // The magnitude of min() is one more than max()
+    const std::uint64_t limit =
+        static_cast<std::uint64_t>(std::numeric_limits<rep>::max()) +
+        (negative ? 1 : 0);
+    std::uint64_t magnitude = 0;
+    auto push = [&](char c) {
+      if (c < '0' || c > '9')
+        return false;
+      const auto digit = static_cast<std::uint64_t>(c - '0');
+      if (magnitude > (limit - digit) / 10)
+        return false;
+      magnitude = magnitude * 10 + digit;
+      return true;
+    };
+    for (char c : whole)
+      if (!push(c))
+        return std::nullopt;
+    for (char c : fraction)
+      if (!push(c))
+        return std::nullopt;
+    for (std::size_t i = fraction.size(); i < kPlaces; ++i)
+      if (!push('0'))
+        return std::nullopt;
+    return from_raw(static_cast<rep>(negative ? 0 - magnitude : magnitude));
+  }
+
+  constexpr FixedPoint operator-() const { return from_raw(-raw_); }
+  constexpr FixedPoint &operator+=(FixedPoint other) {
+    raw_ += other.raw_;
+    return *this;
+  }
+  constexpr FixedPoint &operator-=(FixedPoint other) {
+    raw_ -= other.raw_;
+    return *this;
+  }
+
+  friend constexpr FixedPoint operator+(FixedPoint a, FixedPoint b) {
+    return a += b;
+  }
+  friend constexpr FixedPoint operator-(FixedPoint a, FixedPoint b) {
+    return a -= b;
+  }
+  friend constexpr FixedPoint operator*(FixedPoint a, rep n) {
+    return from_raw(a.raw_ * n);
+  }
+  friend constexpr FixedPoint abs(FixedPoint a) {
+    return a.raw_ < 0 ? -a : a;
+  }
+  friend constexpr auto operator<=>(FixedPoint, FixedPoint) = default;
+
+private:
+  rep raw_ = 0;
+};
+
+inline constexpr std::int64_t kPriceScale = 10'000;    // 1/100 of a cent
+inline constexpr std::int64_t kQuantityScale = 10'000; // fractional shares
+
+// Changing a scale changes the meaning of every stored value; bump the order
+// store's schema version with it.
+using Price = FixedPoint<struct PriceTag, kPriceScale>;
+using Quantity = FixedPoint<struct QuantityTag, kQuantityScale>;
+// Price * Quantity. Its scale is the product of theirs, so notional and PnL
+// are exact with a single integer multiply.
+using Money = FixedPoint<struct MoneyTag, kPriceScale * kQuantityScale>;
+
+constexpr Money operator*(Quantity q, Price p) {
+  return Money::from_raw(q.raw() * p.raw());
+}
+constexpr Money operator*(Price p, Quantity q) { return q * p; }
+
+// Quantity * Price for unvalidated input, or nullopt if it overflows
+constexpr std::optional<Money> checked_mul(Quantity q, Price p) {
+  Money::rep raw = 0;
+  if (detail::mul_overflows(q.raw(), p.raw(), &raw))
+    return std::nullopt;
+  return Money::from_raw(raw);
+}
+
+// a + b for unvalidated input, or nullopt if it overflows
+template <typename Tag, std::int64_t Scale>
+constexpr std::optional<FixedPoint<Tag, Scale>>
+checked_add(FixedPoint<Tag, Scale> a, FixedPoint<Tag, Scale> b) {
+  typename FixedPoint<Tag, Scale>::rep raw = 0;
+  if (detail::add_overflows(a.raw(), b.raw(), &raw))
+    return std::nullopt;
+  return FixedPoint<Tag, Scale>::from_raw(raw);
+}
+
+// Average price of a cost basis, rounded to the nearest price unit
+constexpr Price operator/(Money m, Quantity q) {
+  return Price::from_raw(detail::div_round(m.raw(), q.raw()));
+}
+
+// 150.25_px, 10_qty, 42.5_money
+namespace fixed_point_literals {
+
+namespace detail {
+template <typename T> constexpr T from_literal(long double value) {
+  return T::from_raw(static_cast<typename T::rep>(value * T::scale + 0.5L));
+}
+} // namespace detail
+
+constexpr Price operator""_px(long double v) {
+  return detail::from_literal<Price>(v);
+}
+constexpr Price operator""_px(unsigned long long v) {
+  return Price::from_raw(static_cast<Price::rep>(v) * Price::scale);
+}
+constexpr Quantity operator""_qty(long double v) {
+  return detail::from_literal<Quantity>(v);
+}
+constexpr Quantity operator""_qty(unsigned long long v) {
+  return Quantity::from_raw(static_cast<Quantity::rep>(v) * Quantity::scale);
+}
+constexpr Money operator""_money(long double v) {
+  return detail::from_literal<Money>(v);
+}
+constexpr Money operator""_money(unsigned long long v) {
+  return Money::from_raw(static_cast<Money::rep>(v) * Money::scale);
+}
+
+} // namespace fixed_point_literals
+
+} // namespace quarcc
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace quarcc {
+
+// Unbounded multi-producer/single-consumer queue (Vyukov). push() is
+// wait-free for producers: one atomic exchange plus one release store.
+// try_pop() must only ever be called from the single consumer thread.
+//
+// A push that is still in flight may be momentarily invisible to try_pop();
+// producers are expected to wake the consumer *after* push() returns, so the
+// consumer will look again.
+template <typename T> class MpscQueue {
+public:
+  MpscQueue() : head_(new Node), tail_(head_.load(std::memory_order_relaxed)) {}
+
+  ~MpscQueue() {
+    while (try_pop()) {
+    }
+    delete tail_;
+  }
+
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  void push(T value) {
+    Node *node = new Node;
+    node->value.emplace(std::move(value));
+    Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  std::optional<T> try_pop() {
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (!next)
+      return std::nullopt;
+
+    std::optional<T> value = std::move(next->value);
+    next->value.reset();
+    tail_ = next;
+    delete tail;
+    return value;
+  }
+
+private:
+  struct Node {
+    std::atomic<Node *> next{nullptr};
+    std::optional<T> value;
+  };
+
+  // Producers and the consumer touch different ends; keep them on separate
+  // cache lines.
+  alignas(64) std::atomic<Node *> head_;
+  alignas(64) Node *tail_;
+};
+
+} // namespace quarcc
@@ -1,36 +1,109 @@
 #pragma once
 
+#include <trading/utils/clock.h>
 #include <trading/utils/order_id_types.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <format>
+#include <optional>
+#include <string_view>
 
 namespace quarcc {
 
-// Is there really a point to generating ids for orders if the exchange/broker
-// already gives us ids for them when created
-class OrderIdGenerator {
+// A 64-bit order id, most significant bits first:
+//
+//   | 0 | 41 bits: ms since kEpoch | 10 bits: shard | 12 bits: sequence |
+//
+// Ids from one generator increase with time, and generators with different
+// shards never collide. The text form is the value in Crockford base32,
+// zero-padded to 13 characters, so it sorts the same way as the number.
+class CompactOrderId {
 public:
-  OrderIdGenerator(const std::string &ord = "ORD") : id_specifier_(ord) {}
+  static constexpr int kTimestampBits = 41; // about 69 years
+  static constexpr int kShardBits = 10;
+  static constexpr int kSequenceBits = 12; // 4096 ids per ms per shard
+  static constexpr std::uint32_t kMaxShards = 1u << kShardBits;
+  static constexpr std::uint32_t kMaxSequence = (1u << kSequenceBits) - 1;
+  static constexpr std::size_t kTextSize = 13;
+  // 2024-01-01T00:00:00Z
+  static constexpr std::chrono::sys_time<std::chrono::milliseconds> kEpoch{
+      std::chrono::milliseconds{1'704'067'200'000}};
+
+  using Text = std::array<char, kTextSize>;
 
-  LocalOrderId generate() {
-    auto now = std::chrono::system_clock::now();
-    auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                         now.time_since_epoch())
-                         .count();
+  constexpr CompactOrderId() = default;
+  constexpr explicit CompactOrderId(std::uint64_t value) : value_(value) {}
+  constexpr CompactOrderId(std::uint64_t millis, std::uint32_t shard,
+                           std::uint32_t sequence)
+      : value_(millis << (kShardBits + kSequenceBits) |
+               std::uint64_t{shard} << kSequenceBits | sequence) {}
+
+  constexpr std::uint64_t value() const { return value_; }
+  // Milliseconds since kEpoch
+  constexpr std::uint64_t millis() const {
+    return value_ >> (kShardBits + kSequenceBits);
+  }
+  constexpr std::uint32_t shard() const {
+    return static_cast<std::uint32_t>(value_ >> kSequenceBits) &
+           (kMaxShards - 1);
+  }
+  constexpr std::uint32_t sequence() const {
+    return static_cast<std::uint32_t>(value_) & kMaxSequence;
+  }
 
-    return std::format("{}_{}_{:06d}", id_specifier_, timestamp, counter_++);
+  // Fixed-size, no allocation; view with std::string_view(text.data(), size)
+  Text text() const;
+  LocalOrderId to_string() const {
+    const Text t = text();
+    return LocalOrderId(t.data(), t.size());
   }
+  // Inverse of text(). Case-insensitive, and reads I/L as 1 and O as 0 as
+  // Crockford base32 does. nullopt for anything else.
+  static std::optional<CompactOrderId> parse(std::string_view text);
+
+  friend constexpr auto operator<=>(CompactOrderId, CompactOrderId) = default;
+
+private:
+  std::uint64_t value_ = 0;
+};
+
+// Lock-free source of CompactOrderIds for one shard. Each strategy's
+// OrderManager gets its own shard, so the generators never coordinate.
+//
+// Ids are time based, read from `clock`, which keeps them unique across
+// restarts as long as the clock does not step back past ids already issued;
+// advance_past() covers that for ids recovered from the order store. When a
+// millisecond's 4096 sequence numbers run out, the generator borrows from the
+// next millisecond.
+class OrderIdGenerator {
+public:
+  // Throws std::runtime_error if shard >= CompactOrderId::kMaxShards. The
+  // clock must outlive the generator.
+  explicit OrderIdGenerator(std::uint32_t shard = 0,
+                            const IClock &clock = SystemClock::instance());
+
+  CompactOrderId next();
+  // The text form. At 13 characters it fits std::string's inline buffer, so
+  // neither this nor copies of the id allocate.
+  LocalOrderId generate() { return next().to_string(); }
+
+  // Later ids are from a later millisecond than `id`, whatever its shard
+  void advance_past(CompactOrderId id);
+
+  std::uint32_t shard() const { return shard_; }
 
 private:
-  std::atomic<std::uint64_t> counter_{0};
-  const std::string id_specifier_;
+  std::uint32_t shard_;
+  const IClock *clock_;
+  std::atomic<std::uint64_t> last_{0};
 };
 
-inline std::string get_current_time() noexcept {
-  const auto now = std::chrono::system_clock::now();
-  return std::format("{:%FT%TZ}", now);
+inline std::string
+get_current_time(const IClock &clock = SystemClock::instance()) noexcept {
+  return std::format("{:%FT%TZ}", clock.now());
 }
 
 } // namespace quarcc
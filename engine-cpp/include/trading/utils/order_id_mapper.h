@@ -0,0 +1,131 @@
+#pragma once
+
+#include <trading/utils/order_id_types.h>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace quarcc {
+
+namespace detail {
+
+// Open-addressing string -> string table with linear probing. Slots hold only
+// the key's hash and an index into a separate entry array, so a probe scans
+// 16-byte slots and compares strings only on a full hash match. Not
+// thread-safe; OrderIdMapper shards and locks it.
+class FlatIdTable {
+public:
+  // `hash` must be at least 2; 0 and 1 mark empty and erased slots
+  const std::string *find(std::string_view key, std::uint64_t hash) const;
+  // Returns the value it replaced, if any
+  std::optional<std::string> insert_or_assign(std::string_view key,
+                                              std::uint64_t hash,
+                                              std::string_view value);
+  // Returns the erased value, if the key was present
+  std::optional<std::string> erase(std::string_view key, std::uint64_t hash);
+
+  std::size_t size() const { return size_; }
+
+  template <typename F> void for_each(F &&f) const {
+    for (const Slot &slot : slots_)
+      if (slot.hash > kErased)
+        f(entries_[slot.entry].key, entries_[slot.entry].value);
+  }
+
+private:
+  static constexpr std::uint64_t kEmpty = 0;
+  static constexpr std::uint64_t kErased = 1;
+  static constexpr std::size_t kNotFound = ~std::size_t{0};
+
+  struct Slot {
+    std::uint64_t hash = kEmpty;
+    std::uint32_t entry = 0;
+  };
+  struct Entry {
+    std::string key;
+    std::string value;
+  };
+
+  std::size_t locate(std::string_view key, std::uint64_t hash) const;
+  void rehash(std::size_t capacity);
+
+  std::vector<Slot> slots_; // power-of-two size
+  std::vector<Entry> entries_;
+  std::vector<std::uint32_t> free_entries_;
+  std::size_t size_ = 0;
+  std::size_t used_ = 0; // live plus erased slots
+};
+
+} // namespace detail
+
+// Two-way local <-> broker order id map. Each direction is split into
+// kShards flat hash tables with their own reader/writer lock, so lookups
+// from the fill and cancel paths only contend when they land on the same
+// shard, and even then only with a writer.
+//
+// Lookups are safe from any thread. Mutations are serialized internally so
+// the two directions agree once a call returns, apart from broker ids
+// retired but not yet removed.
+class OrderIdMapper {
+public:
+  static constexpr std::size_t kShards = 16;
+
+  void add_mapping(std::string_view local, std::string_view broker);
+  std::optional<BrokerOrderId> get_broker_id(std::string_view local) const;
+  std::optional<LocalOrderId> get_local_id(std::string_view broker) const;
+  void remove_mapping(std::string_view local);
+
+  // First half of a two-step removal for terminal orders: the local id stops
+  // resolving now, while the broker id keeps resolving (for late fills) until
+  // remove_retired(). Returns the broker id, if the local id was mapped.
+  std::optional<BrokerOrderId> retire_mapping(std::string_view local);
+  // Drops a retired broker id. A no-op if it was mapped again since.
+  void remove_retired(std::string_view broker);
+
+  // Mapped local ids; retired ones are not counted
+  std::size_t size() const;
+  // Every local -> broker pair at one point in time. Holds off writers while
+  // copying, but not readers.
+  std::vector<std::pair<LocalOrderId, BrokerOrderId>> snapshot() const;
+
+private:
+  class Index {
+  public:
+    std::optional<std::string> get(std::string_view key) const;
+    std::optional<std::string> put(std::string_view key,
+                                   std::string_view value);
+    std::optional<std::string> erase(std::string_view key);
+    std::size_t size() const;
+
+    template <typename F> void for_each(F &&f) const {
+      for (const Shard &shard : shards_) {
+        std::shared_lock lock(shard.mutex);
+        shard.table.for_each(f);
+      }
+    }
+
+  private:
+    struct alignas(64) Shard {
+      mutable std::shared_mutex mutex;
+      detail::FlatIdTable table;
+    };
+
+    static std::uint64_t hash(std::string_view key);
+    static std::size_t shard_of(std::uint64_t hash);
+
+    std::array<Shard, kShards> shards_;
+  };
+
+  Index by_local_;
+  Index by_broker_;
+  mutable std::mutex write_mutex_;
+};
+
+} // namespace quarcc
@@ -1,11 +1,8 @@
 #pragma once
 
-#include <mutex>
 #include <optional>
-#include <shared_mutex>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
 
 namespace quarcc {
 
@@ -37,48 +34,4 @@ struct OrderId {
   }
 };
 
-class OrderIdMapper {
-public:
-  void add_mapping(const LocalOrderId &local, const BrokerOrderId &broker) {
-    std::unique_lock lock(mutex_);
-    local_to_broker_[local] = broker;
-    broker_to_local_[broker] = local;
-  }
-
-  std::optional<BrokerOrderId> get_broker_id(const LocalOrderId &local) const {
-    std::shared_lock lock(mutex_);
-    auto it = local_to_broker_.find(local);
-    return (it != local_to_broker_.end())
-               ? std::optional<BrokerOrderId>(it->second)
-               : std::nullopt;
-  }
-
-  std::optional<LocalOrderId> get_local_id(const BrokerOrderId &broker) const {
-    std::shared_lock lock(mutex_);
-    auto it = broker_to_local_.find(broker);
-    return (it != broker_to_local_.end())
-               ? std::optional<LocalOrderId>(it->second)
-               : std::nullopt;
-  }
-
-  void remove_mapping(const LocalOrderId &local) {
-    std::unique_lock lock(mutex_);
-    auto it = local_to_broker_.find(local);
-    if (it != local_to_broker_.end()) {
-      broker_to_local_.erase(it->second);
-      local_to_broker_.erase(it);
-    }
-  }
-
-  const std::unordered_map<LocalOrderId, BrokerOrderId> &
-  get_local_to_broker() const {
-    return local_to_broker_;
-  }
-
-private:
-  mutable std::shared_mutex mutex_;
-  std::unordered_map<LocalOrderId, BrokerOrderId> local_to_broker_;
-  std::unordered_map<BrokerOrderId, LocalOrderId> broker_to_local_;
-};
-
 } // namespace quarcc
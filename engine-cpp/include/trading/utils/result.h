@@ -9,6 +9,8 @@ namespace quarcc {
 enum class ErrorType : std::uint8_t {
   Error,
   FailedOrder,
+  RiskRejected, // refused by a pre-trade risk check
+  Throttled,    // over a message-rate limit; retry later
 };
 
 struct Error {
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace quarcc {
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// A trivially-copyable value behind a sequence lock. store() never waits and
+// load() never blocks the writer: readers retry if a store overlapped their
+// copy. The value is kept as relaxed atomic words so the racing copy is
+// well-defined.
+//
+// store() must only be called by one thread at a time.
+template <typename T> class Seqlocked {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+  static constexpr std::size_t kWords =
+      (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+  using Words = std::array<std::uint64_t, kWords>;
+
+public:
+  Seqlocked() : Seqlocked(T{}) {}
+  explicit Seqlocked(const T &value) { write_words(value); }
+
+  Seqlocked(const Seqlocked &) = delete;
+  Seqlocked &operator=(const Seqlocked &) = delete;
+
+  void store(const T &value) {
+    const auto seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    write_words(value);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  T load() const {
+    Words words;
+    while (true) {
+      const auto seq = seq_.load(std::memory_order_acquire);
+      if (seq & 1) {
+        cpu_relax();
+        continue;
+      }
+      for (std::size_t i = 0; i < kWords; ++i)
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == seq)
+        break;
+    }
+
+    T value;
+    // T is trivially copyable; the cast only quiets -Wclass-memaccess
+    std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+    return value;
+  }
+
+  // Number of completed stores
+  std::uint64_t version() const {
+    return seq_.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  void write_words(const T &value) {
+    Words words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+    for (std::size_t i = 0; i < kWords; ++i)
+      words_[i].store(words[i], std::memory_order_relaxed);
+  }
+
+  std::atomic<std::uint64_t> seq_{0};
+  std::array<std::atomic<std::uint64_t>, kWords> words_{};
+};
+
+} // namespace quarcc
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace quarcc {
+
+// SplitMix64 pseudo-random generator. Unlike the std:: engines paired with
+// std:: distributions, a seed gives the same sequence on every platform and
+// standard library, so simulations replay exactly. Not for cryptography.
+class SplitMix64 {
+public:
+  using result_type = std::uint64_t;
+
+  constexpr explicit SplitMix64(std::uint64_t seed = 0) : state_(seed) {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  constexpr result_type operator()() {
+    std::uint64_t z = (state_ += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform in [0, bound), or 0 when bound is 0. Multiply-shift rather than
+  // rejection, so the bias is below bound / 2^64.
+  constexpr std::uint64_t below(std::uint64_t bound) {
+    __extension__ using Wide = unsigned __int128;
+    return static_cast<std::uint64_t>((Wide{(*this)()} * bound) >> 64);
+  }
+
+  // Uniform in [lo, hi]; requires lo <= hi
+  constexpr std::int64_t between(std::int64_t lo, std::int64_t hi) {
+    const auto span = static_cast<std::uint64_t>(hi) -
+                      static_cast<std::uint64_t>(lo) + 1;
+    return span == 0 ? static_cast<std::int64_t>((*this)())
+                     : lo + static_cast<std::int64_t>(below(span));
+  }
+
+private:
+  std::uint64_t state_;
+};
+
+} // namespace quarcc
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <trading/utils/dense_id_map.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace quarcc {
+
+// Dense id for an interned symbol: 0, 1, 2, ... in order of first sight
+using SymbolId = std::uint32_t;
+
+// Never assigned. Stands in for a symbol that has not been interned, so that
+// untrusted input can be looked up without growing the table; every per-id
+// lookup treats it as a symbol nothing is known about.
+inline constexpr SymbolId kUnknownSymbol = std::numeric_limits<SymbolId>::max();
+
+// Interns symbols to SymbolIds so core state can be kept in flat arrays
+// indexed by id instead of string-keyed maps. Symbols are interned where they
+// enter the core through trusted paths (the configured universe, market data,
+// recovery) and turned back into strings only when a response is built.
+// Orders and fills only find() them, and orders for a symbol the table does
+// not hold are rejected, so clients cannot grow the table.
+//
+// Ids are never reused or removed. Lookups in either direction are lock-free;
+// interning a new symbol takes a mutex that lookups never touch.
+class SymbolTable {
+public:
+  // The process-wide table used by the engine
+  static SymbolTable &global();
+
+  SymbolTable();
+  ~SymbolTable();
+
+  SymbolTable(const SymbolTable &) = delete;
+  SymbolTable &operator=(const SymbolTable &) = delete;
+
+  // Returns the symbol's id, assigning the next one on first sight
+  SymbolId intern(std::string_view symbol);
+  std::optional<SymbolId> find(std::string_view symbol) const;
+
+  // `id` must have been returned by this table
+  const std::string &name(SymbolId id) const;
+
+  std::size_t size() const;
+
+private:
+  struct Entry {
+    std::string name;
+    SymbolId id;
+  };
+
+  // Open-addressing table of Entry pointers. Buckets are only ever filled, so
+  // a reader probing while a new symbol is inserted sees either the old or the
+  // new state. When it gets half full a table twice the size is published.
+  struct Index {
+    explicit Index(std::size_t capacity);
+
+    std::size_t mask;
+    std::unique_ptr<std::atomic<const Entry *>[]> buckets;
+  };
+
+  const Entry *lookup(std::string_view symbol) const;
+  static void insert(Index &index, const Entry *entry);
+
+  std::atomic<Index *> index_;
+  DenseIdMap<const Entry> names_;
+
+  std::mutex write_mutex_; // serializes intern() of new symbols
+  std::vector<std::unique_ptr<Entry>> entries_;
+  // Superseded tables stay alive for readers that may still be probing them
+  std::vector<std::unique_ptr<Index>> indexes_;
+};
+
+} // namespace quarcc
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace quarcc {
+
+// Hashed timer wheel for deadlines that are all about the same distance out,
+// such as grace periods. schedule() is O(1) and advance() only visits the
+// buckets whose ticks have passed. Deadlines further out than the wheel's
+// span wait in their bucket for another turn.
+//
+// Entries fire on the first advance() after their deadline's tick has ended,
+// so up to one tick late. Not thread-safe.
+template <typename T> class TimerWheel {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Throws std::runtime_error for a non-positive tick or zero buckets
+  TimerWheel(Clock::duration tick, std::size_t buckets,
+             Clock::time_point start = Clock::now())
+      : tick_(tick), buckets_(buckets) {
+    if (tick <= Clock::duration::zero() || buckets == 0)
+      throw std::runtime_error("TimerWheel needs a positive tick and buckets");
+    next_tick_ = tick_of(start);
+  }
+
+  // A deadline already in the past fires on the next advance()
+  void schedule(Clock::time_point deadline, T value) {
+    const std::int64_t tick = std::max(tick_of(deadline), next_tick_);
+    buckets_[bucket_of(tick)].push_back({tick, std::move(value)});
+    ++size_;
+  }
+
+  // Calls expire(value) for every entry whose tick ended before `now`.
+  // `expire` must not schedule into this wheel.
+  template <typename F> void advance(Clock::time_point now, F &&expire) {
+    const std::int64_t target = tick_of(now);
+    if (target <= next_tick_)
+      return;
+
+    // Past a full turn, one visit per bucket covers everything
+    const std::int64_t end = std::min<std::int64_t>(
+        target, next_tick_ + static_cast<std::int64_t>(buckets_.size()));
+    for (std::int64_t t = next_tick_; t < end; ++t) {
+      auto &bucket = buckets_[bucket_of(t)];
+      auto keep = bucket.begin();
+      for (auto &entry : bucket) {
+        if (entry.tick < target) {
+          expire(std::move(entry.value));
+          continue;
+        }
+        if (&*keep != &entry)
+          *keep = std::move(entry);
+        ++keep;
+      }
+      size_ -= static_cast<std::size_t>(bucket.end() - keep);
+      bucket.erase(keep, bucket.end());
+    }
+    next_tick_ = target;
+  }
+
+  std::size_t size() const { return size_; }
+
+private:
+  struct Entry {
+    std::int64_t tick;
+    T value;
+  };
+
+  std::int64_t tick_of(Clock::time_point t) const {
+    return t.time_since_epoch() / tick_;
+  }
+  std::size_t bucket_of(std::int64_t tick) const {
+    return static_cast<std::size_t>(tick) % buckets_.size();
+  }
+
+  Clock::duration tick_;
+  std::vector<std::vector<Entry>> buckets_;
+  std::int64_t next_tick_ = 0; // earliest tick not yet swept
+  std::size_t size_ = 0;
+};
+
+} // namespace quarcc
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace quarcc {
+
+// Fixed set of threads for CPU-bound batch work such as backtest sweeps.
+// Every worker has its own deque: tasks submitted from outside are dealt to
+// the deques round-robin, tasks submitted by a running task go on its own
+// worker's deque, and a worker takes from the back of its own deque and,
+// once that is empty, steals from the front of the others'. Uneven task
+// lengths therefore even out without one shared queue every pop contends on.
+class WorkStealingPool {
+public:
+  using Task = std::function<void()>;
+
+  // 0 threads means one per hardware thread
+  explicit WorkStealingPool(std::size_t threads = 0);
+  // Runs whatever is still queued, then joins
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  void submit(Task task);
+
+  // Blocks until every task submitted so far, and any they submitted, has
+  // run; then rethrows the first exception one of them threw, if any. Must
+  // not be called from a task.
+  void wait();
+
+  std::size_t size() const { return threads_.size(); }
+  // Tasks run by a worker other than the one they were queued on
+  std::uint64_t steals() const {
+    return steals_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void run(std::size_t index);
+  bool take(std::size_t index, Task &task);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<std::size_t> next_queue_{0};
+  std::atomic<std::uint64_t> steals_{0};
+
+  // Idle workers sleep on wake_ until a task is queued or the pool stops
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  std::atomic<std::int64_t> queued_{0}; // raised under wake_mutex_
+  bool stopping_ = false;               // guarded by wake_mutex_
+
+  std::mutex done_mutex_;
+  std::condition_variable done_;
+  std::size_t unfinished_ = 0;  // guarded by done_mutex_
+  std::exception_ptr error_;    // guarded by done_mutex_
+};
+
+} // namespace quarcc
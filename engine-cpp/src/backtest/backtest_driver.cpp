@@ -0,0 +1,103 @@
+#include <trading/backtest/backtest_driver.h>
+
+namespace quarcc {
+
+BacktestDriver::BacktestDriver(std::shared_ptr<const TickFile> ticks,
+                               SimulatedClock &clock,
+                               std::unique_ptr<IJournal> journal,
+                               std::unique_ptr<IOrderStore> store,
+                               BacktestStrategy strategy,
+                               BacktestOptions options, SymbolTable &symbols)
+    : clock_(&clock), strategy_(std::move(strategy)),
+      risk_limits_(std::move(options.risk)) {
+  auto keeper = std::make_unique<PositionKeeper>(nullptr, &marks_, symbols);
+  auto risk = std::make_unique<RiskManager>(
+      options.strategy_id, risk_limits_, keeper.get(), nullptr, &marks_,
+      symbols);
+
+  options.gateway.clock = clock_;
+  options.gateway.on_price = [this, on_price = std::move(
+                                        options.gateway.on_price)](
+                                 SymbolId symbol, Price price) {
+    marks_.update(symbol, price);
+    if (on_price)
+      on_price(symbol, price);
+  };
+  auto gateway = std::make_unique<ReplayGateway>(
+      std::move(ticks), std::move(options.gateway), symbols);
+
+  positions_ = keeper.get();
+  gateway_ = gateway.get();
+  options.orders.clock = clock_;
+  orders_ = OrderManager::CreateOrderManager(
+      std::move(keeper), std::move(gateway), std::move(journal),
+      std::move(store), std::move(risk), options.orders);
+  orders_->set_fill_listener([this] { fills_pending_ = true; });
+}
+
+BacktestDriver::~BacktestDriver() = default;
+
+bool BacktestDriver::step() {
+  const TickRecord *tick = gateway_->step();
+  if (!tick)
+    return false;
+  ++stats_.ticks;
+  apply_fills();
+  if (strategy_)
+    strategy_(*this, *tick, gateway_->symbol(*tick));
+  return true;
+}
+
+const BacktestStats &BacktestDriver::run() {
+  while (step()) {
+  }
+  orders_->checkpoint();
+  return stats_;
+}
+
+Result<LocalOrderId>
+BacktestDriver::submit(const v1::StrategySignal &signal) {
+  return count_order(orders_->processSignal(signal));
+}
+
+Result<std::monostate> BacktestDriver::cancel(const v1::CancelSignal &signal) {
+  auto result = orders_->processSignal(signal);
+  apply_fills();
+  return result;
+}
+
+Result<LocalOrderId> BacktestDriver::replace(const v1::ReplaceSignal &signal) {
+  return count_order(orders_->processSignal(signal));
+}
+
+Money BacktestDriver::pnl() const {
+  Money total;
+  positions_->for_each_position(
+      [&](SymbolId symbol, const PositionKeeper::Position &position) {
+        total += position.realizedPnl;
+        if (const auto mark = marks_.get(symbol))
+          total += position.quantity * (*mark - position.avgPrice);
+      });
+  return total;
+}
+
+template <typename T> Result<T> BacktestDriver::count_order(Result<T> result) {
+  if (result)
+    ++stats_.orders;
+  else if (result.error().type_ == ErrorType::RiskRejected ||
+           result.error().type_ == ErrorType::FailedOrder)
+    ++stats_.rejected;
+  apply_fills();
+  return result;
+}
+
+// The gateway pushes fills from inside step() and the order calls, so this
+// runs right after each of them, never on a timer
+void BacktestDriver::apply_fills() {
+  while (fills_pending_) {
+    fills_pending_ = false;
+    stats_.fills += orders_->process_fills();
+  }
+}
+
+} // namespace quarcc
@@ -0,0 +1,85 @@
+#include <trading/backtest/parameter_sweep.h>
+#include <trading/persistence/memory_journal.h>
+#include <trading/persistence/memory_order_store.h>
+#include <trading/utils/work_stealing_pool.h>
+
+#include <algorithm>
+#include <exception>
+#include <format>
+
+namespace quarcc {
+
+static SweepResult run_one(std::shared_ptr<const TickFile> ticks,
+                           SweepRun &run) {
+  SweepResult result;
+  result.name = std::move(run.name);
+  const auto start = std::chrono::steady_clock::now();
+  try {
+    SymbolTable symbols;
+    SimulatedClock clock;
+    auto store = std::make_unique<MemoryOrderStore>(clock);
+    const MemoryOrderStore &orders = *store;
+    BacktestDriver driver{std::move(ticks),
+                          clock,
+                          std::make_unique<MemoryJournal>(clock),
+                          std::move(store),
+                          std::move(run.strategy),
+                          std::move(run.options),
+                          symbols};
+    try {
+      driver.run();
+    } catch (const std::exception &e) {
+      result.error = e.what();
+    }
+    result.stats = driver.stats();
+    result.pnl = driver.pnl();
+    for (const auto &stored : orders.get_all_orders())
+      result.volume += stored.filled_quantity;
+  } catch (const std::exception &e) {
+    result.error = e.what();
+  }
+  result.elapsed = std::chrono::steady_clock::now() - start;
+  return result;
+}
+
+std::vector<SweepResult> run_sweep(std::shared_ptr<const TickFile> ticks,
+                                   std::vector<SweepRun> runs,
+                                   SweepOptions options) {
+  std::vector<SweepResult> results(runs.size());
+  if (runs.empty())
+    return results;
+
+  std::size_t threads = options.threads;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  WorkStealingPool pool{std::min(threads, runs.size())};
+  for (std::size_t i = 0; i < runs.size(); ++i)
+    pool.submit([&, i] { results[i] = run_one(ticks, runs[i]); });
+  pool.wait();
+  return results;
+}
+
+std::string format_sweep_table(const std::vector<SweepResult> &results) {
+  std::size_t name_width = 3;
+  for (const auto &result : results)
+    name_width = std::max(name_width, result.name.size());
+
+  std::string table =
+      std::format("{:<{}}  {:>9}  {:>7}  {:>8}  {:>7}  {:>12}  {:>14}  {:>9}\n",
+                  "run", name_width, "ticks", "orders", "rejected", "fills",
+                  "volume", "pnl", "ms");
+  for (const auto &result : results) {
+    table += std::format(
+        "{:<{}}  {:>9}  {:>7}  {:>8}  {:>7}  {:>12}  {:>14.2f}  {:>9.1f}",
+        result.name, name_width, result.stats.ticks, result.stats.orders,
+        result.stats.rejected, result.stats.fills, result.volume.to_string(),
+        result.pnl.to_double(),
+        std::chrono::duration<double, std::milli>(result.elapsed).count());
+    if (!result.error.empty())
+      table += "  " + result.error;
+    table += '\n';
+  }
+  return table;
+}
+
+} // namespace quarcc
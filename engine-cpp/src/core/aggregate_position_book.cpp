@@ -0,0 +1,163 @@
+#include <trading/core/aggregate_position_book.h>
+
+namespace quarcc {
+
+AggregatePositionBook::AggregatePositionBook(MarkPriceCache *marks,
+                                             SymbolTable &symbols)
+    : marks_(marks), symbols_(symbols) {
+  if (marks_)
+    marks_->set_listener(
+        [this](SymbolId symbol, Price price) { on_mark(symbol, price); });
+}
+
+AggregatePositionBook::~AggregatePositionBook() {
+  if (marks_)
+    marks_->set_listener(nullptr);
+}
+
+void AggregatePositionBook::apply(SymbolId symbol, const Contribution &before,
+                                  const Contribution &after) {
+  std::lock_guard lock(write_mutex_);
+
+  Seqlocked<Aggregate> *cell = aggregates_.get(symbol);
+  if (!cell) {
+    Aggregate initial;
+    if (auto mark = marks_ ? marks_->get(symbol) : std::nullopt) {
+      initial.mark = *mark;
+      initial.has_mark = true;
+    }
+    cell = owned_.emplace_back(std::make_unique<Seqlocked<Aggregate>>(initial))
+               .get();
+    aggregates_.set(symbol, cell);
+  }
+
+  const Aggregate previous = cell->load();
+  Aggregate aggregate = previous;
+  aggregate.quantity += after.quantity - before.quantity;
+  aggregate.cost +=
+      after.quantity * after.avg_price - before.quantity * before.avg_price;
+  aggregate.realized += after.realized_pnl - before.realized_pnl;
+  store(*cell, previous, aggregate);
+}
+
+// Symbols nobody has a position in have nothing to revalue; their mark is
+// picked up from the cache when the first position arrives.
+void AggregatePositionBook::on_mark(SymbolId symbol, Price price) {
+  std::lock_guard lock(write_mutex_);
+
+  Seqlocked<Aggregate> *cell = aggregates_.get(symbol);
+  if (!cell)
+    return;
+
+  const Aggregate previous = cell->load();
+  Aggregate aggregate = previous;
+  aggregate.mark = price;
+  aggregate.has_mark = true;
+  store(*cell, previous, aggregate);
+}
+
+void AggregatePositionBook::apply_working(SymbolId symbol, v1::Side side,
+                                          Quantity delta) {
+  std::lock_guard lock(write_mutex_);
+
+  Seqlocked<WorkingQuantity> *cell = working_.get(symbol);
+  if (!cell) {
+    cell = owned_working_
+               .emplace_back(std::make_unique<Seqlocked<WorkingQuantity>>())
+               .get();
+    working_.set(symbol, cell);
+  }
+
+  WorkingQuantity working = cell->load();
+  working.add(side, delta);
+  cell->store(working);
+}
+
+void AggregatePositionBook::store(Seqlocked<Aggregate> &cell,
+                                  const Aggregate &before,
+                                  const Aggregate &after) {
+  cell.store(after);
+
+  Totals totals = totals_.load();
+  totals.pnl.realized += after.realized - before.realized;
+  totals.pnl.unrealized += after.unrealized() - before.unrealized();
+  totals.exposure.net += after.market_value() - before.market_value();
+  totals.exposure.gross +=
+      abs(after.market_value()) - abs(before.market_value());
+  totals_.store(totals);
+
+  version_.fetch_add(1, std::memory_order_release);
+}
+
+Result<v1::Position> AggregatePositionBook::get(SymbolId symbol) const {
+  const Seqlocked<Aggregate> *cell = aggregates_.get(symbol);
+  if (!cell)
+    return std::unexpected(Error{"Position not found", ErrorType::Error});
+
+  return to_proto(symbol, cell->load());
+}
+
+// The version is read before the cells, so a change that lands mid-rebuild
+// makes the next call rebuild again rather than being missed.
+std::shared_ptr<const AggregatePositionBook::Snapshot>
+AggregatePositionBook::snapshot() const {
+  std::lock_guard lock(snapshot_mutex_);
+
+  const std::uint64_t version = version_.load(std::memory_order_acquire);
+  if (cached_ && cached_->version == version)
+    return cached_;
+
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->version = version;
+  snapshot->pnl = totals_.load().pnl;
+  const SymbolId end = aggregates_.end();
+  for (SymbolId id = 0; id < end; ++id) {
+    if (const auto *cell = aggregates_.get(id))
+      *snapshot->positions.add_positions() = to_proto(id, cell->load());
+  }
+
+  cached_ = std::move(snapshot);
+  return cached_;
+}
+
+AggregatePositionBook::FirmPnl AggregatePositionBook::pnl() const {
+  return totals_.load().pnl;
+}
+
+AggregatePositionBook::Exposure AggregatePositionBook::exposure() const {
+  return totals_.load().exposure;
+}
+
+Quantity AggregatePositionBook::quantity(SymbolId symbol) const {
+  const Seqlocked<Aggregate> *cell = aggregates_.get(symbol);
+  return cell ? cell->load().quantity : Quantity{};
+}
+
+Money AggregatePositionBook::market_value(SymbolId symbol) const {
+  const Seqlocked<Aggregate> *cell = aggregates_.get(symbol);
+  return cell ? cell->load().market_value() : Money{};
+}
+
+WorkingQuantity AggregatePositionBook::working(SymbolId symbol) const {
+  const Seqlocked<WorkingQuantity> *cell = working_.get(symbol);
+  return cell ? cell->load() : WorkingQuantity{};
+}
+
+std::uint64_t AggregatePositionBook::version() const {
+  return version_.load(std::memory_order_acquire);
+}
+
+v1::Position AggregatePositionBook::to_proto(SymbolId symbol,
+                                             const Aggregate &aggregate) const {
+  v1::Position pos;
+  pos.set_symbol(symbols_.name(symbol));
+  pos.set_quantity(aggregate.quantity.to_double());
+  pos.set_avg_price(aggregate.quantity.is_zero()
+                        ? 0.0
+                        : (aggregate.cost / aggregate.quantity).to_double());
+  pos.set_realized_pnl(aggregate.realized.to_double());
+  pos.set_unrealized_pnl(aggregate.unrealized().to_double());
+  return pos;
+}
+
+} // namespace quarcc
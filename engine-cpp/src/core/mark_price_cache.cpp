@@ -0,0 +1,47 @@
+#include <trading/core/mark_price_cache.h>
+
+namespace quarcc {
+
+// Ticks for a symbol already in the cache are a single atomic store unless a
+// listener has to be notified; the first tick for a symbol takes the mutex to
+// allocate its cell.
+void MarkPriceCache::update(SymbolId symbol, Price price) {
+  if (!listener_) {
+    if (auto *cell = prices_.get(symbol)) {
+      cell->store(price, std::memory_order_release);
+      return;
+    }
+    std::lock_guard lock(mutex_);
+    store_locked(symbol, price);
+    return;
+  }
+
+  std::lock_guard lock(mutex_);
+  store_locked(symbol, price);
+  listener_(symbol, price);
+}
+
+std::optional<Price> MarkPriceCache::get(SymbolId symbol) const {
+  if (const auto *price = prices_.get(symbol))
+    return price->load(std::memory_order_acquire);
+  return std::nullopt;
+}
+
+void MarkPriceCache::set_listener(Listener listener) {
+  listener_ = std::move(listener);
+}
+
+// Caller holds mutex_
+void MarkPriceCache::store_locked(SymbolId symbol, Price price) {
+  if (auto *cell = prices_.get(symbol)) {
+    cell->store(price, std::memory_order_release);
+    return;
+  }
+
+  // The cell holds the price before it becomes reachable
+  prices_.set(symbol,
+              owned_.emplace_back(std::make_unique<std::atomic<Price>>(price))
+                  .get());
+}
+
+} // namespace quarcc
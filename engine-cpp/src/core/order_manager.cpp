@@ -1,21 +1,225 @@
 #include <trading/core/order_manager.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
 namespace quarcc {
 
+static constexpr std::chrono::seconds kUnresolvedFillGrace{2};
+// The mapping grace period is split into this many timer wheel ticks, less
+// one so a whole period always fits on the wheel
+static constexpr std::size_t kRetiredMappingBuckets = 64;
+// Bounds how much journal recovery has to replay after a crash
+static constexpr std::size_t kFillsPerCheckpoint = 1000;
+
+struct JournaledFill {
+  v1::Side side;
+  Quantity quantity;
+  std::string symbol;
+  Price price;
+};
+
+// Fill journal entries carry everything needed to replay the execution
+// against positions: "Filled: BUY 5 AAPL @ 150 (5 / 10)". Values are written
+// as exact decimals and parsed straight back into fixed point, so the round
+// trip is lossless.
+static std::string format_fill_entry(const JournaledFill &fill,
+                                     Quantity cumulative_qty,
+                                     Quantity original_qty) {
+  return std::format("Filled: {} {} {} @ {} ({} / {})",
+                     v1::Side_Name(fill.side), fill.quantity.to_string(),
+                     fill.symbol, fill.price.to_string(),
+                     cumulative_qty.to_string(), original_qty.to_string());
+}
+
+static std::optional<JournaledFill> parse_fill_entry(const std::string &data) {
+  char side_name[16];
+  char quantity[32];
+  char symbol[64];
+  char price[32];
+  JournaledFill fill{};
+  if (std::sscanf(data.c_str(), "Filled: %15s %31s %63s @ %31s", side_name,
+                  quantity, symbol, price) != 4 ||
+      !v1::Side_Parse(side_name, &fill.side))
+    return std::nullopt;
+  const auto parsed_quantity = Quantity::from_string(quantity);
+  const auto parsed_price = Price::from_string(price);
+  if (!parsed_quantity || !parsed_price)
+    return std::nullopt;
+  fill.quantity = *parsed_quantity;
+  fill.symbol = symbol;
+  fill.price = *parsed_price;
+  return fill;
+}
+
+struct FillProgress {
+  Quantity cumulative_qty;
+  Quantity original_qty;
+};
+
+// The "(5 / 10)" tail of a fill entry: the order's filled quantity after this
+// fill, out of its original quantity
+static std::optional<FillProgress>
+parse_fill_progress(const std::string &data) {
+  const auto open = data.rfind('(');
+  if (open == std::string::npos)
+    return std::nullopt;
+  char cumulative[32];
+  char original[32];
+  if (std::sscanf(data.c_str() + open, "(%31s / %31[^)])", cumulative,
+                  original) != 2)
+    return std::nullopt;
+  const auto parsed_cumulative = Quantity::from_string(cumulative);
+  const auto parsed_original = Quantity::from_string(original);
+  if (!parsed_cumulative || !parsed_original)
+    return std::nullopt;
+  return FillProgress{*parsed_cumulative, *parsed_original};
+}
+
 std::unique_ptr<OrderManager> OrderManager::CreateOrderManager(
     std::unique_ptr<PositionKeeper> pk, std::unique_ptr<IExecutionGateway> gw,
     std::unique_ptr<IJournal> lj, std::unique_ptr<IOrderStore> os,
-    std::unique_ptr<RiskManager> rm) {
-  return std::unique_ptr<OrderManager>(
+    std::unique_ptr<RiskManager> rm, OrderManagerOptions options) {
+  auto manager = std::unique_ptr<OrderManager>(
       new OrderManager(std::move(pk), std::move(gw), std::move(lj),
-                       std::move(os), std::move(rm)));
+                       std::move(os), std::move(rm), options));
+  manager->recover();
+  return manager;
+}
+
+// Each step reads only what is still live: open orders come from the status
+// index, and the journal is only replayed from the last snapshot onwards.
+void OrderManager::recover() {
+  std::size_t mapped = 0;
+  for (const auto &stored : order_store_->get_open_orders()) {
+    // In case the clock has stepped back since these ids were issued
+    if (auto id = CompactOrderId::parse(stored.local_id))
+      id_generator_->advance_past(*id);
+    const Quantity filled = reconcile_fills(stored);
+    const Quantity original =
+        Quantity::checked_from_double(stored.order.quantity())
+            .value_or(Quantity{});
+    // An order the journal shows as complete is terminal: nothing to map
+    if (!stored.broker_id || (!filled.is_zero() && filled >= original))
+      continue;
+    id_mapper_->add_mapping(stored.local_id, *stored.broker_id);
+    add_working(stored.local_id, stored.order, original - filled);
+    ++mapped;
+  }
+
+  SymbolTable &symbols = position_keeper_->symbols();
+
+  Timestamp replay_from{};
+  std::size_t restored = 0;
+  auto snapshot = order_store_->load_position_snapshot();
+  if (snapshot) {
+    replay_from = snapshot->taken_at;
+    for (const auto &position : snapshot->positions)
+      position_keeper_->restore_position(symbols.intern(position.symbol),
+                                         position.quantity, position.avg_price,
+                                         position.realized_pnl);
+    restored = snapshot->positions.size();
+  }
+
+  std::size_t replayed = 0;
+  for (const auto &entry : journal_->get_history(replay_from, clock_->now())) {
+    if (entry.event_type != Event::ORDER_FILLED &&
+        entry.event_type != Event::ORDER_PARTIALLY_FILLED)
+      continue;
+    // Fills up to the snapshot's journal entry are already part of it. Older
+    // snapshots only know their time, which entries logged in the same
+    // instant share.
+    if (snapshot && (snapshot->journal_id ? entry.id <= *snapshot->journal_id
+                                          : entry.timestamp <= replay_from))
+      continue;
+
+    auto fill = parse_fill_entry(entry.data);
+    if (!fill) {
+      journal_->log(Event::ERROR_OCCURRED,
+                    "Cannot replay fill entry: " + entry.data,
+                    entry.correlation_id);
+      continue;
+    }
+    position_keeper_->on_fill(symbols.intern(fill->symbol), fill->quantity,
+                              fill->price, fill->side);
+    ++replayed;
+  }
+
+  journal_->log(Event::SYSTEM_STARTED,
+                std::format("Recovered {} open orders, {} snapshot positions, "
+                            "{} replayed fills",
+                            mapped, restored, replayed));
+}
+
+// Fills are journaled before the store applies them, so a crash or a failed
+// apply_fills() can leave the store behind the journal. Each fill entry
+// records the order's cumulative quantity, and entries past what the store
+// has seen are applied again. Returns the order's filled quantity afterwards.
+Quantity OrderManager::reconcile_fills(const StoredOrder &stored) {
+  std::vector<FillUpdate> missing;
+  Quantity filled = stored.filled_quantity;
+  for (const auto &entry : journal_->get_order_history(stored.local_id)) {
+    if (entry.event_type != Event::ORDER_FILLED &&
+        entry.event_type != Event::ORDER_PARTIALLY_FILLED)
+      continue;
+    auto fill = parse_fill_entry(entry.data);
+    auto progress = parse_fill_progress(entry.data);
+    if (!fill || !progress ||
+        progress->cumulative_qty <= stored.filled_quantity)
+      continue;
+    filled = progress->cumulative_qty;
+    missing.push_back({stored.local_id, fill->quantity, fill->price,
+                       filled >= progress->original_qty
+                           ? OrderStatus::FILLED
+                           : OrderStatus::PARTIALLY_FILLED});
+  }
+  if (missing.empty())
+    return filled;
+
+  if (auto r = order_store_->apply_fills(missing); !r) {
+    journal_->log(Event::ERROR_OCCURRED,
+                  "Cannot reconcile journaled fills: " + r.error().message_,
+                  stored.local_id);
+    return stored.filled_quantity;
+  }
+  return filled;
+}
+
+Result<std::monostate> OrderManager::checkpoint() {
+  PositionSnapshot snapshot;
+  snapshot.taken_at = clock_->now();
+  // Every fill journaled so far is in the positions below
+  snapshot.journal_id = journal_->last_id();
+
+  const SymbolTable &symbols = position_keeper_->symbols();
+  position_keeper_->for_each_position(
+      [&](SymbolId symbol, const PositionKeeper::Position &position) {
+        snapshot.positions.push_back({symbols.name(symbol),
+                                      position.quantity, position.avgPrice,
+                                      position.realizedPnl});
+      });
+
+  auto result = order_store_->save_position_snapshot(snapshot);
+  if (!result) {
+    journal_->log(Event::ERROR_OCCURRED, result.error().message_);
+    return result;
+  }
+
+  fills_since_checkpoint_ = 0;
+  return result;
 }
 
 Result<LocalOrderId>
 OrderManager::processSignal(const v1::StrategySignal &signal) {
   // Create order
   std::string local_id = id_generator_->generate();
-  v1::Order order = createOrderFromSignal(signal);
+  auto created = createOrderFromSignal(signal);
+  if (!created) {
+    journal_->log(Event::ORDER_REJECTED, created.error().message_, local_id);
+    return std::unexpected(created.error());
+  }
+  v1::Order order = std::move(*created);
   order.set_id(local_id);
   journal_->log(Event::ORDER_CREATED, order.DebugString(), order.id());
 
@@ -23,7 +227,7 @@ OrderManager::processSignal(const v1::StrategySignal &signal) {
   stored.order = order;
   stored.local_id = local_id;
   stored.status = OrderStatus::PENDING_SUBMISSION;
-  stored.created_at = LogEntry::timestamp_to_string(LogEntry::now());
+  stored.created_at = clock_->now();
 
   if (auto store_result = order_store_->store_order(stored); !store_result) {
     journal_->log(Event::ERROR_OCCURRED, store_result.error().message_,
@@ -31,7 +235,16 @@ OrderManager::processSignal(const v1::StrategySignal &signal) {
     return std::unexpected(store_result.error());
   }
 
-  // TODO: Risk check
+  if (auto risk = pre_trade_check(order); !risk) {
+    journal_->log(Event::ORDER_REJECTED, risk.error().message_, local_id);
+    if (auto result =
+            order_store_->update_order_status(local_id, OrderStatus::REJECTED);
+        !result) {
+      journal_->log(Event::ERROR_OCCURRED, result.error().message_, local_id);
+      return std::unexpected(result.error());
+    }
+    return std::unexpected(risk.error());
+  }
 
   // Submit to gateway
   auto result = gateway_->submit_order(order);
@@ -54,6 +267,7 @@ OrderManager::processSignal(const v1::StrategySignal &signal) {
   }
 
   id_mapper_->add_mapping(local_id, broker_id);
+  notify_mapping_added();
 
   std::string log_data = "Local: " + local_id + ", Broker: " + broker_id;
   journal_->log(Event::ORDER_SUBMITTED, log_data, local_id);
@@ -66,6 +280,9 @@ OrderManager::processSignal(const v1::StrategySignal &signal) {
     return std::unexpected(result.error());
   }
 
+  add_working(local_id, order,
+              Quantity::checked_from_double(order.quantity())
+                  .value_or(Quantity{}));
   return local_id;
 }
 
@@ -83,8 +300,9 @@ OrderManager::processSignal(const v1::CancelSignal &signal) {
 
   if (result) {
     journal_->log(Event::ORDER_CANCELLED, "Cancelled", local_id);
-    // id_mapper_->remove_mapping(local_id); TODO: Removal after a grace period
-    // (to wait for the execution to complete)
+    // Executions that raced the cancel may still be reported
+    retire_mapping(local_id);
+    close_working(local_id);
     if (auto result =
             order_store_->update_order_status(local_id, OrderStatus::CANCELLED);
         !result) {
@@ -108,9 +326,37 @@ OrderManager::processSignal(const v1::ReplaceSignal &signal) {
 
   std::string new_local_id = id_generator_->generate();
 
-  v1::Order new_order = createOrderFromSignal(signal);
+  auto created = createOrderFromSignal(signal);
+  if (!created) {
+    journal_->log(Event::ORDER_REJECTED, created.error().message_,
+                  new_local_id);
+    return std::unexpected(created.error());
+  }
+  v1::Order new_order = std::move(*created);
   new_order.set_id(new_local_id);
 
+  // The replacement takes the old order's place, so only the new quantity
+  // counts against the position limits
+  std::optional<WorkingOrder> replaced;
+  if (auto it = working_orders_.find(old_local_id);
+      it != working_orders_.end()) {
+    replaced = it->second;
+    close_working(old_local_id);
+  }
+  const auto restore_replaced = [&] {
+    if (!replaced)
+      return;
+    working_orders_.emplace(old_local_id, *replaced);
+    position_keeper_->add_working(replaced->symbol, replaced->side,
+                                  replaced->leaves);
+  };
+
+  if (auto risk = pre_trade_check(new_order); !risk) {
+    journal_->log(Event::ORDER_REJECTED, risk.error().message_, new_local_id);
+    restore_replaced();
+    return std::unexpected(risk.error());
+  }
+
   journal_->log(Event::ORDER_REPLACED,
                 "Replacing " + old_local_id + " with " + new_local_id,
                 new_local_id);
@@ -118,6 +364,7 @@ OrderManager::processSignal(const v1::ReplaceSignal &signal) {
   auto result = gateway_->replace_order(*old_broker_id, new_order);
   if (!result) {
     journal_->log(Event::ORDER_REJECTED, result.error().message_, new_local_id);
+    restore_replaced();
     return std::unexpected(result.error());
   }
 
@@ -135,7 +382,7 @@ OrderManager::processSignal(const v1::ReplaceSignal &signal) {
   stored.local_id = new_local_id;
   stored.broker_id = new_broker_id;
   stored.status = OrderStatus::SUBMITTED;
-  stored.created_at = LogEntry::timestamp_to_string(LogEntry::now());
+  stored.created_at = clock_->now();
 
   if (auto store_result = order_store_->store_order(stored); !store_result) {
     journal_->log(Event::ERROR_OCCURRED, store_result.error().message_,
@@ -143,8 +390,12 @@ OrderManager::processSignal(const v1::ReplaceSignal &signal) {
     return std::unexpected(store_result.error());
   }
 
-  id_mapper_->remove_mapping(old_local_id);
+  retire_mapping(old_local_id);
   id_mapper_->add_mapping(new_local_id, new_broker_id);
+  notify_mapping_added();
+  add_working(new_local_id, new_order,
+              Quantity::checked_from_double(new_order.quantity())
+                  .value_or(Quantity{}));
 
   std::string log_data = std::format("Old: {} -> New: {} (Broker: {})", old_local_id, new_local_id, new_broker_id);
 
@@ -153,24 +404,63 @@ OrderManager::processSignal(const v1::ReplaceSignal &signal) {
   return new_local_id;
 }
 
-// Called periodically by TradingEngine::Run(). Asks the gateway for any fills
-// that arrived since the last poll, then for each ExecutionReport:
-//   1. Resolves the local order ID via the bidirectional ID mapper.
-//   2. Fetches the stored order to compare filled vs original quantity.
-//   3. Updates fill info (quantity, avg price) in the order store.
-//   4. Sets the order status to FILLED or PARTIALLY_FILLED.
+// Called by the StrategyWorker on every fill notification (or poll tick).
+// Asks the gateway for any fills that arrived since the last call. Each
+// ExecutionReport carries the quantity of that execution (a delta), so for
+// each one:
+//   0. Converts the report's quantity and price to fixed point; nothing past
+//      this point works in floating point. Reports with values that do not
+//      fit are logged and dropped.
+//   1. Resolves the local order ID via the bidirectional ID mapper. Fills that
+//      cannot be resolved yet are retried on later calls until their grace
+//      deadline passes.
+//   2. Fetches the stored order and adds the delta to its cumulative filled
+//      quantity to decide between FILLED and PARTIALLY_FILLED.
+// Then, for the batch as a whole:
+//   3. Journals every fill and waits on the journal barrier, so the journal
+//      is never behind the store.
+//   4. Persists every fill (quantity, avg price, status) with one
+//      apply_fills() transaction. If that fails the store stays behind until
+//      recovery reconciles it from the journal.
+// And for each fill:
 //   5. Calls position_keeper_->on_fill() so positions stay up to date.
-//   6. Journals the event.
-//   7. Removes fully-filled orders from the ID mapper (they're terminal).
-void OrderManager::process_fills() {
-  auto fills = gateway_->get_fills();
-
-  for (const auto &fill : fills) {
+//   6. Retires fully-filled orders from the ID mapper (they're terminal).
+// Fills for orders that are already cancelled or replaced still count, but
+// leave the status alone unless they complete the order.
+// Positions are checkpointed once kFillsPerCheckpoint fills have accumulated.
+std::size_t OrderManager::process_fills() {
+  const auto now = clock_->steady_now();
+  expire_retired_mappings();
+
+  // Previously unresolved fills go first so fills are applied in arrival order
+  std::vector<UnresolvedFill> fills;
+  fills.swap(unresolved_fills_);
+  for (auto &report : gateway_->get_fills())
+    fills.push_back({std::move(report), now + kUnresolvedFillGrace});
+
+  struct ResolvedFill {
+    JournaledFill fill;
+    std::string local_id;
+    Quantity cumulative_qty;
+    Quantity original_qty;
+    bool fully_filled;
+  };
+  std::vector<ResolvedFill> resolved;
+  std::vector<FillUpdate> updates;
+  // Running cumulative quantity, for orders filled more than once in a batch
+  std::unordered_map<std::string, Quantity> cumulative;
+
+  for (auto &pending : fills) {
+    const auto &fill = pending.report;
     const std::string &broker_id = fill.broker_order_id();
 
     // 1. Resolve broker → local ID
     auto local_id_opt = id_mapper_->get_local_id(broker_id);
     if (!local_id_opt) {
+      if (now < pending.deadline) {
+        unresolved_fills_.push_back(std::move(pending));
+        continue;
+      }
       journal_->log(Event::ERROR_OCCURRED,
                     "Received fill for unknown broker order: " + broker_id);
       continue;
@@ -186,40 +476,74 @@ void OrderManager::process_fills() {
       continue;
     }
 
-    const double filled_qty = fill.filled_quantity();
-    const double original_qty = stored->order.quantity();
-
-    // 3. Persist fill details
-    if (auto r = order_store_->update_fill_info(local_id, filled_qty,
-                                                fill.avg_fill_price());
-        !r) {
-      journal_->log(Event::ERROR_OCCURRED, r.error().message_, local_id);
+    const auto fill_qty = Quantity::checked_from_double(fill.filled_quantity());
+    const auto fill_price = Price::checked_from_double(fill.avg_fill_price());
+    const auto order_qty =
+        Quantity::checked_from_double(stored->order.quantity());
+    if (!fill_qty || !fill_price || !order_qty) {
+      journal_->log(Event::ERROR_OCCURRED,
+                    std::format("Fill quantity {} or price {} out of range",
+                                fill.filled_quantity(), fill.avg_fill_price()),
+                    local_id);
+      continue;
     }
+    const JournaledFill execution{fill.side(), *fill_qty, fill.symbol(),
+                                  *fill_price};
 
-    // 4. Determine and persist the new order status
-    const bool fully_filled = (filled_qty >= original_qty);
-    const OrderStatus new_status =
-        fully_filled ? OrderStatus::FILLED : OrderStatus::PARTIALLY_FILLED;
+    auto [it, _] = cumulative.try_emplace(local_id, stored->filled_quantity);
+    it->second += execution.quantity;
 
-    if (auto r = order_store_->update_order_status(local_id, new_status); !r) {
-      journal_->log(Event::ERROR_OCCURRED, r.error().message_, local_id);
-    }
-
-    // 5. Update in-memory position
-    position_keeper_->on_fill(fill.symbol(), filled_qty, fill.avg_fill_price(),
-                              fill.side());
+    const Quantity original_qty = *order_qty;
+    const bool fully_filled = (it->second >= original_qty);
+    OrderStatus new_status =
+        fully_filled ? OrderStatus::FILLED : OrderStatus::PARTIALLY_FILLED;
+    if (!fully_filled && is_terminal(stored->status))
+      new_status = stored->status;
 
-    // 6. Journal the event
-    const std::string log_data = std::format("Filled: {} / {} @ avg=", filled_qty, original_qty, fill.avg_fill_price());
+    updates.push_back(
+        {local_id, execution.quantity, execution.price, new_status});
+    resolved.push_back(
+        {execution, local_id, it->second, original_qty, fully_filled});
+  }
 
-    journal_->log(fully_filled ? Event::ORDER_FILLED
-                               : Event::ORDER_PARTIALLY_FILLED,
-                  log_data, local_id);
+  // 3. Journal the fills before the store sees them. Recovery rebuilds
+  // positions from journaled fills only, so a crash between the two writes
+  // must leave the journal ahead of the store, never behind it.
+  for (const auto &applied : resolved)
+    journal_->log(applied.fully_filled ? Event::ORDER_FILLED
+                                       : Event::ORDER_PARTIALLY_FILLED,
+                  format_fill_entry(applied.fill, applied.cumulative_qty,
+                                    applied.original_qty),
+                  applied.local_id);
+  if (!resolved.empty())
+    journal_->barrier();
+
+  // 4. Persist the whole batch in one store transaction
+  if (auto r = order_store_->apply_fills(updates); !r)
+    journal_->log(Event::ERROR_OCCURRED, r.error().message_);
+
+  for (const auto &applied : resolved) {
+    const auto &fill = applied.fill;
+
+    // 5. Update in-memory position. The order's symbol was known when it
+    // was submitted, so a fill for any other is the gateway's mistake.
+    reduce_working(applied.local_id, fill.quantity);
+    if (auto symbol = position_keeper_->symbols().find(fill.symbol))
+      position_keeper_->on_fill(*symbol, fill.quantity, fill.price, fill.side);
+    else
+      journal_->log(Event::ERROR_OCCURRED,
+                    "Fill for unknown symbol " + fill.symbol,
+                    applied.local_id);
 
-    // 7. Remove fully-filled orders from the mapper — they are terminal
-    if (fully_filled)
-      id_mapper_->remove_mapping(local_id);
+    // 6. Retire fully-filled orders from the mapper — they are terminal
+    if (applied.fully_filled)
+      retire_mapping(applied.local_id);
   }
+
+  fills_since_checkpoint_ += resolved.size();
+  if (fills_since_checkpoint_ >= kFillsPerCheckpoint)
+    checkpoint();
+  return resolved.size();
 }
 
 // Iterates every open order from the order store, attempts a gateway
@@ -246,7 +570,8 @@ void OrderManager::cancel_all(const std::string &reason,
         return;
       }
 
-      id_mapper_->remove_mapping(stored.local_id);
+      retire_mapping(stored.local_id);
+      close_working(stored.local_id);
       journal_->log(Event::ORDER_CANCELLED, "Cancelled by kill switch",
                     stored.local_id);
     } else {
@@ -258,6 +583,88 @@ void OrderManager::cancel_all(const std::string &reason,
   }
 }
 
+// Only symbols already in the table can be traded: they are interned from
+// configuration or market data, never from an order, so clients cannot grow
+// the table (or the gateway's per-symbol state) with made-up symbols.
+// Market orders carry no price; until the symbol has a mark, the risk checks
+// value them at whatever the gateway expects them to trade near.
+Result<std::monostate> OrderManager::pre_trade_check(const v1::Order &order) {
+  if (!position_keeper_->symbols().find(order.symbol()))
+    return std::unexpected(
+        Error{"Unknown symbol " + order.symbol(), ErrorType::FailedOrder});
+
+  std::optional<Price> fallback_price;
+  if (order.price() <= 0.0)
+    fallback_price = gateway_->reference_price(order.symbol());
+  return risk_manager_->check(order, fallback_price);
+}
+
+bool OrderManager::set_fill_listener(
+    IExecutionGateway::FillListener listener) {
+  fill_listener_ = listener;
+  return gateway_->set_fill_listener(std::move(listener));
+}
+
+// A fill may have been parked in unresolved_fills_ while this mapping was
+// being created; wake the fill loop so it gets retried right away.
+void OrderManager::notify_mapping_added() {
+  if (fill_listener_)
+    fill_listener_();
+}
+
+void OrderManager::retire_mapping(const std::string &local_id) {
+  // Expiring first keeps the wheel to about one grace period of entries
+  expire_retired_mappings();
+  if (auto broker_id = id_mapper_->retire_mapping(local_id))
+    retired_mappings_.schedule(clock_->steady_now() + mapping_grace_,
+                               std::move(*broker_id));
+}
+
+void OrderManager::expire_retired_mappings() {
+  retired_mappings_.advance(clock_->steady_now(),
+                            [this](const BrokerOrderId &broker_id) {
+                              id_mapper_->remove_retired(broker_id);
+                            });
+}
+
+// Orders for symbols outside the table never get this far, and one with no
+// quantity has nothing working
+void OrderManager::add_working(const std::string &local_id,
+                               const v1::Order &order, Quantity leaves) {
+  const auto symbol = position_keeper_->symbols().find(order.symbol());
+  if (!symbol || leaves <= Quantity{})
+    return;
+  working_orders_.insert_or_assign(local_id,
+                                   WorkingOrder{*symbol, order.side(), leaves});
+  position_keeper_->add_working(*symbol, order.side(), leaves);
+}
+
+void OrderManager::reduce_working(const std::string &local_id,
+                                  Quantity filled) {
+  auto it = working_orders_.find(local_id);
+  if (it == working_orders_.end())
+    return;
+  WorkingOrder &working = it->second;
+  const Quantity done = std::min(filled, working.leaves);
+  position_keeper_->add_working(working.symbol, working.side, -done);
+  working.leaves -= done;
+  if (working.leaves.is_zero())
+    working_orders_.erase(it);
+}
+
+void OrderManager::close_working(const std::string &local_id) {
+  auto it = working_orders_.find(local_id);
+  if (it == working_orders_.end())
+    return;
+  const WorkingOrder &working = it->second;
+  position_keeper_->add_working(working.symbol, working.side, -working.leaves);
+  working_orders_.erase(it);
+}
+
+Result<v1::Position> OrderManager::get_position(SymbolId symbol) const {
+  return position_keeper_->getPosition(symbol);
+}
+
 Result<v1::Position>
 OrderManager::get_position(const std::string &symbol) const {
   return position_keeper_->getPosition(symbol);
@@ -271,15 +678,35 @@ OrderManager::OrderManager(std::unique_ptr<PositionKeeper> pk,
                            std::unique_ptr<IExecutionGateway> gw,
                            std::unique_ptr<IJournal> lj,
                            std::unique_ptr<IOrderStore> os,
-                           std::unique_ptr<RiskManager> rm)
+                           std::unique_ptr<RiskManager> rm,
+                           OrderManagerOptions options)
     : position_keeper_(std::move(pk)), gateway_(std::move(gw)),
       journal_(std::move(lj)), order_store_(std::move(os)),
-      risk_manager_(std::move(rm)),
-      id_generator_(std::make_unique<OrderIdGenerator>()),
-      id_mapper_(std::make_unique<OrderIdMapper>()) {}
+      risk_manager_(std::move(rm)), clock_(options.clock),
+      id_generator_(
+          std::make_unique<OrderIdGenerator>(options.id_shard, *clock_)),
+      id_mapper_(std::make_unique<OrderIdMapper>()),
+      mapping_grace_(options.mapping_grace),
+      retired_mappings_(std::max<std::chrono::steady_clock::duration>(
+                            mapping_grace_ / (kRetiredMappingBuckets - 1),
+                            std::chrono::milliseconds{1}),
+                        kRetiredMappingBuckets, clock_->steady_now()) {}
+
+// Everything past here converts the quantity to fixed point, so a NaN or
+// out-of-range one is refused before the order is stored
+static Result<std::monostate> check_target_quantity(double quantity) {
+  if (!Quantity::checked_from_double(quantity))
+    return std::unexpected(Error{
+        std::format("Quantity {} is out of range", quantity),
+        ErrorType::FailedOrder});
+  return std::monostate{};
+}
 
-v1::Order
+Result<v1::Order>
 OrderManager::createOrderFromSignal(const v1::StrategySignal &signal) {
+  if (auto r = check_target_quantity(signal.target_quantity()); !r)
+    return std::unexpected(r.error());
+
   v1::Order order;
   order.set_symbol(signal.symbol());
   order.set_side(signal.side());
@@ -293,7 +720,11 @@ OrderManager::createOrderFromSignal(const v1::StrategySignal &signal) {
   return order;
 }
 
-v1::Order OrderManager::createOrderFromSignal(const v1::ReplaceSignal &signal) {
+Result<v1::Order>
+OrderManager::createOrderFromSignal(const v1::ReplaceSignal &signal) {
+  if (auto r = check_target_quantity(signal.target_quantity()); !r)
+    return std::unexpected(r.error());
+
   v1::Order order;
   order.set_symbol(signal.symbol());
   order.set_side(signal.side());
@@ -0,0 +1,231 @@
+#include <trading/core/order_throttle.h>
+
+#include <algorithm>
+#include <format>
+
+namespace quarcc {
+
+static std::int64_t to_ns(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             t.time_since_epoch())
+      .count();
+}
+
+static Result<std::monostate> throttled(std::string reason) {
+  return std::unexpected(
+      Error{"Throttled: " + std::move(reason), ErrorType::Throttled});
+}
+
+RateLimiter::RateLimiter(RateLimit limit) {
+  if (limit.per_second <= 0.0)
+    return;
+  interval_ns_ = std::max<std::int64_t>(
+      1, static_cast<std::int64_t>(1e9 / limit.per_second));
+  tolerance_ns_ = static_cast<std::int64_t>(
+      (std::max(limit.burst, 1.0) - 1.0) * static_cast<double>(interval_ns_));
+}
+
+bool RateLimiter::try_acquire(Clock::time_point now) {
+  if (interval_ns_ == 0)
+    return true;
+
+  const std::int64_t t = to_ns(now);
+  std::int64_t tat = tat_ns_.load(std::memory_order_relaxed);
+  for (;;) {
+    const std::int64_t start = std::max(tat, t);
+    if (start - t > tolerance_ns_)
+      return false;
+    if (tat_ns_.compare_exchange_weak(tat, start + interval_ns_,
+                                      std::memory_order_relaxed))
+      return true;
+  }
+}
+
+// Pushing the arrival time back one interval undoes exactly one acquire. If
+// the bucket had since refilled past it the refund is simply not needed.
+void RateLimiter::refund() {
+  if (interval_ns_ != 0)
+    tat_ns_.fetch_sub(interval_ns_, std::memory_order_relaxed);
+}
+
+// Slot layout: epoch in the high 32 bits, then 16-bit order and replace
+// counts, each saturating.
+static constexpr std::uint64_t kCountMax = 0xFFFF;
+
+std::uint32_t ReplaceRatioWindow::epoch_of(Clock::time_point now) {
+  return static_cast<std::uint32_t>(
+      now.time_since_epoch() /
+      std::chrono::duration_cast<Clock::duration>(kSlotWidth));
+}
+
+void ReplaceRatioWindow::add(std::uint32_t epoch, bool replace) {
+  auto &slot = slots_[epoch % kSlots];
+  std::uint64_t old = slot.load(std::memory_order_relaxed);
+  for (;;) {
+    std::uint64_t orders = 0, replaces = 0;
+    if ((old >> 32) == epoch) {
+      orders = (old >> 16) & kCountMax;
+      replaces = old & kCountMax;
+    }
+    if (replace)
+      replaces = std::min(replaces + 1, kCountMax);
+    else
+      orders = std::min(orders + 1, kCountMax);
+
+    const std::uint64_t next =
+        (std::uint64_t{epoch} << 32) | (orders << 16) | replaces;
+    if (slot.compare_exchange_weak(old, next, std::memory_order_relaxed))
+      return;
+  }
+}
+
+ReplaceRatioWindow::Counts
+ReplaceRatioWindow::totals(std::uint32_t epoch) const {
+  Counts counts;
+  for (const auto &slot : slots_) {
+    const std::uint64_t value = slot.load(std::memory_order_relaxed);
+    const auto slot_epoch = static_cast<std::uint32_t>(value >> 32);
+    if (static_cast<std::uint32_t>(epoch - slot_epoch) >= kSlots)
+      continue;
+    counts.orders += static_cast<std::uint32_t>((value >> 16) & kCountMax);
+    counts.replaces += static_cast<std::uint32_t>(value & kCountMax);
+  }
+  return counts;
+}
+
+void ReplaceRatioWindow::record_order(Clock::time_point now) {
+  add(epoch_of(now), false);
+}
+
+bool ReplaceRatioWindow::allows_replace(Clock::time_point now,
+                                        double max_ratio,
+                                        std::uint32_t allowance) const {
+  const Counts counts = totals(epoch_of(now));
+  return counts.replaces + 1.0 <= max_ratio * counts.orders + allowance;
+}
+
+void ReplaceRatioWindow::record_replace(Clock::time_point now) {
+  add(epoch_of(now), true);
+}
+
+bool ReplaceRatioWindow::try_replace(Clock::time_point now, double max_ratio,
+                                     std::uint32_t allowance) {
+  if (!allows_replace(now, max_ratio, allowance))
+    return false;
+  record_replace(now);
+  return true;
+}
+
+OrderThrottle::OrderThrottle(ThrottleConfig config, SymbolTable &symbols)
+    : config_(config), symbols_(symbols),
+      unknown_symbols_(config.per_symbol) {}
+
+OrderThrottle::~OrderThrottle() = default;
+
+void OrderThrottle::add_strategy(const std::string &strategy_id) {
+  strategies_.try_emplace(strategy_id,
+                          std::make_unique<Counters>(config_.per_strategy));
+}
+
+OrderThrottle::Counters *
+OrderThrottle::strategy(const std::string &strategy_id) const {
+  auto it = strategies_.find(strategy_id);
+  return it != strategies_.end() ? it->second.get() : nullptr;
+}
+
+OrderThrottle::Counters &OrderThrottle::symbol(const std::string &symbol) {
+  const SymbolId id = symbols_.find(symbol).value_or(kUnknownSymbol);
+  if (id >= by_symbol_.capacity())
+    return unknown_symbols_;
+  if (Counters *counters = by_symbol_.get(id))
+    return *counters;
+
+  std::lock_guard lock(symbol_mutex_);
+  if (Counters *counters = by_symbol_.get(id))
+    return *counters;
+  symbol_storage_.push_back(std::make_unique<Counters>(config_.per_symbol));
+  by_symbol_.set(id, symbol_storage_.back().get());
+  return *symbol_storage_.back();
+}
+
+// Rate limiters are lock-free, so "check every bucket, then take from each"
+// could race; instead each token is taken in turn and the strategy's handed
+// back if the symbol's bucket is empty.
+Result<std::monostate> OrderThrottle::acquire_order(
+    Counters *by_strategy, Counters &by_symbol, const std::string &strategy_id,
+    const std::string &symbol, Clock::time_point now) {
+  if (by_strategy && !by_strategy->orders.try_acquire(now))
+    return throttled(std::format("strategy {} over {:g} orders/s",
+                                 strategy_id,
+                                 config_.per_strategy.orders.per_second));
+
+  if (!by_symbol.orders.try_acquire(now)) {
+    if (by_strategy)
+      by_strategy->orders.refund();
+    return throttled(std::format("{} over {:g} orders/s", symbol,
+                                 config_.per_symbol.orders.per_second));
+  }
+  return std::monostate{};
+}
+
+Result<std::monostate> OrderThrottle::check(const v1::StrategySignal &signal,
+                                            Clock::time_point now) {
+  Counters *by_strategy = strategy(signal.strategy_id());
+  Counters &by_symbol = symbol(signal.symbol());
+  if (auto r = acquire_order(by_strategy, by_symbol, signal.strategy_id(),
+                             signal.symbol(), now);
+      !r)
+    return r;
+
+  if (by_strategy)
+    by_strategy->replaces.record_order(now);
+  by_symbol.replaces.record_order(now);
+  return std::monostate{};
+}
+
+Result<std::monostate> OrderThrottle::check(const v1::CancelSignal &signal,
+                                            Clock::time_point now) {
+  Counters *by_strategy = strategy(signal.strategy_id());
+  if (by_strategy && !by_strategy->cancels.try_acquire(now))
+    return throttled(std::format("strategy {} over {:g} cancels/s",
+                                 signal.strategy_id(),
+                                 config_.per_strategy.cancels.per_second));
+  return std::monostate{};
+}
+
+// The replace ratios are only read until every limit has passed, then both
+// windows count the replace.
+Result<std::monostate> OrderThrottle::check(const v1::ReplaceSignal &signal,
+                                            Clock::time_point now) {
+  const ThrottleLimits &strategy_limits = config_.per_strategy;
+  const ThrottleLimits &symbol_limits = config_.per_symbol;
+  Counters *by_strategy = strategy(signal.strategy_id());
+  Counters &by_symbol = symbol(signal.symbol());
+
+  if (by_strategy && strategy_limits.max_replace_ratio > 0.0 &&
+      !by_strategy->replaces.allows_replace(now,
+                                            strategy_limits.max_replace_ratio,
+                                            strategy_limits.replace_allowance))
+    return throttled(std::format("strategy {} over {:g} replaces per order",
+                                 signal.strategy_id(),
+                                 strategy_limits.max_replace_ratio));
+  if (symbol_limits.max_replace_ratio > 0.0 &&
+      !by_symbol.replaces.allows_replace(now, symbol_limits.max_replace_ratio,
+                                         symbol_limits.replace_allowance))
+    return throttled(std::format("{} over {:g} replaces per order",
+                                 signal.symbol(),
+                                 symbol_limits.max_replace_ratio));
+
+  if (auto r = acquire_order(by_strategy, by_symbol, signal.strategy_id(),
+                             signal.symbol(), now);
+      !r)
+    return r;
+
+  if (by_strategy && strategy_limits.max_replace_ratio > 0.0)
+    by_strategy->replaces.record_replace(now);
+  if (symbol_limits.max_replace_ratio > 0.0)
+    by_symbol.replaces.record_replace(now);
+  return std::monostate{};
+}
+
+} // namespace quarcc
@@ -1,7 +1,16 @@
 #include <trading/core/position_keeper.h>
 
+#include <algorithm>
+
 namespace quarcc {
 
+PositionKeeper::PositionKeeper(AggregatePositionBook *book,
+                               const MarkPriceCache *marks,
+                               SymbolTable &symbols)
+    : book_(book), marks_(marks), symbols_(symbols) {}
+
+PositionKeeper::~PositionKeeper() = default;
+
 // Applies a broker fill to the in-memory position using signed quantity and
 // a weighted-average entry price.
 //
@@ -14,32 +23,44 @@ namespace quarcc {
 //  - Position flips sides: avg = fill_price of new side
 //  - Goes flat: avg = 0
 //  - fill_price == 0 (gateway didn't provide it): update qty only
-void PositionKeeper::on_fill(const std::string &symbol, double fill_qty,
-                             double fill_price, v1::Side side) {
-  if (fill_qty <= 0.0)
+//
+// Quantities and prices are fixed point, so "goes flat" is an exact test.
+//
+// Realized PnL: the part of a fill that closes existing quantity realizes
+// (fill_price - avg) per unit for longs and (avg - fill_price) for shorts.
+void PositionKeeper::on_fill(SymbolId symbol, Quantity fill_qty,
+                             Price fill_price, v1::Side side) {
+  const Quantity zero{};
+  if (fill_qty <= zero)
     return;
 
-  std::unique_lock lock(mutex_);
-  auto &pos = positions_[symbol];
-  pos.symbol = symbol;
+  std::lock_guard lock(write_mutex_);
+  Slot *slot = slots_.get(symbol);
+  Position pos = slot ? slot->value.load() : Position{};
 
-  const double signed_fill = (side == v1::Side::BUY) ? fill_qty : -fill_qty;
-  const double old_qty = pos.quantity;
-  const double new_qty = old_qty + signed_fill;
+  const Quantity signed_fill = (side == v1::Side::BUY) ? fill_qty : -fill_qty;
+  const Quantity old_qty = pos.quantity;
+  const Quantity new_qty = old_qty + signed_fill;
 
-  if (fill_price > 0.0) {
-    if (new_qty == 0.0) {
+  if (fill_price > Price{}) {
+    if (!old_qty.is_zero() && (old_qty > zero) != (signed_fill > zero)) {
+      const Quantity closed = std::min(fill_qty, abs(old_qty));
+      const Price per_unit = fill_price - pos.avgPrice;
+      pos.realizedPnl += (old_qty > zero ? closed : -closed) * per_unit;
+    }
+
+    if (new_qty.is_zero()) {
       // Position went flat
-      pos.avgPrice = 0.0;
-    } else if (old_qty == 0.0) {
+      pos.avgPrice = Price{};
+    } else if (old_qty.is_zero()) {
       // Opening a brand-new position
       pos.avgPrice = fill_price;
-    } else if ((old_qty > 0.0 && new_qty < 0.0) ||
-               (old_qty < 0.0 && new_qty > 0.0)) {
+    } else if ((old_qty > zero && new_qty < zero) ||
+               (old_qty < zero && new_qty > zero)) {
       // Position flipped sides; the new position's cost basis is the fill
       pos.avgPrice = fill_price;
-    } else if ((old_qty > 0.0 && signed_fill > 0.0) ||
-               (old_qty < 0.0 && signed_fill < 0.0)) {
+    } else if ((old_qty > zero && signed_fill > zero) ||
+               (old_qty < zero && signed_fill < zero)) {
       // Adding to the existing side: weighted average
       pos.avgPrice =
           (old_qty * pos.avgPrice + signed_fill * fill_price) / new_qty;
@@ -48,38 +69,114 @@ void PositionKeeper::on_fill(const std::string &symbol, double fill_qty,
   }
 
   pos.quantity = new_qty;
+  store(symbol, pos);
+}
+
+void PositionKeeper::add_working(SymbolId symbol, v1::Side side,
+                                 Quantity delta) {
+  std::lock_guard lock(write_mutex_);
+  Seqlocked<WorkingQuantity> *cell = working_.get(symbol);
+  if (!cell) {
+    cell = owned_working_
+               .emplace_back(std::make_unique<Seqlocked<WorkingQuantity>>())
+               .get();
+    working_.set(symbol, cell);
+  }
+
+  WorkingQuantity working = cell->load();
+  working.add(side, delta);
+  cell->store(working);
+
+  if (book_)
+    book_->apply_working(symbol, side, delta);
+}
+
+void PositionKeeper::restore_position(SymbolId symbol, Quantity quantity,
+                                      Price avg_price, Money realized_pnl) {
+  std::lock_guard lock(write_mutex_);
+  store(symbol, Position{quantity, avg_price, realized_pnl});
+}
+
+Result<v1::Position> PositionKeeper::getPosition(SymbolId symbol) const {
+  const Slot *slot = slots_.get(symbol);
+  if (!slot) {
+    return std::unexpected(Error{"Position not found", ErrorType::Error});
+  }
+
+  return to_proto(symbol, slot->value.load());
 }
 
 Result<v1::Position>
 PositionKeeper::getPosition(const std::string &symbol) const {
-  std::shared_lock lock(mutex_);
-
-  auto it = positions_.find(symbol);
-  if (it == positions_.end()) {
+  auto id = symbols_.find(symbol);
+  if (!id) {
     return std::unexpected(Error{"Position not found", ErrorType::Error});
   }
 
-  v1::Position pos;
-  pos.set_symbol(it->second.symbol);
-  pos.set_quantity(it->second.quantity);
-  pos.set_avg_price(it->second.avgPrice);
+  return getPosition(*id);
+}
 
-  return pos;
+Quantity PositionKeeper::quantity(SymbolId symbol) const {
+  const Slot *slot = slots_.get(symbol);
+  return slot ? slot->value.load().quantity : Quantity{};
 }
 
-v1::PositionList PositionKeeper::getAllPositions() const {
-  std::shared_lock lock(mutex_);
+WorkingQuantity PositionKeeper::working(SymbolId symbol) const {
+  const Seqlocked<WorkingQuantity> *cell = working_.get(symbol);
+  return cell ? cell->load() : WorkingQuantity{};
+}
 
+v1::PositionList PositionKeeper::getAllPositions() const {
   v1::PositionList all_pos;
-  for (const auto &[symbol, curr_pos] : positions_) {
-    v1::Position pos;
-    pos.set_symbol(curr_pos.symbol);
-    pos.set_quantity(curr_pos.quantity);
-    pos.set_avg_price(curr_pos.avgPrice);
-    all_pos.add_positions()->CopyFrom(pos);
+  const SymbolId end = slots_.end();
+  for (SymbolId id = 0; id < end; ++id) {
+    if (const Slot *slot = slots_.get(id))
+      *all_pos.add_positions() = to_proto(id, slot->value.load());
   }
 
   return all_pos;
 }
 
+void PositionKeeper::for_each_position(
+    const std::function<void(SymbolId, const Position &)> &visit) const {
+  const SymbolId end = slots_.end();
+  for (SymbolId id = 0; id < end; ++id) {
+    if (const Slot *slot = slots_.get(id))
+      visit(id, slot->value.load());
+  }
+}
+
+// Caller holds write_mutex_
+void PositionKeeper::store(SymbolId symbol, const Position &position) {
+  Slot *slot = slots_.get(symbol);
+  const Position previous = slot ? slot->value.load() : Position{};
+
+  if (slot) {
+    slot->value.store(position);
+  } else {
+    // The slot is fully initialised before it becomes reachable
+    slots_.set(
+        symbol,
+        owned_slots_.emplace_back(std::make_unique<Slot>(position)).get());
+  }
+
+  if (book_)
+    book_->apply(symbol,
+                 {previous.quantity, previous.avgPrice, previous.realizedPnl},
+                 {position.quantity, position.avgPrice, position.realizedPnl});
+}
+
+v1::Position PositionKeeper::to_proto(SymbolId symbol,
+                                      const Position &position) const {
+  v1::Position pos;
+  pos.set_symbol(symbols_.name(symbol));
+  pos.set_quantity(position.quantity.to_double());
+  pos.set_avg_price(position.avgPrice.to_double());
+  pos.set_realized_pnl(position.realizedPnl.to_double());
+  if (auto mark = marks_ ? marks_->get(symbol) : std::nullopt)
+    pos.set_unrealized_pnl(
+        (position.quantity * (*mark - position.avgPrice)).to_double());
+  return pos;
+}
+
 }; // namespace quarcc
@@ -0,0 +1,161 @@
+#include <trading/core/risk_manager.h>
+
+#include <format>
+
+namespace quarcc {
+
+SharedRiskLimits::SharedRiskLimits(RiskLimits initial) {
+  versions_.push_back(std::make_unique<const RiskLimits>(std::move(initial)));
+  current_.store(versions_.back().get(), std::memory_order_release);
+}
+
+void SharedRiskLimits::publish(RiskLimits limits) {
+  std::lock_guard lock(publish_mutex_);
+  versions_.push_back(std::make_unique<const RiskLimits>(std::move(limits)));
+  current_.store(versions_.back().get(), std::memory_order_release);
+}
+
+namespace detail {
+
+Result<std::monostate> reject(std::string reason) {
+  return std::unexpected(Error{std::move(reason), ErrorType::RiskRejected});
+}
+
+Result<std::monostate> order_quantity_exceeded(Quantity quantity,
+                                               Quantity limit) {
+  return reject(std::format("order quantity {} exceeds limit {}",
+                            quantity.to_string(), limit.to_string()));
+}
+
+Result<std::monostate> order_notional_exceeded(std::optional<Money> notional,
+                                               Money limit) {
+  return reject(std::format("order notional {} exceeds limit {}",
+                            notional ? notional->to_string() : "(overflow)",
+                            limit.to_string()));
+}
+
+Result<std::monostate> position_exceeded(const char *whose, Quantity after,
+                                         Quantity limit) {
+  return reject(std::format("{} position would be {}, limit {}", whose,
+                            after.to_string(), limit.to_string()));
+}
+
+Result<std::monostate> exposure_exceeded(const char *which, Money after,
+                                         Money limit) {
+  return reject(std::format("{} exposure would be {}, limit {}", which,
+                            after.to_string(), limit.to_string()));
+}
+
+Result<std::monostate> unpriced_order() {
+  return reject("no reference price to value the order");
+}
+
+} // namespace detail
+
+RiskManager::RiskManager() = default;
+
+RiskManager::RiskManager(std::string strategy_id,
+                         const SharedRiskLimits &limits,
+                         const PositionKeeper *strategy_positions,
+                         const AggregatePositionBook *firm_positions,
+                         const MarkPriceCache *marks, SymbolTable &symbols)
+    : strategy_id_(std::move(strategy_id)), limits_(&limits),
+      strategy_positions_(strategy_positions), firm_positions_(firm_positions),
+      marks_(marks), symbols_(&symbols),
+      checks_(std::make_unique<DefaultRiskPipeline>()) {}
+
+RiskManager::~RiskManager() = default;
+
+Result<std::monostate> RiskManager::check(const v1::Order &order,
+                                          std::optional<Price> fallback_price) {
+  if (!limits_)
+    return std::monostate{};
+
+  const auto quantity = Quantity::checked_from_double(order.quantity());
+  if (!quantity || *quantity <= Quantity{})
+    return detail::reject(
+        std::format("Risk check failed for {}: invalid quantity {}",
+                    order.symbol(), order.quantity()));
+
+  RiskOrder risk_order;
+  // Not interned: the symbol is unvalidated client input, and one the table
+  // has never seen has no limits, positions or marks of its own anyway
+  risk_order.symbol = symbols_->find(order.symbol()).value_or(kUnknownSymbol);
+  risk_order.side = order.side();
+  risk_order.quantity = *quantity;
+  if (order.price() > 0.0) {
+    risk_order.reference_price =
+        Price::checked_from_double(order.price()).value_or(Price{});
+  } else {
+    const auto mark = marks_ ? marks_->get(risk_order.symbol) : std::nullopt;
+    risk_order.reference_price = mark.or_else([&] { return fallback_price; })
+                                     .value_or(Price{});
+  }
+
+  auto result = check(risk_order);
+  if (!result)
+    result.error().message_ = std::format(
+        "Risk check failed for {}: {}", order.symbol(), result.error().message_);
+  return result;
+}
+
+Result<std::monostate> RiskManager::check(const RiskOrder &order) {
+  if (!limits_)
+    return std::monostate{};
+
+  const RiskLimits &limits = limits_->current();
+  RiskContext context{
+      .limits = limits,
+      .symbol_limits = limits.for_symbol(order.symbol),
+      .strategy_limits = strategy_limits(limits),
+      .strategy_position = strategy_positions_
+                               ? strategy_positions_->quantity(order.symbol)
+                               : Quantity{},
+      .firm_position = firm_positions_
+                           ? firm_positions_->quantity(order.symbol)
+                           : Quantity{},
+      .firm_market_value = firm_positions_
+                               ? firm_positions_->market_value(order.symbol)
+                               : Money{},
+      .gross_exposure = {},
+      .net_exposure = {},
+      .strategy_working =
+          strategy_positions_
+              ? strategy_positions_->working(order.symbol).toward(order.side)
+              : Quantity{},
+      .firm_working =
+          firm_positions_
+              ? firm_positions_->working(order.symbol).toward(order.side)
+              : Quantity{},
+  };
+  if (firm_positions_) {
+    const auto exposure = firm_positions_->exposure();
+    context.gross_exposure = exposure.gross;
+    context.net_exposure = exposure.net;
+  }
+
+  if (auto result = checks_->check(order, context); !result)
+    return result;
+  if (!extra_checks_.empty())
+    return extra_checks_.check(order, context);
+  return std::monostate{};
+}
+
+void RiskManager::set_checks(std::unique_ptr<IRiskCheck> checks) {
+  checks_ = std::move(checks);
+}
+
+void RiskManager::add_check(std::unique_ptr<IRiskCheck> check) {
+  extra_checks_.add(std::move(check));
+}
+
+const StrategyRiskLimits &
+RiskManager::strategy_limits(const RiskLimits &limits) {
+  if (resolved_table_ != &limits) {
+    resolved_strategy_ = &limits.for_strategy(strategy_id_);
+    resolved_table_ = &limits;
+  }
+  return *resolved_strategy_;
+}
+
+} // namespace quarcc
@@ -0,0 +1,167 @@
+#include <trading/core/strategy_worker.h>
+
+namespace quarcc {
+
+// Only used when the gateway cannot push fills
+static constexpr std::chrono::milliseconds kFillPollInterval{500};
+
+template <class... Ts> struct Overloaded : Ts... {
+  using Ts::operator()...;
+};
+
+StrategyWorker::StrategyWorker(std::unique_ptr<OrderManager> manager)
+    : manager_(std::move(manager)) {
+  gateway_pushes_fills_ =
+      manager_->set_fill_listener([this] { on_fills_ready(); });
+  thread_ = std::thread([this] { run(); });
+  worker_id_.store(thread_.get_id(), std::memory_order_release);
+}
+
+StrategyWorker::~StrategyWorker() { stop(); }
+
+void StrategyWorker::submit(v1::StrategySignal signal,
+                            Completion<LocalOrderId> done) {
+  post(SubmitMsg{std::move(signal), std::move(done)});
+}
+
+void StrategyWorker::cancel(v1::CancelSignal signal,
+                            Completion<std::monostate> done) {
+  post(CancelMsg{std::move(signal), std::move(done)});
+}
+
+void StrategyWorker::replace(v1::ReplaceSignal signal,
+                             Completion<LocalOrderId> done) {
+  post(ReplaceMsg{std::move(signal), std::move(done)});
+}
+
+void StrategyWorker::cancel_all(std::string reason, std::string initiated_by,
+                                std::function<void()> done) {
+  post(CancelAllMsg{std::move(reason), std::move(initiated_by),
+                    std::move(done)});
+}
+
+void StrategyWorker::stop() {
+  if (stopping_.exchange(true))
+    return;
+
+  wakeup_.notify();
+  if (thread_.joinable())
+    thread_.join();
+
+  // Lets the next start replay as little of the journal as possible
+  manager_->checkpoint();
+}
+
+// stopping_ and posting_ are sequentially consistent, so either a racing
+// post sees stopping_ and is refused, or the worker sees it in posting_ and
+// drains it. Posts from the worker itself (fill notifications raised while it
+// handles a message) are still taken, since the last drain runs until the
+// inbox is empty.
+void StrategyWorker::post(Message msg) {
+  posting_.fetch_add(1);
+  if (stopping_.load() &&
+      std::this_thread::get_id() !=
+          worker_id_.load(std::memory_order_acquire)) {
+    posting_.fetch_sub(1);
+    reject(msg);
+    return;
+  }
+  inbox_.push(std::move(msg));
+  posting_.fetch_sub(1, std::memory_order_release);
+  wakeup_.notify();
+}
+
+void StrategyWorker::reject(Message &msg) {
+  const Error stopped{"Strategy worker is stopped", ErrorType::Error};
+  std::visit(Overloaded{
+                 [&](SubmitMsg &m) {
+                   if (m.done)
+                     m.done(std::unexpected(stopped));
+                 },
+                 [&](CancelMsg &m) {
+                   if (m.done)
+                     m.done(std::unexpected(stopped));
+                 },
+                 [&](ReplaceMsg &m) {
+                   if (m.done)
+                     m.done(std::unexpected(stopped));
+                 },
+                 [](CancelAllMsg &m) {
+                   if (m.done)
+                     m.done();
+                 },
+                 [](FillsReadyMsg &) {},
+             },
+             msg);
+}
+
+// Called by the gateway, possibly from its own thread or from inside a
+// submit_order() running on this worker. Coalesces bursts of notifications
+// into a single queued FillsReadyMsg, which is ordered after any signal that
+// was already in the inbox so the broker id mapping exists by the time the
+// fill is applied.
+void StrategyWorker::on_fills_ready() {
+  if (!fills_queued_.exchange(true, std::memory_order_acq_rel))
+    post(FillsReadyMsg{});
+}
+
+void StrategyWorker::run() {
+  auto next_poll = std::chrono::steady_clock::now() + kFillPollInterval;
+
+  while (true) {
+    if (gateway_pushes_fills_)
+      wakeup_.wait();
+    else
+      wakeup_.wait_for(next_poll - std::chrono::steady_clock::now());
+
+    while (auto msg = inbox_.try_pop())
+      handle(*msg);
+
+    if (!gateway_pushes_fills_ &&
+        std::chrono::steady_clock::now() >= next_poll) {
+      manager_->process_fills();
+      next_poll = std::chrono::steady_clock::now() + kFillPollInterval;
+    }
+
+    if (stopping_.load()) {
+      // Anything posted before stop() still gets processed
+      while (posting_.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+      while (auto msg = inbox_.try_pop())
+        handle(*msg);
+      return;
+    }
+  }
+}
+
+void StrategyWorker::handle(Message &msg) {
+  std::visit(Overloaded{
+                 [this](SubmitMsg &m) {
+                   auto r = manager_->processSignal(m.signal);
+                   if (m.done)
+                     m.done(std::move(r));
+                 },
+                 [this](CancelMsg &m) {
+                   auto r = manager_->processSignal(m.signal);
+                   if (m.done)
+                     m.done(std::move(r));
+                 },
+                 [this](ReplaceMsg &m) {
+                   auto r = manager_->processSignal(m.signal);
+                   if (m.done)
+                     m.done(std::move(r));
+                 },
+                 [this](CancelAllMsg &m) {
+                   manager_->cancel_all(m.reason, m.initiated_by);
+                   if (m.done)
+                     m.done();
+                 },
+                 [this](FillsReadyMsg &) {
+                   fills_queued_.store(false, std::memory_order_release);
+                   manager_->process_fills();
+                 },
+             },
+             msg);
+}
+
+} // namespace quarcc
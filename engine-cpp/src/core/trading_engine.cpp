@@ -1,140 +1,190 @@
 #include <trading/core/trading_engine.h>
-#include <trading/persistence/sqlite_journal.h>
+#include <trading/persistence/caching_order_store.h>
+#include <trading/persistence/journal_factory.h>
 #include <trading/persistence/sqlite_order_store.h>
 #include <trading/gateways/paper_trading_gateway.h>
+#include <trading/utils/symbol_table.h>
 
-#include <chrono>
-#include <thread>
+#include <atomic>
+#include <future>
 
 namespace quarcc {
 
-static constexpr std::chrono::milliseconds kFillPollInterval{500};
+// Blocks the caller until the strategy worker has processed the request
+// posted by `post`.
+template <typename T, typename Post> static Result<T> await_worker(Post post) {
+  std::promise<Result<T>> promise;
+  auto future = promise.get_future();
+  post([&promise](Result<T> r) { promise.set_value(std::move(r)); });
+  return future.get();
+}
+
+TradingEngine::TradingEngine(TradingEngineOptions options)
+    : options_(std::move(options)), risk_limits_(options_.risk),
+      throttle_(options_.throttle) {
+  for (const auto &symbol : options_.symbols)
+    SymbolTable::global().intern(symbol);
+}
 
 void TradingEngine::Run() {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
   // TODO: config.h, reading configs from user to create strategies
-  managers_.emplace(
-      StrategyId{"SMA_CROSS_v1.0"},
-      OrderManager::CreateOrderManager(
-          std::make_unique<PositionKeeper>(), std::make_unique<PaperGateway>(),
-          std::make_unique<SQLiteJournal>("SMA_CROSS_v1_trading_journal.db"),
-          std::make_unique<SQLiteOrderStore>("SMA_CROSS_v1_trading_orders.db"),
-          std::make_unique<RiskManager>()));
-
-  server_ = std::make_unique<gRPCServer>("0.0.0.0:50051", *this);
+  const StrategyId strategy_id{"SMA_CROSS_v1.0"};
+  auto keeper = std::make_unique<PositionKeeper>(&positions_, &marks_);
+  auto risk = std::make_unique<RiskManager>(strategy_id, risk_limits_,
+                                            keeper.get(), &positions_, &marks_);
+  workers_.emplace(
+      strategy_id,
+      std::make_unique<StrategyWorker>(OrderManager::CreateOrderManager(
+          std::move(keeper),
+          std::make_unique<PaperGateway>(PaperGatewayOptions{
+              .venue = {},
+              .reference_prices = {},
+              .on_price = [this](SymbolId symbol,
+                                 Price price) { marks_.update(symbol, price); },
+              .clock = options_.clock}),
+          make_journal("SMA_CROSS_v1_trading_journal", options_.journal,
+                       *options_.clock),
+          std::make_unique<CachingOrderStore>(
+              std::make_unique<SQLiteOrderStore>(
+                  "SMA_CROSS_v1_trading_orders.db", *options_.clock),
+              *options_.clock),
+          std::move(risk),
+          {.id_shard = static_cast<std::uint32_t>(workers_.size()),
+           .clock = options_.clock})));
+  throttle_.add_strategy(strategy_id);
+
+  server_ = std::make_unique<gRPCServer>(options_.listen_address, *this,
+                                         options_.server);
   server_->start();
 
-  while (running_) {
-    for (auto &[strategy_id, manager] : managers_)
-      manager->process_fills();
-
-    std::this_thread::sleep_for(kFillPollInterval);
-  }
+  while (running_)
+    shutdown_notifier_.wait();
 
   server_->shutdown();
+  for (auto &[strategy_id, worker] : workers_)
+    worker->stop();
   google::protobuf::ShutdownProtobufLibrary();
 }
 
-// Submit/Cancel/Replace orders through custom gateway
+void TradingEngine::ReloadRiskLimits(RiskLimits limits) {
+  risk_limits_.publish(std::move(limits));
+}
+
+void TradingEngine::UpdateMarkPrice(const std::string &symbol, Price price) {
+  marks_.update(SymbolTable::global().intern(symbol), price);
+}
+
+// Submit/Cancel/Replace orders through custom gateway. The async variants
+// only throttle and route to the strategy's worker; `done` runs on that
+// worker's thread, or on the caller's when the signal is refused up front.
+void TradingEngine::SubmitSignalAsync(const v1::StrategySignal &signal,
+                                      Completion<BrokerOrderId> done) {
+  auto it = workers_.find(signal.strategy_id());
+  if (it == workers_.end())
+    return done(std::unexpected(Error{"Unknown strategy", ErrorType::Error}));
+  if (auto throttled =
+          throttle_.check(signal, options_.clock->steady_now());
+      !throttled)
+    return done(std::unexpected(throttled.error()));
+  it->second->submit(signal, std::move(done));
+}
+
+void TradingEngine::CancelOrderAsync(const v1::CancelSignal &signal,
+                                     Completion<std::monostate> done) {
+  auto it = workers_.find(signal.strategy_id());
+  if (it == workers_.end())
+    return done(std::unexpected(Error{"Unknown strategy", ErrorType::Error}));
+  if (auto throttled =
+          throttle_.check(signal, options_.clock->steady_now());
+      !throttled)
+    return done(std::unexpected(throttled.error()));
+  it->second->cancel(signal, std::move(done));
+}
+
+void TradingEngine::ReplaceOrderAsync(const v1::ReplaceSignal &signal,
+                                      Completion<BrokerOrderId> done) {
+  auto it = workers_.find(signal.strategy_id());
+  if (it == workers_.end())
+    return done(std::unexpected(Error{"Unknown strategy", ErrorType::Error}));
+  if (auto throttled =
+          throttle_.check(signal, options_.clock->steady_now());
+      !throttled)
+    return done(std::unexpected(throttled.error()));
+  it->second->replace(signal, std::move(done));
+}
+
 Result<BrokerOrderId>
 TradingEngine::SubmitSignal(const v1::StrategySignal &signal) {
-  auto it = managers_.find(signal.strategy_id());
-  if (it == managers_.end())
-    return std::unexpected(Error{"Unknown strategy", ErrorType::Error});
-  return it->second->processSignal(signal);
+  return await_worker<BrokerOrderId>(
+      [&](auto done) { SubmitSignalAsync(signal, std::move(done)); });
 }
 
 Result<std::monostate>
 TradingEngine::CancelOrder(const v1::CancelSignal &signal) {
-  auto it = managers_.find(signal.strategy_id());
-  if (it == managers_.end())
-    return std::unexpected(Error{"Unknown strategy", ErrorType::Error});
-  return it->second->processSignal(signal);
+  return await_worker<std::monostate>(
+      [&](auto done) { CancelOrderAsync(signal, std::move(done)); });
 }
 
 Result<BrokerOrderId>
 TradingEngine::ReplaceOrder(const v1::ReplaceSignal &signal) {
-  auto it = managers_.find(signal.strategy_id());
-  if (it == managers_.end())
-    return std::unexpected(Error{"Unknown strategy", ErrorType::Error});
-  return it->second->processSignal(signal);
+  return await_worker<BrokerOrderId>(
+      [&](auto done) { ReplaceOrderAsync(signal, std::move(done)); });
 }
 
-// Collects across all strategies, if multiple strategies hold the same symbol,
-// it sums up the quantity and makes an weighted average of the price
+// Firm-wide position: quantities summed across strategies, average price
+// weighted by quantity. Maintained incrementally by the aggregate book.
 Result<v1::Position>
 TradingEngine::GetPosition(const v1::GetPositionRequest &req) {
-  v1::Position combined;
-  combined.set_symbol(req.symbol());
-  bool found = false;
-
-  for (const auto &[strategy_id, manager] : managers_) {
-    auto pos = manager->get_position(req.symbol());
-    if (!pos)
-      continue;
-
-    found = true;
-    const double existing_qty = combined.quantity();
-    const double new_qty = existing_qty + pos->quantity();
-
-    if (new_qty != 0.0 && existing_qty != 0.0) {
-      combined.set_avg_price((existing_qty * combined.avg_price() +
-                              pos->quantity() * pos->avg_price()) /
-                             new_qty);
-    } else if (pos->quantity() != 0.0) {
-      combined.set_avg_price(pos->avg_price());
-    }
-    combined.set_quantity(new_qty);
-  }
+  const auto symbol = SymbolTable::global().find(req.symbol());
+  if (!symbol)
+    return std::unexpected(
+        Error{"No position found for " + req.symbol(), ErrorType::Error});
 
-  if (!found)
+  auto pos = positions_.get(*symbol);
+  if (!pos)
     return std::unexpected(
         Error{"No position found for " + req.symbol(), ErrorType::Error});
 
-  return combined;
+  return pos;
 }
 
-// Collects positions from every strategy and merges entries for the same symbol
-// (sum of quantities, weighted-average price)
 Result<v1::PositionList> TradingEngine::GetAllPositions(const v1::Empty &) {
-  std::unordered_map<std::string, v1::Position> combined;
-
-  for (const auto &[strategy_id, manager] : managers_) {
-    const v1::PositionList list = manager->get_all_positions();
-    for (const auto &pos : list.positions()) {
-      auto it = combined.find(pos.symbol());
-      if (it == combined.end()) {
-        combined[pos.symbol()] = pos;
-      } else {
-        v1::Position &existing = it->second;
-        const double new_qty = existing.quantity() + pos.quantity();
-        if (new_qty != 0.0) {
-          existing.set_avg_price((existing.quantity() * existing.avg_price() +
-                                  pos.quantity() * pos.avg_price()) /
-                                 new_qty);
-        }
-        existing.set_quantity(new_qty);
-      }
-    }
-  }
-
-  v1::PositionList result;
-  for (auto &[symbol, pos] : combined)
-    result.add_positions()->CopyFrom(pos);
-
-  return result;
+  return positions_.snapshot()->positions;
 }
 
-// Stops running, cancels all cancellable orders
 Result<std::monostate>
 TradingEngine::ActivateKillSwitch(const v1::KillSwitchRequest &req) {
-  running_ = false;
+  return await_worker<std::monostate>(
+      [&](auto done) { ActivateKillSwitchAsync(req, std::move(done)); });
+}
 
-  for (auto &[strategy_id, manager] : managers_)
-    manager->cancel_all(req.reason(), req.initiated_by());
+// Stops running, cancels all cancellable orders. Every worker cancels in
+// parallel; the last one to finish completes `done` and wakes Run() to shut
+// down.
+void TradingEngine::ActivateKillSwitchAsync(const v1::KillSwitchRequest &req,
+                                            Completion<std::monostate> done) {
+  running_ = false;
+  if (workers_.empty()) {
+    done(std::monostate{});
+    shutdown_notifier_.notify();
+    return;
+  }
 
-  return std::monostate{};
+  struct Pending {
+    std::atomic<std::size_t> workers;
+    Completion<std::monostate> done;
+  };
+  auto pending = std::make_shared<Pending>(workers_.size(), std::move(done));
+  const auto finish = [this, pending] {
+    if (pending->workers.fetch_sub(1, std::memory_order_acq_rel) > 1)
+      return;
+    pending->done(std::monostate{});
+    shutdown_notifier_.notify();
+  };
+  for (auto &[strategy_id, worker] : workers_)
+    worker->cancel_all(req.reason(), req.initiated_by(), finish);
 }
 
 } // namespace quarcc
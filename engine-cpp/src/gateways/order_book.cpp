@@ -0,0 +1,162 @@
+#include <trading/gateways/order_book.h>
+
+#include <utility>
+
+namespace quarcc {
+
+void OrderBook::reserve(std::size_t orders) {
+  nodes_.reserve(orders);
+  free_.reserve(orders);
+}
+
+BookOrderId OrderBook::add(v1::Side side, Price price, Quantity quantity,
+                           std::uint64_t tag) {
+  const std::uint32_t slot = allocate();
+  Node &node = nodes_[slot];
+  node.price = price;
+  node.leaves = quantity;
+  node.tag = tag;
+  node.side = side;
+
+  Levels &levels = resting(side);
+  auto it = find_level(side, price);
+  if (it == levels.end() || it->price != price)
+    it = levels.insert(it, Level{.price = price,
+                                 .total = {},
+                                 .head = kNil,
+                                 .tail = kNil});
+
+  Level &level = *it;
+  node.prev = level.tail;
+  node.next = kNil;
+  if (level.tail != kNil)
+    nodes_[level.tail].next = slot;
+  else
+    level.head = slot;
+  level.tail = slot;
+  level.total += quantity;
+
+  return make_id(slot, node.generation);
+}
+
+bool OrderBook::cancel(BookOrderId id) {
+  if (!lookup(id))
+    return false;
+
+  const auto slot = static_cast<std::uint32_t>(id);
+  const Node &node = nodes_[slot];
+  Levels &levels = resting(node.side);
+  auto it = find_level(node.side, node.price);
+  it->total -= node.leaves;
+  unlink(*it, slot);
+  if (it->head == kNil)
+    levels.erase(it);
+  release(slot);
+  return true;
+}
+
+std::optional<Quantity> OrderBook::leaves(BookOrderId id) const {
+  if (const Node *node = lookup(id))
+    return node->leaves;
+  return std::nullopt;
+}
+
+Quantity OrderBook::available(v1::Side side, std::optional<Price> limit,
+                              Quantity wanted) const {
+  const Levels &book = side == v1::BUY ? asks_ : bids_;
+  Quantity total;
+  for (auto it = book.rbegin(); it != book.rend() && total < wanted; ++it) {
+    if (limit && !crosses(side, *limit, it->price))
+      break;
+    total += it->total;
+  }
+  return total;
+}
+
+std::optional<Price> OrderBook::best_bid() const {
+  if (bids_.empty())
+    return std::nullopt;
+  return bids_.back().price;
+}
+
+std::optional<Price> OrderBook::best_ask() const {
+  if (asks_.empty())
+    return std::nullopt;
+  return asks_.back().price;
+}
+
+Quantity OrderBook::depth(v1::Side side, Price price) const {
+  auto it = find_level(side, price);
+  if (it == resting(side).end() || it->price != price)
+    return {};
+  return it->total;
+}
+
+std::size_t OrderBook::level_count(v1::Side side) const {
+  return resting(side).size();
+}
+
+OrderBook::Levels::iterator OrderBook::find_level(v1::Side side, Price price) {
+  Levels &levels = resting(side);
+  return levels.begin() + (std::as_const(*this).find_level(side, price) -
+                           std::as_const(levels).begin());
+}
+
+OrderBook::Levels::const_iterator OrderBook::find_level(v1::Side side,
+                                                        Price price) const {
+  const Levels &levels = resting(side);
+  if (side == v1::BUY)
+    return std::lower_bound(
+        levels.begin(), levels.end(), price,
+        [](const Level &level, Price p) { return level.price < p; });
+  return std::lower_bound(
+      levels.begin(), levels.end(), price,
+      [](const Level &level, Price p) { return level.price > p; });
+}
+
+const OrderBook::Node *OrderBook::lookup(BookOrderId id) const {
+  const auto slot = static_cast<std::uint32_t>(id);
+  if (slot >= nodes_.size())
+    return nullptr;
+  const Node &node = nodes_[slot];
+  if (!node.live || node.generation != static_cast<std::uint32_t>(id >> 32))
+    return nullptr;
+  return &node;
+}
+
+std::uint32_t OrderBook::allocate() {
+  std::uint32_t slot;
+  if (!free_.empty()) {
+    slot = free_.back();
+    free_.pop_back();
+  } else {
+    slot = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+  }
+  nodes_[slot].live = true;
+  ++live_;
+  return slot;
+}
+
+void OrderBook::release(std::uint32_t slot) {
+  Node &node = nodes_[slot];
+  node.live = false;
+  ++node.generation;
+  free_.push_back(slot);
+  --live_;
+}
+
+void OrderBook::unlink(Level &level, std::uint32_t slot) {
+  Node &node = nodes_[slot];
+  if (node.prev != kNil)
+    nodes_[node.prev].next = node.next;
+  else
+    level.head = node.next;
+  if (node.next != kNil)
+    nodes_[node.next].prev = node.prev;
+  else
+    level.tail = node.prev;
+  node.prev = node.next = kNil;
+}
+
+} // namespace quarcc
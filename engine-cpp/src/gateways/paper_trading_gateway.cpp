@@ -1,65 +1,185 @@
 #include <trading/gateways/paper_trading_gateway.h>
 
+#include <format>
+
 namespace quarcc {
 
-PaperGateway::PaperGateway() : id_gen_("BROKER") {}
+// ISO 8601 UTC with nanoseconds, for venue times since the Unix epoch
+static std::string format_venue_time(VenueTime time) {
+  const std::chrono::sys_time<VenueTime> t{time};
+  const auto seconds = std::chrono::floor<std::chrono::seconds>(t);
+  return std::format("{:%FT%T}.{:09}Z", seconds, (t - seconds).count());
+}
 
-Result<BrokerOrderId> PaperGateway::submit_order(const v1::Order &order) {
-  // "Submit order"
-  const BrokerOrderId broker_id = id_gen_.generate();
+PaperGateway::PaperGateway(PaperGatewayOptions options, SymbolTable &symbols)
+    : symbols_(&symbols),
+      pushes_fills_(options.venue.order_latency.is_zero() &&
+                    options.venue.report_latency.is_zero() &&
+                    options.venue.market.step_interval.count() <= 0),
+      start_(std::chrono::steady_clock::now()),
+      clock_(options.clock), venue_(std::move(options.venue)),
+      id_gen_(0, clock_ ? *clock_ : SystemClock::instance()),
+      on_price_(std::move(options.on_price)) {
+  for (const auto &[symbol, price] : options.reference_prices)
+    venue_.set_reference_price(symbols.intern(symbol), price);
+}
 
+Result<BrokerOrderId> PaperGateway::submit_order(const v1::Order &order) {
+  Result<BrokerOrderId> broker_id;
+  bool fills_ready = false;
   {
-    std::lock_guard lk{orders_mutex_};
-    pending_orders_[broker_id] = order;
+    std::lock_guard lk{venue_mutex_};
+    const VenueTime t = now();
+    broker_id = submit_locked(order, t);
+    venue_.advance(t);
+    fills_ready = venue_.undelivered() > 0;
   }
 
+  if (broker_id && fills_ready)
+    notify_fill_ready();
   return broker_id;
 }
 
 Result<std::monostate>
 PaperGateway::cancel_order(const BrokerOrderId &orderId) {
-  {
-    std::lock_guard lk{orders_mutex_};
-    pending_orders_.erase(orderId);
-  }
-
-  return std::monostate{};
+  std::lock_guard lk{venue_mutex_};
+  const auto id = find_locked(orderId);
+  if (!id)
+    return std::unexpected(id.error());
+
+  const VenueTime t = now();
+  auto result = venue_.cancel(*id, t);
+  venue_.advance(t);
+  return result;
 }
 
 Result<BrokerOrderId> PaperGateway::replace_order(const BrokerOrderId &orderId,
                                                   const v1::Order &new_order) {
-  const BrokerOrderId broker_id = id_gen_.generate();
+  Result<BrokerOrderId> broker_id;
+  bool fills_ready = false;
   {
-    std::lock_guard lk{orders_mutex_};
-    pending_orders_.erase(orderId);
-    pending_orders_[broker_id] = new_order;
+    std::lock_guard lk{venue_mutex_};
+    const auto id = find_locked(orderId);
+    if (!id)
+      return std::unexpected(id.error());
+
+    const VenueTime t = now();
+    if (auto cancelled = venue_.cancel(*id, t); !cancelled)
+      return std::unexpected(cancelled.error());
+    broker_id = submit_locked(new_order, t);
+    venue_.advance(t);
+    fills_ready = venue_.undelivered() > 0;
   }
 
+  if (broker_id && fills_ready)
+    notify_fill_ready();
   return broker_id;
 }
 
 std::vector<v1::ExecutionReport> PaperGateway::get_fills() {
   std::vector<v1::ExecutionReport> fills;
-  std::vector<BrokerOrderId> to_erase;
 
-  std::lock_guard lk{orders_mutex_};
+  std::lock_guard lk{venue_mutex_};
+  const VenueTime t = now();
+  venue_.advance(t);
+  reports_.clear();
+  venue_.drain(t, reports_);
+
+  for (const VenueReport &report : reports_) {
+    if (report.kind == VenueReport::Kind::Fill) {
+      const BrokerOrderId broker_id = CompactOrderId{report.tag}.to_string();
+      v1::ExecutionReport fill;
+      fill.set_symbol(symbols_->name(report.symbol));
+      fill.set_side(report.side);
+      fill.set_filled_quantity(report.quantity.to_double());
+      fill.set_avg_fill_price(report.price.to_double());
+      fill.set_execution_id(
+          std::format("{}-{}", broker_id, report.execution_id));
+      fill.set_fill_time(clock_ ? format_venue_time(report.time)
+                                : get_current_time());
+      fill.set_broker_order_id(broker_id);
+      fills.push_back(std::move(fill));
+      if (on_price_)
+        on_price_(report.symbol, report.price);
+    }
+    if (report.closes())
+      open_orders_.erase(report.tag);
+  }
 
-  for (const auto &[broker_id, order] : pending_orders_) {
-    v1::ExecutionReport fill;
-    fill.set_broker_order_id(broker_id);
-    fill.set_symbol(order.symbol());
-    fill.set_side(order.side());
-    fill.set_filled_quantity(order.quantity());
-    fill.set_fill_time(get_current_time());
-    fills.push_back(std::move(fill));
+  return fills;
+}
 
-    to_erase.push_back(broker_id);
-  }
+bool PaperGateway::set_fill_listener(FillListener listener) {
+  if (!pushes_fills())
+    return false;
+  fill_listener_ = std::move(listener);
+  return true;
+}
 
-  for (const auto &id : to_erase)
-    pending_orders_.erase(id);
+std::optional<Price>
+PaperGateway::reference_price(const std::string &symbol) {
+  // A symbol the venue has never seen starts at the synthetic reference
+  const SymbolId id = symbols_->find(symbol).value_or(kUnknownSymbol);
+  std::lock_guard lk{venue_mutex_};
+  return venue_.reference_price(id);
+}
 
-  return fills;
+void PaperGateway::end_session() {
+  std::lock_guard lk{venue_mutex_};
+  venue_.end_session(now());
+}
+
+Result<BrokerOrderId> PaperGateway::submit_locked(const v1::Order &order,
+                                                  VenueTime now) {
+  const auto quantity = Quantity::checked_from_double(order.quantity());
+  const auto price = Price::checked_from_double(order.price());
+  if (!quantity || !price)
+    return std::unexpected(Error{"Order quantity or price out of range",
+                                 ErrorType::FailedOrder});
+
+  // Each symbol gets a market in the venue, so only known ones are traded
+  const auto symbol = symbols_->find(order.symbol());
+  if (!symbol)
+    return std::unexpected(
+        Error{"Unknown symbol " + order.symbol(), ErrorType::FailedOrder});
+
+  const CompactOrderId broker_id = id_gen_.next();
+  const auto id = venue_.submit(VenueOrder{.symbol = *symbol,
+                                           .side = order.side(),
+                                           .type = order.type(),
+                                           .time_in_force =
+                                               order.time_in_force(),
+                                           .quantity = *quantity,
+                                           .price = *price},
+                                broker_id.value(), now);
+  if (!id)
+    return std::unexpected(id.error());
+
+  open_orders_.emplace(broker_id.value(), *id);
+  return broker_id.to_string();
+}
+
+Result<VenueOrderId>
+PaperGateway::find_locked(const BrokerOrderId &orderId) const {
+  if (const auto broker_id = CompactOrderId::parse(orderId))
+    if (auto it = open_orders_.find(broker_id->value());
+        it != open_orders_.end())
+      return it->second;
+  return std::unexpected(
+      Error{"Unknown or closed order " + orderId, ErrorType::FailedOrder});
+}
+
+VenueTime PaperGateway::now() const {
+  if (clock_)
+    return std::chrono::duration_cast<VenueTime>(
+        clock_->now().time_since_epoch());
+  return std::chrono::duration_cast<VenueTime>(
+      std::chrono::steady_clock::now() - start_);
+}
+
+void PaperGateway::notify_fill_ready() {
+  if (fill_listener_)
+    fill_listener_();
 }
 
 } // namespace quarcc
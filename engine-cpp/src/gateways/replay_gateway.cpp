@@ -0,0 +1,106 @@
+#include <trading/gateways/replay_gateway.h>
+
+namespace quarcc {
+
+static IClock::WallTime wall_time(VenueTime time) {
+  return IClock::WallTime{
+      std::chrono::duration_cast<IClock::WallTime::duration>(time)};
+}
+
+ReplayGateway::ReplayGateway(std::shared_ptr<const TickFile> ticks,
+                             ReplayGatewayOptions options, SymbolTable &symbols)
+    : PaperGateway(
+          PaperGatewayOptions{.venue = std::move(options.venue),
+                              .reference_prices = {},
+                              .clock = options.clock ? options.clock
+                                                     : &own_clock_},
+          symbols),
+      replay_(std::move(ticks), symbols),
+      on_price_(std::move(options.on_price)),
+      clock_(options.clock ? options.clock : &own_clock_) {
+  if (const TickRecord *first = replay_.peek())
+    clock_->set(wall_time(VenueTime{first->timestamp_ns}));
+}
+
+const TickRecord *ReplayGateway::step() {
+  std::lock_guard lk{replay_mutex_};
+  const TickRecord *record = replay_.next();
+  if (!record)
+    return nullptr;
+
+  const bool fills_ready = with_venue([&](SimulatedVenue &venue, VenueTime) {
+    replay_locked(venue, *record);
+    return venue.undelivered() > 0;
+  });
+  if (fills_ready)
+    notify_fill_ready();
+  return record;
+}
+
+std::size_t ReplayGateway::replay_until(VenueTime until) {
+  std::lock_guard lk{replay_mutex_};
+  std::size_t replayed = 0;
+  const bool fills_ready = with_venue([&](SimulatedVenue &venue, VenueTime) {
+    while (const TickRecord *record = replay_.peek()) {
+      if (record->timestamp_ns > until.count())
+        break;
+      replay_.next();
+      replay_locked(venue, *record);
+      ++replayed;
+    }
+    clock_->set(wall_time(until));
+    venue.advance(time());
+    return venue.undelivered() > 0;
+  });
+  if (fills_ready)
+    notify_fill_ready();
+  return replayed;
+}
+
+VenueTime ReplayGateway::time() const {
+  return std::chrono::duration_cast<VenueTime>(
+      clock_->now().time_since_epoch());
+}
+
+std::optional<VenueTime> ReplayGateway::next_time() {
+  std::lock_guard lk{replay_mutex_};
+  if (const TickRecord *record = replay_.peek())
+    return VenueTime{record->timestamp_ns};
+  return std::nullopt;
+}
+
+bool ReplayGateway::done() {
+  std::lock_guard lk{replay_mutex_};
+  return replay_.done();
+}
+
+void ReplayGateway::replay_locked(SimulatedVenue &venue,
+                                  const TickRecord &record) {
+  // Out-of-order ticks replay at the current time rather than rewinding it
+  clock_->set(wall_time(VenueTime{record.timestamp_ns}));
+  const VenueTime now = time();
+  const SymbolId symbol = replay_.symbol(record);
+
+  Price price;
+  switch (record.kind) {
+  case TickKind::Trade:
+    price = record.price();
+    venue.trade(symbol, price, record.size(), now);
+    break;
+  case TickKind::Quote:
+    venue.quote(symbol, record.bid(), record.bid_size(), record.ask(),
+                record.ask_size(), now);
+    // An empty side is 0, which would halve the mark
+    if (record.bid() <= Price{} || record.ask() <= Price{})
+      return;
+    price = Price::from_raw((record.bid().raw() + record.ask().raw()) / 2);
+    break;
+  default:
+    venue.advance(now);
+    return;
+  }
+  if (on_price_)
+    on_price_(symbol, price);
+}
+
+} // namespace quarcc
@@ -0,0 +1,483 @@
+#include <trading/gateways/simulated_venue.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace quarcc {
+
+static Result<std::monostate> refuse(const char *reason) {
+  return std::unexpected(Error{reason, ErrorType::FailedOrder});
+}
+
+static bool is_stop(v1::OrderType type) {
+  return type == v1::STOP || type == v1::STOP_LIMIT;
+}
+
+static bool triggered(const VenueOrder &order, std::optional<Price> last) {
+  if (!last)
+    return false;
+  return order.side == v1::BUY ? *last >= order.price : *last <= order.price;
+}
+
+// Lowest mid that keeps every synthetic bid above zero
+static Price lowest_mid(const SyntheticMarket &market) {
+  return market.tick *
+         static_cast<Price::rep>(market.half_spread_ticks + market.levels);
+}
+
+static Result<std::monostate> validate(const VenueOrder &order) {
+  if (order.side != v1::BUY && order.side != v1::SELL)
+    return refuse("Order side must be BUY or SELL");
+  if (order.quantity <= Quantity{})
+    return refuse("Order quantity must be positive");
+  switch (order.type) {
+  case v1::MARKET:
+    break;
+  case v1::LIMIT:
+  case v1::STOP:
+  case v1::STOP_LIMIT:
+    if (order.price <= Price{})
+      return refuse("Order price must be positive");
+    break;
+  default:
+    return refuse("Unsupported order type");
+  }
+  switch (order.time_in_force) {
+  case v1::DAY:
+  case v1::GTC:
+  case v1::IOC:
+  case v1::FOK:
+    return std::monostate{};
+  default:
+    return refuse("Unsupported time in force");
+  }
+}
+
+SimulatedVenue::SimulatedVenue(SimulatedVenueOptions options)
+    : options_(std::move(options)), rng_(options_.seed) {
+  const SyntheticMarket &market = options_.market;
+  if (market.tick <= Price{})
+    throw std::runtime_error("SimulatedVenue tick must be positive");
+  if (market.reference_price <= Price{})
+    throw std::runtime_error("SimulatedVenue reference price must be positive");
+  if (market.level_size <= Quantity{})
+    throw std::runtime_error("SimulatedVenue level size must be positive");
+  if (market.half_spread_ticks == 0)
+    throw std::runtime_error("SimulatedVenue half spread must be at least a tick");
+}
+
+void SimulatedVenue::set_reference_price(SymbolId symbol, Price price) {
+  reference_prices_[symbol] = price;
+}
+
+Result<VenueOrderId> SimulatedVenue::submit(const VenueOrder &order,
+                                            std::uint64_t tag, VenueTime now) {
+  if (auto valid = validate(order); !valid)
+    return std::unexpected(valid.error());
+
+  std::uint32_t slot;
+  if (!free_orders_.empty()) {
+    slot = free_orders_.back();
+    free_orders_.pop_back();
+  } else {
+    slot = static_cast<std::uint32_t>(orders_.size());
+    orders_.emplace_back();
+  }
+
+  ClientOrder &entry = orders_[slot];
+  entry.order = order;
+  entry.tag = tag;
+  entry.leaves = order.quantity;
+  entry.resting = OrderBook::kNoOrder;
+  entry.state = State::InFlight;
+
+  const VenueOrderId id = make_id(slot, entry.generation);
+  last_arrival_ = std::max(now + delay(options_.order_latency), last_arrival_);
+  inbound_.push(Message{.arrival = last_arrival_, .order = id, .cancel = false});
+  return id;
+}
+
+Result<std::monostate> SimulatedVenue::cancel(VenueOrderId id, VenueTime now) {
+  if (!is_open(id))
+    return refuse("Order is not open");
+
+  last_arrival_ = std::max(now + delay(options_.order_latency), last_arrival_);
+  inbound_.push(Message{.arrival = last_arrival_, .order = id, .cancel = true});
+  return std::monostate{};
+}
+
+void SimulatedVenue::advance(VenueTime now) {
+  while (!inbound_.empty() && inbound_.front().arrival <= now) {
+    const Message message = inbound_.front();
+    inbound_.pop();
+    process(message);
+  }
+  for (auto &market : markets_)
+    if (market)
+      catch_up(*market, now);
+}
+
+std::size_t SimulatedVenue::drain(VenueTime now,
+                                  std::vector<VenueReport> &out) {
+  std::size_t count = 0;
+  while (!outbound_.empty() && outbound_.front().visible <= now) {
+    out.push_back(outbound_.front().report);
+    outbound_.pop();
+    ++count;
+  }
+  return count;
+}
+
+void SimulatedVenue::quote(SymbolId symbol, Price bid, Quantity bid_size,
+                           Price ask, Quantity ask_size, VenueTime now) {
+  advance(now);
+  Market &book = market(symbol, now);
+  const bool first_quote = !book.replayed;
+  book.replayed = true;
+  for (BookOrderId quote : book.quotes)
+    book.book.cancel(quote);
+  book.quotes.assign(2, OrderBook::kNoOrder);
+  book.hit.clear();
+
+  if (bid > Price{} && bid_size > Quantity{})
+    post(book, 0, v1::BUY, bid, bid_size, now);
+  if (ask > Price{} && ask_size > Quantity{})
+    post(book, 1, v1::SELL, ask, ask_size, now);
+  if (bid > Price{} && ask > Price{})
+    book.mid = Price::from_raw((bid.raw() + ask.raw()) / 2);
+  if (first_quote)
+    book.last = book.mid; // not the configured reference price
+  trigger_stops(book, now);
+}
+
+void SimulatedVenue::trade(SymbolId symbol, Price price, Quantity size,
+                           VenueTime now) {
+  advance(now);
+  Market &book = market(symbol, now);
+  const auto sweep = [&](v1::Side side, Price limit) {
+    book.book.match(side, limit, size, [&](const OrderBook::Fill &fill) {
+      on_fill(book, kSyntheticTag, fill, now);
+    });
+  };
+  // One price unit inside the print, so orders resting at it do not fill
+  sweep(v1::SELL, price + Price::from_raw(1));
+  sweep(v1::BUY, price - Price::from_raw(1));
+  book.last = price;
+  trigger_stops(book, now);
+}
+
+void SimulatedVenue::end_session(VenueTime now) {
+  advance(now);
+  for (std::uint32_t slot = 0; slot < orders_.size(); ++slot) {
+    const ClientOrder &entry = orders_[slot];
+    if ((entry.state == State::Resting || entry.state == State::Stopped) &&
+        entry.order.time_in_force == v1::DAY)
+      close(market(entry.order.symbol, now), make_id(slot, entry.generation),
+            now);
+  }
+}
+
+bool SimulatedVenue::is_open(VenueOrderId id) const {
+  return lookup(id) != nullptr;
+}
+
+std::optional<Quantity> SimulatedVenue::leaves(VenueOrderId id) const {
+  if (const ClientOrder *entry = lookup(id))
+    return entry->leaves;
+  return std::nullopt;
+}
+
+std::optional<Price> SimulatedVenue::last_price(SymbolId symbol) const {
+  if (symbol >= markets_.size() || !markets_[symbol])
+    return std::nullopt;
+  return markets_[symbol]->last;
+}
+
+Price SimulatedVenue::reference_price(SymbolId symbol) const {
+  if (symbol < markets_.size() && markets_[symbol] && markets_[symbol]->last)
+    return *markets_[symbol]->last;
+  return starting_mid(symbol);
+}
+
+const OrderBook *SimulatedVenue::book(SymbolId symbol) const {
+  if (symbol >= markets_.size() || !markets_[symbol])
+    return nullptr;
+  return &markets_[symbol]->book;
+}
+
+SimulatedVenue::ClientOrder *SimulatedVenue::lookup(VenueOrderId id) {
+  return const_cast<ClientOrder *>(std::as_const(*this).lookup(id));
+}
+
+const SimulatedVenue::ClientOrder *
+SimulatedVenue::lookup(VenueOrderId id) const {
+  const auto slot = static_cast<std::uint32_t>(id);
+  if (slot >= orders_.size())
+    return nullptr;
+  const ClientOrder &entry = orders_[slot];
+  if (entry.state == State::Free ||
+      entry.generation != static_cast<std::uint32_t>(id >> 32))
+    return nullptr;
+  return &entry;
+}
+
+void SimulatedVenue::release(VenueOrderId id) {
+  const auto slot = static_cast<std::uint32_t>(id);
+  ClientOrder &entry = orders_[slot];
+  entry.state = State::Free;
+  entry.resting = OrderBook::kNoOrder;
+  ++entry.generation;
+  free_orders_.push_back(slot);
+}
+
+VenueTime SimulatedVenue::delay(const LatencyModel &latency) {
+  if (latency.jitter.count() <= 0)
+    return latency.base;
+  return latency.base +
+         VenueTime{static_cast<VenueTime::rep>(rng_.below(
+             static_cast<std::uint64_t>(latency.jitter.count()) + 1))};
+}
+
+Price SimulatedVenue::starting_mid(SymbolId symbol) const {
+  const auto it = reference_prices_.find(symbol);
+  const SyntheticMarket &synthetic = options_.market;
+  return std::max(it != reference_prices_.end() ? it->second
+                                                : synthetic.reference_price,
+                  lowest_mid(synthetic));
+}
+
+SimulatedVenue::Market &SimulatedVenue::market(SymbolId symbol,
+                                               VenueTime now) {
+  if (symbol >= markets_.size())
+    markets_.resize(symbol + 1);
+
+  auto &market = markets_[symbol];
+  if (!market) {
+    market = std::make_unique<Market>();
+    market->mid = starting_mid(symbol);
+    market->last = market->mid;
+    market->next_step = now + options_.market.step_interval;
+    requote(*market, now);
+  } else {
+    catch_up(*market, now);
+  }
+  return *market;
+}
+
+void SimulatedVenue::catch_up(Market &market, VenueTime now) {
+  if (options_.market.step_interval.count() <= 0 || market.replayed)
+    return;
+  while (market.next_step <= now) {
+    const VenueTime at = market.next_step;
+    market.next_step += options_.market.step_interval;
+    step(market, at);
+  }
+}
+
+void SimulatedVenue::step(Market &market, VenueTime now) {
+  const SyntheticMarket &synthetic = options_.market;
+  const auto max_step = static_cast<std::int64_t>(synthetic.max_step_ticks);
+  market.mid = std::max(
+      market.mid + synthetic.tick * rng_.between(-max_step, max_step),
+      lowest_mid(synthetic));
+  market.last = market.mid;
+  requote(market, now);
+  trigger_stops(market, now);
+}
+
+// Replaces the synthetic quotes around the current mid
+void SimulatedVenue::requote(Market &market, VenueTime now) {
+  for (BookOrderId quote : market.quotes)
+    market.book.cancel(quote);
+  market.quotes.assign(std::size_t{options_.market.levels} * 2,
+                       OrderBook::kNoOrder);
+  market.hit.clear();
+  for (std::size_t index = 0; index < market.quotes.size(); ++index)
+    post_quote(market, index, now);
+}
+
+// Restores only the quotes that traded, at the back of their level
+void SimulatedVenue::refill(Market &market, VenueTime now) {
+  for (std::size_t index : market.hit) {
+    market.book.cancel(market.quotes[index]);
+    post_quote(market, index, now);
+  }
+  market.hit.clear();
+}
+
+void SimulatedVenue::post_quote(Market &market, std::size_t index,
+                                VenueTime now) {
+  const SyntheticMarket &synthetic = options_.market;
+  const auto side = index % 2 == 0 ? v1::BUY : v1::SELL;
+  const Price offset =
+      synthetic.tick *
+      static_cast<Price::rep>(synthetic.half_spread_ticks + index / 2);
+  post(market, index, side,
+       side == v1::BUY ? market.mid - offset : market.mid + offset,
+       synthetic.level_size, now);
+}
+
+// A new quote takes any client orders it crosses before resting
+void SimulatedVenue::post(Market &market, std::size_t index, v1::Side side,
+                          Price price, Quantity size, VenueTime now) {
+  const Quantity left =
+      market.book.match(side, price, size, [&](const OrderBook::Fill &fill) {
+        on_fill(market, kSyntheticTag, fill, now);
+      });
+  market.quotes[index] =
+      left.is_zero() ? OrderBook::kNoOrder
+                     : market.book.add(side, price, left, kSyntheticTag);
+}
+
+void SimulatedVenue::process(const Message &message) {
+  const ClientOrder *entry = lookup(message.order);
+  if (!entry)
+    return; // closed before the cancel arrived
+
+  Market &book = market(entry->order.symbol, message.arrival);
+  if (message.cancel)
+    close(book, message.order, message.arrival);
+  else
+    arrive(book, message.order, message.arrival);
+}
+
+void SimulatedVenue::arrive(Market &market, VenueOrderId id, VenueTime now) {
+  if (options_.market.step_interval.count() <= 0 && !market.replayed)
+    refill(market, now);
+
+  ClientOrder &entry = orders_[static_cast<std::uint32_t>(id)];
+  if (is_stop(entry.order.type) && !triggered(entry.order, market.last)) {
+    entry.state = State::Stopped;
+    market.stops.push_back(id);
+    return;
+  }
+
+  execute(market, id, now);
+  trigger_stops(market, now);
+}
+
+void SimulatedVenue::execute(Market &market, VenueOrderId id, VenueTime now) {
+  ClientOrder &entry = orders_[static_cast<std::uint32_t>(id)];
+  const VenueOrder &order = entry.order;
+  const bool marketable =
+      order.type == v1::MARKET || order.type == v1::STOP;
+  const std::optional<Price> limit =
+      marketable ? std::nullopt : std::optional{order.price};
+
+  if (order.time_in_force == v1::FOK &&
+      market.book.available(order.side, limit, entry.leaves) < entry.leaves)
+    return close(market, id, now);
+
+  market.book.match(order.side, limit, entry.leaves,
+                    [&](const OrderBook::Fill &fill) {
+                      on_fill(market, id, fill, now);
+                    });
+
+  if (entry.leaves.is_zero())
+    return release(id);
+  if (marketable || order.time_in_force == v1::IOC ||
+      order.time_in_force == v1::FOK)
+    return close(market, id, now);
+
+  entry.resting = market.book.add(order.side, order.price, entry.leaves, id);
+  entry.state = State::Resting;
+}
+
+// Stops fire oldest first, and each execution can move the last price enough
+// to fire more
+void SimulatedVenue::trigger_stops(Market &market, VenueTime now) {
+  for (bool fired = true; fired;) {
+    fired = false;
+    for (auto it = market.stops.begin(); it != market.stops.end(); ++it) {
+      ClientOrder &entry = orders_[static_cast<std::uint32_t>(*it)];
+      if (!triggered(entry.order, market.last))
+        continue;
+
+      const VenueOrderId id = *it;
+      market.stops.erase(it);
+      entry.state = State::InFlight;
+      execute(market, id, now);
+      fired = true;
+      break;
+    }
+  }
+}
+
+void SimulatedVenue::on_fill(Market &market, VenueOrderId taker,
+                             const OrderBook::Fill &fill, VenueTime now) {
+  market.last = fill.price;
+
+  if (taker != kSyntheticTag) {
+    ClientOrder &entry = orders_[static_cast<std::uint32_t>(taker)];
+    entry.leaves -= fill.quantity;
+    report(VenueReport{.kind = VenueReport::Kind::Fill,
+                       .order = taker,
+                       .tag = entry.tag,
+                       .symbol = entry.order.symbol,
+                       .side = entry.order.side,
+                       .price = fill.price,
+                       .quantity = fill.quantity,
+                       .leaves = entry.leaves,
+                       .execution_id = 0,
+                       .time = now});
+  }
+
+  if (fill.maker_tag == kSyntheticTag) {
+    const auto quote = std::find(market.quotes.begin(), market.quotes.end(),
+                                 fill.maker);
+    const auto index =
+        static_cast<std::size_t>(quote - market.quotes.begin());
+    if (quote != market.quotes.end() &&
+        std::find(market.hit.begin(), market.hit.end(), index) ==
+            market.hit.end())
+      market.hit.push_back(index);
+    return;
+  }
+
+  const VenueOrderId maker = fill.maker_tag;
+  ClientOrder &entry = orders_[static_cast<std::uint32_t>(maker)];
+  entry.leaves = fill.maker_leaves;
+  report(VenueReport{.kind = VenueReport::Kind::Fill,
+                     .order = maker,
+                     .tag = entry.tag,
+                     .symbol = entry.order.symbol,
+                     .side = entry.order.side,
+                     .price = fill.price,
+                     .quantity = fill.quantity,
+                     .leaves = entry.leaves,
+                     .execution_id = 0,
+                     .time = now});
+  if (entry.leaves.is_zero())
+    release(maker);
+}
+
+void SimulatedVenue::close(Market &market, VenueOrderId id, VenueTime now) {
+  ClientOrder &entry = orders_[static_cast<std::uint32_t>(id)];
+  if (entry.state == State::Resting)
+    market.book.cancel(entry.resting);
+  else if (entry.state == State::Stopped)
+    std::erase(market.stops, id);
+
+  report(VenueReport{.kind = VenueReport::Kind::Cancelled,
+                     .order = id,
+                     .tag = entry.tag,
+                     .symbol = entry.order.symbol,
+                     .side = entry.order.side,
+                     .price = {},
+                     .quantity = entry.leaves,
+                     .leaves = {},
+                     .execution_id = 0,
+                     .time = now});
+  release(id);
+}
+
+void SimulatedVenue::report(VenueReport report) {
+  if (report.kind == VenueReport::Kind::Fill)
+    report.execution_id = ++executions_;
+  last_visible_ =
+      std::max(report.time + delay(options_.report_latency), last_visible_);
+  outbound_.push(Delivery{.visible = last_visible_, .report = report});
+}
+
+} // namespace quarcc
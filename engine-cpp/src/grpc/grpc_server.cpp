@@ -1,217 +1,443 @@
 #include <trading/grpc/grpc_server.h>
 #include <trading/utils/order_id_generator.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <utility>
 
 namespace quarcc {
 
-gRPCServer::gRPCServer(std::string server_address,
-                       IExecutionServiceHandler &handler)
-    : server_address_(std::move(server_address)), handler_(&handler) {}
-
-void gRPCServer::start() {
-  service_ = std::make_unique<ExecutionServiceImpl>(this);
-
-  grpc::ServerBuilder builder;
-  builder.AddListeningPort(server_address_, grpc::InsecureServerCredentials());
-  builder.RegisterService(service_.get());
+// How long shutdown() lets open calls (mostly idle signal streams) finish
+// before they are cancelled
+static constexpr std::chrono::seconds kShutdownGrace{2};
 
-  server_ = builder.BuildAndStart();
-  std::cout << "gRPC server listening on " << server_address_ << std::endl;
+// Status for a refused request; throttled clients are told to back off
+static grpc::Status error_status(const Error &error) {
+  const auto code = error.type_ == ErrorType::Throttled
+                        ? grpc::RESOURCE_EXHAUSTED
+                        : grpc::INVALID_ARGUMENT;
+  return grpc::Status(code, error.message_);
 }
 
-void gRPCServer::wait() {
-  if (server_)
-    server_->Wait();
+const char *rpc_method_to_string(RpcMethod method) {
+  switch (method) {
+  case RpcMethod::SubmitSignal:
+    return "SubmitSignal";
+  case RpcMethod::CancelOrder:
+    return "CancelOrder";
+  case RpcMethod::ReplaceOrder:
+    return "ReplaceOrder";
+  case RpcMethod::StreamSignals:
+    return "StreamSignals";
+  case RpcMethod::GetPosition:
+    return "GetPosition";
+  case RpcMethod::GetAllPositions:
+    return "GetAllPositions";
+  case RpcMethod::ActivateKillSwitch:
+    return "ActivateKillSwitch";
+  default:
+    return "UNKNOWN";
+  }
 }
 
-void gRPCServer::shutdown() {
-  if (server_)
-    server_->Shutdown();
-}
+// Every call object is its own completion-queue tag. A poller invokes
+// proceed() with the outcome of the last operation started on the call; at
+// most one operation is outstanding per call at any time.
+class gRPCServer::CallBase {
+public:
+  explicit CallBase(gRPCServer &server) : server_(server) {
+    server_.live_calls_.fetch_add(1, std::memory_order_relaxed);
+  }
+  virtual ~CallBase() {
+    server_.live_calls_.fetch_sub(1, std::memory_order_acq_rel);
+  }
 
-gRPCServer::ExecutionServiceImpl::ExecutionServiceImpl(gRPCServer *owner)
-    : owner_(owner) {}
+  virtual void proceed(bool ok) = 0;
+
+protected:
+  gRPCServer &server_;
+};
+
+template <typename Request, typename Response>
+class gRPCServer::UnaryCall final : public CallBase {
+public:
+  using RequestFn = void (v1::ExecutionService::AsyncService::*)(
+      grpc::ServerContext *, Request *,
+      grpc::ServerAsyncResponseWriter<Response> *, grpc::CompletionQueue *,
+      grpc::ServerCompletionQueue *, void *);
+  using Handler = void (gRPCServer::*)(UnaryCall &);
+
+  UnaryCall(gRPCServer &server, grpc::ServerCompletionQueue *cq,
+            RpcMethod method, RequestFn request_fn, Handler handler)
+      : CallBase(server), cq_(cq), method_(method), request_fn_(request_fn),
+        handler_(handler), responder_(&ctx_) {
+    (server_.service_.*request_fn_)(&ctx_, &request_, &responder_, cq_, cq_,
+                                    this);
+  }
 
-grpc::Status gRPCServer::ExecutionServiceImpl::SubmitSignal(
-    grpc::ServerContext *context, const v1::StrategySignal *request,
-    v1::SubmitSignalResponse *response) {
+  const Request &request() const { return request_; }
+  Response &response() { return response_; }
+  std::string peer() const { return ctx_.peer(); }
 
-  if (!owner_ || !owner_->handler_) {
-    response->set_accepted(false);
-    response->set_rejection_reason("Server handler not initialized");
-    return grpc::Status(grpc::ABORTED, "Server handler not initialized");
+  // Sends the response. Called exactly once per accepted call, from any
+  // thread.
+  void finish(const grpc::Status &status) {
+    finishing_ = true;
+    server_.on_call_completed(method_);
+    responder_.Finish(response_, status, this);
   }
 
-  std::cout << "Received signal from " << context->peer() << " - "
-            << request->strategy_id() << " " << request->side() << " "
-            << request->symbol() << std::endl;
+  void proceed(bool ok) override {
+    if (finishing_ || !ok) {
+      delete this;
+      return;
+    }
 
-  auto r = owner_->handler_->SubmitSignal(*request);
+    // A client call was matched; keep one request armed for the next client
+    new UnaryCall(server_, cq_, method_, request_fn_, handler_);
 
-  if (!r) {
-    response->set_accepted(false);
-    response->set_rejection_reason(r.error().message_);
-    return grpc::Status(grpc::INVALID_ARGUMENT, r.error().message_);
+    server_.on_call_started(method_);
+    (server_.*handler_)(*this);
   }
 
-  response->set_accepted(true);
-  response->set_order_id(r.value());
-
-  return grpc::Status::OK;
-}
+private:
+  grpc::ServerCompletionQueue *cq_;
+  RpcMethod method_;
+  RequestFn request_fn_;
+  Handler handler_;
+
+  grpc::ServerContext ctx_;
+  Request request_;
+  Response response_;
+  grpc::ServerAsyncResponseWriter<Response> responder_;
+  bool finishing_ = false;
+};
+
+// Bidirectional signal stream: read one signal, hand it to the strategy
+// worker, write the response once the worker is done, then read the next.
+class gRPCServer::StreamSignalsCall final : public CallBase {
+public:
+  StreamSignalsCall(gRPCServer &server, grpc::ServerCompletionQueue *cq)
+      : CallBase(server), cq_(cq), stream_(&ctx_) {
+    server_.service_.RequestStreamSignals(&ctx_, &stream_, cq_, cq_, this);
+  }
 
-grpc::Status gRPCServer::ExecutionServiceImpl::CancelOrder(
-    grpc::ServerContext *context, const v1::CancelSignal *request,
-    v1::CancelOrderResponse *response) {
+  void proceed(bool ok) override {
+    switch (state_) {
+    case State::Requested:
+      if (!ok) {
+        delete this;
+        return;
+      }
+      new StreamSignalsCall(server_, cq_);
+      server_.on_call_started(RpcMethod::StreamSignals);
+      std::cout << "Client " << ctx_.peer() << " opened signal stream"
+                << std::endl;
+      read_next();
+      return;
+
+    case State::Reading:
+      if (!ok) {
+        // Client half-closed (or went away)
+        std::cout << "Client " << ctx_.peer() << " closed signal stream\n";
+        finish(grpc::Status::OK);
+        return;
+      }
+      state_ = State::Handling;
+      server_.handler_->SubmitSignalAsync(
+          signal_, [this](Result<BrokerOrderId> r) { write_response(r); });
+      return;
+
+    case State::Writing:
+      if (!ok) {
+        finish(grpc::Status(grpc::CANCELLED, "Signal stream write failed"));
+        return;
+      }
+      read_next();
+      return;
+
+    case State::Handling:
+      return;
+
+    case State::Finishing:
+      delete this;
+      return;
+    }
+  }
 
-  response->set_received_at(get_current_time());
+private:
+  enum class State { Requested, Reading, Handling, Writing, Finishing };
 
-  if (!owner_ || !owner_->handler_) {
-    response->set_accepted(false);
-    response->set_rejection_reason("Server handler not initialized");
-    return grpc::Status(grpc::ABORTED, "Server handler not initialized");
+  void read_next() {
+    state_ = State::Reading;
+    signal_.Clear();
+    stream_.Read(&signal_, this);
   }
 
-  std::cout << "Cancel signal received from " << context->peer() << " - "
-            << request->strategy_id() << " " << request->order_id()
-            << std::endl;
+  void write_response(const Result<BrokerOrderId> &r) {
+    response_.Clear();
+    if (!r) {
+      response_.set_accepted(false);
+      response_.set_rejection_reason(r.error().message_);
+    } else {
+      response_.set_accepted(true);
+      response_.set_order_id(r.value());
+    }
 
-  auto r = owner_->handler_->CancelOrder(*request);
+    state_ = State::Writing;
+    stream_.Write(response_, this);
+  }
 
-  if (!r) {
-    response->set_accepted(false);
-    response->set_rejection_reason(r.error().message_);
-    return grpc::Status(grpc::INVALID_ARGUMENT, r.error().message_);
+  void finish(const grpc::Status &status) {
+    state_ = State::Finishing;
+    server_.on_call_completed(RpcMethod::StreamSignals);
+    stream_.Finish(status, this);
   }
 
-  response->set_accepted(true);
+  grpc::ServerCompletionQueue *cq_;
+  grpc::ServerContext ctx_;
+  grpc::ServerAsyncReaderWriter<v1::SubmitSignalResponse, v1::StrategySignal>
+      stream_;
+  v1::StrategySignal signal_;
+  v1::SubmitSignalResponse response_;
+  State state_ = State::Requested;
+};
 
-  return grpc::Status::OK;
-}
+gRPCServer::gRPCServer(std::string server_address,
+                       IExecutionServiceHandler &handler,
+                       gRPCServerOptions options)
+    : server_address_(std::move(server_address)), handler_(&handler),
+      options_(options) {}
 
-grpc::Status gRPCServer::ExecutionServiceImpl::ReplaceOrder(
-    grpc::ServerContext *context, const v1::ReplaceSignal *request,
-    v1::ReplaceOrderResponse *response) {
+gRPCServer::~gRPCServer() { shutdown(); }
 
-  response->set_received_at(get_current_time());
+void gRPCServer::start() {
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort(server_address_, grpc::InsecureServerCredentials(),
+                           &port_);
+  builder.RegisterService(&service_);
+  if (options_.max_concurrent_streams > 0)
+    builder.AddChannelArgument(GRPC_ARG_MAX_CONCURRENT_STREAMS,
+                               options_.max_concurrent_streams);
 
-  if (!owner_ || !owner_->handler_) {
-    response->set_accepted(false);
-    response->set_rejection_reason("Server handler not initialized");
-    return grpc::Status(grpc::ABORTED, "Server handler not initialized");
+  for (int i = 0; i < std::max(1, options_.num_cqs); ++i)
+    cqs_.push_back(builder.AddCompletionQueue());
+
+  server_ = builder.BuildAndStart();
+
+  for (auto &cq : cqs_) {
+    arm_calls(cq.get());
+    for (int i = 0; i < std::max(1, options_.pollers_per_cq); ++i)
+      pollers_.emplace_back([this, cq = cq.get()] { poll(cq); });
   }
 
-  std::cout << "Replace signal received from " << context->peer() << " - "
-            << request->strategy_id() << " " << request->side() << " "
-            << request->symbol() << request->order_id() << std::endl;
+  std::cout << "gRPC server listening on " << server_address_ << " ("
+            << cqs_.size() << " completion queues, " << pollers_.size()
+            << " pollers)" << std::endl;
+}
 
-  auto r = owner_->handler_->ReplaceOrder(*request);
+void gRPCServer::wait() {
+  if (server_)
+    server_->Wait();
+}
 
-  if (!r) {
-    response->set_accepted(false);
-    response->set_rejection_reason(r.error().message_);
-    return grpc::Status(grpc::INVALID_ARGUMENT, r.error().message_);
-  }
+void gRPCServer::shutdown() {
+  if (!server_ || shut_down_)
+    return;
+  shut_down_ = true;
+
+  server_->Shutdown(std::chrono::system_clock::now() + kShutdownGrace);
+
+  // Once the server is down every call object comes back through its queue
+  // and deletes itself; handlers still running on strategy workers finish on
+  // these queues, so they must stay open until the last call is gone.
+  while (live_calls_.load(std::memory_order_acquire) > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+  for (auto &cq : cqs_)
+    cq->Shutdown();
+  for (auto &poller : pollers_)
+    poller.join();
+}
 
-  response->set_accepted(true);
-  response->set_order_id(r.value());
+RpcMethodStats gRPCServer::method_stats(RpcMethod method) const {
+  const auto &c = counters_[static_cast<std::size_t>(method)];
+  return RpcMethodStats{
+      .started = c.started.load(std::memory_order_relaxed),
+      .completed = c.completed.load(std::memory_order_relaxed),
+      .in_flight = c.in_flight.load(std::memory_order_relaxed),
+      .peak_in_flight = c.peak_in_flight.load(std::memory_order_relaxed),
+  };
+}
 
-  return grpc::Status::OK;
+// Arms one outstanding request per method on `cq`; each matched call re-arms
+// its method before being handled.
+void gRPCServer::arm_calls(grpc::ServerCompletionQueue *cq) {
+  using Service = v1::ExecutionService::AsyncService;
+
+  new UnaryCall<v1::StrategySignal, v1::SubmitSignalResponse>(
+      *this, cq, RpcMethod::SubmitSignal, &Service::RequestSubmitSignal,
+      &gRPCServer::handle_submit_signal);
+  new UnaryCall<v1::CancelSignal, v1::CancelOrderResponse>(
+      *this, cq, RpcMethod::CancelOrder, &Service::RequestCancelOrder,
+      &gRPCServer::handle_cancel_order);
+  new UnaryCall<v1::ReplaceSignal, v1::ReplaceOrderResponse>(
+      *this, cq, RpcMethod::ReplaceOrder, &Service::RequestReplaceOrder,
+      &gRPCServer::handle_replace_order);
+  new StreamSignalsCall(*this, cq);
+  new UnaryCall<v1::GetPositionRequest, v1::Position>(
+      *this, cq, RpcMethod::GetPosition, &Service::RequestGetPosition,
+      &gRPCServer::handle_get_position);
+  new UnaryCall<v1::Empty, v1::PositionList>(
+      *this, cq, RpcMethod::GetAllPositions, &Service::RequestGetAllPositions,
+      &gRPCServer::handle_get_all_positions);
+  new UnaryCall<v1::KillSwitchRequest, v1::Empty>(
+      *this, cq, RpcMethod::ActivateKillSwitch,
+      &Service::RequestActivateKillSwitch, &gRPCServer::handle_kill_switch);
 }
 
-grpc::Status gRPCServer::ExecutionServiceImpl::StreamSignals(
-    grpc::ServerContext *context,
-    grpc::ServerReaderWriter<v1::SubmitSignalResponse, v1::StrategySignal>
-        *stream) {
+void gRPCServer::poll(grpc::ServerCompletionQueue *cq) {
+  void *tag = nullptr;
+  bool ok = false;
+  while (cq->Next(&tag, &ok))
+    static_cast<CallBase *>(tag)->proceed(ok);
+}
 
-  if (!owner_ || !owner_->handler_) {
-    return grpc::Status(grpc::FAILED_PRECONDITION,
-                        "Server handler not initialized");
+void gRPCServer::on_call_started(RpcMethod method) {
+  auto &c = counters_[static_cast<std::size_t>(method)];
+  c.started.fetch_add(1, std::memory_order_relaxed);
+  const auto depth = c.in_flight.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  auto peak = c.peak_in_flight.load(std::memory_order_relaxed);
+  while (depth > peak && !c.peak_in_flight.compare_exchange_weak(
+                             peak, depth, std::memory_order_relaxed)) {
   }
+}
 
-  std::cout << "Client " << context->peer() << " opened signal stream";
+void gRPCServer::on_call_completed(RpcMethod method) {
+  auto &c = counters_[static_cast<std::size_t>(method)];
+  c.completed.fetch_add(1, std::memory_order_relaxed);
+  c.in_flight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void gRPCServer::handle_submit_signal(
+    UnaryCall<v1::StrategySignal, v1::SubmitSignalResponse> &call) {
+  const auto &request = call.request();
 
-  v1::StrategySignal signal;
-  while (stream->Read(&signal)) {
-    auto r = owner_->handler_->SubmitSignal(signal);
+  std::cout << "Received signal from " << call.peer() << " - "
+            << request.strategy_id() << " " << request.side() << " "
+            << request.symbol() << std::endl;
 
-    v1::SubmitSignalResponse response;
+  handler_->SubmitSignalAsync(request, [&call](Result<BrokerOrderId> r) {
+    auto &response = call.response();
     if (!r) {
       response.set_accepted(false);
       response.set_rejection_reason(r.error().message_);
-    } else {
-      response.set_accepted(true);
+      call.finish(error_status(r.error()));
+      return;
     }
 
-    stream->Write(response);
-  }
-
-  std::cout << "Client " << context->peer() << " closed signal stream\n";
-  return grpc::Status::OK;
+    response.set_accepted(true);
+    response.set_order_id(r.value());
+    call.finish(grpc::Status::OK);
+  });
 }
 
-grpc::Status gRPCServer::ExecutionServiceImpl::GetPosition(
-    grpc::ServerContext *context, const v1::GetPositionRequest *request,
-    v1::Position *response) {
+void gRPCServer::handle_cancel_order(
+    UnaryCall<v1::CancelSignal, v1::CancelOrderResponse> &call) {
+  const auto &request = call.request();
+  call.response().set_received_at(get_current_time());
 
-  if (!owner_ || !owner_->handler_) {
-    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
-                        "Server handler not initialized");
-  }
-
-  std::cout << "Received position request from " << context->peer()
+  std::cout << "Cancel signal received from " << call.peer() << " - "
+            << request.strategy_id() << " " << request.order_id()
             << std::endl;
 
-  auto r = owner_->handler_->GetPosition(*request);
-  if (!r)
-    return grpc::Status(grpc::StatusCode::INTERNAL, r.error().message_);
+  handler_->CancelOrderAsync(request, [&call](Result<std::monostate> r) {
+    auto &response = call.response();
+    if (!r) {
+      response.set_accepted(false);
+      response.set_rejection_reason(r.error().message_);
+      call.finish(error_status(r.error()));
+      return;
+    }
 
-  *response = std::move(r.value());
-  return grpc::Status::OK;
+    response.set_accepted(true);
+    call.finish(grpc::Status::OK);
+  });
 }
 
-grpc::Status
-gRPCServer::ExecutionServiceImpl::GetAllPositions(grpc::ServerContext *context,
-                                                  const v1::Empty *request,
-                                                  v1::PositionList *response) {
+void gRPCServer::handle_replace_order(
+    UnaryCall<v1::ReplaceSignal, v1::ReplaceOrderResponse> &call) {
+  const auto &request = call.request();
+  call.response().set_received_at(get_current_time());
 
-  if (!owner_ || !owner_->handler_) {
-    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
-                        "Server handler not initialized");
-  }
-
-  std::cout << "Received position request for all from " << context->peer()
-            << std::endl;
+  std::cout << "Replace signal received from " << call.peer() << " - "
+            << request.strategy_id() << " " << request.side() << " "
+            << request.symbol() << request.order_id() << std::endl;
 
-  auto r = owner_->handler_->GetAllPositions(*request);
-  if (!r)
-    return grpc::Status(grpc::StatusCode::INTERNAL, r.error().message_);
+  handler_->ReplaceOrderAsync(request, [&call](Result<BrokerOrderId> r) {
+    auto &response = call.response();
+    if (!r) {
+      response.set_accepted(false);
+      response.set_rejection_reason(r.error().message_);
+      call.finish(error_status(r.error()));
+      return;
+    }
 
-  *response = std::move(r.value());
-  return grpc::Status::OK;
+    response.set_accepted(true);
+    response.set_order_id(r.value());
+    call.finish(grpc::Status::OK);
+  });
 }
 
-grpc::Status gRPCServer::ExecutionServiceImpl::ActivateKillSwitch(
-    grpc::ServerContext *context, const v1::KillSwitchRequest *request,
-    v1::Empty *response) {
-
-  (void)response;
+// Position queries only read PositionKeeper and are answered inline on the
+// poller thread.
+void gRPCServer::handle_get_position(
+    UnaryCall<v1::GetPositionRequest, v1::Position> &call) {
+  std::cout << "Received position request from " << call.peer() << std::endl;
 
-  if (!owner_ || !owner_->handler_) {
-    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
-                        "Server handler not initialized");
+  auto r = handler_->GetPosition(call.request());
+  if (!r) {
+    call.finish(grpc::Status(grpc::StatusCode::INTERNAL, r.error().message_));
+    return;
   }
 
-  std::cout << "Received kill switch request from " << context->peer()
+  call.response() = std::move(r.value());
+  call.finish(grpc::Status::OK);
+}
+
+void gRPCServer::handle_get_all_positions(
+    UnaryCall<v1::Empty, v1::PositionList> &call) {
+  std::cout << "Received position request for all from " << call.peer()
             << std::endl;
 
-  auto r = owner_->handler_->ActivateKillSwitch(*request);
-  if (!r)
-    return grpc::Status(grpc::StatusCode::INTERNAL, r.error().message_);
+  auto r = handler_->GetAllPositions(call.request());
+  if (!r) {
+    call.finish(grpc::Status(grpc::StatusCode::INTERNAL, r.error().message_));
+    return;
+  }
+
+  call.response() = std::move(r.value());
+  call.finish(grpc::Status::OK);
+}
+
+// Answered once every strategy has cancelled its open orders, from whichever
+// worker finishes last; the poller goes straight back to serving.
+void gRPCServer::handle_kill_switch(
+    UnaryCall<v1::KillSwitchRequest, v1::Empty> &call) {
+  std::cout << "Received kill switch request from " << call.peer()
+            << std::endl;
 
-  return grpc::Status::OK;
+  handler_->ActivateKillSwitchAsync(
+      call.request(), [&call](Result<std::monostate> r) {
+        if (!r) {
+          call.finish(
+              grpc::Status(grpc::StatusCode::INTERNAL, r.error().message_));
+          return;
+        }
+        call.finish(grpc::Status::OK);
+      });
 }
 
 } // namespace quarcc
@@ -0,0 +1,162 @@
+#include <trading/marketdata/csv_ticks.h>
+
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <string>
+
+namespace quarcc {
+
+namespace {
+
+template <typename T> std::optional<T> parse_number(std::string_view text) {
+  T value{};
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc{} || end != text.data() + text.size())
+    return std::nullopt;
+  return value;
+}
+
+// Fixed-width unsigned field of an ISO timestamp
+std::optional<int> digits(std::string_view text, std::size_t pos,
+                          std::size_t width) {
+  if (pos + width > text.size())
+    return std::nullopt;
+  int value = 0;
+  for (std::size_t i = pos; i < pos + width; ++i) {
+    if (text[i] < '0' || text[i] > '9')
+      return std::nullopt;
+    value = value * 10 + (text[i] - '0');
+  }
+  return value;
+}
+
+template <typename T> std::optional<T> parse_decimal(std::string_view text) {
+  const auto value = parse_number<double>(text);
+  if (!value)
+    return std::nullopt;
+  return T::checked_from_double(*value);
+}
+
+Result<std::size_t> bad_line(std::size_t line, std::string_view reason) {
+  return std::unexpected(
+      Error{std::format("line {}: {}", line, reason), ErrorType::Error});
+}
+
+} // namespace
+
+std::optional<std::int64_t> parse_timestamp_ns(std::string_view text) {
+  if (!text.empty() && text.find_first_not_of("0123456789") ==
+                           std::string_view::npos)
+    return parse_number<std::int64_t>(text);
+
+  // YYYY-MM-DDTHH:MM:SS
+  if (text.size() < 19 || text[4] != '-' || text[7] != '-' ||
+      (text[10] != 'T' && text[10] != ' ') || text[13] != ':' ||
+      text[16] != ':')
+    return std::nullopt;
+  const auto y = digits(text, 0, 4), mo = digits(text, 5, 2),
+             d = digits(text, 8, 2), h = digits(text, 11, 2),
+             mi = digits(text, 14, 2), s = digits(text, 17, 2);
+  if (!y || !mo || !d || !h || !mi || !s || *h > 23 || *mi > 59 || *s > 59)
+    return std::nullopt;
+
+  const std::chrono::year_month_day date{
+      std::chrono::year{*y}, std::chrono::month{static_cast<unsigned>(*mo)},
+      std::chrono::day{static_cast<unsigned>(*d)}};
+  if (!date.ok())
+    return std::nullopt;
+
+  std::size_t pos = 19;
+  std::int64_t fraction_ns = 0;
+  if (pos < text.size() && text[pos] == '.') {
+    std::int64_t scale = 100'000'000;
+    std::size_t i = ++pos;
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+      if (scale == 0)
+        return std::nullopt; // finer than a nanosecond
+      fraction_ns += (text[i] - '0') * scale;
+      scale /= 10;
+    }
+    if (i == pos)
+      return std::nullopt;
+    pos = i;
+  }
+  if (pos < text.size() && text[pos] == 'Z')
+    ++pos;
+  if (pos != text.size())
+    return std::nullopt;
+
+  const auto time = std::chrono::sys_days{date} + std::chrono::hours{*h} +
+                    std::chrono::minutes{*mi} + std::chrono::seconds{*s};
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch())
+             .count() +
+         fraction_ns;
+}
+
+Result<std::size_t> read_csv_ticks(std::istream &in, TickFileWriter &writer) {
+  constexpr std::size_t kMaxFields = 7;
+
+  std::string line;
+  std::size_t line_number = 0;
+  std::size_t ticks = 0;
+  while (std::getline(in, line)) {
+    ++line_number;
+    std::string_view text = line;
+    if (!text.empty() && text.back() == '\r')
+      text.remove_suffix(1);
+    if (text.empty())
+      continue;
+
+    std::array<std::string_view, kMaxFields> fields;
+    std::size_t count = 0;
+    for (std::size_t start = 0;;) {
+      const std::size_t comma = text.find(',', start);
+      if (count == kMaxFields)
+        return bad_line(line_number, "too many fields");
+      fields[count++] = text.substr(start, comma - start);
+      if (comma == std::string_view::npos)
+        break;
+      start = comma + 1;
+    }
+
+    const auto timestamp = parse_timestamp_ns(fields[0]);
+    if (!timestamp) {
+      if (line_number == 1)
+        continue; // header
+      return bad_line(line_number, "bad timestamp");
+    }
+    if (count < 5)
+      return bad_line(line_number, "expected at least 5 fields");
+
+    const std::string_view symbol = fields[1];
+    if (symbol.empty() || symbol.size() > TickFile::kMaxSymbolLength)
+      return bad_line(line_number, "symbol must be 1 to 16 characters");
+
+    const auto price = parse_decimal<Price>(fields[3]);
+    const auto size = parse_decimal<Quantity>(fields[4]);
+    if (!price || !size)
+      return bad_line(line_number, "bad price or size");
+
+    if (fields[2] == "T") {
+      writer.add_trade(*timestamp, symbol, *price, *size);
+    } else if (fields[2] == "Q") {
+      if (count < 7)
+        return bad_line(line_number, "quotes need ask_price and ask_size");
+      const auto ask = parse_decimal<Price>(fields[5]);
+      const auto ask_size = parse_decimal<Quantity>(fields[6]);
+      if (!ask || !ask_size)
+        return bad_line(line_number, "bad ask price or size");
+      writer.add_quote(*timestamp, symbol, *price, *size, *ask, *ask_size);
+    } else {
+      return bad_line(line_number, "kind must be T or Q");
+    }
+    ++ticks;
+  }
+  return ticks;
+}
+
+} // namespace quarcc
@@ -0,0 +1,38 @@
+// Converts CSV ticks (see read_csv_ticks) into a tick file for replay:
+//
+//   trading_tick_convert ticks.csv ticks.qtk
+
+#include <trading/marketdata/csv_ticks.h>
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0] << " <input.csv> <output>" << std::endl;
+    return 2;
+  }
+
+  std::ifstream in(argv[1]);
+  if (!in) {
+    std::cerr << "cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+
+  quarcc::TickFileWriter writer;
+  const auto ticks = quarcc::read_csv_ticks(in, writer);
+  if (!ticks) {
+    std::cerr << argv[1] << ": " << ticks.error().message_ << std::endl;
+    return 1;
+  }
+
+  try {
+    writer.write(argv[2]);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  std::cout << "wrote " << *ticks << " ticks to " << argv[2] << std::endl;
+  return 0;
+}
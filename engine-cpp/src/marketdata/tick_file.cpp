@@ -0,0 +1,172 @@
+#include <trading/marketdata/tick_file.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace quarcc {
+
+namespace {
+
+constexpr std::uint64_t kTickFileMagic = 0x31305343'49545151; // "QQTICS01"
+constexpr std::uint32_t kTickFileVersion = 1;
+
+struct FileHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t header_size;
+  std::uint32_t record_size;
+  std::uint32_t symbol_count;
+  std::uint64_t record_count;
+  std::int64_t first_timestamp_ns;
+  std::int64_t last_timestamp_ns;
+  std::uint64_t reserved[2];
+};
+static_assert(sizeof(FileHeader) == 64);
+static_assert(TickFile::kMaxSymbolLength % alignof(TickRecord) == 0,
+              "records must stay aligned after the symbol list");
+
+std::runtime_error file_error(const std::filesystem::path &path,
+                              const std::string &what) {
+  return std::runtime_error("Tick file " + path.string() + ": " + what);
+}
+
+} // namespace
+
+TickFile::TickFile(const std::filesystem::path &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw file_error(path, std::strerror(errno));
+
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    const int err = errno;
+    ::close(fd);
+    throw file_error(path, std::strerror(err));
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  if (size_ < sizeof(FileHeader)) {
+    ::close(fd);
+    throw file_error(path, "too short for a header");
+  }
+
+  base_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  const int err = errno;
+  ::close(fd);
+  if (base_ == MAP_FAILED) {
+    base_ = nullptr;
+    throw file_error(path, std::strerror(err));
+  }
+  ::madvise(base_, size_, MADV_SEQUENTIAL);
+
+  FileHeader header;
+  std::memcpy(&header, base_, sizeof(header));
+  const std::size_t symbols_size =
+      std::size_t{header.symbol_count} * kMaxSymbolLength;
+  if (header.magic != kTickFileMagic || header.version != kTickFileVersion ||
+      header.header_size != sizeof(FileHeader) ||
+      header.record_size != sizeof(TickRecord) ||
+      header.record_count > (size_ - sizeof(FileHeader)) / sizeof(TickRecord) ||
+      sizeof(FileHeader) + symbols_size +
+              header.record_count * sizeof(TickRecord) !=
+          size_) {
+    ::munmap(base_, size_);
+    base_ = nullptr;
+    throw file_error(path, "not a version 1 tick file, or truncated");
+  }
+
+  const char *symbols = static_cast<const char *>(base_) + sizeof(FileHeader);
+  symbols_.reserve(header.symbol_count);
+  for (std::uint32_t i = 0; i < header.symbol_count; ++i) {
+    const char *name = symbols + std::size_t{i} * kMaxSymbolLength;
+    symbols_.emplace_back(name, ::strnlen(name, kMaxSymbolLength));
+  }
+
+  records_ = {reinterpret_cast<const TickRecord *>(symbols + symbols_size),
+              static_cast<std::size_t>(header.record_count)};
+}
+
+TickFile::~TickFile() {
+  if (base_)
+    ::munmap(base_, size_);
+}
+
+void TickFileWriter::add_trade(std::int64_t timestamp_ns,
+                               std::string_view symbol, Price price,
+                               Quantity size) {
+  records_.push_back(TickRecord{.timestamp_ns = timestamp_ns,
+                                .price_raw = price.raw(),
+                                .size_raw = size.raw(),
+                                .ask_price_raw = 0,
+                                .ask_size_raw = 0,
+                                .symbol = symbol_index(symbol),
+                                .kind = TickKind::Trade,
+                                .reserved = {}});
+}
+
+void TickFileWriter::add_quote(std::int64_t timestamp_ns,
+                               std::string_view symbol, Price bid,
+                               Quantity bid_size, Price ask,
+                               Quantity ask_size) {
+  records_.push_back(TickRecord{.timestamp_ns = timestamp_ns,
+                                .price_raw = bid.raw(),
+                                .size_raw = bid_size.raw(),
+                                .ask_price_raw = ask.raw(),
+                                .ask_size_raw = ask_size.raw(),
+                                .symbol = symbol_index(symbol),
+                                .kind = TickKind::Quote,
+                                .reserved = {}});
+}
+
+void TickFileWriter::write(const std::filesystem::path &path) {
+  std::stable_sort(records_.begin(), records_.end(),
+                   [](const TickRecord &a, const TickRecord &b) {
+                     return a.timestamp_ns < b.timestamp_ns;
+                   });
+
+  FileHeader header{};
+  header.magic = kTickFileMagic;
+  header.version = kTickFileVersion;
+  header.header_size = sizeof(FileHeader);
+  header.record_size = sizeof(TickRecord);
+  header.symbol_count = static_cast<std::uint32_t>(symbols_.size());
+  header.record_count = records_.size();
+  if (!records_.empty()) {
+    header.first_timestamp_ns = records_.front().timestamp_ns;
+    header.last_timestamp_ns = records_.back().timestamp_ns;
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (const std::string &symbol : symbols_) {
+    char name[TickFile::kMaxSymbolLength] = {};
+    std::memcpy(name, symbol.data(), symbol.size());
+    out.write(name, sizeof(name));
+  }
+  out.write(reinterpret_cast<const char *>(records_.data()),
+            static_cast<std::streamsize>(records_.size() * sizeof(TickRecord)));
+  out.flush();
+  if (!out)
+    throw file_error(path, "write failed");
+}
+
+std::uint32_t TickFileWriter::symbol_index(std::string_view symbol) {
+  if (symbol.empty() || symbol.size() > TickFile::kMaxSymbolLength)
+    throw std::runtime_error("Tick file symbol must be 1 to 16 characters: " +
+                             std::string(symbol));
+
+  auto [it, inserted] = symbol_indexes_.try_emplace(
+      std::string(symbol), static_cast<std::uint32_t>(symbols_.size()));
+  if (inserted)
+    symbols_.emplace_back(symbol);
+  return it->second;
+}
+
+} // namespace quarcc
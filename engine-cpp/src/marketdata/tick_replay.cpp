@@ -0,0 +1,44 @@
+#include <trading/marketdata/tick_replay.h>
+
+#include <algorithm>
+
+namespace quarcc {
+
+TickReplay::TickReplay(std::shared_ptr<const TickFile> file,
+                       SymbolTable &symbols)
+    : file_(std::move(file)) {
+  symbol_ids_.reserve(file_->symbol_count());
+  for (std::uint32_t i = 0; i < file_->symbol_count(); ++i)
+    symbol_ids_.push_back(symbols.intern(file_->symbol(i)));
+}
+
+const TickRecord *TickReplay::peek() {
+  const auto records = file_->records();
+  while (position_ < records.size()) {
+    const TickRecord &record = records[position_];
+    if (record.symbol < symbol_ids_.size())
+      return &record;
+    ++position_;
+    ++skipped_;
+  }
+  return nullptr;
+}
+
+const TickRecord *TickReplay::next() {
+  const TickRecord *record = peek();
+  if (record)
+    ++position_;
+  return record;
+}
+
+void TickReplay::seek(std::int64_t timestamp_ns) {
+  const auto records = file_->records();
+  const auto it = std::lower_bound(
+      records.begin() + static_cast<std::ptrdiff_t>(position_), records.end(),
+      timestamp_ns, [](const TickRecord &record, std::int64_t ts) {
+        return record.timestamp_ns < ts;
+      });
+  position_ = static_cast<std::size_t>(it - records.begin());
+}
+
+} // namespace quarcc
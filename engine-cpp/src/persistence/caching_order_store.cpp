@@ -0,0 +1,181 @@
+#include <trading/interfaces/i_journal.h>
+#include <trading/persistence/caching_order_store.h>
+
+#include <algorithm>
+
+namespace quarcc {
+
+static std::vector<StoredOrder> sorted_by_creation(std::vector<StoredOrder> v) {
+  std::stable_sort(v.begin(), v.end(),
+                   [](const StoredOrder &a, const StoredOrder &b) {
+                     return a.created_at < b.created_at;
+                   });
+  return v;
+}
+
+CachingOrderStore::CachingOrderStore(std::unique_ptr<IOrderStore> backing,
+                                     const IClock &clock)
+    : backing_(std::move(backing)), clock_(&clock) {
+  for (auto &stored : backing_->get_open_orders()) {
+    auto local_id = stored.local_id;
+    open_orders_.emplace(std::move(local_id), std::move(stored));
+  }
+}
+
+Result<std::monostate>
+CachingOrderStore::store_order(const StoredOrder &order) {
+  if (auto r = backing_->store_order(order); !r)
+    return r;
+
+  if (!is_terminal(order.status)) {
+    std::lock_guard lock(mutex_);
+    open_orders_.insert_or_assign(order.local_id, order);
+  }
+  return std::monostate{};
+}
+
+Result<std::monostate>
+CachingOrderStore::update_order_status(const std::string &local_id,
+                                       OrderStatus new_status) {
+  if (auto r = backing_->update_order_status(local_id, new_status); !r)
+    return r;
+
+  std::lock_guard lock(mutex_);
+  auto it = open_orders_.find(local_id);
+  if (it == open_orders_.end())
+    return std::monostate{};
+
+  if (is_terminal(new_status)) {
+    open_orders_.erase(it);
+  } else {
+    it->second.status = new_status;
+    it->second.updated_at = clock_->now();
+  }
+  return std::monostate{};
+}
+
+Result<std::monostate>
+CachingOrderStore::update_broker_id(const std::string &local_id,
+                                    const std::string &broker_id) {
+  if (auto r = backing_->update_broker_id(local_id, broker_id); !r)
+    return r;
+
+  std::lock_guard lock(mutex_);
+  if (auto it = open_orders_.find(local_id); it != open_orders_.end()) {
+    it->second.broker_id = broker_id;
+    it->second.updated_at = clock_->now();
+  }
+  return std::monostate{};
+}
+
+Result<std::monostate>
+CachingOrderStore::update_fill_info(const std::string &local_id,
+                                    Quantity filled_quantity, Price avg_price) {
+  if (auto r = backing_->update_fill_info(local_id, filled_quantity, avg_price);
+      !r)
+    return r;
+
+  std::lock_guard lock(mutex_);
+  if (auto it = open_orders_.find(local_id); it != open_orders_.end()) {
+    it->second.filled_quantity = filled_quantity;
+    it->second.avg_fill_price = avg_price;
+    it->second.updated_at = clock_->now();
+  }
+  return std::monostate{};
+}
+
+Result<std::monostate>
+CachingOrderStore::apply_fill(const std::string &local_id, Quantity delta_qty,
+                              Price price, OrderStatus new_status) {
+  if (auto r = backing_->apply_fill(local_id, delta_qty, price, new_status); !r)
+    return r;
+
+  std::lock_guard lock(mutex_);
+  apply_fill_to_cache({local_id, delta_qty, price, new_status});
+  return std::monostate{};
+}
+
+Result<std::monostate>
+CachingOrderStore::apply_fills(const std::vector<FillUpdate> &updates) {
+  if (auto r = backing_->apply_fills(updates); !r)
+    return r;
+
+  std::lock_guard lock(mutex_);
+  for (const auto &update : updates)
+    apply_fill_to_cache(update);
+  return std::monostate{};
+}
+
+// Mirrors the SQL in SQLiteOrderStore::apply_fill
+void CachingOrderStore::apply_fill_to_cache(const FillUpdate &update) {
+  auto it = open_orders_.find(update.local_id);
+  if (it == open_orders_.end())
+    return;
+
+  if (is_terminal(update.new_status)) {
+    open_orders_.erase(it);
+    return;
+  }
+
+  auto &stored = it->second;
+  const Quantity total = stored.filled_quantity + update.delta_qty;
+  if (total > Quantity{})
+    stored.avg_fill_price = (stored.filled_quantity * stored.avg_fill_price +
+                             update.delta_qty * update.price) /
+                            total;
+  stored.filled_quantity = total;
+  stored.status = update.new_status;
+  stored.updated_at = clock_->now();
+}
+
+Result<StoredOrder> CachingOrderStore::get_order(const std::string &local_id) {
+  {
+    std::lock_guard lock(mutex_);
+    if (auto it = open_orders_.find(local_id); it != open_orders_.end())
+      return it->second;
+  }
+  // Terminal (or unknown) orders are not cached
+  return backing_->get_order(local_id);
+}
+
+std::vector<StoredOrder> CachingOrderStore::get_open_orders() {
+  std::vector<StoredOrder> orders;
+  {
+    std::lock_guard lock(mutex_);
+    orders.reserve(open_orders_.size());
+    for (const auto &[local_id, stored] : open_orders_)
+      orders.push_back(stored);
+  }
+  return sorted_by_creation(std::move(orders));
+}
+
+std::vector<StoredOrder>
+CachingOrderStore::get_orders_by_status(OrderStatus status) {
+  if (is_terminal(status))
+    return backing_->get_orders_by_status(status);
+
+  std::vector<StoredOrder> orders;
+  {
+    std::lock_guard lock(mutex_);
+    for (const auto &[local_id, stored] : open_orders_)
+      if (stored.status == status)
+        orders.push_back(stored);
+  }
+  return sorted_by_creation(std::move(orders));
+}
+
+Result<std::monostate>
+CachingOrderStore::save_position_snapshot(const PositionSnapshot &snapshot) {
+  return backing_->save_position_snapshot(snapshot);
+}
+
+Result<PositionSnapshot> CachingOrderStore::load_position_snapshot() {
+  return backing_->load_position_snapshot();
+}
+
+std::size_t CachingOrderStore::cached_count() const {
+  std::lock_guard lock(mutex_);
+  return open_orders_.size();
+}
+
+} // namespace quarcc
@@ -0,0 +1,19 @@
+#include <trading/persistence/journal_factory.h>
+
+namespace quarcc {
+
+std::unique_ptr<IJournal> make_journal(const std::string &path,
+                                       const JournalConfig &config,
+                                       const IClock &clock) {
+  switch (config.backend) {
+  case JournalBackend::Mmap:
+    return std::make_unique<MmapJournal>(path, config.mmap, clock);
+  case JournalBackend::Memory:
+    return std::make_unique<MemoryJournal>(clock);
+  case JournalBackend::SQLite:
+  default:
+    return std::make_unique<SQLiteJournal>(path + ".db", config.sqlite, clock);
+  }
+}
+
+} // namespace quarcc
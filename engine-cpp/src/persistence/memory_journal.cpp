@@ -0,0 +1,62 @@
+#include <trading/persistence/memory_journal.h>
+
+#include <algorithm>
+
+namespace quarcc {
+
+MemoryJournal::MemoryJournal(const IClock &clock) : clock_(&clock) {}
+
+void MemoryJournal::log(Event event, const std::string &data,
+                        const std::string &correlation_id) {
+  const Timestamp now = clock_->now();
+
+  std::lock_guard lock(mutex_);
+  // Kept non-decreasing so get_history can binary search
+  const Timestamp timestamp =
+      entries_.empty() ? now : std::max(now, entries_.back().timestamp);
+  if (!correlation_id.empty())
+    by_correlation_[correlation_id].push_back(entries_.size());
+  entries_.push_back(
+      {entries_.size() + 1, timestamp, event, data, correlation_id});
+}
+
+std::vector<LogEntry>
+MemoryJournal::get_history(Timestamp from, Timestamp to,
+                           std::optional<Event> event_filter) {
+  std::vector<LogEntry> entries;
+
+  std::lock_guard lock(mutex_);
+  auto it = std::lower_bound(
+      entries_.begin(), entries_.end(), from,
+      [](const LogEntry &entry, Timestamp t) { return entry.timestamp < t; });
+  for (; it != entries_.end() && it->timestamp <= to; ++it)
+    if (!event_filter || it->event_type == *event_filter)
+      entries.push_back(*it);
+  return entries;
+}
+
+std::vector<LogEntry>
+MemoryJournal::get_order_history(const std::string &order_id) {
+  std::vector<LogEntry> entries;
+
+  std::lock_guard lock(mutex_);
+  auto it = by_correlation_.find(order_id);
+  if (it == by_correlation_.end())
+    return entries;
+  entries.reserve(it->second.size());
+  for (const std::size_t index : it->second)
+    entries.push_back(entries_[index]);
+  return entries;
+}
+
+std::uint64_t MemoryJournal::last_id() {
+  std::lock_guard lock(mutex_);
+  return entries_.size();
+}
+
+std::size_t MemoryJournal::size() const {
+  std::lock_guard lock(mutex_);
+  return entries_.size();
+}
+
+} // namespace quarcc
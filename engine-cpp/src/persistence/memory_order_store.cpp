@@ -0,0 +1,149 @@
+#include <trading/persistence/memory_order_store.h>
+
+#include <algorithm>
+
+namespace quarcc {
+
+MemoryOrderStore::MemoryOrderStore(const IClock &clock) : clock_(&clock) {}
+
+StoredOrder *MemoryOrderStore::find(const std::string &local_id) {
+  auto it = index_.find(local_id);
+  return it == index_.end() ? nullptr : &orders_[it->second];
+}
+
+template <typename Pred>
+std::vector<StoredOrder> MemoryOrderStore::collect(Pred pred) const {
+  std::vector<StoredOrder> orders;
+  {
+    std::lock_guard lock(mutex_);
+    for (const auto &stored : orders_)
+      if (pred(stored))
+        orders.push_back(stored);
+  }
+  std::stable_sort(orders.begin(), orders.end(),
+                   [](const StoredOrder &a, const StoredOrder &b) {
+                     return a.created_at < b.created_at;
+                   });
+  return orders;
+}
+
+Result<std::monostate> MemoryOrderStore::store_order(const StoredOrder &order) {
+  std::lock_guard lock(mutex_);
+  if (!index_.try_emplace(order.local_id, orders_.size()).second)
+    return std::unexpected(Error{
+        "Failed to insert order: duplicate local id " + order.local_id,
+        ErrorType::Error});
+
+  // Like the SQL insert, which leaves updated_at NULL
+  auto &stored = orders_.emplace_back(order);
+  stored.updated_at.reset();
+  return std::monostate{};
+}
+
+Result<std::monostate>
+MemoryOrderStore::update_order_status(const std::string &local_id,
+                                      OrderStatus new_status) {
+  std::lock_guard lock(mutex_);
+  if (auto *stored = find(local_id)) {
+    stored->status = new_status;
+    stored->updated_at = clock_->now();
+  }
+  return std::monostate{};
+}
+
+Result<std::monostate>
+MemoryOrderStore::update_broker_id(const std::string &local_id,
+                                   const std::string &broker_id) {
+  std::lock_guard lock(mutex_);
+  if (auto *stored = find(local_id)) {
+    stored->broker_id = broker_id;
+    stored->updated_at = clock_->now();
+  }
+  return std::monostate{};
+}
+
+Result<std::monostate>
+MemoryOrderStore::update_fill_info(const std::string &local_id,
+                                   Quantity filled_quantity, Price avg_price) {
+  std::lock_guard lock(mutex_);
+  if (auto *stored = find(local_id)) {
+    stored->filled_quantity = filled_quantity;
+    stored->avg_fill_price = avg_price;
+    stored->updated_at = clock_->now();
+  }
+  return std::monostate{};
+}
+
+Result<std::monostate>
+MemoryOrderStore::apply_fill(const std::string &local_id, Quantity delta_qty,
+                             Price price, OrderStatus new_status) {
+  std::lock_guard lock(mutex_);
+  apply_fill_locked({local_id, delta_qty, price, new_status});
+  return std::monostate{};
+}
+
+// Nothing here can fail part way, so the batch is trivially atomic
+Result<std::monostate>
+MemoryOrderStore::apply_fills(const std::vector<FillUpdate> &updates) {
+  std::lock_guard lock(mutex_);
+  for (const auto &update : updates)
+    apply_fill_locked(update);
+  return std::monostate{};
+}
+
+// Mirrors the SQL in SQLiteOrderStore::apply_fill
+void MemoryOrderStore::apply_fill_locked(const FillUpdate &update) {
+  auto *stored = find(update.local_id);
+  if (!stored)
+    return;
+
+  const Quantity total = stored->filled_quantity + update.delta_qty;
+  if (total > Quantity{})
+    stored->avg_fill_price = (stored->filled_quantity * stored->avg_fill_price +
+                              update.delta_qty * update.price) /
+                             total;
+  stored->filled_quantity = total;
+  stored->status = update.new_status;
+  stored->updated_at = clock_->now();
+}
+
+Result<StoredOrder> MemoryOrderStore::get_order(const std::string &local_id) {
+  std::lock_guard lock(mutex_);
+  if (const auto *stored = find(local_id))
+    return *stored;
+  return std::unexpected(
+      Error{"Order not found: " + local_id, ErrorType::Error});
+}
+
+std::vector<StoredOrder> MemoryOrderStore::get_open_orders() {
+  return collect(
+      [](const StoredOrder &stored) { return !is_terminal(stored.status); });
+}
+
+std::vector<StoredOrder>
+MemoryOrderStore::get_orders_by_status(OrderStatus status) {
+  return collect(
+      [status](const StoredOrder &stored) { return stored.status == status; });
+}
+
+Result<std::monostate>
+MemoryOrderStore::save_position_snapshot(const PositionSnapshot &snapshot) {
+  std::lock_guard lock(mutex_);
+  snapshot_ = snapshot;
+  return std::monostate{};
+}
+
+Result<PositionSnapshot> MemoryOrderStore::load_position_snapshot() {
+  std::lock_guard lock(mutex_);
+  if (!snapshot_)
+    return std::unexpected(
+        Error{"No position snapshot stored", ErrorType::Error});
+  return *snapshot_;
+}
+
+std::vector<StoredOrder> MemoryOrderStore::get_all_orders() const {
+  std::lock_guard lock(mutex_);
+  return orders_;
+}
+
+} // namespace quarcc
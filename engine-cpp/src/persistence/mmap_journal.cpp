@@ -0,0 +1,504 @@
+#include <trading/persistence/mmap_journal.h>
+#include <trading/utils/crc32.h>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace quarcc {
+
+namespace {
+
+constexpr std::uint64_t kSegmentMagic = 0x31474553'4C4E4A51; // "QJNLSEG1"
+constexpr std::uint32_t kSegmentVersion = 1;
+
+struct SegmentHeader {
+  std::uint64_t magic;
+  std::uint32_t version;
+  std::uint32_t header_size;
+  std::uint64_t reserved[6];
+};
+static_assert(sizeof(SegmentHeader) == 64);
+
+// Followed by `length` payload bytes: correlation id, then data. The CRC
+// covers the header (with crc = 0) and the payload. An id of 0 marks the
+// zero-filled space after the last record.
+struct RecordHeader {
+  std::uint32_t length;
+  std::uint32_t crc;
+  std::uint64_t id;
+  std::int64_t timestamp_ns;
+  std::uint16_t correlation_len;
+  std::uint8_t event;
+  std::uint8_t reserved[5];
+};
+static_assert(sizeof(RecordHeader) == 32);
+
+constexpr std::size_t kRecordAlign = 8;
+
+constexpr std::size_t record_size(std::uint32_t length) {
+  return (sizeof(RecordHeader) + length + kRecordAlign - 1) &
+         ~(kRecordAlign - 1);
+}
+
+std::uint32_t record_crc(RecordHeader header, const char *payload) {
+  header.crc = 0;
+  return crc32(payload, header.length, crc32(&header, sizeof(header)));
+}
+
+std::string segment_name(std::uint32_t index) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "journal-%08u.seg", index);
+  return name;
+}
+
+} // namespace
+
+struct MmapJournal::Segment {
+  std::uint32_t index = 0;
+  int fd = -1;
+  char *base = nullptr;
+  std::size_t capacity = 0;
+  std::size_t write_offset = sizeof(SegmentHeader);
+  // Written back up to here by MS_ASYNC (scheduled) or MS_SYNC (durable)
+  std::size_t scheduled_offset = 0;
+  std::size_t durable_offset = 0;
+
+  std::size_t record_count = 0;
+  std::int64_t min_ts = 0;
+  std::int64_t max_ts = 0;
+  // (timestamp, offset) of every `time_index_stride`-th record
+  std::vector<std::pair<std::int64_t, std::uint32_t>> time_index;
+  // Dropped by trim_correlation_index() once the journal holds too many
+  std::unordered_map<std::string, std::vector<std::uint32_t>> by_correlation;
+  std::size_t correlation_entries = 0;
+  bool correlation_indexed = true;
+
+  ~Segment() {
+    if (base)
+      munmap(base, capacity);
+    if (fd >= 0)
+      close(fd);
+  }
+
+  RecordHeader header_at(std::size_t offset) const {
+    RecordHeader header;
+    std::memcpy(&header, base + offset, sizeof(header));
+    return header;
+  }
+
+  LogEntry entry_at(std::size_t offset, const RecordHeader &header) const {
+    const char *payload = base + offset + sizeof(RecordHeader);
+    LogEntry entry;
+    entry.id = header.id;
+    entry.timestamp = LogEntry::from_nanos(header.timestamp_ns);
+    entry.event_type = static_cast<Event>(header.event);
+    entry.correlation_id.assign(payload, header.correlation_len);
+    entry.data.assign(payload + header.correlation_len,
+                      header.length - header.correlation_len);
+    return entry;
+  }
+
+  // Fallback for a segment whose correlation index was dropped
+  void scan_correlation(const std::string &correlation_id,
+                        std::vector<LogEntry> &entries) const {
+    for (std::size_t offset = sizeof(SegmentHeader); offset < write_offset;) {
+      const RecordHeader header = header_at(offset);
+      if (header.correlation_len == correlation_id.size() &&
+          std::memcmp(base + offset + sizeof(RecordHeader),
+                      correlation_id.data(), correlation_id.size()) == 0)
+        entries.push_back(entry_at(offset, header));
+      offset += record_size(header.length);
+    }
+  }
+};
+
+MmapJournal::MmapJournal(std::filesystem::path directory,
+                         MmapJournalOptions options, const IClock &clock)
+    : directory_(std::move(directory)), options_(options), clock_(&clock),
+      last_sync_(std::chrono::steady_clock::now()) {
+  options_.time_index_stride = std::max<std::size_t>(1, options_.time_index_stride);
+  options_.segment_size =
+      std::max(options_.segment_size, sizeof(SegmentHeader) + 4096);
+
+  std::filesystem::create_directories(directory_);
+  directory_fd_ =
+      ::open(directory_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (directory_fd_ < 0)
+    throw std::runtime_error("Failed to open journal directory " +
+                             directory_.string() + ": " +
+                             std::strerror(errno));
+  // Two writers would hand out the same ids and overwrite each other's
+  // records through their mappings
+  if (flock(directory_fd_, LOCK_EX | LOCK_NB) != 0) {
+    const int err = errno;
+    close(directory_fd_);
+    throw std::runtime_error(
+        "Journal directory " + directory_.string() +
+        (err == EWOULDBLOCK ? " is in use by another writer"
+                            : std::string(" could not be locked: ") +
+                                  std::strerror(err)));
+  }
+
+  try {
+    recover();
+  } catch (...) {
+    close(directory_fd_);
+    throw;
+  }
+}
+
+MmapJournal::~MmapJournal() {
+  std::lock_guard lock(mutex_);
+  sync_all();
+  // Unmapped before the lock goes, so the next writer has the files to itself
+  segments_.clear();
+  close(directory_fd_);
+}
+
+void MmapJournal::log(Event event, const std::string &data,
+                      const std::string &correlation_id) {
+  if (correlation_id.size() > std::numeric_limits<std::uint16_t>::max() ||
+      correlation_id.size() + data.size() >
+          options_.segment_size - sizeof(SegmentHeader) -
+              sizeof(RecordHeader)) {
+    std::cerr << "Journal record too large, dropped (" << data.size()
+              << " bytes)" << std::endl;
+    return;
+  }
+
+  const auto length =
+      static_cast<std::uint32_t>(correlation_id.size() + data.size());
+  const std::size_t size = record_size(length);
+
+  std::lock_guard lock(mutex_);
+
+  if (segments_.back()->write_offset + size > segments_.back()->capacity)
+    roll_segment();
+  Segment &segment = *segments_.back();
+
+  // Kept non-decreasing so the sparse time index stays sorted
+  const std::int64_t ts =
+      std::max(LogEntry::to_nanos(clock_->now()), last_timestamp_ns_);
+  last_timestamp_ns_ = ts;
+
+  RecordHeader header{};
+  header.length = length;
+  header.id = next_id_++;
+  header.timestamp_ns = ts;
+  header.correlation_len = static_cast<std::uint16_t>(correlation_id.size());
+  header.event = static_cast<std::uint8_t>(event);
+
+  const auto offset = static_cast<std::uint32_t>(segment.write_offset);
+  char *record = segment.base + offset;
+  char *payload = record + sizeof(RecordHeader);
+  std::memcpy(payload, correlation_id.data(), correlation_id.size());
+  std::memcpy(payload + correlation_id.size(), data.data(), data.size());
+  header.crc = record_crc(header, payload);
+  std::memcpy(record, &header, sizeof(header));
+
+  segment.write_offset += size;
+  index_record(segment, offset, ts, correlation_id);
+  trim_correlation_index();
+
+  if (options_.sync_interval.count() > 0) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_sync_ >= options_.sync_interval) {
+      sync(segment, MS_ASYNC);
+      last_sync_ = now;
+    }
+  }
+}
+
+std::vector<LogEntry> MmapJournal::get_history(Timestamp from, Timestamp to,
+                                               std::optional<Event> event_filter) {
+  const std::int64_t from_ts = LogEntry::to_nanos(from);
+  const std::int64_t to_ts = LogEntry::to_nanos(to);
+  std::vector<LogEntry> entries;
+
+  std::lock_guard lock(mutex_);
+  for (const auto &segment : segments_) {
+    if (segment->record_count == 0 || segment->max_ts < from_ts ||
+        segment->min_ts > to_ts)
+      continue;
+
+    // Start at the last indexed record strictly before `from`; everything
+    // before it is older still.
+    const auto &index = segment->time_index;
+    auto it = std::lower_bound(
+        index.begin(), index.end(), from_ts,
+        [](const auto &point, std::int64_t ts) { return point.first < ts; });
+    if (it != index.begin())
+      --it;
+
+    for (std::size_t offset = it->second; offset < segment->write_offset;) {
+      const RecordHeader header = segment->header_at(offset);
+      if (header.timestamp_ns > to_ts)
+        break;
+      if (header.timestamp_ns >= from_ts &&
+          (!event_filter ||
+           header.event == static_cast<std::uint8_t>(*event_filter)))
+        entries.push_back(segment->entry_at(offset, header));
+      offset += record_size(header.length);
+    }
+  }
+  return entries;
+}
+
+std::vector<LogEntry>
+MmapJournal::get_order_history(const std::string &order_id) {
+  std::vector<LogEntry> entries;
+
+  std::lock_guard lock(mutex_);
+  for (const auto &segment : segments_) {
+    if (!segment->correlation_indexed) {
+      segment->scan_correlation(order_id, entries);
+      continue;
+    }
+    auto it = segment->by_correlation.find(order_id);
+    if (it == segment->by_correlation.end())
+      continue;
+    for (const std::uint32_t offset : it->second)
+      entries.push_back(segment->entry_at(offset, segment->header_at(offset)));
+  }
+  return entries;
+}
+
+void MmapJournal::flush() {
+  std::lock_guard lock(mutex_);
+  sync_all();
+  last_sync_ = std::chrono::steady_clock::now();
+}
+
+std::size_t MmapJournal::segment_count() const {
+  std::lock_guard lock(mutex_);
+  return segments_.size();
+}
+
+std::uint64_t MmapJournal::last_id() {
+  std::lock_guard lock(mutex_);
+  return next_id_ - 1;
+}
+
+std::size_t MmapJournal::correlation_index_size() const {
+  std::lock_guard lock(mutex_);
+  return correlation_entries_;
+}
+
+std::size_t MmapJournal::unsynced_bytes() const {
+  std::lock_guard lock(mutex_);
+  std::size_t bytes = 0;
+  for (const auto &segment : segments_)
+    bytes += segment->write_offset - segment->durable_offset;
+  return bytes;
+}
+
+// Maps an existing segment file (create_size == 0), or creates, pre-allocates
+// and maps a new one
+std::unique_ptr<MmapJournal::Segment>
+MmapJournal::map_segment(const std::filesystem::path &path,
+                         std::uint32_t index, std::size_t create_size) {
+  auto segment = std::make_unique<Segment>();
+  segment->index = index;
+
+  const int flags = create_size ? O_RDWR | O_CREAT | O_EXCL : O_RDWR;
+  segment->fd = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+  if (segment->fd < 0)
+    throw std::runtime_error("Failed to open journal segment " +
+                             path.string() + ": " + std::strerror(errno));
+
+  if (create_size) {
+    // Reserve the blocks up front so appends never hit ENOSPC through a
+    // SIGBUS on the mapping; fall back to a sparse file where unsupported.
+    if (posix_fallocate(segment->fd, 0, static_cast<off_t>(create_size)) != 0 &&
+        ftruncate(segment->fd, static_cast<off_t>(create_size)) != 0)
+      throw std::runtime_error("Failed to allocate journal segment " +
+                               path.string() + ": " + std::strerror(errno));
+    // The new size is metadata, which msync() of the mapping does not cover
+    if (fsync(segment->fd) != 0)
+      throw std::runtime_error("Failed to sync journal segment " +
+                               path.string() + ": " + std::strerror(errno));
+    segment->capacity = create_size;
+  } else {
+    struct stat st {};
+    if (fstat(segment->fd, &st) != 0)
+      throw std::runtime_error("Failed to stat journal segment " +
+                               path.string() + ": " + std::strerror(errno));
+    segment->capacity = static_cast<std::size_t>(st.st_size);
+    if (segment->capacity < sizeof(SegmentHeader))
+      throw std::runtime_error("Truncated journal segment " + path.string());
+  }
+
+  void *base = mmap(nullptr, segment->capacity, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, segment->fd, 0);
+  if (base == MAP_FAILED)
+    throw std::runtime_error("Failed to map journal segment " + path.string() +
+                             ": " + std::strerror(errno));
+  segment->base = static_cast<char *>(base);
+
+  if (create_size) {
+    const SegmentHeader header{kSegmentMagic, kSegmentVersion,
+                               sizeof(SegmentHeader), {}};
+    std::memcpy(segment->base, &header, sizeof(header));
+  } else {
+    SegmentHeader header;
+    std::memcpy(&header, segment->base, sizeof(header));
+    if (header.magic != kSegmentMagic || header.version != kSegmentVersion)
+      throw std::runtime_error("Not a journal segment: " + path.string());
+  }
+
+  return segment;
+}
+
+void MmapJournal::recover() {
+  std::vector<std::pair<std::uint32_t, std::filesystem::path>> files;
+  for (const auto &dirent : std::filesystem::directory_iterator(directory_)) {
+    unsigned index = 0;
+    const auto name = dirent.path().filename().string();
+    if (std::sscanf(name.c_str(), "journal-%8u.seg", &index) == 1 &&
+        name == segment_name(index))
+      files.emplace_back(index, dirent.path());
+  }
+  std::sort(files.begin(), files.end());
+
+  for (const auto &[index, path] : files) {
+    segments_.push_back(map_segment(path, index, 0));
+    scan_segment(*segments_.back());
+    trim_correlation_index();
+  }
+
+  if (segments_.empty()) {
+    segments_.push_back(map_segment(directory_ / segment_name(0), 0,
+                                    options_.segment_size));
+    sync_directory();
+  }
+}
+
+// Rebuilds the indexes of a segment and positions its write offset after the
+// last record that passes its CRC check.
+void MmapJournal::scan_segment(Segment &segment) {
+  std::size_t offset = sizeof(SegmentHeader);
+
+  while (offset + sizeof(RecordHeader) <= segment.capacity) {
+    const RecordHeader header = segment.header_at(offset);
+    if (header.id == 0)
+      break; // pre-allocated space, end of log
+
+    const bool valid =
+        header.correlation_len <= header.length &&
+        offset + record_size(header.length) <= segment.capacity &&
+        record_crc(header, segment.base + offset + sizeof(RecordHeader)) ==
+            header.crc;
+    if (!valid) {
+      // Torn or corrupt tail: clear it so the next append starts clean
+      std::cerr << "Journal segment " << segment.index
+                << ": discarding invalid record at offset " << offset
+                << std::endl;
+      std::memset(segment.base + offset, 0,
+                  std::min(segment.capacity - offset,
+                           record_size(header.length)));
+      break;
+    }
+
+    const char *payload = segment.base + offset + sizeof(RecordHeader);
+    index_record(segment, static_cast<std::uint32_t>(offset),
+                 header.timestamp_ns,
+                 std::string(payload, header.correlation_len));
+    next_id_ = std::max(next_id_, header.id + 1);
+    last_timestamp_ns_ = std::max(last_timestamp_ns_, header.timestamp_ns);
+    offset += record_size(header.length);
+  }
+
+  segment.write_offset = offset;
+  segment.scheduled_offset = offset;
+  segment.durable_offset = offset;
+}
+
+void MmapJournal::roll_segment() {
+  sync(*segments_.back(), MS_ASYNC);
+  const std::uint32_t index = segments_.back()->index + 1;
+  segments_.push_back(
+      map_segment(directory_ / segment_name(index), index, options_.segment_size));
+  sync_directory();
+}
+
+void MmapJournal::index_record(Segment &segment, std::uint32_t offset,
+                               std::int64_t timestamp_ns,
+                               const std::string &correlation_id) {
+  if (segment.record_count % options_.time_index_stride == 0)
+    segment.time_index.emplace_back(timestamp_ns, offset);
+  if (segment.record_count == 0)
+    segment.min_ts = timestamp_ns;
+  segment.max_ts = timestamp_ns;
+  ++segment.record_count;
+
+  if (!correlation_id.empty() && segment.correlation_indexed) {
+    segment.by_correlation[correlation_id].push_back(offset);
+    ++segment.correlation_entries;
+    ++correlation_entries_;
+  }
+}
+
+// Drops whole indexes, oldest segment first, never the one being written to
+void MmapJournal::trim_correlation_index() {
+  for (auto &segment : segments_) {
+    if (correlation_entries_ <= options_.max_correlation_entries ||
+        segment == segments_.back())
+      return;
+    if (!segment->correlation_indexed)
+      continue;
+    correlation_entries_ -= segment->correlation_entries;
+    segment->by_correlation = {};
+    segment->correlation_entries = 0;
+    segment->correlation_indexed = false;
+  }
+}
+
+// MS_ASYNC only schedules the write-back, so it never counts towards
+// durable_offset; an MS_SYNC starts from the last MS_SYNC, not the last
+// MS_ASYNC. Every range starts on a page boundary, which also covers the
+// segment header of a new segment.
+void MmapJournal::sync(Segment &segment, int flags) {
+  std::size_t &from =
+      flags & MS_SYNC ? segment.durable_offset : segment.scheduled_offset;
+  if (segment.write_offset <= from)
+    return;
+
+  static const std::size_t page_size =
+      static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  const std::size_t start = from & ~(page_size - 1);
+  if (msync(segment.base + start, segment.write_offset - start, flags) != 0) {
+    std::cerr << "Journal msync failed: " << std::strerror(errno) << std::endl;
+    return;
+  }
+  from = segment.write_offset;
+  segment.scheduled_offset =
+      std::max(segment.scheduled_offset, segment.durable_offset);
+}
+
+// Rolled segments can still hold bytes only ever synced with MS_ASYNC
+void MmapJournal::sync_all() {
+  for (auto &segment : segments_)
+    sync(*segment, MS_SYNC);
+}
+
+// Makes a newly created segment's directory entry survive a power loss
+void MmapJournal::sync_directory() {
+  if (fsync(directory_fd_) != 0)
+    std::cerr << "Journal directory fsync failed: " << std::strerror(errno)
+              << std::endl;
+}
+
+} // namespace quarcc
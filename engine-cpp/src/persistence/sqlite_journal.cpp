@@ -1,10 +1,14 @@
 #include <trading/persistence/sqlite_journal.h>
+#include <trading/persistence/sqlite_schema.h>
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 
 namespace quarcc {
 
-SQLiteJournal::SQLiteJournal(const std::string &db_path) {
+SQLiteJournal::SQLiteJournal(const std::string &db_path,
+                             JournalOptions options, const IClock &clock)
+    : options_(options), clock_(&clock) {
   int rc = sqlite3_open(db_path.c_str(), &db_);
   if (rc != SQLITE_OK) {
     std::string error = sqlite3_errmsg(db_);
@@ -12,79 +16,245 @@ SQLiteJournal::SQLiteJournal(const std::string &db_path) {
   }
   
   create_schema();
+  apply_pragmas();
+  prepare_statements();
+
+  if (options_.async) {
+    options_.max_batch = std::max<std::size_t>(1, options_.max_batch);
+    ring_.resize(std::max<std::size_t>(1, options_.queue_capacity));
+    writer_ = std::thread([this] { writer_loop(); });
+  }
 }
 
 SQLiteJournal::~SQLiteJournal() {
+  if (writer_.joinable()) {
+    {
+      std::lock_guard lock(queue_mutex_);
+      stopping_ = true;
+    }
+    queue_not_empty_.notify_one();
+    writer_.join();
+  }
+
   if (db_) {
     flush();
+    stmts_ = {}; // finalize before closing the connection
     sqlite3_close(db_);
   }
 }
 
-void SQLiteJournal::create_schema() {
-  const char *sql = R"(
+// Version 1: timestamps are INTEGER nanoseconds since the epoch (version 0
+// stored them as TEXT). Version 2: no UNIQUE(timestamp, correlation_id,
+// event_type); entries logged at the same instant, e.g. several fills of one
+// order under a simulated clock, are all kept and ordered by id.
+static constexpr int kJournalSchemaVersion = 2;
+
+static constexpr const char *kJournalTableSql = R"(
     CREATE TABLE IF NOT EXISTS journal (
       id INTEGER PRIMARY KEY AUTOINCREMENT,
-      timestamp TEXT NOT NULL,
+      timestamp INTEGER NOT NULL,
       event_type INTEGER NOT NULL,
       data TEXT NOT NULL,
-      correlation_id TEXT,
-      UNIQUE(timestamp, correlation_id, event_type)
+      correlation_id TEXT
     );
-    
+  )";
+
+static constexpr const char *kJournalIndexSql = R"(
     CREATE INDEX IF NOT EXISTS idx_timestamp ON journal(timestamp);
     CREATE INDEX IF NOT EXISTS idx_event_type ON journal(event_type);
     CREATE INDEX IF NOT EXISTS idx_correlation_id ON journal(correlation_id);
   )";
-  
-  char *err_msg = nullptr;
-  int rc = sqlite3_exec(db_, sql, nullptr, nullptr, &err_msg);
-  
-  if (rc != SQLITE_OK) {
-    std::string error = err_msg;
-    sqlite3_free(err_msg);
-    throw std::runtime_error("Failed to create journal schema: " + error);
+
+void SQLiteJournal::create_schema() {
+  const int version = schema_version(db_);
+  if (version < kJournalSchemaVersion && table_exists(db_, "journal")) {
+    migrate(version);
+  } else {
+    exec_or_throw(db_, kJournalTableSql, "Failed to create journal schema");
+    set_schema_version(db_, kJournalSchemaVersion);
   }
+  exec_or_throw(db_, kJournalIndexSql, "Failed to create journal schema");
+}
+
+// Rebuilds a table written by an older version in the current layout, keeping
+// ids. The version bump is part of the transaction, so an interrupted
+// migration is simply redone.
+void SQLiteJournal::migrate(int from_version) {
+  const bool text_timestamps = from_version == 0;
+  if (text_timestamps)
+    register_timestamp_functions(db_);
+
+  // The old indexes move with the renamed table and are dropped with it
+  const std::string sql =
+      std::string("BEGIN;"
+                  "ALTER TABLE journal RENAME TO journal_old;") +
+      kJournalTableSql +
+      "INSERT INTO journal"
+      "  (id, timestamp, event_type, data, correlation_id)"
+      "  SELECT id, " +
+      (text_timestamps ? "text_to_ns(timestamp)" : "timestamp") +
+      ", event_type, data, correlation_id"
+      "  FROM journal_old;"
+      "DROP TABLE journal_old;"
+      "PRAGMA user_version = " +
+      std::to_string(kJournalSchemaVersion) +
+      ";"
+      "COMMIT;";
+
+  try {
+    exec_or_throw(db_, sql, "Failed to migrate journal");
+  } catch (...) {
+    sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+    throw;
+  }
+}
+
+void SQLiteJournal::prepare_statements() {
+  stmts_.insert = SQLiteStatement(db_, R"(
+    INSERT INTO journal (timestamp, event_type, data, correlation_id) 
+    VALUES (?, ?, ?, ?)
+  )");
+  stmts_.history = SQLiteStatement(db_, R"(
+    SELECT id, timestamp, event_type, data, correlation_id 
+    FROM journal 
+    WHERE timestamp BETWEEN ? AND ?
+    ORDER BY id ASC
+  )");
+  stmts_.history_by_event = SQLiteStatement(db_, R"(
+    SELECT id, timestamp, event_type, data, correlation_id 
+    FROM journal 
+    WHERE timestamp BETWEEN ? AND ? AND event_type = ?
+    ORDER BY id ASC
+  )");
+  stmts_.order_history = SQLiteStatement(db_, R"(
+    SELECT id, timestamp, event_type, data, correlation_id 
+    FROM journal 
+    WHERE correlation_id = ?
+    ORDER BY id ASC
+  )");
+  stmts_.last_id =
+      SQLiteStatement(db_, "SELECT COALESCE(MAX(id), 0) FROM journal");
+}
+
+void SQLiteJournal::apply_pragmas() {
+  std::string sql = "PRAGMA synchronous = " +
+                    std::to_string(static_cast<int>(options_.sync)) + ";";
+  // WAL lets batched commits append instead of rewriting pages; flush()
+  // checkpoints it.
+  if (options_.async)
+    sql += "PRAGMA journal_mode = WAL;";
+
+  exec_or_throw(db_, sql, "Failed to configure journal");
 }
 
 void SQLiteJournal::log(Event event, 
                         const std::string &data,
                         const std::string &correlation_id) {
-  std::lock_guard lock(mutex_);
-  
-  const char *sql = R"(
-    INSERT INTO journal (timestamp, event_type, data, correlation_id) 
-    VALUES (?, ?, ?, ?)
-  )";
-  
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-  
-  if (rc != SQLITE_OK) {
-    std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+  PendingEntry entry{clock_->now(), event, data, correlation_id};
+
+  if (options_.async) {
+    std::unique_lock lock(queue_mutex_);
+    queue_not_full_.wait(lock, [this] { return ring_size_ < ring_.size(); });
+
+    ring_[(ring_head_ + ring_size_) % ring_.size()] = std::move(entry);
+    ++ring_size_;
+    ++enqueued_;
+
+    // The writer only needs waking when work appears or a batch is full
+    const bool wake_writer =
+        ring_size_ == 1 || ring_size_ == options_.max_batch;
+    lock.unlock();
+    if (wake_writer)
+      queue_not_empty_.notify_one();
     return;
   }
+
+  std::lock_guard lock(mutex_);
+  insert_entry(entry);
+}
+
+void SQLiteJournal::insert_entry(const PendingEntry &entry) {
+  auto stmt = stmts_.insert.use();
+  sqlite3_bind_int64(stmt, 1, LogEntry::to_nanos(entry.timestamp));
+  sqlite3_bind_int(stmt, 2, static_cast<int>(entry.event));
+  sqlite3_bind_text(stmt, 3, entry.data.c_str(), -1, SQLITE_TRANSIENT);
   
-  auto now = LogEntry::now();
-  std::string timestamp_str = LogEntry::timestamp_to_string(now);
-  
-  sqlite3_bind_text(stmt, 1, timestamp_str.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_int(stmt, 2, static_cast<int>(event));
-  sqlite3_bind_text(stmt, 3, data.c_str(), -1, SQLITE_TRANSIENT);
-  
-  if (!correlation_id.empty()) {
-    sqlite3_bind_text(stmt, 4, correlation_id.c_str(), -1, SQLITE_TRANSIENT);
+  if (!entry.correlation_id.empty()) {
+    sqlite3_bind_text(stmt, 4, entry.correlation_id.c_str(), -1,
+                      SQLITE_TRANSIENT);
   } else {
     sqlite3_bind_null(stmt, 4);
   }
   
   // Execute
-  rc = sqlite3_step(stmt);
+  int rc = sqlite3_step(stmt);
   if (rc != SQLITE_DONE) {
     std::cerr << "Failed to insert log: " << sqlite3_errmsg(db_) << std::endl;
   }
-  
-  sqlite3_finalize(stmt);
+}
+
+// Group commit: waits for the ring to fill up to max_batch (or for max_delay,
+// or for a flush() waiter), then commits everything taken in one transaction.
+void SQLiteJournal::writer_loop() {
+  std::vector<PendingEntry> batch;
+  batch.reserve(options_.max_batch);
+
+  std::unique_lock lock(queue_mutex_);
+  while (true) {
+    queue_not_empty_.wait(lock, [this] { return ring_size_ > 0 || stopping_; });
+    if (ring_size_ == 0)
+      return; // stopping and fully drained
+
+    const auto batch_ready = [this] {
+      return ring_size_ >= options_.max_batch || stopping_ ||
+             flush_target_ > committed_;
+    };
+    if (!batch_ready())
+      queue_not_empty_.wait_for(lock, options_.max_delay, batch_ready);
+
+    const std::size_t n = std::min(ring_size_, options_.max_batch);
+    for (std::size_t i = 0; i < n; ++i) {
+      batch.push_back(std::move(ring_[ring_head_]));
+      ring_head_ = (ring_head_ + 1) % ring_.size();
+    }
+    ring_size_ -= n;
+
+    lock.unlock();
+    queue_not_full_.notify_all();
+    commit_batch(batch);
+    batch.clear();
+    lock.lock();
+
+    committed_ += n;
+    batch_committed_.notify_all();
+  }
+}
+
+void SQLiteJournal::commit_batch(std::vector<PendingEntry> &batch) {
+  std::lock_guard lock(mutex_);
+
+  // A failing INSERT only aborts that statement, the rest of the batch still
+  // commits.
+  sqlite3_exec(db_, "BEGIN", nullptr, nullptr, nullptr);
+  for (const auto &entry : batch)
+    insert_entry(entry);
+  if (sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+    std::cerr << "Failed to commit journal batch: " << sqlite3_errmsg(db_)
+              << std::endl;
+    sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+  }
+}
+
+// Blocks until every entry enqueued before the call has been committed.
+void SQLiteJournal::wait_until_committed() {
+  std::unique_lock lock(queue_mutex_);
+  const std::uint64_t target = enqueued_;
+  if (committed_ >= target)
+    return;
+
+  flush_target_ = std::max(flush_target_, target);
+  queue_not_empty_.notify_one();
+  batch_committed_.wait(lock, [&] { return committed_ >= target; });
 }
 
 std::vector<LogEntry> SQLiteJournal::get_history(
@@ -92,89 +262,45 @@ std::vector<LogEntry> SQLiteJournal::get_history(
     Timestamp to,
     std::optional<Event> event_filter) {
   
+  // Readers see everything logged before the call
+  if (options_.async)
+    wait_until_committed();
+
   std::lock_guard lock(mutex_);
-  std::vector<LogEntry> entries;
-  
-  std::string sql = R"(
-    SELECT id, timestamp, event_type, data, correlation_id 
-    FROM journal 
-    WHERE timestamp BETWEEN ? AND ?
-  )";
-  
-  if (event_filter) {
-    sql += " AND event_type = ?";
-  }
-  
-  sql += " ORDER BY id ASC";
-  
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
-  
-  if (rc != SQLITE_OK) {
-    std::cerr << "Failed to prepare query: " << sqlite3_errmsg(db_) << std::endl;
-    return entries;
-  }
-  
-  std::string from_str = LogEntry::timestamp_to_string(from);
-  std::string to_str = LogEntry::timestamp_to_string(to);
+
+  auto stmt = event_filter ? stmts_.history_by_event.use()
+                           : stmts_.history.use();
   
-  sqlite3_bind_text(stmt, 1, from_str.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 2, to_str.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 1, LogEntry::to_nanos(from));
+  sqlite3_bind_int64(stmt, 2, LogEntry::to_nanos(to));
   
   if (event_filter) {
     sqlite3_bind_int(stmt, 3, static_cast<int>(*event_filter));
   }
   
-  // Fetch results
-  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-    LogEntry entry;
-    entry.id = sqlite3_column_int64(stmt, 0);
-    
-    const char *timestamp_str = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-    entry.timestamp = LogEntry::string_to_timestamp(timestamp_str);
-    
-    entry.event_type = static_cast<Event>(sqlite3_column_int(stmt, 2));
-    
-    const char *data_str = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-    entry.data = data_str ? data_str : "";
-    
-    const char *corr_id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
-    entry.correlation_id = corr_id ? corr_id : "";
-    
-    entries.push_back(std::move(entry));
-  }
-  
-  sqlite3_finalize(stmt);
-  return entries;
+  return read_entries(stmt);
 }
 
 std::vector<LogEntry> SQLiteJournal::get_order_history(const std::string &order_id) {
+  if (options_.async)
+    wait_until_committed();
+
   std::lock_guard lock(mutex_);
-  std::vector<LogEntry> entries;
-  
-  const char *sql = R"(
-    SELECT id, timestamp, event_type, data, correlation_id 
-    FROM journal 
-    WHERE correlation_id = ?
-    ORDER BY id ASC
-  )";
-  
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-  
-  if (rc != SQLITE_OK) {
-    std::cerr << "Failed to prepare query: " << sqlite3_errmsg(db_) << std::endl;
-    return entries;
-  }
-  
+
+  auto stmt = stmts_.order_history.use();
   sqlite3_bind_text(stmt, 1, order_id.c_str(), -1, SQLITE_TRANSIENT);
   
-  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+  return read_entries(stmt);
+}
+
+std::vector<LogEntry> SQLiteJournal::read_entries(sqlite3_stmt *stmt) {
+  std::vector<LogEntry> entries;
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
     LogEntry entry;
     entry.id = sqlite3_column_int64(stmt, 0);
     
-    const char *timestamp_str = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-    entry.timestamp = LogEntry::string_to_timestamp(timestamp_str);
+    entry.timestamp = LogEntry::from_nanos(sqlite3_column_int64(stmt, 1));
     
     entry.event_type = static_cast<Event>(sqlite3_column_int(stmt, 2));
     
@@ -187,11 +313,29 @@ std::vector<LogEntry> SQLiteJournal::get_order_history(const std::string &order_
     entries.push_back(std::move(entry));
   }
   
-  sqlite3_finalize(stmt);
   return entries;
 }
 
+void SQLiteJournal::barrier() {
+  if (options_.async)
+    wait_until_committed();
+}
+
+std::uint64_t SQLiteJournal::last_id() {
+  if (options_.async)
+    wait_until_committed();
+
+  std::lock_guard lock(mutex_);
+  auto stmt = stmts_.last_id.use();
+  if (sqlite3_step(stmt) != SQLITE_ROW)
+    return 0;
+  return static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 0));
+}
+
 void SQLiteJournal::flush() {
+  if (options_.async)
+    wait_until_committed();
+
   std::lock_guard lock(mutex_);
   sqlite3_wal_checkpoint(db_, nullptr);
 }
@@ -1,10 +1,13 @@
 #include <iostream>
 #include <stdexcept>
 #include <trading/persistence/sqlite_order_store.h>
+#include <trading/persistence/sqlite_schema.h>
 
 namespace quarcc {
 
-SQLiteOrderStore::SQLiteOrderStore(const std::string &db_path) {
+SQLiteOrderStore::SQLiteOrderStore(const std::string &db_path,
+                                   const IClock &clock)
+    : clock_(&clock) {
   int rc = sqlite3_open(db_path.c_str(), &db_);
   if (rc != SQLITE_OK) {
     std::string error = sqlite3_errmsg(db_);
@@ -12,73 +15,250 @@ SQLiteOrderStore::SQLiteOrderStore(const std::string &db_path) {
   }
 
   create_schema();
+  prepare_statements();
 }
 
 SQLiteOrderStore::~SQLiteOrderStore() {
   if (db_) {
+    stmts_ = {}; // finalize before closing the connection
     sqlite3_close(db_);
   }
 }
 
-void SQLiteOrderStore::create_schema() {
-  const char *sql = R"(
+// Version 1: created_at/updated_at are INTEGER nanoseconds since the epoch
+// (version 0 stored them as TEXT).
+// Version 2: quantities, prices and PnL are INTEGER fixed-point units (see
+// fixed_point.h); earlier versions stored them as REAL.
+static constexpr int kOrderStoreSchemaVersion = 2;
+
+static constexpr const char *kOrdersTableSql = R"(
     CREATE TABLE IF NOT EXISTS orders (
       local_id TEXT PRIMARY KEY,
       broker_id TEXT UNIQUE,
       symbol TEXT NOT NULL,
       side INTEGER NOT NULL,
-      quantity REAL NOT NULL,
-      price REAL,
+      quantity INTEGER NOT NULL,
+      price INTEGER,
       order_type INTEGER NOT NULL,
       status INTEGER NOT NULL,
       time_in_force INTEGER NOT NULL,
       account_id TEXT NOT NULL,
       strategy_id TEXT NOT NULL,
-      created_at TEXT NOT NULL,
-      updated_at TEXT,
-      filled_quantity REAL DEFAULT 0.0,
-      avg_fill_price REAL DEFAULT 0.0,
+      created_at INTEGER NOT NULL,
+      updated_at INTEGER,
+      filled_quantity INTEGER DEFAULT 0,
+      avg_fill_price INTEGER DEFAULT 0,
       order_proto BLOB NOT NULL
     );
-    
+  )";
+
+static constexpr const char *kOrdersIndexSql = R"(
     CREATE INDEX IF NOT EXISTS idx_status ON orders(status);
     CREATE INDEX IF NOT EXISTS idx_strategy ON orders(strategy_id);
     CREATE INDEX IF NOT EXISTS idx_broker_id ON orders(broker_id);
     CREATE INDEX IF NOT EXISTS idx_created_at ON orders(created_at);
   )";
 
-  char *err_msg = nullptr;
-  int rc = sqlite3_exec(db_, sql, nullptr, nullptr, &err_msg);
+static constexpr const char *kPositionSnapshotTableSql = R"(
+    CREATE TABLE IF NOT EXISTS position_snapshot (
+      symbol TEXT PRIMARY KEY,
+      quantity INTEGER NOT NULL,
+      avg_price INTEGER NOT NULL,
+      realized_pnl INTEGER NOT NULL DEFAULT 0
+    );
+  )";
 
-  if (rc != SQLITE_OK) {
-    std::string error = err_msg;
-    sqlite3_free(err_msg);
-    throw std::runtime_error("Failed to create order store schema: " + error);
+// Single-row meta table so an all-flat snapshot still records its time and
+// the last journal entry it includes
+static constexpr const char *kPositionSnapshotMetaSql = R"(
+    CREATE TABLE IF NOT EXISTS position_snapshot_meta (
+      id INTEGER PRIMARY KEY CHECK (id = 1),
+      taken_at INTEGER NOT NULL,
+      journal_id INTEGER
+    );
+  )";
+
+void SQLiteOrderStore::create_schema() {
+  const int version = schema_version(db_);
+  if (version < kOrderStoreSchemaVersion && table_exists(db_, "orders")) {
+    migrate(version);
+  } else {
+    exec_or_throw(db_, kOrdersTableSql,
+                  "Failed to create order store schema");
+    set_schema_version(db_, kOrderStoreSchemaVersion);
   }
+  exec_or_throw(db_, kOrdersIndexSql, "Failed to create order store schema");
+  exec_or_throw(db_, kPositionSnapshotTableSql,
+                "Failed to create order store schema");
+  exec_or_throw(db_, kPositionSnapshotMetaSql,
+                "Failed to create order store schema");
+  // Snapshots saved before journal ids were recorded keep a NULL one
+  if (!column_exists(db_, "position_snapshot_meta", "journal_id"))
+    exec_or_throw(db_,
+                  "ALTER TABLE position_snapshot_meta "
+                  "ADD COLUMN journal_id INTEGER;",
+                  "Failed to create order store schema");
 }
 
-Result<std::monostate>
-SQLiteOrderStore::store_order(const StoredOrder &stored_order) {
-  std::lock_guard lock(mutex_);
+// REAL column -> fixed-point units
+static std::string to_units(const char *column, std::int64_t scale) {
+  return std::string("CAST(ROUND(") + column + " * " + std::to_string(scale) +
+         ") AS INTEGER)";
+}
+
+// Rebuilds tables written by an older version in the current layout. The
+// version bump is part of the transaction, so an interrupted migration is
+// simply redone.
+void SQLiteOrderStore::migrate(int from_version) {
+  const bool text_timestamps = from_version == 0;
+  if (text_timestamps)
+    register_timestamp_functions(db_);
+  auto timestamp = [&](const char *column) {
+    return text_timestamps ? std::string("text_to_ns(") + column + ")"
+                           : std::string(column);
+  };
+
+  std::string sql =
+      std::string("BEGIN;"
+                  "ALTER TABLE orders RENAME TO orders_old;") +
+      kOrdersTableSql +
+      "INSERT INTO orders ("
+      "  local_id, broker_id, symbol, side, quantity, price, order_type,"
+      "  status, time_in_force, account_id, strategy_id, created_at,"
+      "  updated_at, filled_quantity, avg_fill_price, order_proto)"
+      "SELECT"
+      "  local_id, broker_id, symbol, side, " +
+      to_units("quantity", kQuantityScale) + ", " +
+      to_units("price", kPriceScale) +
+      ", order_type, status, time_in_force, account_id, strategy_id, " +
+      timestamp("created_at") + ", " + timestamp("updated_at") + ", " +
+      to_units("filled_quantity", kQuantityScale) + ", " +
+      to_units("avg_fill_price", kPriceScale) +
+      ", order_proto "
+      "FROM orders_old;"
+      "DROP TABLE orders_old;";
+
+  if (table_exists(db_, "position_snapshot")) {
+    // Snapshots written before PnL tracking have no realized_pnl
+    const std::string realized =
+        column_exists(db_, "position_snapshot", "realized_pnl")
+            ? to_units("realized_pnl", Money::scale)
+            : "0";
+    sql += std::string("ALTER TABLE position_snapshot RENAME TO "
+                       "position_snapshot_old;") +
+           kPositionSnapshotTableSql +
+           "INSERT INTO position_snapshot "
+           "  (symbol, quantity, avg_price, realized_pnl) "
+           "SELECT symbol, " +
+           to_units("quantity", kQuantityScale) + ", " +
+           to_units("avg_price", kPriceScale) + ", " + realized +
+           " FROM position_snapshot_old;"
+           "DROP TABLE position_snapshot_old;";
+  }
+
+  sql += "PRAGMA user_version = " + std::to_string(kOrderStoreSchemaVersion) +
+         ";"
+         "COMMIT;";
+
+  try {
+    exec_or_throw(db_, sql, "Failed to migrate order store");
+  } catch (...) {
+    sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+    throw;
+  }
+}
 
-  const char *sql = R"(
+void SQLiteOrderStore::prepare_statements() {
+  stmts_.insert = SQLiteStatement(db_, R"(
     INSERT INTO orders (
       local_id, broker_id, symbol, side, quantity, price, 
       order_type, status, time_in_force, account_id, strategy_id,
       created_at, filled_quantity, avg_fill_price, order_proto
     ) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
-  )";
-
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
+  )");
+  stmts_.update_status = SQLiteStatement(db_, R"(
+    UPDATE orders 
+    SET status = ?, updated_at = ?
+    WHERE local_id = ?
+  )");
+  stmts_.update_broker_id = SQLiteStatement(db_, R"(
+    UPDATE orders 
+    SET broker_id = ?, updated_at = ?
+    WHERE local_id = ?
+  )");
+  stmts_.update_fill_info = SQLiteStatement(db_, R"(
+    UPDATE orders 
+    SET filled_quantity = ?, avg_fill_price = ?, updated_at = ?
+    WHERE local_id = ?
+  )");
+  // SET expressions all see the pre-update row, so the average is weighted
+  // by the previous filled_quantity. Integer division rounded half up, the
+  // same as Money / Quantity for these non-negative values.
+  stmts_.apply_fill = SQLiteStatement(db_, R"(
+    UPDATE orders 
+    SET avg_fill_price = CASE WHEN filled_quantity + ?1 > 0
+          THEN (filled_quantity * avg_fill_price + ?1 * ?2
+                + (filled_quantity + ?1) / 2)
+               / (filled_quantity + ?1)
+          ELSE avg_fill_price END,
+        filled_quantity = filled_quantity + ?1,
+        status = ?3,
+        updated_at = ?5
+    WHERE local_id = ?4
+  )");
+  stmts_.begin = SQLiteStatement(db_, "BEGIN");
+  stmts_.commit = SQLiteStatement(db_, "COMMIT");
+  stmts_.rollback = SQLiteStatement(db_, "ROLLBACK");
+  stmts_.get_order = SQLiteStatement(db_, R"(
+    SELECT local_id, broker_id, status, created_at, updated_at, 
+           filled_quantity, avg_fill_price, order_proto
+    FROM orders 
+    WHERE local_id = ?
+  )");
+  stmts_.open_orders = SQLiteStatement(db_, R"(
+    SELECT local_id, broker_id, status, created_at, updated_at,
+           filled_quantity, avg_fill_price, order_proto
+    FROM orders 
+    WHERE status IN (?, ?, ?, ?)
+    ORDER BY created_at ASC
+  )");
+  stmts_.orders_by_status = SQLiteStatement(db_, R"(
+    SELECT local_id, broker_id, status, created_at, updated_at,
+           filled_quantity, avg_fill_price, order_proto
+    FROM orders 
+    WHERE status = ?
+    ORDER BY created_at ASC
+  )");
+  stmts_.clear_snapshot = SQLiteStatement(db_, "DELETE FROM position_snapshot");
+  stmts_.insert_snapshot_position = SQLiteStatement(db_, R"(
+    INSERT INTO position_snapshot (symbol, quantity, avg_price, realized_pnl)
+    VALUES (?, ?, ?, ?)
+  )");
+  stmts_.set_snapshot_time = SQLiteStatement(db_, R"(
+    INSERT OR REPLACE INTO position_snapshot_meta (id, taken_at, journal_id)
+    VALUES (1, ?, ?)
+  )");
+  stmts_.get_snapshot_time = SQLiteStatement(db_, R"(
+    SELECT taken_at, journal_id FROM position_snapshot_meta WHERE id = 1
+  )");
+  stmts_.get_snapshot_positions = SQLiteStatement(
+      db_, R"(
+    SELECT symbol, quantity, avg_price, realized_pnl FROM position_snapshot
+  )");
+}
 
-  if (rc != SQLITE_OK) {
-    return std::unexpected(Error{"Failed to prepare insert statement: " +
-                                     std::string(sqlite3_errmsg(db_)),
-                                 ErrorType::Error});
-  }
+Result<std::monostate>
+SQLiteOrderStore::store_order(const StoredOrder &stored_order) {
+  std::lock_guard lock(mutex_);
 
   const auto &order = stored_order.order;
+  const auto quantity = Quantity::checked_from_double(order.quantity());
+  const auto price = Price::checked_from_double(order.price());
+  if (!quantity || !price)
+    return std::unexpected(
+        Error{"Order quantity or price out of range", ErrorType::Error});
+
+  auto stmt = stmts_.insert.use();
 
   // Bind values
   sqlite3_bind_text(stmt, 1, stored_order.local_id.c_str(), -1,
@@ -93,26 +273,24 @@ SQLiteOrderStore::store_order(const StoredOrder &stored_order) {
 
   sqlite3_bind_text(stmt, 3, order.symbol().c_str(), -1, SQLITE_TRANSIENT);
   sqlite3_bind_int(stmt, 4, static_cast<int>(order.side()));
-  sqlite3_bind_double(stmt, 5, order.quantity());
-  sqlite3_bind_double(stmt, 6, order.price());
+  sqlite3_bind_int64(stmt, 5, quantity->raw());
+  sqlite3_bind_int64(stmt, 6, price->raw());
   sqlite3_bind_int(stmt, 7, static_cast<int>(order.type()));
   sqlite3_bind_int(stmt, 8, static_cast<int>(stored_order.status));
   sqlite3_bind_int(stmt, 9, static_cast<int>(order.time_in_force()));
   sqlite3_bind_text(stmt, 10, order.account_id().c_str(), -1, SQLITE_TRANSIENT);
   sqlite3_bind_text(stmt, 11, order.strategy_id().c_str(), -1,
                     SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 12, stored_order.created_at.c_str(), -1,
-                    SQLITE_TRANSIENT);
-  sqlite3_bind_double(stmt, 13, stored_order.filled_quantity);
-  sqlite3_bind_double(stmt, 14, stored_order.avg_fill_price);
+  sqlite3_bind_int64(stmt, 12, LogEntry::to_nanos(stored_order.created_at));
+  sqlite3_bind_int64(stmt, 13, stored_order.filled_quantity.raw());
+  sqlite3_bind_int64(stmt, 14, stored_order.avg_fill_price.raw());
 
   std::string serialized;
   order.SerializeToString(&serialized);
   sqlite3_bind_blob(stmt, 15, serialized.data(), serialized.size(),
                     SQLITE_TRANSIENT);
 
-  rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  int rc = sqlite3_step(stmt);
 
   if (rc != SQLITE_DONE) {
     return std::unexpected(
@@ -129,26 +307,13 @@ SQLiteOrderStore::update_order_status(const std::string &local_id,
 
   std::lock_guard lock(mutex_);
 
-  const char *sql = R"(
-    UPDATE orders 
-    SET status = ?, updated_at = datetime('now')
-    WHERE local_id = ?
-  )";
-
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-
-  if (rc != SQLITE_OK) {
-    return std::unexpected(Error{"Failed to prepare update statement: " +
-                                     std::string(sqlite3_errmsg(db_)),
-                                 ErrorType::Error});
-  }
+  auto stmt = stmts_.update_status.use();
 
   sqlite3_bind_int(stmt, 1, static_cast<int>(new_status));
-  sqlite3_bind_text(stmt, 2, local_id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 2, LogEntry::to_nanos(clock_->now()));
+  sqlite3_bind_text(stmt, 3, local_id.c_str(), -1, SQLITE_TRANSIENT);
 
-  rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  int rc = sqlite3_step(stmt);
 
   if (rc != SQLITE_DONE) {
     return std::unexpected(Error{"Failed to update order status: " +
@@ -165,26 +330,13 @@ SQLiteOrderStore::update_broker_id(const std::string &local_id,
 
   std::lock_guard lock(mutex_);
 
-  const char *sql = R"(
-    UPDATE orders 
-    SET broker_id = ?, updated_at = datetime('now')
-    WHERE local_id = ?
-  )";
-
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-
-  if (rc != SQLITE_OK) {
-    return std::unexpected(Error{"Failed to prepare update statement: " +
-                                     std::string(sqlite3_errmsg(db_)),
-                                 ErrorType::Error});
-  }
+  auto stmt = stmts_.update_broker_id.use();
 
   sqlite3_bind_text(stmt, 1, broker_id.c_str(), -1, SQLITE_TRANSIENT);
-  sqlite3_bind_text(stmt, 2, local_id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 2, LogEntry::to_nanos(clock_->now()));
+  sqlite3_bind_text(stmt, 3, local_id.c_str(), -1, SQLITE_TRANSIENT);
 
-  rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  int rc = sqlite3_step(stmt);
 
   if (rc != SQLITE_DONE) {
     return std::unexpected(
@@ -197,35 +349,82 @@ SQLiteOrderStore::update_broker_id(const std::string &local_id,
 
 Result<std::monostate>
 SQLiteOrderStore::update_fill_info(const std::string &local_id,
-                                   double filled_quantity, double avg_price) {
+                                   Quantity filled_quantity,
+                                   Price avg_price) {
 
   std::lock_guard lock(mutex_);
 
-  const char *sql = R"(
-    UPDATE orders 
-    SET filled_quantity = ?, avg_fill_price = ?, updated_at = datetime('now')
-    WHERE local_id = ?
-  )";
+  auto stmt = stmts_.update_fill_info.use();
 
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
+  sqlite3_bind_int64(stmt, 1, filled_quantity.raw());
+  sqlite3_bind_int64(stmt, 2, avg_price.raw());
+  sqlite3_bind_int64(stmt, 3, LogEntry::to_nanos(clock_->now()));
+  sqlite3_bind_text(stmt, 4, local_id.c_str(), -1, SQLITE_TRANSIENT);
 
-  if (rc != SQLITE_OK) {
-    return std::unexpected(Error{"Failed to prepare update statement: " +
+  int rc = sqlite3_step(stmt);
+
+  if (rc != SQLITE_DONE) {
+    return std::unexpected(
+        Error{"Failed to update fill info: " + std::string(sqlite3_errmsg(db_)),
+              ErrorType::Error});
+  }
+
+  return std::monostate{};
+}
+
+Result<std::monostate>
+SQLiteOrderStore::apply_fill(const std::string &local_id, Quantity delta_qty,
+                             Price price, OrderStatus new_status) {
+  std::lock_guard lock(mutex_);
+  return step_apply_fill({local_id, delta_qty, price, new_status});
+}
+
+Result<std::monostate>
+SQLiteOrderStore::apply_fills(const std::vector<FillUpdate> &updates) {
+  if (updates.empty())
+    return std::monostate{};
+
+  std::lock_guard lock(mutex_);
+
+  if (auto begin = stmts_.begin.use(); sqlite3_step(begin) != SQLITE_DONE) {
+    return std::unexpected(Error{"Failed to begin fill batch: " +
                                      std::string(sqlite3_errmsg(db_)),
                                  ErrorType::Error});
   }
 
-  sqlite3_bind_double(stmt, 1, filled_quantity);
-  sqlite3_bind_double(stmt, 2, avg_price);
-  sqlite3_bind_text(stmt, 3, local_id.c_str(), -1, SQLITE_TRANSIENT);
+  for (const auto &update : updates) {
+    if (auto r = step_apply_fill(update); !r) {
+      auto rollback = stmts_.rollback.use();
+      sqlite3_step(rollback);
+      return r;
+    }
+  }
 
-  rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  if (auto commit = stmts_.commit.use(); sqlite3_step(commit) != SQLITE_DONE) {
+    Error error{"Failed to commit fill batch: " +
+                    std::string(sqlite3_errmsg(db_)),
+                ErrorType::Error};
+    auto rollback = stmts_.rollback.use();
+    sqlite3_step(rollback);
+    return std::unexpected(std::move(error));
+  }
 
-  if (rc != SQLITE_DONE) {
+  return std::monostate{};
+}
+
+Result<std::monostate>
+SQLiteOrderStore::step_apply_fill(const FillUpdate &update) {
+  auto stmt = stmts_.apply_fill.use();
+
+  sqlite3_bind_int64(stmt, 1, update.delta_qty.raw());
+  sqlite3_bind_int64(stmt, 2, update.price.raw());
+  sqlite3_bind_int(stmt, 3, static_cast<int>(update.new_status));
+  sqlite3_bind_text(stmt, 4, update.local_id.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 5, LogEntry::to_nanos(clock_->now()));
+
+  if (sqlite3_step(stmt) != SQLITE_DONE) {
     return std::unexpected(
-        Error{"Failed to update fill info: " + std::string(sqlite3_errmsg(db_)),
+        Error{"Failed to apply fill: " + std::string(sqlite3_errmsg(db_)),
               ErrorType::Error});
   }
 
@@ -245,17 +444,14 @@ StoredOrder SQLiteOrderStore::parse_order(sqlite3_stmt *stmt) {
   }
 
   stored.status = static_cast<OrderStatus>(sqlite3_column_int(stmt, 2));
-  stored.created_at =
-      reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+  stored.created_at = LogEntry::from_nanos(sqlite3_column_int64(stmt, 3));
 
-  const char *updated_at =
-      reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4));
-  if (updated_at) {
-    stored.updated_at = updated_at;
+  if (sqlite3_column_type(stmt, 4) != SQLITE_NULL) {
+    stored.updated_at = LogEntry::from_nanos(sqlite3_column_int64(stmt, 4));
   }
 
-  stored.filled_quantity = sqlite3_column_double(stmt, 5);
-  stored.avg_fill_price = sqlite3_column_double(stmt, 6);
+  stored.filled_quantity = Quantity::from_raw(sqlite3_column_int64(stmt, 5));
+  stored.avg_fill_price = Price::from_raw(sqlite3_column_int64(stmt, 6));
 
   const void *blob = sqlite3_column_blob(stmt, 7);
   int size = sqlite3_column_bytes(stmt, 7);
@@ -267,33 +463,13 @@ StoredOrder SQLiteOrderStore::parse_order(sqlite3_stmt *stmt) {
 Result<StoredOrder> SQLiteOrderStore::get_order(const std::string &local_id) {
   std::lock_guard lock(mutex_);
 
-  const char *sql = R"(
-    SELECT local_id, broker_id, status, created_at, updated_at, 
-           filled_quantity, avg_fill_price, order_proto
-    FROM orders 
-    WHERE local_id = ?
-  )";
-
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-
-  if (rc != SQLITE_OK) {
-    return std::unexpected(Error{"Failed to prepare select statement: " +
-                                     std::string(sqlite3_errmsg(db_)),
-                                 ErrorType::Error});
-  }
+  auto stmt = stmts_.get_order.use();
 
   sqlite3_bind_text(stmt, 1, local_id.c_str(), -1, SQLITE_TRANSIENT);
 
-  rc = sqlite3_step(stmt);
+  if (sqlite3_step(stmt) == SQLITE_ROW)
+    return parse_order(stmt);
 
-  if (rc == SQLITE_ROW) {
-    StoredOrder order = parse_order(stmt);
-    sqlite3_finalize(stmt);
-    return order;
-  }
-
-  sqlite3_finalize(stmt);
   return std::unexpected(
       Error{"Order not found: " + local_id, ErrorType::Error});
 }
@@ -302,33 +478,17 @@ std::vector<StoredOrder> SQLiteOrderStore::get_open_orders() {
   std::lock_guard lock(mutex_);
   std::vector<StoredOrder> orders;
 
-  const char *sql = R"(
-    SELECT local_id, broker_id, status, created_at, updated_at,
-           filled_quantity, avg_fill_price, order_proto
-    FROM orders 
-    WHERE status IN (?, ?, ?, ?)
-    ORDER BY created_at ASC
-  )";
-
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-
-  if (rc != SQLITE_OK) {
-    std::cerr << "Failed to prepare query: " << sqlite3_errmsg(db_)
-              << std::endl;
-    return orders;
-  }
+  auto stmt = stmts_.open_orders.use();
 
   sqlite3_bind_int(stmt, 1, static_cast<int>(OrderStatus::PENDING_SUBMISSION));
   sqlite3_bind_int(stmt, 2, static_cast<int>(OrderStatus::SUBMITTED));
   sqlite3_bind_int(stmt, 3, static_cast<int>(OrderStatus::ACCEPTED));
   sqlite3_bind_int(stmt, 4, static_cast<int>(OrderStatus::PARTIALLY_FILLED));
 
-  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
     orders.push_back(parse_order(stmt));
   }
 
-  sqlite3_finalize(stmt);
   return orders;
 }
 
@@ -337,31 +497,92 @@ SQLiteOrderStore::get_orders_by_status(OrderStatus status) {
   std::lock_guard lock(mutex_);
   std::vector<StoredOrder> orders;
 
-  const char *sql = R"(
-    SELECT local_id, broker_id, status, created_at, updated_at,
-           filled_quantity, avg_fill_price, order_proto
-    FROM orders 
-    WHERE status = ?
-    ORDER BY created_at ASC
-  )";
-
-  sqlite3_stmt *stmt = nullptr;
-  int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-
-  if (rc != SQLITE_OK) {
-    std::cerr << "Failed to prepare query: " << sqlite3_errmsg(db_)
-              << std::endl;
-    return orders;
-  }
+  auto stmt = stmts_.orders_by_status.use();
 
   sqlite3_bind_int(stmt, 1, static_cast<int>(status));
 
-  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
     orders.push_back(parse_order(stmt));
   }
 
-  sqlite3_finalize(stmt);
   return orders;
 }
 
+Result<std::monostate>
+SQLiteOrderStore::save_position_snapshot(const PositionSnapshot &snapshot) {
+  std::lock_guard lock(mutex_);
+
+  auto fail = [this](const char *what) -> Result<std::monostate> {
+    Error error{std::string(what) + ": " + sqlite3_errmsg(db_),
+                ErrorType::Error};
+    auto rollback = stmts_.rollback.use();
+    sqlite3_step(rollback);
+    return std::unexpected(std::move(error));
+  };
+
+  if (auto begin = stmts_.begin.use(); sqlite3_step(begin) != SQLITE_DONE) {
+    return std::unexpected(Error{"Failed to begin position snapshot: " +
+                                     std::string(sqlite3_errmsg(db_)),
+                                 ErrorType::Error});
+  }
+
+  if (auto clear = stmts_.clear_snapshot.use();
+      sqlite3_step(clear) != SQLITE_DONE)
+    return fail("Failed to clear position snapshot");
+
+  for (const auto &position : snapshot.positions) {
+    auto stmt = stmts_.insert_snapshot_position.use();
+    sqlite3_bind_text(stmt, 1, position.symbol.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, position.quantity.raw());
+    sqlite3_bind_int64(stmt, 3, position.avg_price.raw());
+    sqlite3_bind_int64(stmt, 4, position.realized_pnl.raw());
+    if (sqlite3_step(stmt) != SQLITE_DONE)
+      return fail("Failed to store snapshot position");
+  }
+
+  {
+    auto stmt = stmts_.set_snapshot_time.use();
+    sqlite3_bind_int64(stmt, 1, LogEntry::to_nanos(snapshot.taken_at));
+    if (snapshot.journal_id)
+      sqlite3_bind_int64(stmt, 2,
+                         static_cast<sqlite3_int64>(*snapshot.journal_id));
+    else
+      sqlite3_bind_null(stmt, 2);
+    if (sqlite3_step(stmt) != SQLITE_DONE)
+      return fail("Failed to store snapshot time");
+  }
+
+  if (auto commit = stmts_.commit.use(); sqlite3_step(commit) != SQLITE_DONE)
+    return fail("Failed to commit position snapshot");
+
+  return std::monostate{};
+}
+
+Result<PositionSnapshot> SQLiteOrderStore::load_position_snapshot() {
+  std::lock_guard lock(mutex_);
+
+  PositionSnapshot snapshot;
+  {
+    auto stmt = stmts_.get_snapshot_time.use();
+    if (sqlite3_step(stmt) != SQLITE_ROW)
+      return std::unexpected(
+          Error{"No position snapshot stored", ErrorType::Error});
+    snapshot.taken_at = LogEntry::from_nanos(sqlite3_column_int64(stmt, 0));
+    if (sqlite3_column_type(stmt, 1) != SQLITE_NULL)
+      snapshot.journal_id =
+          static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 1));
+  }
+
+  auto stmt = stmts_.get_snapshot_positions.use();
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    snapshot.positions.push_back(
+        {reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)),
+         Quantity::from_raw(sqlite3_column_int64(stmt, 1)),
+         Price::from_raw(sqlite3_column_int64(stmt, 2)),
+         Money::from_raw(sqlite3_column_int64(stmt, 3))});
+  }
+
+  return snapshot;
+}
+
 } // namespace quarcc
@@ -0,0 +1,75 @@
+#include <trading/interfaces/i_journal.h>
+#include <trading/persistence/sqlite_schema.h>
+
+#include <stdexcept>
+
+namespace quarcc {
+
+int schema_version(sqlite3 *db) {
+  sqlite3_stmt *stmt = nullptr;
+  int version = 0;
+  if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, nullptr) ==
+          SQLITE_OK &&
+      sqlite3_step(stmt) == SQLITE_ROW)
+    version = sqlite3_column_int(stmt, 0);
+  sqlite3_finalize(stmt);
+  return version;
+}
+
+void set_schema_version(sqlite3 *db, int version) {
+  exec_or_throw(db, "PRAGMA user_version = " + std::to_string(version),
+                "Failed to set schema version");
+}
+
+bool table_exists(sqlite3 *db, const char *name) {
+  sqlite3_stmt *stmt = nullptr;
+  bool exists = false;
+  if (sqlite3_prepare_v2(
+          db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?",
+          -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    exists = sqlite3_step(stmt) == SQLITE_ROW;
+  }
+  sqlite3_finalize(stmt);
+  return exists;
+}
+
+bool column_exists(sqlite3 *db, const char *table, const char *column) {
+  sqlite3_stmt *stmt = nullptr;
+  bool exists = false;
+  if (sqlite3_prepare_v2(db, "SELECT 1 FROM pragma_table_info(?) WHERE name = ?",
+                         -1, &stmt, nullptr) == SQLITE_OK) {
+    sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, column, -1, SQLITE_STATIC);
+    exists = sqlite3_step(stmt) == SQLITE_ROW;
+  }
+  sqlite3_finalize(stmt);
+  return exists;
+}
+
+void exec_or_throw(sqlite3 *db, const std::string &sql, const char *what) {
+  char *err_msg = nullptr;
+  if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK) {
+    std::string error = err_msg ? err_msg : sqlite3_errmsg(db);
+    sqlite3_free(err_msg);
+    throw std::runtime_error(std::string(what) + ": " + error);
+  }
+}
+
+static void text_to_ns(sqlite3_context *ctx, int, sqlite3_value **argv) {
+  const auto *text = sqlite3_value_text(argv[0]);
+  if (!text) {
+    sqlite3_result_null(ctx);
+    return;
+  }
+  sqlite3_result_int64(ctx, LogEntry::to_nanos(LogEntry::string_to_timestamp(
+                                reinterpret_cast<const char *>(text))));
+}
+
+void register_timestamp_functions(sqlite3 *db) {
+  sqlite3_create_function(db, "text_to_ns", 1,
+                          SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr,
+                          &text_to_ns, nullptr, nullptr);
+}
+
+} // namespace quarcc
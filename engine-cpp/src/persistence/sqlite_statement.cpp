@@ -0,0 +1,34 @@
+#include <stdexcept>
+#include <string>
+#include <trading/persistence/sqlite_statement.h>
+#include <utility>
+
+namespace quarcc {
+
+SQLiteStatement::SQLiteStatement(sqlite3 *db, const char *sql) {
+  // Statements live as long as the connection: hint SQLite to keep them off
+  // the lookaside allocator.
+  int rc = sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt_,
+                              nullptr);
+  if (rc != SQLITE_OK) {
+    std::string error = sqlite3_errmsg(db);
+    sqlite3_finalize(stmt_);
+    stmt_ = nullptr;
+    throw std::runtime_error("Failed to prepare statement: " + error);
+  }
+}
+
+SQLiteStatement::~SQLiteStatement() { sqlite3_finalize(stmt_); }
+
+SQLiteStatement::SQLiteStatement(SQLiteStatement &&other) noexcept
+    : stmt_(std::exchange(other.stmt_, nullptr)) {}
+
+SQLiteStatement &SQLiteStatement::operator=(SQLiteStatement &&other) noexcept {
+  if (this != &other) {
+    sqlite3_finalize(stmt_);
+    stmt_ = std::exchange(other.stmt_, nullptr);
+  }
+  return *this;
+}
+
+} // namespace quarcc
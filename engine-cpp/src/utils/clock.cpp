@@ -0,0 +1,21 @@
+#include <trading/utils/clock.h>
+
+namespace quarcc {
+
+SystemClock &SystemClock::instance() {
+  static SystemClock clock;
+  return clock;
+}
+
+void SimulatedClock::set(WallTime t) {
+  const std::int64_t ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch())
+          .count();
+  std::int64_t current = ns_.load(std::memory_order_relaxed);
+  while (current < ns && !ns_.compare_exchange_weak(
+                             current, ns, std::memory_order_release,
+                             std::memory_order_relaxed)) {
+  }
+}
+
+} // namespace quarcc
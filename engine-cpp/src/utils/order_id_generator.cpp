@@ -0,0 +1,92 @@
+#include <trading/utils/order_id_generator.h>
+
+#include <stdexcept>
+
+namespace quarcc {
+
+static constexpr std::string_view kCrockford = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+
+// Value of a Crockford base32 digit, or -1
+static constexpr int crockford_digit(char c) {
+  if (c >= 'a' && c <= 'z')
+    c = static_cast<char>(c - 'a' + 'A');
+  switch (c) {
+  case 'O':
+    return 0;
+  case 'I':
+  case 'L':
+    return 1;
+  case 'U':
+    return -1;
+  default:
+    break;
+  }
+  const auto pos = kCrockford.find(c);
+  return pos == std::string_view::npos ? -1 : static_cast<int>(pos);
+}
+
+CompactOrderId::Text CompactOrderId::text() const {
+  Text out;
+  std::uint64_t v = value_;
+  for (auto it = out.rbegin(); it != out.rend(); ++it, v >>= 5)
+    *it = kCrockford[v & 31];
+  return out;
+}
+
+std::optional<CompactOrderId> CompactOrderId::parse(std::string_view text) {
+  // 13 digits hold 65 bits; the leading digit may only use its low 4
+  if (text.size() != kTextSize)
+    return std::nullopt;
+
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    const int digit = crockford_digit(text[i]);
+    if (digit < 0 || (i == 0 && digit > 15))
+      return std::nullopt;
+    value = value << 5 | static_cast<std::uint64_t>(digit);
+  }
+  return CompactOrderId{value};
+}
+
+OrderIdGenerator::OrderIdGenerator(std::uint32_t shard, const IClock &clock)
+    : shard_(shard), clock_(&clock) {
+  if (shard >= CompactOrderId::kMaxShards)
+    throw std::runtime_error("Order id shard out of range: " +
+                             std::to_string(shard));
+}
+
+CompactOrderId OrderIdGenerator::next() {
+  const auto now =
+      std::chrono::floor<std::chrono::milliseconds>(clock_->now());
+  const auto millis =
+      static_cast<std::uint64_t>((now - CompactOrderId::kEpoch).count());
+  const std::uint64_t fresh = CompactOrderId(millis, shard_, 0).value();
+
+  std::uint64_t last = last_.load(std::memory_order_relaxed);
+  for (;;) {
+    std::uint64_t candidate = fresh;
+    if (candidate <= last) {
+      const CompactOrderId prev{last};
+      candidate =
+          prev.sequence() < CompactOrderId::kMaxSequence
+              ? last + 1
+              : CompactOrderId(prev.millis() + 1, shard_, 0).value();
+    }
+    if (last_.compare_exchange_weak(last, candidate,
+                                    std::memory_order_relaxed))
+      return CompactOrderId{candidate};
+  }
+}
+
+void OrderIdGenerator::advance_past(CompactOrderId id) {
+  // A full sequence makes next() move on to the following millisecond
+  const std::uint64_t floor =
+      CompactOrderId(id.millis(), shard_, CompactOrderId::kMaxSequence)
+          .value();
+  std::uint64_t last = last_.load(std::memory_order_relaxed);
+  while (last < floor &&
+         !last_.compare_exchange_weak(last, floor, std::memory_order_relaxed)) {
+  }
+}
+
+} // namespace quarcc
@@ -0,0 +1,208 @@
+#include <trading/utils/order_id_mapper.h>
+
+#include <bit>
+#include <functional>
+
+namespace quarcc {
+
+namespace detail {
+
+static constexpr std::size_t kMinCapacity = 16;
+
+std::size_t FlatIdTable::locate(std::string_view key,
+                                std::uint64_t hash) const {
+  if (slots_.empty())
+    return kNotFound;
+
+  const std::size_t mask = slots_.size() - 1;
+  // Terminates because the load factor keeps at least one slot empty
+  for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+    const Slot &slot = slots_[i];
+    if (slot.hash == kEmpty)
+      return kNotFound;
+    if (slot.hash == hash && entries_[slot.entry].key == key)
+      return i;
+  }
+}
+
+const std::string *FlatIdTable::find(std::string_view key,
+                                     std::uint64_t hash) const {
+  const std::size_t i = locate(key, hash);
+  return i == kNotFound ? nullptr : &entries_[slots_[i].entry].value;
+}
+
+std::optional<std::string> FlatIdTable::insert_or_assign(std::string_view key,
+                                                         std::uint64_t hash,
+                                                         std::string_view value) {
+  if (const std::size_t i = locate(key, hash); i != kNotFound) {
+    std::string &stored = entries_[slots_[i].entry].value;
+    std::optional<std::string> previous = std::move(stored);
+    stored.assign(value);
+    return previous;
+  }
+
+  // Keep the table at most 3/4 full, counting erased slots. Grow only if
+  // live entries need it; otherwise rehashing just clears the erased ones.
+  if ((used_ + 1) * 4 > slots_.size() * 3)
+    rehash(std::max(kMinCapacity, std::bit_ceil((size_ + 1) * 2)));
+
+  std::uint32_t entry;
+  if (!free_entries_.empty()) {
+    entry = free_entries_.back();
+    free_entries_.pop_back();
+    entries_[entry].key.assign(key);
+    entries_[entry].value.assign(value);
+  } else {
+    entry = static_cast<std::uint32_t>(entries_.size());
+    entries_.push_back({std::string(key), std::string(value)});
+  }
+
+  const std::size_t mask = slots_.size() - 1;
+  std::size_t i = hash & mask;
+  while (slots_[i].hash > kErased)
+    i = (i + 1) & mask;
+  if (slots_[i].hash == kEmpty)
+    ++used_;
+  slots_[i] = {hash, entry};
+  ++size_;
+  return std::nullopt;
+}
+
+std::optional<std::string> FlatIdTable::erase(std::string_view key,
+                                              std::uint64_t hash) {
+  const std::size_t i = locate(key, hash);
+  if (i == kNotFound)
+    return std::nullopt;
+
+  Entry &entry = entries_[slots_[i].entry];
+  std::optional<std::string> value = std::move(entry.value);
+  entry.key.clear();
+  entry.value.clear();
+  free_entries_.push_back(slots_[i].entry);
+  slots_[i].hash = kErased;
+  --size_;
+  return value;
+}
+
+void FlatIdTable::rehash(std::size_t capacity) {
+  std::vector<Slot> old = std::exchange(slots_, std::vector<Slot>(capacity));
+  const std::size_t mask = capacity - 1;
+  for (const Slot &slot : old) {
+    if (slot.hash <= kErased)
+      continue;
+    std::size_t i = slot.hash & mask;
+    while (slots_[i].hash != kEmpty)
+      i = (i + 1) & mask;
+    slots_[i] = slot;
+  }
+  used_ = size_;
+}
+
+} // namespace detail
+
+std::uint64_t OrderIdMapper::Index::hash(std::string_view key) {
+  // Spread std::hash's output so both the shard (top bits) and the slot
+  // (bottom bits) are well mixed, then keep clear of the reserved values
+  std::uint64_t h = std::hash<std::string_view>{}(key);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h < 2 ? h + 2 : h;
+}
+
+std::size_t OrderIdMapper::Index::shard_of(std::uint64_t hash) {
+  static_assert(std::has_single_bit(kShards));
+  return hash >> (64 - std::countr_zero(kShards));
+}
+
+std::optional<std::string>
+OrderIdMapper::Index::get(std::string_view key) const {
+  const std::uint64_t h = hash(key);
+  const Shard &shard = shards_[shard_of(h)];
+  std::shared_lock lock(shard.mutex);
+  if (const std::string *value = shard.table.find(key, h))
+    return *value;
+  return std::nullopt;
+}
+
+std::optional<std::string> OrderIdMapper::Index::put(std::string_view key,
+                                                     std::string_view value) {
+  const std::uint64_t h = hash(key);
+  Shard &shard = shards_[shard_of(h)];
+  std::unique_lock lock(shard.mutex);
+  return shard.table.insert_or_assign(key, h, value);
+}
+
+std::optional<std::string>
+OrderIdMapper::Index::erase(std::string_view key) {
+  const std::uint64_t h = hash(key);
+  Shard &shard = shards_[shard_of(h)];
+  std::unique_lock lock(shard.mutex);
+  return shard.table.erase(key, h);
+}
+
+std::size_t OrderIdMapper::Index::size() const {
+  std::size_t total = 0;
+  for (const Shard &shard : shards_) {
+    std::shared_lock lock(shard.mutex);
+    total += shard.table.size();
+  }
+  return total;
+}
+
+void OrderIdMapper::add_mapping(std::string_view local,
+                                std::string_view broker) {
+  std::lock_guard lock(write_mutex_);
+  // Drop the reverse entries a remapping would leave behind
+  if (auto old_broker = by_local_.put(local, broker);
+      old_broker && *old_broker != broker)
+    by_broker_.erase(*old_broker);
+  if (auto old_local = by_broker_.put(broker, local);
+      old_local && *old_local != local)
+    by_local_.erase(*old_local);
+}
+
+std::optional<BrokerOrderId>
+OrderIdMapper::get_broker_id(std::string_view local) const {
+  return by_local_.get(local);
+}
+
+std::optional<LocalOrderId>
+OrderIdMapper::get_local_id(std::string_view broker) const {
+  return by_broker_.get(broker);
+}
+
+void OrderIdMapper::remove_mapping(std::string_view local) {
+  std::lock_guard lock(write_mutex_);
+  if (auto broker = by_local_.erase(local))
+    by_broker_.erase(*broker);
+}
+
+std::optional<BrokerOrderId>
+OrderIdMapper::retire_mapping(std::string_view local) {
+  std::lock_guard lock(write_mutex_);
+  return by_local_.erase(local);
+}
+
+void OrderIdMapper::remove_retired(std::string_view broker) {
+  std::lock_guard lock(write_mutex_);
+  auto local = by_broker_.get(broker);
+  if (local && by_local_.get(*local) != broker)
+    by_broker_.erase(broker);
+}
+
+std::size_t OrderIdMapper::size() const { return by_local_.size(); }
+
+std::vector<std::pair<LocalOrderId, BrokerOrderId>>
+OrderIdMapper::snapshot() const {
+  std::lock_guard lock(write_mutex_);
+  std::vector<std::pair<LocalOrderId, BrokerOrderId>> out;
+  out.reserve(by_local_.size());
+  by_local_.for_each([&out](const std::string &local,
+                            const std::string &broker) {
+    out.emplace_back(local, broker);
+  });
+  return out;
+}
+
+} // namespace quarcc
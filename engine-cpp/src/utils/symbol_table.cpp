@@ -0,0 +1,88 @@
+#include <trading/utils/symbol_table.h>
+
+#include <functional>
+
+namespace quarcc {
+
+static constexpr std::size_t kInitialIndexCapacity = 1024;
+
+static std::size_t hash_symbol(std::string_view symbol) {
+  return std::hash<std::string_view>{}(symbol);
+}
+
+SymbolTable &SymbolTable::global() {
+  static SymbolTable table;
+  return table;
+}
+
+SymbolTable::Index::Index(std::size_t capacity)
+    : mask(capacity - 1),
+      buckets(std::make_unique<std::atomic<const Entry *>[]>(capacity)) {}
+
+SymbolTable::SymbolTable() {
+  indexes_.push_back(std::make_unique<Index>(kInitialIndexCapacity));
+  index_.store(indexes_.back().get(), std::memory_order_release);
+}
+
+SymbolTable::~SymbolTable() = default;
+
+SymbolId SymbolTable::intern(std::string_view symbol) {
+  if (const Entry *entry = lookup(symbol))
+    return entry->id;
+
+  std::lock_guard lock(write_mutex_);
+  // Another thread may have interned it while we waited
+  if (const Entry *entry = lookup(symbol))
+    return entry->id;
+
+  const auto id = static_cast<SymbolId>(entries_.size());
+  // The entry is fully initialised before it becomes reachable
+  const Entry *entry =
+      entries_.emplace_back(std::make_unique<Entry>(std::string(symbol), id))
+          .get();
+  names_.set(id, entry);
+
+  Index *index = index_.load(std::memory_order_relaxed);
+  if (entries_.size() * 2 > index->mask + 1) {
+    auto grown = std::make_unique<Index>((index->mask + 1) * 2);
+    for (const auto &existing : entries_)
+      insert(*grown, existing.get());
+    index_.store(grown.get(), std::memory_order_release);
+    indexes_.push_back(std::move(grown));
+  } else {
+    insert(*index, entry);
+  }
+
+  return id;
+}
+
+std::optional<SymbolId> SymbolTable::find(std::string_view symbol) const {
+  if (const Entry *entry = lookup(symbol))
+    return entry->id;
+  return std::nullopt;
+}
+
+const std::string &SymbolTable::name(SymbolId id) const {
+  return names_.get(id)->name;
+}
+
+std::size_t SymbolTable::size() const { return names_.end(); }
+
+const SymbolTable::Entry *SymbolTable::lookup(std::string_view symbol) const {
+  const Index *index = index_.load(std::memory_order_acquire);
+  for (std::size_t i = hash_symbol(symbol) & index->mask;;
+       i = (i + 1) & index->mask) {
+    const Entry *entry = index->buckets[i].load(std::memory_order_acquire);
+    if (!entry || entry->name == symbol)
+      return entry;
+  }
+}
+
+void SymbolTable::insert(Index &index, const Entry *entry) {
+  std::size_t i = hash_symbol(entry->name) & index.mask;
+  while (index.buckets[i].load(std::memory_order_relaxed))
+    i = (i + 1) & index.mask;
+  index.buckets[i].store(entry, std::memory_order_release);
+}
+
+} // namespace quarcc
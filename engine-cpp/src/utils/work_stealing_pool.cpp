@@ -0,0 +1,122 @@
+#include <trading/utils/work_stealing_pool.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace quarcc {
+
+namespace {
+// The pool and queue of the worker running on this thread, if any
+thread_local const WorkStealingPool *current_pool = nullptr;
+thread_local std::size_t current_queue = 0;
+} // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  queues_.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i)
+    queues_.push_back(std::make_unique<Queue>());
+  threads_.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i)
+    threads_.emplace_back([this, i] { run(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard lock(wake_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto &thread : threads_)
+    thread.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+  const std::size_t index =
+      current_pool == this
+          ? current_queue
+          : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                queues_.size();
+  {
+    std::lock_guard lock(done_mutex_);
+    ++unfinished_;
+  }
+  {
+    // Counted before it is visible, so a worker that takes it never sees
+    // queued_ go negative, and under wake_mutex_ so none misses the wakeup
+    std::lock_guard lock(wake_mutex_);
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard queue_lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  wake_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+  std::unique_lock lock(done_mutex_);
+  done_.wait(lock, [this] { return unfinished_ == 0; });
+  if (auto error = std::exchange(error_, nullptr))
+    std::rethrow_exception(error);
+}
+
+// Own deque from the back, then the others' from the front, starting with
+// the next worker along so thieves spread out
+bool WorkStealingPool::take(std::size_t index, Task &task) {
+  {
+    Queue &own = *queues_[index];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  for (std::size_t i = 1; i < queues_.size(); ++i) {
+    Queue &victim = *queues_[(index + i) % queues_.size()];
+    std::lock_guard lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::run(std::size_t index) {
+  current_pool = this;
+  current_queue = index;
+
+  Task task;
+  for (;;) {
+    if (!take(index, task)) {
+      std::unique_lock lock(wake_mutex_);
+      wake_.wait(lock, [this] {
+        return stopping_ || queued_.load(std::memory_order_relaxed) > 0;
+      });
+      if (stopping_ && queued_.load(std::memory_order_relaxed) == 0)
+        return;
+      continue;
+    }
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+
+    std::exception_ptr error;
+    try {
+      task();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    task = nullptr;
+
+    std::lock_guard lock(done_mutex_);
+    if (error && !error_)
+      error_ = error;
+    if (--unfinished_ == 0)
+      done_.notify_all();
+  }
+}
+
+} // namespace quarcc
@@ -45,7 +45,8 @@ inline StoredOrder make_stored_order(
   stored.order = make_order(local_id, symbol, side, qty);
   stored.status = status;
   stored.broker_id = broker_id;
-  stored.created_at = "2024-01-01 00:00:00.000";
+  stored.created_at =
+      LogEntry::string_to_timestamp("2024-01-01 00:00:00.000");
   return stored;
 }
 
@@ -15,6 +15,7 @@ public:
               (const BrokerOrderId &orderId, const v1::Order &new_order),
               (override));
   MOCK_METHOD(std::vector<v1::ExecutionReport>, get_fills, (), (override));
+  MOCK_METHOD(bool, set_fill_listener, (FillListener listener), (override));
 };
 
 } // namespace quarcc
@@ -17,6 +17,8 @@ public:
   MOCK_METHOD(std::vector<LogEntry>, get_order_history,
               (const std::string &order_id), (override));
   MOCK_METHOD(void, flush, (), (override));
+  MOCK_METHOD(void, barrier, (), (override));
+  MOCK_METHOD(std::uint64_t, last_id, (), (override));
 };
 
 } // namespace quarcc
@@ -16,14 +16,24 @@ public:
               (const std::string &local_id, const std::string &broker_id),
               (override));
   MOCK_METHOD(Result<std::monostate>, update_fill_info,
-              (const std::string &local_id, double filled_quantity,
-               double avg_price),
+              (const std::string &local_id, Quantity filled_quantity,
+               Price avg_price),
               (override));
+  MOCK_METHOD(Result<std::monostate>, apply_fill,
+              (const std::string &local_id, Quantity delta_qty, Price price,
+               OrderStatus new_status),
+              (override));
+  MOCK_METHOD(Result<std::monostate>, apply_fills,
+              (const std::vector<FillUpdate> &updates), (override));
   MOCK_METHOD(Result<StoredOrder>, get_order, (const std::string &local_id),
               (override));
   MOCK_METHOD(std::vector<StoredOrder>, get_open_orders, (), (override));
   MOCK_METHOD(std::vector<StoredOrder>, get_orders_by_status,
               (OrderStatus status), (override));
+  MOCK_METHOD(Result<std::monostate>, save_position_snapshot,
+              (const PositionSnapshot &snapshot), (override));
+  MOCK_METHOD(Result<PositionSnapshot>, load_position_snapshot, (),
+              (override));
 };
 
 } // namespace quarcc
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <trading/core/aggregate_position_book.h>
+#include <trading/core/position_keeper.h>
+
+#include <thread>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+
+struct AggregateBookFixture : public testing::Test {
+  SymbolTable symbols;
+  MarkPriceCache marks;
+  AggregatePositionBook book{&marks, symbols};
+  PositionKeeper alpha{&book, &marks, symbols};
+  PositionKeeper beta{&book, &marks, symbols};
+
+  SymbolId id(const std::string &sym) { return symbols.intern(sym); }
+};
+
+TEST_F(AggregateBookFixture, SumsQuantitiesAndWeightsAveragePrice) {
+  alpha.on_fill(id("AAPL"), 10_qty, 100_px, v1::Side::BUY);
+  beta.on_fill(id("AAPL"), 30_qty, 200_px, v1::Side::BUY);
+
+  auto pos = book.get(id("AAPL"));
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_EQ(pos->symbol(), "AAPL");
+  EXPECT_DOUBLE_EQ(pos->quantity(), 40.0);
+  EXPECT_DOUBLE_EQ(pos->avg_price(), 175.0);
+}
+
+TEST_F(AggregateBookFixture, TracksEachStrategysLatestPosition) {
+  alpha.on_fill(id("AAPL"), 10_qty, 100_px, v1::Side::BUY);
+  beta.on_fill(id("AAPL"), 10_qty, 120_px, v1::Side::SELL);
+
+  // Offsetting strategies: flat overall
+  auto pos = book.get(id("AAPL"));
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), 0.0);
+  EXPECT_DOUBLE_EQ(pos->avg_price(), 0.0);
+
+  // Alpha closes out; only beta's short remains, at its own cost basis
+  alpha.on_fill(id("AAPL"), 10_qty, 130_px, v1::Side::SELL);
+  pos = book.get(id("AAPL"));
+  EXPECT_DOUBLE_EQ(pos->quantity(), -10.0);
+  EXPECT_DOUBLE_EQ(pos->avg_price(), 120.0);
+}
+
+TEST_F(AggregateBookFixture, RestoredPositionsAreIncluded) {
+  alpha.restore_position(id("MSFT"), 5_qty, 300_px);
+  alpha.restore_position(id("MSFT"), 8_qty, 310_px);
+
+  auto pos = book.get(id("MSFT"));
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), 8.0);
+  EXPECT_DOUBLE_EQ(pos->avg_price(), 310.0);
+}
+
+TEST_F(AggregateBookFixture, UnknownSymbolIsNotFound) {
+  EXPECT_FALSE(book.get(id("TSLA")).has_value());
+}
+
+TEST_F(AggregateBookFixture, WorkingQuantityIsSummedApartFromPositions) {
+  alpha.add_working(id("AAPL"), v1::Side::BUY, 10_qty);
+  beta.add_working(id("AAPL"), v1::Side::BUY, 5_qty);
+  beta.add_working(id("AAPL"), v1::Side::SELL, 3_qty);
+  alpha.add_working(id("AAPL"), v1::Side::BUY, -4_qty);
+
+  EXPECT_EQ(alpha.working(id("AAPL")).buy, 6_qty);
+  EXPECT_EQ(book.working(id("AAPL")).buy, 11_qty);
+  EXPECT_EQ(book.working(id("AAPL")).sell, 3_qty);
+  EXPECT_EQ(book.working(id("AAPL")).toward(v1::Side::SELL), -3_qty);
+  // Nothing has filled, so there is still no position
+  EXPECT_FALSE(book.get(id("AAPL")).has_value());
+  EXPECT_EQ(book.version(), 0u);
+}
+
+TEST_F(AggregateBookFixture, SnapshotIsSharedUntilTheNextChange) {
+  alpha.on_fill(id("AAPL"), 1_qty, 100_px, v1::Side::BUY);
+  beta.on_fill(id("MSFT"), 2_qty, 200_px, v1::Side::BUY);
+
+  auto first = book.snapshot();
+  EXPECT_EQ(first->version, book.version());
+  EXPECT_EQ(first->positions.positions_size(), 2);
+  EXPECT_EQ(book.snapshot(), first);
+
+  beta.on_fill(id("MSFT"), 2_qty, 200_px, v1::Side::BUY);
+  auto second = book.snapshot();
+  EXPECT_NE(second, first);
+  EXPECT_GT(second->version, first->version);
+  EXPECT_DOUBLE_EQ(second->positions.positions(1).quantity(), 4.0);
+  // The earlier snapshot is immutable
+  EXPECT_DOUBLE_EQ(first->positions.positions(1).quantity(), 2.0);
+}
+
+TEST_F(AggregateBookFixture, ConcurrentStrategiesSumCorrectly) {
+  const SymbolId aapl = id("AAPL");
+  auto run = [&](PositionKeeper &keeper) {
+    for (int i = 0; i < 10'000; ++i)
+      keeper.on_fill(aapl, 1_qty, 100_px, v1::Side::BUY);
+  };
+
+  std::atomic<bool> done{false};
+  std::thread reader([&] {
+    while (!done.load(std::memory_order_acquire)) {
+      auto snapshot = book.snapshot();
+      for (const auto &pos : snapshot->positions.positions())
+        EXPECT_TRUE(pos.quantity() == 0.0 || pos.avg_price() == 100.0);
+    }
+  });
+
+  std::thread a([&] { run(alpha); });
+  std::thread b([&] { run(beta); });
+  a.join();
+  b.join();
+  done.store(true, std::memory_order_release);
+  reader.join();
+
+  EXPECT_DOUBLE_EQ(book.get(aapl)->quantity(), 20'000.0);
+}
+
+TEST_F(AggregateBookFixture, FirmPnlTracksFillsAndMarks) {
+  marks.update(id("MSFT"), 300_px); // marked before anyone holds it
+
+  alpha.on_fill(id("AAPL"), 10_qty, 100_px, v1::Side::BUY);
+  beta.on_fill(id("MSFT"), 5_qty, 290_px, v1::Side::BUY);
+  EXPECT_EQ(book.pnl().unrealized, 50_money); // AAPL has no mark yet
+
+  marks.update(id("AAPL"), 103_px);
+  EXPECT_EQ(book.pnl().unrealized, 80_money);
+
+  alpha.on_fill(id("AAPL"), 4_qty, 105_px, v1::Side::SELL);
+  auto pnl = book.pnl();
+  EXPECT_EQ(pnl.realized, 20_money);
+  EXPECT_EQ(pnl.unrealized, 68_money); // 6 AAPL * 3 + 5 MSFT * 10
+
+  auto aapl = book.get(id("AAPL"));
+  ASSERT_TRUE(aapl.has_value());
+  EXPECT_DOUBLE_EQ(aapl->realized_pnl(), 20.0);
+  EXPECT_DOUBLE_EQ(aapl->unrealized_pnl(), 18.0);
+
+  // Totals agree with the per-symbol values
+  auto snapshot = book.snapshot();
+  double realized = 0.0, unrealized = 0.0;
+  for (const auto &pos : snapshot->positions.positions()) {
+    realized += pos.realized_pnl();
+    unrealized += pos.unrealized_pnl();
+  }
+  EXPECT_DOUBLE_EQ(snapshot->pnl.realized.to_double(), realized);
+  EXPECT_DOUBLE_EQ(snapshot->pnl.unrealized.to_double(), unrealized);
+}
+
+TEST_F(AggregateBookFixture, OffsettingStrategiesKeepTheirOwnCostBasis) {
+  marks.update(id("AAPL"), 110_px);
+  alpha.on_fill(id("AAPL"), 10_qty, 100_px, v1::Side::BUY);  // +100
+  beta.on_fill(id("AAPL"), 10_qty, 120_px, v1::Side::SELL); // +100
+
+  EXPECT_EQ(book.pnl().unrealized, 200_money);
+  EXPECT_DOUBLE_EQ(book.get(id("AAPL"))->unrealized_pnl(), 200.0);
+}
+
+} // namespace quarcc
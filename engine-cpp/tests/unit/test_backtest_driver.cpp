@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <trading/backtest/backtest_driver.h>
+#include <trading/persistence/sqlite_journal.h>
+#include <trading/persistence/sqlite_order_store.h>
+
+#include "helpers/proto_builders.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+using namespace std::chrono_literals;
+using test::make_signal;
+
+constexpr std::int64_t kOpen = 1704205800000000000; // 2024-01-02T14:30:00Z
+
+// Buys 10 when flat and sells once the mid is 0.10 above the entry price
+struct TakeProfit {
+  std::vector<LocalOrderId> *ids;
+
+  void operator()(BacktestDriver &driver, const TickRecord &tick,
+                  SymbolId symbol) const {
+    if (tick.kind != TickKind::Quote)
+      return;
+    const double mid = (tick.bid().to_double() + tick.ask().to_double()) / 2;
+    const auto position = driver.positions().getPosition(symbol);
+    const bool flat = !position || position->quantity() == 0;
+    if (!flat && mid < position->avg_price() + 0.10 - 1e-9)
+      return;
+
+    auto id = driver.submit(make_signal("BACKTEST", "BT",
+                                        flat ? v1::BUY : v1::SELL, 10));
+    ASSERT_TRUE(id) << id.error().message_;
+    ids->push_back(*id);
+  }
+};
+
+struct BacktestDriverTest : public testing::Test {
+  std::filesystem::path path;
+
+  void SetUp() override {
+    const auto *info = testing::UnitTest::GetInstance()->current_test_info();
+    path = std::filesystem::path(testing::TempDir()) /
+           (std::string("backtest_") + info->name() + ".bin");
+
+    // A quote a millisecond around these mids, a penny either side
+    const double mids[] = {100.00, 100.05, 100.10, 100.15, 100.05,
+                           99.95,  100.00, 100.10, 100.20};
+    TickFileWriter writer;
+    std::int64_t t = kOpen;
+    for (double mid : mids) {
+      writer.add_quote(t, "BT", Price::from_double(mid - 0.01), 100_qty,
+                       Price::from_double(mid + 0.01), 100_qty);
+      t += 1'000'000;
+    }
+    writer.write(path);
+  }
+
+  void TearDown() override { std::filesystem::remove(path); }
+
+  struct Run {
+    std::vector<LocalOrderId> ids;
+    std::vector<LogEntry> journal;
+    BacktestStats stats;
+    Money pnl;
+    IClock::WallTime end;
+  };
+
+  Run run() {
+    Run result;
+    SymbolTable symbols;
+    SimulatedClock clock;
+    auto journal = std::make_unique<SQLiteJournal>(":memory:",
+                                                   JournalOptions{}, clock);
+    IJournal *journal_view = journal.get();
+    BacktestDriver driver{std::make_shared<const TickFile>(path),
+                          clock,
+                          std::move(journal),
+                          std::make_unique<SQLiteOrderStore>(":memory:", clock),
+                          TakeProfit{&result.ids},
+                          {},
+                          symbols};
+    result.stats = driver.run();
+    result.pnl = driver.pnl();
+    result.end = driver.now();
+    result.journal = journal_view->get_history(IClock::WallTime{},
+                                               IClock::WallTime::max());
+    return result;
+  }
+};
+
+TEST_F(BacktestDriverTest, TradesAtReplayedPricesOnSimulatedTime) {
+  const auto result = run();
+
+  EXPECT_EQ(result.stats.ticks, 9u);
+  EXPECT_EQ(result.stats.orders, 4u);
+  EXPECT_EQ(result.stats.rejected, 0u);
+  EXPECT_EQ(result.stats.fills, 4u);
+  // In at 100.01, out at 100.14; in at 100.06, out at 100.19
+  EXPECT_EQ(result.pnl, 2.6_money);
+
+  // Everything is stamped with replayed time, not the wall clock
+  const IClock::WallTime open{std::chrono::nanoseconds{kOpen}};
+  EXPECT_EQ(result.end, open + 8ms);
+  ASSERT_FALSE(result.journal.empty());
+  for (const auto &entry : result.journal) {
+    EXPECT_GE(entry.timestamp, open);
+    EXPECT_LE(entry.timestamp, result.end);
+  }
+  for (const auto &id : result.ids) {
+    const auto parsed = CompactOrderId::parse(id);
+    ASSERT_TRUE(parsed);
+    const auto issued =
+        CompactOrderId::kEpoch + std::chrono::milliseconds{parsed->millis()};
+    EXPECT_GE(issued, open);
+    EXPECT_LE(issued, result.end);
+  }
+}
+
+TEST_F(BacktestDriverTest, RunsAreIdentical) {
+  const auto first = run();
+  const auto second = run();
+
+  EXPECT_EQ(first.ids, second.ids);
+  EXPECT_EQ(first.pnl, second.pnl);
+  ASSERT_EQ(first.journal.size(), second.journal.size());
+  for (std::size_t i = 0; i < first.journal.size(); ++i) {
+    EXPECT_EQ(first.journal[i].timestamp, second.journal[i].timestamp);
+    EXPECT_EQ(first.journal[i].event_type, second.journal[i].event_type);
+    EXPECT_EQ(first.journal[i].data, second.journal[i].data);
+  }
+}
+
+} // namespace quarcc
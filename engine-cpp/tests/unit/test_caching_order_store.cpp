@@ -0,0 +1,152 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <trading/persistence/caching_order_store.h>
+
+#include "helpers/proto_builders.h"
+#include "mocks/mock_order_store.h"
+
+using namespace testing;
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+
+struct CachingOrderStoreFixture : public Test {
+  MockOrderStore *backing{};
+  std::unique_ptr<CachingOrderStore> store;
+
+  // Builds the cache over a backing store that reports `open` at warm-load
+  void make_store(std::vector<StoredOrder> open = {}) {
+    auto owned = std::make_unique<NiceMock<MockOrderStore>>();
+    backing = owned.get();
+    ON_CALL(*backing, get_open_orders()).WillByDefault(Return(open));
+    ON_CALL(*backing, store_order(_)).WillByDefault(Return(std::monostate{}));
+    ON_CALL(*backing, update_order_status(_, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*backing, update_broker_id(_, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*backing, update_fill_info(_, _, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*backing, apply_fill(_, _, _, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*backing, apply_fills(_)).WillByDefault(Return(std::monostate{}));
+    store = std::make_unique<CachingOrderStore>(std::move(owned));
+  }
+
+  void SetUp() override { make_store(); }
+};
+
+TEST_F(CachingOrderStoreFixture, WarmLoadsOpenOrdersFromBacking) {
+  make_store({test::make_stored_order("L1"), test::make_stored_order("L2")});
+  EXPECT_EQ(store->cached_count(), 2u);
+
+  EXPECT_CALL(*backing, get_order(_)).Times(0);
+  auto fetched = store->get_order("L2");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->local_id, "L2");
+}
+
+TEST_F(CachingOrderStoreFixture, OpenOrderReadsDoNotTouchBacking) {
+  store->store_order(test::make_stored_order("L1", "AAPL", v1::Side::BUY, 10.0,
+                                             OrderStatus::PENDING_SUBMISSION));
+
+  EXPECT_CALL(*backing, get_order(_)).Times(0);
+  EXPECT_CALL(*backing, get_open_orders()).Times(0);
+
+  auto fetched = store->get_order("L1");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_DOUBLE_EQ(fetched->order.quantity(), 10.0);
+  EXPECT_EQ(store->get_open_orders().size(), 1u);
+}
+
+TEST_F(CachingOrderStoreFixture, WritesGoThroughAndUpdateCachedCopy) {
+  store->store_order(test::make_stored_order("L1"));
+
+  EXPECT_CALL(*backing, update_broker_id("L1", "B1"));
+  EXPECT_CALL(*backing, update_fill_info("L1", 4_qty, 101.5_px));
+  EXPECT_CALL(*backing, update_order_status("L1", OrderStatus::PARTIALLY_FILLED));
+
+  store->update_broker_id("L1", "B1");
+  store->update_fill_info("L1", 4_qty, 101.5_px);
+  store->update_order_status("L1", OrderStatus::PARTIALLY_FILLED);
+
+  auto fetched = store->get_order("L1");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->broker_id, "B1");
+  EXPECT_EQ(fetched->filled_quantity, 4_qty);
+  EXPECT_EQ(fetched->avg_fill_price, 101.5_px);
+  EXPECT_EQ(fetched->status, OrderStatus::PARTIALLY_FILLED);
+  EXPECT_TRUE(fetched->updated_at.has_value());
+}
+
+TEST_F(CachingOrderStoreFixture, ApplyFillsUpdatesCachedCopyAndEvictsFilled) {
+  store->store_order(test::make_stored_order("L1"));
+  store->store_order(test::make_stored_order("L2"));
+
+  std::vector<FillUpdate> updates{
+      {"L1", 4_qty, 100_px, OrderStatus::PARTIALLY_FILLED},
+      {"L1", 2_qty, 106_px, OrderStatus::PARTIALLY_FILLED},
+      {"L2", 10_qty, 50_px, OrderStatus::FILLED},
+  };
+  EXPECT_CALL(*backing, apply_fills(SizeIs(3)))
+      .WillOnce(Return(std::monostate{}));
+  ASSERT_TRUE(store->apply_fills(updates));
+
+  EXPECT_EQ(store->cached_count(), 1u);
+  auto l1 = store->get_order("L1");
+  ASSERT_TRUE(l1.has_value());
+  EXPECT_EQ(l1->filled_quantity, 6_qty);
+  EXPECT_EQ(l1->avg_fill_price, 102_px);
+  EXPECT_EQ(l1->status, OrderStatus::PARTIALLY_FILLED);
+}
+
+TEST_F(CachingOrderStoreFixture, TerminalStatusEvictsAndReadsFallThrough) {
+  store->store_order(test::make_stored_order("L1"));
+  store->update_order_status("L1", OrderStatus::FILLED);
+  EXPECT_EQ(store->cached_count(), 0u);
+
+  EXPECT_CALL(*backing, get_order("L1"))
+      .WillOnce(Return(test::make_stored_order(
+          "L1", "AAPL", v1::Side::BUY, 10.0, OrderStatus::FILLED)));
+  auto fetched = store->get_order("L1");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->status, OrderStatus::FILLED);
+}
+
+TEST_F(CachingOrderStoreFixture, FailedBackingWriteLeavesCacheUntouched) {
+  store->store_order(test::make_stored_order("L1"));
+
+  EXPECT_CALL(*backing, update_order_status("L1", OrderStatus::CANCELLED))
+      .WillOnce(Return(std::unexpected(Error{"disk full", ErrorType::Error})));
+  EXPECT_FALSE(store->update_order_status("L1", OrderStatus::CANCELLED));
+  EXPECT_EQ(store->cached_count(), 1u);
+
+  EXPECT_CALL(*backing, store_order(_))
+      .WillOnce(Return(std::unexpected(Error{"disk full", ErrorType::Error})));
+  EXPECT_FALSE(store->store_order(test::make_stored_order("L2")));
+  EXPECT_EQ(store->cached_count(), 1u);
+}
+
+TEST_F(CachingOrderStoreFixture, GetOrdersByStatusServesOpenStatusesFromCache) {
+  auto older = test::make_stored_order("L_OLD");
+  older.created_at = LogEntry::string_to_timestamp("2024-01-01 00:00:00");
+  auto newer = test::make_stored_order("L_NEW");
+  newer.created_at = LogEntry::string_to_timestamp("2024-01-02 00:00:00");
+  store->store_order(newer);
+  store->store_order(older);
+  store->store_order(test::make_stored_order("L_ACK", "AAPL", v1::Side::BUY,
+                                             10.0, OrderStatus::ACCEPTED));
+
+  EXPECT_CALL(*backing, get_orders_by_status(OrderStatus::SUBMITTED)).Times(0);
+  auto submitted = store->get_orders_by_status(OrderStatus::SUBMITTED);
+  ASSERT_EQ(submitted.size(), 2u);
+  EXPECT_EQ(submitted[0].local_id, "L_OLD");
+  EXPECT_EQ(submitted[1].local_id, "L_NEW");
+
+  EXPECT_CALL(*backing, get_orders_by_status(OrderStatus::CANCELLED))
+      .WillOnce(Return(std::vector<StoredOrder>{}));
+  EXPECT_TRUE(store->get_orders_by_status(OrderStatus::CANCELLED).empty());
+}
+
+} // namespace quarcc
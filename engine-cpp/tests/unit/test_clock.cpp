@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+#include <trading/utils/clock.h>
+
+namespace quarcc {
+
+using namespace std::chrono_literals;
+
+TEST(SimulatedClockTest, MovesOnlyWhenTold) {
+  const IClock::WallTime start{1704205800s};
+  SimulatedClock clock{start};
+  EXPECT_EQ(clock.now(), start);
+  EXPECT_EQ(clock.now(), clock.now());
+
+  clock.advance(1500ms);
+  EXPECT_EQ(clock.now(), start + 1500ms);
+  clock.set(start + 2s);
+  EXPECT_EQ(clock.now(), start + 2s);
+}
+
+TEST(SimulatedClockTest, NeverGoesBackwards) {
+  SimulatedClock clock{IClock::WallTime{10s}};
+  clock.set(IClock::WallTime{5s});
+  EXPECT_EQ(clock.now(), IClock::WallTime{10s});
+}
+
+TEST(SimulatedClockTest, SteadyTimeKeepsPaceWithWallTime) {
+  SimulatedClock clock{IClock::WallTime{10s}};
+  const auto steady = clock.steady_now();
+  clock.advance(250ms);
+  EXPECT_EQ(clock.steady_now() - steady, 250ms);
+}
+
+} // namespace quarcc
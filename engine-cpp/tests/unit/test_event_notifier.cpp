@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <trading/utils/event_notifier.h>
+
+#include <thread>
+
+namespace quarcc {
+
+using namespace std::chrono_literals;
+
+TEST(EventNotifier, WaitForTimesOutWithoutNotification) {
+  EventNotifier notifier;
+  EXPECT_FALSE(notifier.wait_for(1ms));
+}
+
+TEST(EventNotifier, NotifyBeforeWaitIsNotLost) {
+  EventNotifier notifier;
+  notifier.notify();
+  EXPECT_TRUE(notifier.wait_for(0ms));
+}
+
+TEST(EventNotifier, NotificationsCoalesceIntoOneWakeup) {
+  EventNotifier notifier;
+  notifier.notify();
+  notifier.notify();
+  EXPECT_TRUE(notifier.wait_for(0ms));
+  EXPECT_FALSE(notifier.wait_for(0ms));
+}
+
+TEST(EventNotifier, NotifyFromAnotherThreadWakesWaiter) {
+  EventNotifier notifier;
+  std::thread producer([&] {
+    std::this_thread::sleep_for(5ms);
+    notifier.notify();
+  });
+  EXPECT_TRUE(notifier.wait_for(5s));
+  producer.join();
+}
+
+} // namespace quarcc
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <trading/utils/fixed_point.h>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+
+TEST(FixedPoint, LiteralsAndDoublesAgree) {
+  EXPECT_EQ((150.25_px).raw(), 1'502'500);
+  EXPECT_EQ(Price::from_double(150.25), 150.25_px);
+  EXPECT_EQ(Quantity::from_double(0.1 + 0.2), 0.3_qty);
+  EXPECT_EQ(Quantity::from_double(-2.5), -2.5_qty);
+  EXPECT_DOUBLE_EQ((101.5_px).to_double(), 101.5);
+}
+
+TEST(FixedPoint, RepeatedAdditionIsExact) {
+  Quantity total;
+  for (int i = 0; i < 1000; ++i)
+    total += 0.1_qty;
+  EXPECT_EQ(total, 100_qty);
+
+  for (int i = 0; i < 1000; ++i)
+    total -= 0.1_qty;
+  EXPECT_TRUE(total.is_zero());
+}
+
+TEST(FixedPoint, PriceTimesQuantityIsExactMoney) {
+  EXPECT_EQ(3_qty * 0.01_px, 0.03_money);
+  EXPECT_EQ(0.0001_qty * 0.0001_px, Money::from_raw(1));
+  EXPECT_EQ(-10_qty * 150.25_px, -1502.5_money);
+}
+
+TEST(FixedPoint, CheckedArithmeticReportsOverflow) {
+  static_assert(checked_mul(3_qty, 0.01_px) == 0.03_money);
+  EXPECT_FALSE(checked_mul(Quantity::max(), 2_px));
+  EXPECT_FALSE(checked_mul(-Quantity::max(), 2_px));
+  EXPECT_EQ(checked_add(1_qty, 2_qty), 3_qty);
+  EXPECT_FALSE(checked_add(Quantity::max(), Quantity::from_raw(1)));
+  EXPECT_FALSE(checked_add(Quantity::from_raw(INT64_MIN), -1_qty));
+}
+
+TEST(FixedPoint, MoneyOverQuantityRoundsHalfAwayFromZero) {
+  // 1 / 3 and 2 / 3 of a price unit
+  EXPECT_EQ(Money::from_raw(10'000) / 3_qty, Price::from_raw(0));
+  EXPECT_EQ(Money::from_raw(20'000) / 3_qty, Price::from_raw(1));
+  EXPECT_EQ(Money::from_raw(-20'000) / 3_qty, Price::from_raw(-1));
+  EXPECT_EQ(-1000_money / -10_qty, 100_px);
+}
+
+TEST(FixedPoint, ToStringIsExact) {
+  EXPECT_EQ((150.25_px).to_string(), "150.25");
+  EXPECT_EQ((10_qty).to_string(), "10");
+  EXPECT_EQ((-0.0001_qty).to_string(), "-0.0001");
+  EXPECT_EQ(Price{}.to_string(), "0");
+  EXPECT_EQ((1.5_money).to_string(), "1.5");
+}
+
+TEST(FixedPoint, FromStringIsTheExactInverseOfToString) {
+  for (const auto value : {150.25_px, Price{}, -0.0001_px, Price::max(),
+                           Price::from_raw(std::numeric_limits<
+                                           Price::rep>::min())})
+    EXPECT_EQ(Price::from_string(value.to_string()), value);
+  // Not representable exactly as a double
+  EXPECT_EQ(Quantity::from_string("900719925474.0993"),
+            Quantity::from_raw(9'007'199'254'740'993));
+  EXPECT_EQ(Quantity::from_string("2.50"), 2.5_qty);
+
+  for (const char *bad : {"", "-", ".5", "1.", "1.00001", "1e3", " 1", "1x",
+                          "922337203685477.5808"})
+    EXPECT_FALSE(Price::from_string(bad)) << bad;
+}
+
+TEST(FixedPoint, ComparesByValue) {
+  EXPECT_LT(-1_qty, 0_qty);
+  EXPECT_GT(100.0001_px, 100_px);
+  EXPECT_EQ(abs(-3_qty), 3_qty);
+}
+
+} // namespace quarcc
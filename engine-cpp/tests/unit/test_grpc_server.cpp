@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <trading/grpc/grpc_server.h>
+
+#include "helpers/proto_builders.h"
+
+#include <grpcpp/grpcpp.h>
+
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace quarcc {
+
+namespace {
+
+// Completes async calls only when the test says so, from the test's thread,
+// the way a strategy worker completes them from its own
+struct ParkingHandler : IExecutionServiceHandler {
+  std::promise<Completion<BrokerOrderId>> submitted;
+  std::promise<Completion<std::monostate>> kill_switch;
+
+  Result<BrokerOrderId> SubmitSignal(const v1::StrategySignal &) override {
+    return std::unexpected(Error{"blocking call", ErrorType::Error});
+  }
+  Result<std::monostate> CancelOrder(const v1::CancelSignal &) override {
+    return std::unexpected(Error{"blocking call", ErrorType::Error});
+  }
+  Result<BrokerOrderId> ReplaceOrder(const v1::ReplaceSignal &) override {
+    return std::unexpected(Error{"blocking call", ErrorType::Error});
+  }
+  Result<v1::Position> GetPosition(const v1::GetPositionRequest &) override {
+    return std::unexpected(Error{"no position", ErrorType::Error});
+  }
+  Result<v1::PositionList> GetAllPositions(const v1::Empty &) override {
+    return v1::PositionList{};
+  }
+  Result<std::monostate>
+  ActivateKillSwitch(const v1::KillSwitchRequest &) override {
+    ADD_FAILURE() << "the server must not block a poller on the kill switch";
+    return std::monostate{};
+  }
+
+  void SubmitSignalAsync(const v1::StrategySignal &,
+                         Completion<BrokerOrderId> done) override {
+    submitted.set_value(std::move(done));
+  }
+  void ActivateKillSwitchAsync(const v1::KillSwitchRequest &,
+                               Completion<std::monostate> done) override {
+    kill_switch.set_value(std::move(done));
+  }
+};
+
+} // namespace
+
+struct GrpcServerFixture : public testing::Test {
+  ParkingHandler handler;
+  // One poller, so a call that held it would stall every other call
+  gRPCServer server{"127.0.0.1:0", handler,
+                    {.num_cqs = 1,
+                     .pollers_per_cq = 1,
+                     .max_concurrent_streams = 0}};
+  std::unique_ptr<v1::ExecutionService::Stub> stub;
+
+  void SetUp() override {
+    server.start();
+    ASSERT_GT(server.port(), 0);
+    stub = v1::ExecutionService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(server.port()),
+                            grpc::InsecureChannelCredentials()));
+  }
+
+  static void set_deadline(grpc::ClientContext &ctx) {
+    ctx.set_deadline(std::chrono::system_clock::now() +
+                     std::chrono::seconds{5});
+  }
+};
+
+TEST_F(GrpcServerFixture, SubmitIsAnsweredWhenTheHandlerCompletes) {
+  auto reply = std::async(std::launch::async, [&] {
+    grpc::ClientContext ctx;
+    set_deadline(ctx);
+    v1::SubmitSignalResponse response;
+    auto status = stub->SubmitSignal(&ctx, test::make_signal(), &response);
+    return std::pair{status, response};
+  });
+
+  auto done = handler.submitted.get_future().get();
+  EXPECT_EQ(server.method_stats(RpcMethod::SubmitSignal).in_flight, 1);
+  done(BrokerOrderId{"B1"});
+
+  auto [status, response] = reply.get();
+  ASSERT_TRUE(status.ok()) << status.error_message();
+  EXPECT_TRUE(response.accepted());
+  EXPECT_EQ(response.order_id(), "B1");
+  const auto stats = server.method_stats(RpcMethod::SubmitSignal);
+  EXPECT_EQ(stats.completed, 1u);
+  EXPECT_EQ(stats.in_flight, 0);
+}
+
+TEST_F(GrpcServerFixture, RejectedSubmitCarriesTheReason) {
+  auto reply = std::async(std::launch::async, [&] {
+    grpc::ClientContext ctx;
+    set_deadline(ctx);
+    v1::SubmitSignalResponse response;
+    return stub->SubmitSignal(&ctx, test::make_signal(), &response);
+  });
+
+  handler.submitted.get_future().get()(
+      std::unexpected(Error{"slow down", ErrorType::Throttled}));
+
+  auto status = reply.get();
+  EXPECT_EQ(status.error_code(), grpc::RESOURCE_EXHAUSTED);
+  EXPECT_EQ(status.error_message(), "slow down");
+}
+
+TEST_F(GrpcServerFixture, KillSwitchLeavesThePollerFree) {
+  auto reply = std::async(std::launch::async, [&] {
+    grpc::ClientContext ctx;
+    set_deadline(ctx);
+    v1::Empty response;
+    return stub->ActivateKillSwitch(&ctx, v1::KillSwitchRequest{}, &response);
+  });
+  auto done = handler.kill_switch.get_future().get();
+
+  // Still cancelling, yet the only poller answers other calls
+  grpc::ClientContext ctx;
+  set_deadline(ctx);
+  v1::PositionList positions;
+  EXPECT_TRUE(stub->GetAllPositions(&ctx, v1::Empty{}, &positions).ok());
+
+  done(std::monostate{});
+  EXPECT_TRUE(reply.get().ok());
+}
+
+TEST_F(GrpcServerFixture, ShutdownWaitsForCallsStillBeingHandled) {
+  auto reply = std::async(std::launch::async, [&] {
+    grpc::ClientContext ctx;
+    set_deadline(ctx);
+    v1::SubmitSignalResponse response;
+    return stub->SubmitSignal(&ctx, test::make_signal(), &response);
+  });
+  auto done = handler.submitted.get_future().get();
+
+  auto stopped = std::async(std::launch::async, [&] { server.shutdown(); });
+  EXPECT_EQ(stopped.wait_for(std::chrono::milliseconds{100}),
+            std::future_status::timeout);
+
+  // A worker finishing after shutdown began still has a queue to finish on
+  done(BrokerOrderId{"B1"});
+  EXPECT_EQ(stopped.wait_for(std::chrono::seconds{5}),
+            std::future_status::ready);
+  reply.get();
+  EXPECT_EQ(server.method_stats(RpcMethod::SubmitSignal).in_flight, 0);
+}
+
+TEST_F(GrpcServerFixture, ShutdownClosesOpenSignalStreams) {
+  grpc::ClientContext ctx;
+  auto stream = stub->StreamSignals(&ctx);
+
+  // An idle stream is cancelled once the shutdown grace period runs out
+  server.shutdown();
+  v1::SubmitSignalResponse response;
+  EXPECT_FALSE(stream->Read(&response));
+  EXPECT_EQ(server.method_stats(RpcMethod::StreamSignals).in_flight, 0);
+}
+
+} // namespace quarcc
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <trading/core/mark_price_cache.h>
+
+#include <vector>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+
+TEST(MarkPriceCache, UnmarkedSymbolHasNoPrice) {
+  MarkPriceCache marks;
+  EXPECT_FALSE(marks.get(0).has_value());
+}
+
+TEST(MarkPriceCache, UpdateReplacesTheLastPrice) {
+  MarkPriceCache marks;
+  marks.update(3, 100_px);
+  marks.update(3, 101.5_px);
+  marks.update(2000, 7_px); // ids beyond the first chunk
+
+  EXPECT_EQ(marks.get(3), 101.5_px);
+  EXPECT_EQ(marks.get(2000), 7_px);
+  EXPECT_FALSE(marks.get(4).has_value());
+}
+
+TEST(MarkPriceCache, ListenerSeesEveryTickInOrder) {
+  MarkPriceCache marks;
+  std::vector<std::pair<SymbolId, Price>> ticks;
+  marks.set_listener([&](SymbolId symbol, Price price) {
+    // The new price is already visible
+    EXPECT_EQ(marks.get(symbol), price);
+    ticks.emplace_back(symbol, price);
+  });
+
+  marks.update(1, 10_px);
+  marks.update(2, 20_px);
+  marks.update(1, 11_px);
+
+  ASSERT_EQ(ticks.size(), 3u);
+  EXPECT_EQ(ticks[2], (std::pair<SymbolId, Price>{1, 11_px}));
+}
+
+} // namespace quarcc
@@ -0,0 +1,78 @@
+// Tests for MemoryJournal on a simulated clock.
+
+#include <gtest/gtest.h>
+#include <trading/persistence/journal_factory.h>
+#include <trading/persistence/memory_journal.h>
+
+#include <chrono>
+
+namespace quarcc {
+
+using namespace std::chrono_literals;
+
+struct MemoryJournalFixture : public testing::Test {
+  SimulatedClock clock{IClock::WallTime{} + 24h};
+  MemoryJournal journal{clock};
+};
+
+TEST_F(MemoryJournalFixture, LogAndRetrieveEntries) {
+  journal.log(Event::ORDER_CREATED, "created", "ORD_A");
+  clock.advance(1ms);
+  journal.log(Event::SYSTEM_STARTED, "no correlation id");
+
+  auto entries = journal.get_history(IClock::WallTime{}, clock.now());
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].id, 1u);
+  EXPECT_EQ(entries[0].timestamp, clock.now() - 1ms);
+  EXPECT_EQ(entries[0].event_type, Event::ORDER_CREATED);
+  EXPECT_EQ(entries[0].data, "created");
+  EXPECT_EQ(entries[0].correlation_id, "ORD_A");
+  EXPECT_EQ(entries[1].id, 2u);
+  EXPECT_EQ(entries[1].timestamp, clock.now());
+  EXPECT_EQ(journal.size(), 2u);
+}
+
+TEST_F(MemoryJournalFixture, GetHistoryIsBoundedAndFiltered) {
+  const auto start = clock.now();
+  for (int i = 0; i < 10; ++i) {
+    journal.log(i % 2 ? Event::ORDER_FILLED : Event::ORDER_CREATED,
+                std::to_string(i));
+    clock.advance(1s);
+  }
+
+  auto window = journal.get_history(start + 2s, start + 5s);
+  ASSERT_EQ(window.size(), 4u);
+  EXPECT_EQ(window.front().data, "2");
+  EXPECT_EQ(window.back().data, "5");
+
+  auto fills = journal.get_history(start + 2s, start + 5s, Event::ORDER_FILLED);
+  ASSERT_EQ(fills.size(), 2u);
+  EXPECT_EQ(fills[0].data, "3");
+  EXPECT_EQ(fills[1].data, "5");
+
+  EXPECT_TRUE(journal.get_history(start + 1h, start + 2h).empty());
+}
+
+TEST_F(MemoryJournalFixture, GetOrderHistoryFiltersByCorrelationId) {
+  journal.log(Event::ORDER_CREATED, "created", "ORD_X");
+  journal.log(Event::ORDER_CREATED, "other order", "ORD_Y");
+  journal.log(Event::ORDER_SUBMITTED, "submitted", "ORD_X");
+
+  auto entries = journal.get_order_history("ORD_X");
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].event_type, Event::ORDER_CREATED);
+  EXPECT_EQ(entries[1].event_type, Event::ORDER_SUBMITTED);
+  EXPECT_TRUE(journal.get_order_history("NO_SUCH_ORDER").empty());
+}
+
+TEST(MemoryJournalFactory, MakeJournalIgnoresThePath) {
+  JournalConfig config;
+  config.backend = JournalBackend::Memory;
+  auto journal = make_journal("/nonexistent/dir/journal", config);
+  journal->log(Event::SYSTEM_STARTED, "up");
+  EXPECT_EQ(journal->get_history(LogEntry::now() - 1h, LogEntry::now() + 1h)
+                .size(),
+            1u);
+}
+
+} // namespace quarcc
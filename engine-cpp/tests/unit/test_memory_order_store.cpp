@@ -0,0 +1,118 @@
+// Tests for MemoryOrderStore, checked against SQLiteOrderStore behaviour.
+
+#include <gtest/gtest.h>
+#include <trading/persistence/memory_order_store.h>
+#include <trading/persistence/sqlite_order_store.h>
+
+#include "helpers/proto_builders.h"
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+using namespace std::chrono_literals;
+
+struct MemoryOrderStoreFixture : public testing::Test {
+  SimulatedClock clock{IClock::WallTime{} + 24h};
+  MemoryOrderStore store{clock};
+};
+
+TEST_F(MemoryOrderStoreFixture, StoreAndRetrieveOrder) {
+  ASSERT_TRUE(store.store_order(test::make_stored_order("L1", "MSFT")));
+
+  auto fetched = store.get_order("L1");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->order.symbol(), "MSFT");
+  EXPECT_EQ(fetched->status, OrderStatus::SUBMITTED);
+  EXPECT_FALSE(fetched->updated_at.has_value());
+
+  EXPECT_FALSE(store.get_order("NOPE").has_value());
+}
+
+TEST_F(MemoryOrderStoreFixture, StoringALocalIdTwiceFails) {
+  ASSERT_TRUE(store.store_order(test::make_stored_order("L1")));
+  EXPECT_FALSE(store.store_order(test::make_stored_order("L1")));
+  EXPECT_EQ(store.get_all_orders().size(), 1u);
+}
+
+TEST_F(MemoryOrderStoreFixture, UpdatesStampFromTheClock) {
+  store.store_order(test::make_stored_order("L1"));
+  clock.advance(5s);
+
+  store.update_broker_id("L1", "B1");
+  store.update_order_status("L1", OrderStatus::ACCEPTED);
+
+  auto fetched = store.get_order("L1");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->broker_id, "B1");
+  EXPECT_EQ(fetched->status, OrderStatus::ACCEPTED);
+  EXPECT_EQ(fetched->updated_at, clock.now());
+
+  // Like an UPDATE matching no rows
+  EXPECT_TRUE(store.update_order_status("NOPE", OrderStatus::FILLED));
+  EXPECT_TRUE(store.apply_fill("NOPE", 1_qty, 1_px, OrderStatus::FILLED));
+}
+
+TEST_F(MemoryOrderStoreFixture, FillsWeightPricesLikeSQLiteOrderStore) {
+  SQLiteOrderStore sqlite{":memory:", clock};
+  const std::vector<FillUpdate> fills = {
+      {"L1", 3_qty, 100.01_px, OrderStatus::PARTIALLY_FILLED},
+      {"L2", 10_qty, 50_px, OrderStatus::FILLED},
+      {"L1", 4_qty, 100.02_px, OrderStatus::PARTIALLY_FILLED},
+      {"L1", 2_qty, 99.97_px, OrderStatus::FILLED},
+  };
+
+  for (IOrderStore *s : {static_cast<IOrderStore *>(&store),
+                         static_cast<IOrderStore *>(&sqlite)}) {
+    s->store_order(test::make_stored_order("L1"));
+    s->store_order(test::make_stored_order("L2"));
+    ASSERT_TRUE(s->apply_fill(fills[0].local_id, fills[0].delta_qty,
+                              fills[0].price, fills[0].new_status));
+    ASSERT_TRUE(s->apply_fills({fills.begin() + 1, fills.end()}));
+  }
+
+  for (const char *id : {"L1", "L2"}) {
+    auto memory = store.get_order(id);
+    auto stored = sqlite.get_order(id);
+    ASSERT_TRUE(memory.has_value());
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(memory->filled_quantity, stored->filled_quantity) << id;
+    EXPECT_EQ(memory->avg_fill_price, stored->avg_fill_price) << id;
+    EXPECT_EQ(memory->status, stored->status) << id;
+  }
+}
+
+TEST_F(MemoryOrderStoreFixture, ListsInCreationThenStorageOrder) {
+  auto late = test::make_stored_order("LATE");
+  late.created_at += 1s;
+  store.store_order(late);
+  store.store_order(test::make_stored_order("B"));
+  store.store_order(test::make_stored_order("A"));
+  store.store_order(test::make_stored_order("DONE", "AAPL", v1::Side::BUY,
+                                            10.0, OrderStatus::FILLED));
+
+  auto open = store.get_open_orders();
+  ASSERT_EQ(open.size(), 3u);
+  EXPECT_EQ(open[0].local_id, "B");
+  EXPECT_EQ(open[1].local_id, "A");
+  EXPECT_EQ(open[2].local_id, "LATE");
+
+  auto filled = store.get_orders_by_status(OrderStatus::FILLED);
+  ASSERT_EQ(filled.size(), 1u);
+  EXPECT_EQ(filled[0].local_id, "DONE");
+}
+
+TEST_F(MemoryOrderStoreFixture, PositionSnapshotMissingUntilSaved) {
+  EXPECT_FALSE(store.load_position_snapshot().has_value());
+
+  PositionSnapshot snapshot{clock.now(), {{"AAPL", 10_qty, 150_px, 5_money}}};
+  ASSERT_TRUE(store.save_position_snapshot(snapshot));
+  snapshot.positions.clear();
+  ASSERT_TRUE(store.save_position_snapshot(snapshot));
+
+  auto loaded = store.load_position_snapshot();
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(loaded->taken_at, clock.now());
+  EXPECT_TRUE(loaded->positions.empty());
+}
+
+} // namespace quarcc
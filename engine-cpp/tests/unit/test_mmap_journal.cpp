@@ -0,0 +1,230 @@
+// Tests for MmapJournal against segment files in a per-test temp directory.
+
+#include <gtest/gtest.h>
+#include <trading/persistence/journal_factory.h>
+#include <trading/persistence/mmap_journal.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace quarcc {
+
+struct MmapJournalFixture : public testing::Test {
+  std::filesystem::path dir;
+
+  void SetUp() override {
+    const auto *info = testing::UnitTest::GetInstance()->current_test_info();
+    dir = std::filesystem::path(testing::TempDir()) /
+          (std::string("mmap_journal_") + info->name());
+    std::filesystem::remove_all(dir);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir); }
+
+  static std::vector<LogEntry> everything(IJournal &journal) {
+    return journal.get_history(LogEntry::now() - std::chrono::hours{1},
+                               LogEntry::now() + std::chrono::hours{1});
+  }
+};
+
+TEST_F(MmapJournalFixture, LogAndRetrieveSingleEntry) {
+  MmapJournal journal{dir};
+  journal.log(Event::ORDER_CREATED, "test data", "ORDER_1");
+
+  auto entries = everything(journal);
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries[0].id, 1u);
+  EXPECT_EQ(entries[0].event_type, Event::ORDER_CREATED);
+  EXPECT_EQ(entries[0].data, "test data");
+  EXPECT_EQ(entries[0].correlation_id, "ORDER_1");
+}
+
+TEST_F(MmapJournalFixture, GetHistoryWithEventFilterReturnsOnlyMatchingEvents) {
+  MmapJournal journal{dir};
+  journal.log(Event::ORDER_CREATED, "created", "ORD_A");
+  journal.log(Event::ORDER_SUBMITTED, "submitted", "ORD_A");
+  journal.log(Event::ORDER_FILLED, "filled", "ORD_A");
+
+  auto entries = journal.get_history(LogEntry::now() - std::chrono::hours{1},
+                                     LogEntry::now() + std::chrono::hours{1},
+                                     Event::ORDER_SUBMITTED);
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries[0].data, "submitted");
+}
+
+TEST_F(MmapJournalFixture, GetHistoryOutsideRangeIsEmpty) {
+  MmapJournal journal{dir};
+  journal.log(Event::ORDER_CREATED, "created", "ORD_A");
+
+  EXPECT_TRUE(journal
+                  .get_history(LogEntry::now() + std::chrono::hours{1},
+                               LogEntry::now() + std::chrono::hours{2})
+                  .empty());
+}
+
+TEST_F(MmapJournalFixture, GetOrderHistoryFiltersByCorrelationId) {
+  MmapJournal journal{dir};
+  journal.log(Event::ORDER_CREATED, "created", "ORD_X");
+  journal.log(Event::ORDER_CREATED, "other order", "ORD_Y");
+  journal.log(Event::ORDER_SUBMITTED, "submitted", "ORD_X");
+  journal.log(Event::SYSTEM_STARTED, "no correlation id");
+
+  auto entries = journal.get_order_history("ORD_X");
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].event_type, Event::ORDER_CREATED);
+  EXPECT_EQ(entries[1].event_type, Event::ORDER_SUBMITTED);
+  EXPECT_TRUE(journal.get_order_history("NO_SUCH_ORDER").empty());
+}
+
+TEST_F(MmapJournalFixture, SparseTimeIndexFindsRecordsBetweenIndexPoints) {
+  MmapJournal journal{dir, MmapJournalOptions{.time_index_stride = 8}};
+  for (int i = 0; i < 200; ++i)
+    journal.log(Event::ORDER_CREATED, std::to_string(i), "ORD");
+
+  auto all = everything(journal);
+  ASSERT_EQ(all.size(), 200u);
+
+  for (std::size_t pivot : {0u, 1u, 7u, 8u, 9u, 101u, 199u}) {
+    const Timestamp from = all[pivot].timestamp;
+    std::size_t expected = 0;
+    for (const auto &e : all)
+      expected += e.timestamp >= from;
+
+    auto entries = journal.get_history(from, all.back().timestamp);
+    EXPECT_EQ(entries.size(), expected) << "pivot " << pivot;
+  }
+}
+
+TEST_F(MmapJournalFixture, RollsToNewSegmentWhenFull) {
+  MmapJournal journal{dir, MmapJournalOptions{.segment_size = 8192}};
+  const std::string payload(200, 'x');
+  for (int i = 0; i < 100; ++i)
+    journal.log(Event::ORDER_CREATED, payload, "ORD_" + std::to_string(i % 3));
+
+  EXPECT_GT(journal.segment_count(), 1u);
+  auto entries = everything(journal);
+  ASSERT_EQ(entries.size(), 100u);
+  for (std::size_t i = 0; i < entries.size(); ++i)
+    EXPECT_EQ(entries[i].id, i + 1);
+  EXPECT_EQ(journal.get_order_history("ORD_1").size(), 33u);
+}
+
+TEST_F(MmapJournalFixture, CorrelationIndexIsBoundedAndOldSegmentsAreScanned) {
+  MmapJournal journal{dir, MmapJournalOptions{.segment_size = 8192,
+                                              .max_correlation_entries = 40}};
+  const std::string payload(200, 'x');
+  for (int i = 0; i < 300; ++i)
+    journal.log(Event::ORDER_CREATED, payload, "ORD_" + std::to_string(i % 3));
+
+  ASSERT_GT(journal.segment_count(), 3u);
+  EXPECT_LE(journal.correlation_index_size(), 40u);
+  auto history = journal.get_order_history("ORD_1");
+  ASSERT_EQ(history.size(), 100u);
+  for (std::size_t i = 0; i < history.size(); ++i)
+    EXPECT_EQ(history[i].id, 3 * i + 2);
+  EXPECT_TRUE(journal.get_order_history("ORD_").empty());
+}
+
+TEST_F(MmapJournalFixture, FlushSyncsRolledSegmentsAndAsyncSyncedRanges) {
+  MmapJournal journal{dir, MmapJournalOptions{.segment_size = 8192,
+                                              .sync_interval =
+                                                  std::chrono::milliseconds{1},
+                                              .time_index_stride = 64}};
+  const std::string payload(200, 'x');
+  for (int i = 0; i < 100; ++i) {
+    journal.log(Event::ORDER_CREATED, payload);
+    if (i % 10 == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds{2});
+  }
+  ASSERT_GT(journal.segment_count(), 1u);
+
+  // Rolls and periodic syncs only schedule write-back; none of it is durable
+  // until flush(), which has to reach every segment
+  EXPECT_GT(journal.unsynced_bytes(), 8192u);
+  journal.flush();
+  EXPECT_EQ(journal.unsynced_bytes(), 0u);
+
+  journal.log(Event::ORDER_CREATED, payload);
+  EXPECT_GT(journal.unsynced_bytes(), 0u);
+  journal.flush();
+  EXPECT_EQ(journal.unsynced_bytes(), 0u);
+}
+
+TEST_F(MmapJournalFixture, ReopenRecoversEntriesAndContinuesIds) {
+  {
+    MmapJournal journal{dir, MmapJournalOptions{.segment_size = 8192}};
+    for (int i = 0; i < 60; ++i)
+      journal.log(Event::ORDER_CREATED, std::string(100, 'y'), "ORD_R");
+    journal.flush();
+  }
+
+  MmapJournal reopened{dir, MmapJournalOptions{.segment_size = 8192}};
+  EXPECT_EQ(reopened.get_order_history("ORD_R").size(), 60u);
+  EXPECT_EQ(reopened.last_id(), 60u);
+
+  reopened.log(Event::ORDER_FILLED, "after reopen", "ORD_R");
+  auto history = reopened.get_order_history("ORD_R");
+  ASSERT_EQ(history.size(), 61u);
+  EXPECT_EQ(history.back().id, 61u);
+  EXPECT_EQ(history.back().data, "after reopen");
+}
+
+TEST_F(MmapJournalFixture, SecondWriterOnTheSameDirectoryIsRefused) {
+  {
+    MmapJournal journal{dir};
+    journal.log(Event::ORDER_CREATED, "first", "ORD_L");
+    EXPECT_THROW(MmapJournal{dir}, std::runtime_error);
+  }
+
+  // Released on close
+  MmapJournal reopened{dir};
+  EXPECT_EQ(reopened.get_order_history("ORD_L").size(), 1u);
+}
+
+TEST_F(MmapJournalFixture, CorruptRecordTruncatesLogOnReopen) {
+  {
+    MmapJournal journal{dir};
+    journal.log(Event::ORDER_CREATED, "first", "ORD_C");
+    journal.log(Event::ORDER_SUBMITTED, "second", "ORD_C");
+  }
+
+  // Flip a byte in the payload of the second record
+  auto seg = dir / "journal-00000000.seg";
+  // 64-byte segment header, then the first record: 32-byte header + 10 payload
+  // bytes, padded to 48
+  const std::streamoff second_record = 64 + 48;
+  {
+    std::fstream f(seg, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(second_record + 32 + 2);
+    f.put('!');
+  }
+
+  MmapJournal reopened{dir};
+  auto history = reopened.get_order_history("ORD_C");
+  ASSERT_EQ(history.size(), 1u);
+  EXPECT_EQ(history[0].data, "first");
+
+  // The discarded slot is reused
+  reopened.log(Event::ORDER_CANCELLED, "third", "ORD_C");
+  history = reopened.get_order_history("ORD_C");
+  ASSERT_EQ(history.size(), 2u);
+  EXPECT_EQ(history[1].id, 2u);
+  EXPECT_EQ(history[1].data, "third");
+}
+
+TEST_F(MmapJournalFixture, FactorySelectsBackend) {
+  JournalConfig config;
+  config.backend = JournalBackend::Mmap;
+  auto journal = make_journal(dir.string(), config);
+  ASSERT_NE(dynamic_cast<MmapJournal *>(journal.get()), nullptr);
+
+  journal->log(Event::SYSTEM_STARTED, "boot");
+  journal->flush();
+  EXPECT_TRUE(std::filesystem::exists(dir / "journal-00000000.seg"));
+}
+
+} // namespace quarcc
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <trading/utils/mpsc_queue.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace quarcc {
+
+TEST(MpscQueue, EmptyQueuePopsNothing) {
+  MpscQueue<int> q;
+  EXPECT_FALSE(q.try_pop().has_value());
+}
+
+TEST(MpscQueue, SingleProducerIsFifo) {
+  MpscQueue<std::string> q;
+  q.push("a");
+  q.push("b");
+  q.push("c");
+
+  EXPECT_EQ(*q.try_pop(), "a");
+  EXPECT_EQ(*q.try_pop(), "b");
+  EXPECT_EQ(*q.try_pop(), "c");
+  EXPECT_FALSE(q.try_pop().has_value());
+}
+
+TEST(MpscQueue, DestructorReleasesUnconsumedItems) {
+  auto q = std::make_unique<MpscQueue<std::unique_ptr<int>>>();
+  q->push(std::make_unique<int>(1));
+  q->push(std::make_unique<int>(2));
+  EXPECT_NO_THROW(q.reset());
+}
+
+TEST(MpscQueue, ConcurrentProducersPreservePerProducerOrder) {
+  constexpr int kProducers = 4;
+  constexpr int kPerProducer = 10000;
+  MpscQueue<std::pair<int, int>> q;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p)
+    producers.emplace_back([&q, p] {
+      for (int i = 0; i < kPerProducer; ++i)
+        q.push({p, i});
+    });
+
+  std::vector<int> next(kProducers, 0);
+  int received = 0;
+  while (received < kProducers * kPerProducer) {
+    auto item = q.try_pop();
+    if (!item)
+      continue;
+    auto [p, i] = *item;
+    ASSERT_EQ(i, next[p]);
+    ++next[p];
+    ++received;
+  }
+
+  for (auto &t : producers)
+    t.join();
+  EXPECT_FALSE(q.try_pop().has_value());
+}
+
+} // namespace quarcc
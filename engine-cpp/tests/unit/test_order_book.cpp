@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <trading/gateways/order_book.h>
+
+#include <vector>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+
+struct OrderBookTest : public testing::Test {
+  OrderBook book;
+  std::vector<OrderBook::Fill> fills;
+
+  Quantity take(v1::Side side, std::optional<Price> limit, Quantity quantity) {
+    return book.match(side, limit, quantity,
+                      [this](const OrderBook::Fill &f) { fills.push_back(f); });
+  }
+};
+
+TEST_F(OrderBookTest, BestPricesAndDepth) {
+  book.add(v1::BUY, 99_px, 10_qty, 1);
+  book.add(v1::BUY, 100_px, 5_qty, 2);
+  book.add(v1::BUY, 100_px, 7_qty, 3);
+  book.add(v1::SELL, 101_px, 4_qty, 4);
+  book.add(v1::SELL, 102_px, 4_qty, 5);
+
+  EXPECT_EQ(book.best_bid(), 100_px);
+  EXPECT_EQ(book.best_ask(), 101_px);
+  EXPECT_EQ(book.depth(v1::BUY, 100_px), 12_qty);
+  EXPECT_EQ(book.depth(v1::BUY, 98_px), Quantity{});
+  EXPECT_EQ(book.level_count(v1::BUY), 2u);
+  EXPECT_EQ(book.level_count(v1::SELL), 2u);
+  EXPECT_EQ(book.order_count(), 5u);
+}
+
+TEST_F(OrderBookTest, MatchesBestPriceThenOldestFirst) {
+  book.add(v1::SELL, 101_px, 5_qty, 1);
+  book.add(v1::SELL, 100_px, 3_qty, 2);
+  book.add(v1::SELL, 100_px, 4_qty, 3);
+
+  EXPECT_EQ(take(v1::BUY, std::nullopt, 9_qty), Quantity{});
+
+  ASSERT_EQ(fills.size(), 3u);
+  EXPECT_EQ(fills[0].maker_tag, 2u);
+  EXPECT_EQ(fills[0].price, 100_px);
+  EXPECT_EQ(fills[0].quantity, 3_qty);
+  EXPECT_EQ(fills[1].maker_tag, 3u);
+  EXPECT_EQ(fills[1].quantity, 4_qty);
+  EXPECT_EQ(fills[2].maker_tag, 1u);
+  EXPECT_EQ(fills[2].price, 101_px);
+  EXPECT_EQ(fills[2].quantity, 2_qty);
+  EXPECT_EQ(fills[2].maker_leaves, 3_qty);
+
+  EXPECT_EQ(book.best_ask(), 101_px);
+  EXPECT_EQ(book.order_count(), 1u);
+}
+
+TEST_F(OrderBookTest, LimitStopsAtPricesThatDoNotCross) {
+  book.add(v1::BUY, 100_px, 5_qty, 1);
+  book.add(v1::BUY, 99_px, 5_qty, 2);
+
+  EXPECT_EQ(take(v1::SELL, 100_px, 8_qty), 3_qty);
+  ASSERT_EQ(fills.size(), 1u);
+  EXPECT_EQ(fills[0].maker_tag, 1u);
+  EXPECT_EQ(book.best_bid(), 99_px);
+}
+
+TEST_F(OrderBookTest, AvailableCountsOnlyCrossingLiquidity) {
+  book.add(v1::SELL, 100_px, 5_qty, 1);
+  book.add(v1::SELL, 101_px, 5_qty, 2);
+
+  EXPECT_EQ(book.available(v1::BUY, 100_px, 20_qty), 5_qty);
+  EXPECT_EQ(book.available(v1::BUY, std::nullopt, 20_qty), 10_qty);
+  // Stops counting once it has enough
+  EXPECT_EQ(book.available(v1::BUY, std::nullopt, 3_qty), 5_qty);
+  EXPECT_EQ(book.available(v1::SELL, std::nullopt, 3_qty), Quantity{});
+}
+
+TEST_F(OrderBookTest, CancelRemovesOrderAndEmptyLevel) {
+  const auto a = book.add(v1::BUY, 100_px, 5_qty, 1);
+  const auto b = book.add(v1::BUY, 100_px, 6_qty, 2);
+
+  EXPECT_TRUE(book.cancel(a));
+  EXPECT_FALSE(book.cancel(a));
+  EXPECT_EQ(book.depth(v1::BUY, 100_px), 6_qty);
+  EXPECT_EQ(book.leaves(a), std::nullopt);
+  EXPECT_EQ(book.leaves(b), 6_qty);
+
+  EXPECT_TRUE(book.cancel(b));
+  EXPECT_EQ(book.best_bid(), std::nullopt);
+  EXPECT_EQ(book.order_count(), 0u);
+}
+
+TEST_F(OrderBookTest, StaleIdDoesNotReachRecycledSlot) {
+  const auto old_id = book.add(v1::SELL, 100_px, 5_qty, 1);
+  take(v1::BUY, std::nullopt, 5_qty);
+
+  const auto new_id = book.add(v1::SELL, 100_px, 5_qty, 2);
+  EXPECT_NE(old_id, new_id);
+  EXPECT_FALSE(book.cancel(old_id));
+  EXPECT_EQ(book.leaves(new_id), 5_qty);
+}
+
+TEST_F(OrderBookTest, CancelKeepsQueuePositionOfOthers) {
+  book.add(v1::SELL, 100_px, 1_qty, 1);
+  const auto middle = book.add(v1::SELL, 100_px, 1_qty, 2);
+  book.add(v1::SELL, 100_px, 1_qty, 3);
+  book.cancel(middle);
+
+  take(v1::BUY, std::nullopt, 2_qty);
+  ASSERT_EQ(fills.size(), 2u);
+  EXPECT_EQ(fills[0].maker_tag, 1u);
+  EXPECT_EQ(fills[1].maker_tag, 3u);
+}
+
+} // namespace quarcc
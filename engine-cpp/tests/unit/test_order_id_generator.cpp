@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <trading/utils/order_id_generator.h>
+
+#include <algorithm>
+#include <set>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace quarcc {
+
+TEST(CompactOrderIdTest, PacksFields) {
+  const CompactOrderId id(123'456, 7, 89);
+  EXPECT_EQ(id.millis(), 123'456u);
+  EXPECT_EQ(id.shard(), 7u);
+  EXPECT_EQ(id.sequence(), 89u);
+}
+
+TEST(CompactOrderIdTest, TextIsFixedWidthCrockfordBase32) {
+  EXPECT_EQ(CompactOrderId{0}.to_string(), "0000000000000");
+  EXPECT_EQ(CompactOrderId{31}.to_string(), "000000000000Z");
+  EXPECT_EQ(CompactOrderId{32}.to_string(), "0000000000010");
+  EXPECT_EQ(CompactOrderId{~0ull}.to_string(), "FZZZZZZZZZZZZ");
+
+  const CompactOrderId id(987'654'321, 1023, 4095);
+  const auto text = id.text();
+  EXPECT_EQ(text.size(), CompactOrderId::kTextSize);
+  EXPECT_EQ(CompactOrderId::parse({text.data(), text.size()}), id);
+}
+
+TEST(CompactOrderIdTest, ParseIsLenientLikeCrockford) {
+  EXPECT_EQ(CompactOrderId::parse("000000000000z"), CompactOrderId{31});
+  EXPECT_EQ(CompactOrderId::parse("0000000000001"),
+            CompactOrderId::parse("000000000000i"));
+  EXPECT_EQ(CompactOrderId::parse("000000000000L"), CompactOrderId{1});
+  EXPECT_EQ(CompactOrderId::parse("O00000000000O"), CompactOrderId{0});
+}
+
+TEST(CompactOrderIdTest, ParseRejectsMalformedText) {
+  EXPECT_FALSE(CompactOrderId::parse(""));
+  EXPECT_FALSE(CompactOrderId::parse("000000000000"));   // too short
+  EXPECT_FALSE(CompactOrderId::parse("00000000000000")); // too long
+  EXPECT_FALSE(CompactOrderId::parse("000000000000U"));
+  EXPECT_FALSE(CompactOrderId::parse("00000000000_1"));
+  EXPECT_FALSE(CompactOrderId::parse("G000000000000")); // over 64 bits
+  EXPECT_FALSE(CompactOrderId::parse("ORD_1700000000000_000001"));
+}
+
+TEST(OrderIdGeneratorTest, IdsIncreaseAndTextSortsTheSameWay) {
+  OrderIdGenerator gen(3);
+  std::vector<CompactOrderId> ids;
+  for (int i = 0; i < 20'000; ++i) // forces sequence rollover
+    ids.push_back(gen.next());
+
+  for (std::size_t i = 1; i < ids.size(); ++i) {
+    ASSERT_LT(ids[i - 1], ids[i]);
+    ASSERT_LT(ids[i - 1].to_string(), ids[i].to_string());
+    ASSERT_EQ(ids[i].shard(), 3u);
+  }
+}
+
+TEST(OrderIdGeneratorTest, TimestampIsNearNow) {
+  OrderIdGenerator gen;
+  const auto id = gen.next();
+  const auto now = std::chrono::floor<std::chrono::milliseconds>(
+      std::chrono::system_clock::now());
+  const auto issued = CompactOrderId::kEpoch +
+                      std::chrono::milliseconds{id.millis()};
+  EXPECT_LE(issued, now);
+  EXPECT_GT(issued, now - std::chrono::seconds{5});
+}
+
+TEST(OrderIdGeneratorTest, ReadsTimeFromItsClock) {
+  SimulatedClock clock{CompactOrderId::kEpoch + std::chrono::milliseconds{42}};
+  OrderIdGenerator gen{3, clock};
+  EXPECT_EQ(gen.next(), CompactOrderId(42, 3, 0));
+  EXPECT_EQ(gen.next(), CompactOrderId(42, 3, 1));
+
+  clock.advance(std::chrono::seconds{1});
+  EXPECT_EQ(gen.next(), CompactOrderId(1042, 3, 0));
+}
+
+TEST(OrderIdGeneratorTest, GenerateFitsTheInlineStringBuffer) {
+  OrderIdGenerator gen;
+  const LocalOrderId id = gen.generate();
+  EXPECT_EQ(id.size(), CompactOrderId::kTextSize);
+  EXPECT_LE(id.size(), LocalOrderId{}.capacity());
+  EXPECT_TRUE(CompactOrderId::parse(id));
+}
+
+TEST(OrderIdGeneratorTest, ShardsNeverCollide) {
+  OrderIdGenerator a(0), b(1);
+  std::unordered_set<std::uint64_t> seen;
+  for (int i = 0; i < 10'000; ++i) {
+    ASSERT_TRUE(seen.insert(a.next().value()).second);
+    ASSERT_TRUE(seen.insert(b.next().value()).second);
+  }
+}
+
+TEST(OrderIdGeneratorTest, ConcurrentCallersGetUniqueIds) {
+  OrderIdGenerator gen(5);
+  std::vector<std::vector<std::uint64_t>> per_thread(4);
+  std::vector<std::thread> threads;
+  for (auto &out : per_thread)
+    threads.emplace_back([&gen, &out] {
+      for (int i = 0; i < 20'000; ++i)
+        out.push_back(gen.next().value());
+    });
+  for (auto &t : threads)
+    t.join();
+
+  std::set<std::uint64_t> all;
+  for (const auto &out : per_thread)
+    all.insert(out.begin(), out.end());
+  EXPECT_EQ(all.size(), 80'000u);
+}
+
+TEST(OrderIdGeneratorTest, AdvancePastSkipsAheadOfRecoveredIds) {
+  OrderIdGenerator gen(2);
+  const auto now = gen.next();
+
+  // An id from "later" (e.g. issued before the clock stepped back)
+  const CompactOrderId recovered(now.millis() + 60'000, 9, 17);
+  gen.advance_past(recovered);
+  const auto next = gen.next();
+  EXPECT_GT(next.millis(), recovered.millis());
+  EXPECT_EQ(next.shard(), 2u);
+
+  // Advancing to the past is a no-op
+  gen.advance_past(now);
+  EXPECT_GT(gen.next(), next);
+}
+
+TEST(OrderIdGeneratorTest, RejectsOutOfRangeShard) {
+  EXPECT_THROW(OrderIdGenerator(CompactOrderId::kMaxShards),
+               std::runtime_error);
+  EXPECT_NO_THROW(OrderIdGenerator(CompactOrderId::kMaxShards - 1));
+}
+
+} // namespace quarcc
@@ -1,5 +1,11 @@
 #include <gtest/gtest.h>
-#include <trading/utils/order_id_types.h>
+#include <trading/utils/order_id_mapper.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace quarcc {
 
@@ -69,4 +75,121 @@ TEST(OrderIdMapper, MultipleIndependentMappings) {
   EXPECT_EQ(*mapper.get_local_id("Z"), "C");
 }
 
+TEST(OrderIdMapper, RemappingDropsStaleReverseEntries) {
+  OrderIdMapper mapper;
+  mapper.add_mapping("LOCAL_3", "BROKER_OLD");
+  mapper.add_mapping("LOCAL_3", "BROKER_NEW");
+  EXPECT_FALSE(mapper.get_local_id("BROKER_OLD").has_value());
+  EXPECT_EQ(*mapper.get_local_id("BROKER_NEW"), "LOCAL_3");
+
+  mapper.add_mapping("LOCAL_4", "BROKER_NEW");
+  EXPECT_FALSE(mapper.get_broker_id("LOCAL_3").has_value());
+  EXPECT_EQ(*mapper.get_local_id("BROKER_NEW"), "LOCAL_4");
+  EXPECT_EQ(mapper.size(), 1u);
+}
+
+TEST(OrderIdMapper, SurvivesGrowthAndChurn) {
+  OrderIdMapper mapper;
+  for (int i = 0; i < 10'000; ++i)
+    mapper.add_mapping("L" + std::to_string(i), "B" + std::to_string(i));
+  for (int i = 0; i < 10'000; i += 2)
+    mapper.remove_mapping("L" + std::to_string(i));
+  // Reuses erased slots and entries
+  for (int i = 0; i < 10'000; i += 2)
+    mapper.add_mapping("N" + std::to_string(i), "C" + std::to_string(i));
+
+  EXPECT_EQ(mapper.size(), 10'000u);
+  for (int i = 0; i < 10'000; ++i) {
+    const auto n = std::to_string(i);
+    if (i % 2 == 0) {
+      ASSERT_FALSE(mapper.get_broker_id("L" + n)) << i;
+      ASSERT_EQ(mapper.get_local_id("C" + n), "N" + n);
+    } else {
+      ASSERT_EQ(mapper.get_broker_id("L" + n), "B" + n);
+      ASSERT_EQ(mapper.get_local_id("B" + n), "L" + n);
+    }
+  }
+}
+
+TEST(OrderIdMapper, SnapshotCopiesEveryMapping) {
+  OrderIdMapper mapper;
+  mapper.add_mapping("A", "X");
+  mapper.add_mapping("B", "Y");
+  mapper.add_mapping("C", "Z");
+  mapper.remove_mapping("B");
+
+  auto snapshot = mapper.snapshot();
+  std::sort(snapshot.begin(), snapshot.end());
+  ASSERT_EQ(snapshot.size(), 2u);
+  EXPECT_EQ(snapshot[0].first, "A");
+  EXPECT_EQ(snapshot[0].second, "X");
+  EXPECT_EQ(snapshot[1].first, "C");
+  EXPECT_EQ(snapshot[1].second, "Z");
+
+  // Later changes do not show through
+  mapper.remove_mapping("A");
+  EXPECT_EQ(snapshot.size(), 2u);
+}
+
+TEST(OrderIdMapper, RetiredBrokerIdsResolveUntilRemoved) {
+  OrderIdMapper mapper;
+  mapper.add_mapping("L1", "B1");
+
+  EXPECT_EQ(mapper.retire_mapping("L1"), "B1");
+  EXPECT_FALSE(mapper.get_broker_id("L1").has_value());
+  EXPECT_EQ(mapper.get_local_id("B1"), "L1");
+  EXPECT_EQ(mapper.size(), 0u);
+  EXPECT_FALSE(mapper.retire_mapping("L1").has_value());
+
+  mapper.remove_retired("B1");
+  EXPECT_FALSE(mapper.get_local_id("B1").has_value());
+}
+
+TEST(OrderIdMapper, RemoveRetiredSkipsRemappedBrokerIds) {
+  OrderIdMapper mapper;
+  mapper.add_mapping("L1", "B1");
+  mapper.retire_mapping("L1");
+  mapper.add_mapping("L1", "B1");
+
+  mapper.remove_retired("B1");
+  EXPECT_EQ(mapper.get_local_id("B1"), "L1");
+  EXPECT_EQ(mapper.get_broker_id("L1"), "B1");
+}
+
+TEST(OrderIdMapper, ConcurrentLookupsDuringWrites) {
+  OrderIdMapper mapper;
+  for (int i = 0; i < 1'000; ++i)
+    mapper.add_mapping("L" + std::to_string(i), "B" + std::to_string(i));
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; ++t)
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        for (int i = 0; i < 1'000; ++i) {
+          const auto n = std::to_string(i);
+          auto local = mapper.get_local_id("B" + n);
+          if (!local || *local != "L" + n)
+            ++mismatches;
+          if (auto broker = mapper.get_broker_id("T" + n);
+              broker && *broker != "U" + n)
+            ++mismatches;
+        }
+      }
+    });
+
+  // Churn other keys, forcing rehashes while readers probe
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 0; i < 1'000; ++i)
+      mapper.add_mapping("T" + std::to_string(i), "U" + std::to_string(i));
+    for (int i = 0; i < 1'000; ++i)
+      mapper.remove_mapping("T" + std::to_string(i));
+  }
+  stop = true;
+  for (auto &r : readers)
+    r.join();
+  EXPECT_EQ(mismatches.load(), 0);
+}
+
 } // namespace quarcc
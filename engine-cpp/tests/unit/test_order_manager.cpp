@@ -2,7 +2,12 @@
 #include <gtest/gtest.h>
 
 #include <trading/core/order_manager.h>
+#include <trading/gateways/paper_trading_gateway.h>
 #include <trading/interfaces/i_risk_check.h>
+#include <trading/persistence/memory_journal.h>
+#include <trading/persistence/memory_order_store.h>
+
+#include <thread>
 
 #include "helpers/proto_builders.h"
 #include "mocks/mock_execution_gateway.h"
@@ -13,6 +18,8 @@ using namespace testing;
 
 namespace quarcc {
 
+using namespace fixed_point_literals;
+
 struct OrderManagerFixture : public Test {
   // Raw pointers kept for EXPECT_CALL; ownership transferred to manager.
   MockExecutionGateway *gw{};
@@ -22,6 +29,9 @@ struct OrderManagerFixture : public Test {
   std::unique_ptr<OrderManager> manager;
 
   void SetUp() override {
+    // Orders are only accepted for symbols already in the table
+    SymbolTable::global().intern("AAPL");
+
     auto gw_owned = std::make_unique<NiceMock<MockExecutionGateway>>();
     auto jn_owned = std::make_unique<NiceMock<MockJournal>>();
     auto os_owned = std::make_unique<NiceMock<MockOrderStore>>();
@@ -68,6 +78,219 @@ TEST_F(OrderManagerFixture, SubmitSignalGatewayReject) {
   EXPECT_FALSE(result.has_value());
 }
 
+TEST_F(OrderManagerFixture, SubmitSignalForUnknownSymbolIsRejected) {
+  ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_order_status(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  EXPECT_CALL(*gw, submit_order(_)).Times(0);
+  EXPECT_CALL(*store, update_order_status(_, OrderStatus::REJECTED));
+
+  const auto before = SymbolTable::global().size();
+  auto result = manager->processSignal(
+      test::make_signal("TEST", "NOT_A_LISTED_SYMBOL"));
+  ASSERT_FALSE(result.has_value());
+  EXPECT_EQ(result.error().message_, "Unknown symbol NOT_A_LISTED_SYMBOL");
+  EXPECT_EQ(SymbolTable::global().size(), before);
+}
+
+// Terminal orders keep their broker id resolving for a short grace period
+struct MappingGraceFixture : public Test {
+  static constexpr std::chrono::milliseconds kGrace{50};
+
+  MockExecutionGateway *gw{};
+  MockOrderStore *store{};
+  std::unique_ptr<OrderManager> manager;
+
+  void SetUp() override {
+    SymbolTable::global().intern("AAPL");
+
+    auto gw_owned = std::make_unique<NiceMock<MockExecutionGateway>>();
+    auto os_owned = std::make_unique<NiceMock<MockOrderStore>>();
+    gw = gw_owned.get();
+    store = os_owned.get();
+    manager = OrderManager::CreateOrderManager(
+        std::make_unique<PositionKeeper>(), std::move(gw_owned),
+        std::make_unique<NiceMock<MockJournal>>(), std::move(os_owned),
+        std::make_unique<RiskManager>(), {.mapping_grace = kGrace});
+
+    ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+    ON_CALL(*store, update_broker_id(_, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*store, update_order_status(_, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B1"}));
+    ON_CALL(*gw, cancel_order(_)).WillByDefault(Return(std::monostate{}));
+  }
+
+  // Submits an order for 10 AAPL and cancels it
+  std::string submit_and_cancel() {
+    auto local_id = manager->processSignal(test::make_signal());
+    EXPECT_TRUE(local_id.has_value());
+    v1::CancelSignal cancel;
+    cancel.set_order_id(*local_id);
+    EXPECT_TRUE(manager->processSignal(cancel).has_value());
+    ON_CALL(*store, get_order(*local_id))
+        .WillByDefault(Return(test::make_stored_order(
+            *local_id, "AAPL", v1::Side::BUY, 10.0, OrderStatus::CANCELLED,
+            "B1")));
+    return *local_id;
+  }
+};
+
+TEST_F(MappingGraceFixture, LateFillAfterCancelStillResolves) {
+  const auto local_id = submit_and_cancel();
+
+  // The order itself is gone...
+  v1::CancelSignal again;
+  again.set_order_id(local_id);
+  EXPECT_CALL(*gw, cancel_order(_)).Times(0);
+  EXPECT_FALSE(manager->processSignal(again).has_value());
+
+  // ...but an execution that raced the cancel is applied, and the order
+  // stays cancelled
+  ON_CALL(*gw, get_fills())
+      .WillByDefault(Return(std::vector{
+          test::make_fill("B1", "AAPL", v1::Side::BUY, 4.0, 150.0)}));
+  EXPECT_CALL(*store, apply_fills(ElementsAre(AllOf(
+                          Field(&FillUpdate::local_id, local_id),
+                          Field(&FillUpdate::new_status,
+                                OrderStatus::CANCELLED)))));
+  manager->process_fills();
+  EXPECT_EQ(manager->get_position("AAPL")->quantity(), 4.0);
+}
+
+TEST_F(MappingGraceFixture, MappingIsDroppedAfterTheGracePeriod) {
+  submit_and_cancel();
+  std::this_thread::sleep_for(kGrace + std::chrono::milliseconds{20});
+
+  // Too late: the fill is parked as unknown instead of applied
+  ON_CALL(*gw, get_fills())
+      .WillByDefault(Return(std::vector{
+          test::make_fill("B1", "AAPL", v1::Side::BUY, 4.0, 150.0)}));
+  EXPECT_CALL(*store, apply_fills(IsEmpty()));
+  manager->process_fills();
+}
+
+TEST(OrderManagerRisk, RiskRejectionNeverReachesTheGateway) {
+  SymbolTable::global().intern("AAPL");
+  auto gw_owned = std::make_unique<NiceMock<MockExecutionGateway>>();
+  auto os_owned = std::make_unique<NiceMock<MockOrderStore>>();
+  auto *gw = gw_owned.get();
+  auto *store = os_owned.get();
+
+  SharedRiskLimits limits;
+  RiskLimits strict;
+  strict.default_symbol.max_order_quantity = 5_qty;
+  limits.publish(strict);
+
+  auto manager = OrderManager::CreateOrderManager(
+      std::make_unique<PositionKeeper>(), std::move(gw_owned),
+      std::make_unique<NiceMock<MockJournal>>(), std::move(os_owned),
+      std::make_unique<RiskManager>("TEST", limits, nullptr, nullptr,
+                                    nullptr));
+
+  ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_order_status(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  EXPECT_CALL(*gw, submit_order(_)).Times(0);
+  EXPECT_CALL(*store, update_order_status(_, OrderStatus::REJECTED));
+
+  auto result = manager->processSignal(test::make_signal());
+  ASSERT_FALSE(result.has_value());
+  EXPECT_EQ(result.error().type_, ErrorType::RiskRejected);
+  EXPECT_NE(result.error().message_.find("order quantity 10 exceeds limit 5"),
+            std::string::npos);
+}
+
+// Wired as the engine wires each strategy: market orders, a PaperGateway and
+// a mark cache that has seen no market data yet
+TEST(OrderManagerRisk, MarketOrdersAreValuedAtTheGatewayReferencePrice) {
+  SharedRiskLimits limits;
+  RiskLimits notional;
+  notional.default_symbol.max_order_notional = 1'500_money;
+  limits.publish(notional);
+
+  MarkPriceCache marks;
+  auto keeper = std::make_unique<PositionKeeper>(nullptr, &marks);
+  auto risk = std::make_unique<RiskManager>("TEST", limits, keeper.get(),
+                                            nullptr, &marks);
+  auto manager = OrderManager::CreateOrderManager(
+      std::move(keeper),
+      std::make_unique<PaperGateway>(PaperGatewayOptions{
+          .venue = {}, .reference_prices = {{"AAPL", 100_px}}, .clock = {}}),
+      std::make_unique<MemoryJournal>(), std::make_unique<MemoryOrderStore>(),
+      std::move(risk));
+
+  EXPECT_TRUE(manager->processSignal(
+      test::make_signal("TEST", "AAPL", v1::Side::BUY, 10.0)));
+
+  auto result = manager->processSignal(
+      test::make_signal("TEST", "AAPL", v1::Side::BUY, 20.0));
+  ASSERT_FALSE(result.has_value());
+  EXPECT_EQ(result.error().type_, ErrorType::RiskRejected);
+  EXPECT_NE(result.error().message_.find("order notional 2000"),
+            std::string::npos);
+}
+
+TEST(OrderManagerRisk, WorkingOrdersCountTowardsPositionLimits) {
+  SymbolTable::global().intern("AAPL");
+  auto gw_owned = std::make_unique<NiceMock<MockExecutionGateway>>();
+  auto os_owned = std::make_unique<NiceMock<MockOrderStore>>();
+  auto *gw = gw_owned.get();
+  auto *store = os_owned.get();
+
+  SharedRiskLimits limits;
+  RiskLimits capped;
+  capped.default_strategy.max_position = 15_qty;
+  limits.publish(capped);
+
+  auto keeper = std::make_unique<PositionKeeper>();
+  auto risk = std::make_unique<RiskManager>("TEST", limits, keeper.get(),
+                                            nullptr, nullptr);
+  auto manager = OrderManager::CreateOrderManager(
+      std::move(keeper), std::move(gw_owned),
+      std::make_unique<NiceMock<MockJournal>>(), std::move(os_owned),
+      std::move(risk));
+
+  ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_order_status(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_broker_id(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B1"}));
+  ON_CALL(*gw, cancel_order(_)).WillByDefault(Return(std::monostate{}));
+
+  // Neither fills, but together they would breach the limit
+  auto first = manager->processSignal(
+      test::make_signal("TEST", "AAPL", v1::Side::BUY, 10.0));
+  ASSERT_TRUE(first.has_value());
+  auto second = manager->processSignal(
+      test::make_signal("TEST", "AAPL", v1::Side::BUY, 10.0));
+  ASSERT_FALSE(second.has_value());
+  EXPECT_EQ(second.error().type_, ErrorType::RiskRejected);
+  EXPECT_NE(second.error().message_.find("strategy position would be 20"),
+            std::string::npos);
+
+  // Cancelling the first frees its quantity
+  v1::CancelSignal cancel;
+  cancel.set_order_id(*first);
+  ASSERT_TRUE(manager->processSignal(cancel).has_value());
+  EXPECT_TRUE(manager->processSignal(
+      test::make_signal("TEST", "AAPL", v1::Side::BUY, 10.0)));
+}
+
+TEST_F(OrderManagerFixture, SignalsWithUnrepresentableQuantityAreRefused) {
+  EXPECT_CALL(*store, store_order(_)).Times(0);
+  EXPECT_CALL(*gw, submit_order(_)).Times(0);
+
+  for (double qty : {std::nan(""), HUGE_VAL, 1e300}) {
+    auto result = manager->processSignal(
+        test::make_signal("TEST", "AAPL", v1::Side::BUY, qty));
+    ASSERT_FALSE(result.has_value()) << qty;
+    EXPECT_EQ(result.error().type_, ErrorType::FailedOrder);
+  }
+}
+
 TEST_F(OrderManagerFixture, SubmitSignalStoreFailureIsReturned) {
   ON_CALL(*store, store_order(_))
       .WillByDefault(
@@ -170,11 +393,14 @@ TEST_F(OrderManagerFixture, ProcessFillsFullyFilledOrder) {
       test::make_stored_order(local_id, "AAPL", v1::Side::BUY, 10.0,
                               OrderStatus::SUBMITTED, "BROKER_F1");
   ON_CALL(*store, get_order(local_id)).WillByDefault(Return(stored));
-  ON_CALL(*store, update_fill_info(_, _, _))
-      .WillByDefault(Return(std::monostate{}));
 
-  // Fully-filled order must get FILLED status.
-  EXPECT_CALL(*store, update_order_status(local_id, OrderStatus::FILLED));
+  // Fully-filled order must get FILLED status, in a single batched update.
+  EXPECT_CALL(*store,
+              apply_fills(ElementsAre(AllOf(
+                  Field(&FillUpdate::local_id, local_id),
+                  Field(&FillUpdate::delta_qty, 10_qty),
+                  Field(&FillUpdate::price, 150_px),
+                  Field(&FillUpdate::new_status, OrderStatus::FILLED)))));
 
   manager->process_fills();
 
@@ -184,6 +410,58 @@ TEST_F(OrderManagerFixture, ProcessFillsFullyFilledOrder) {
   EXPECT_DOUBLE_EQ(pos->quantity(), 10.0);
 }
 
+TEST_F(OrderManagerFixture, ProcessFillsDropsUnrepresentableReports) {
+  ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_broker_id(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_order_status(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B_NAN"}));
+
+  auto submit = manager->processSignal(test::make_signal());
+  ASSERT_TRUE(submit.has_value());
+  ON_CALL(*store, get_order(*submit))
+      .WillByDefault(Return(test::make_stored_order(
+          *submit, "AAPL", v1::Side::BUY, 10.0, OrderStatus::SUBMITTED,
+          "B_NAN")));
+  ON_CALL(*gw, get_fills())
+      .WillByDefault(Return(std::vector{
+          test::make_fill("B_NAN", "AAPL", v1::Side::BUY, std::nan(""), 150.0),
+          test::make_fill("B_NAN", "AAPL", v1::Side::BUY, 5.0, 1e300)}));
+
+  EXPECT_CALL(*store, apply_fills(IsEmpty()));
+  EXPECT_EQ(manager->process_fills(), 0u);
+  EXPECT_FALSE(manager->get_position("AAPL").has_value());
+}
+
+TEST_F(OrderManagerFixture, ProcessFillsJournalsBeforeTheStore) {
+  ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_broker_id(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"BROKER_J1"}));
+
+  auto submit = manager->processSignal(test::make_signal("TEST", "AAPL",
+                                                         v1::Side::BUY, 10.0));
+  ASSERT_TRUE(submit.has_value());
+  const std::string local_id = *submit;
+
+  ON_CALL(*gw, get_fills())
+      .WillByDefault(Return(std::vector{
+          test::make_fill("BROKER_J1", "AAPL", v1::Side::BUY, 10.0, 150.0)}));
+  ON_CALL(*store, get_order(local_id))
+      .WillByDefault(Return(test::make_stored_order(
+          local_id, "AAPL", v1::Side::BUY, 10.0, OrderStatus::SUBMITTED,
+          "BROKER_J1")));
+
+  // Recovery replays journaled fills only, so the store must never get ahead
+  InSequence in_order;
+  EXPECT_CALL(*journal, log(Event::ORDER_FILLED, _, local_id));
+  EXPECT_CALL(*journal, barrier());
+  EXPECT_CALL(*store, apply_fills(SizeIs(1)));
+
+  EXPECT_EQ(manager->process_fills(), 1u);
+}
+
 TEST_F(OrderManagerFixture, ProcessFillsPartialFill) {
   ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
   ON_CALL(*store, update_broker_id(_, _))
@@ -204,12 +482,62 @@ TEST_F(OrderManagerFixture, ProcessFillsPartialFill) {
       test::make_stored_order(local_id, "AAPL", v1::Side::BUY, 10.0,
                               OrderStatus::SUBMITTED, "BROKER_P1");
   ON_CALL(*store, get_order(local_id)).WillByDefault(Return(stored));
-  ON_CALL(*store, update_fill_info(_, _, _))
-      .WillByDefault(Return(std::monostate{}));
 
   // Partial fill -> PARTIALLY_FILLED, NOT FILLED.
+  EXPECT_CALL(*store, apply_fills(ElementsAre(Field(
+                          &FillUpdate::new_status,
+                          OrderStatus::PARTIALLY_FILLED))));
+
+  manager->process_fills();
+}
+
+TEST_F(OrderManagerFixture, ProcessFillsAddsDeltaToStoredFilledQuantity) {
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"BROKER_D1"}));
+  auto submit = manager->processSignal(test::make_signal("TEST", "AAPL",
+                                                         v1::Side::BUY, 10.0));
+  ASSERT_TRUE(submit.has_value());
+  const std::string local_id = *submit;
+
+  // 6 already filled; this execution fills the remaining 4.
+  auto stored = test::make_stored_order(local_id, "AAPL", v1::Side::BUY, 10.0,
+                                        OrderStatus::PARTIALLY_FILLED,
+                                        "BROKER_D1");
+  stored.filled_quantity = 6_qty;
+  ON_CALL(*store, get_order(local_id)).WillByDefault(Return(stored));
+  ON_CALL(*gw, get_fills())
+      .WillByDefault(Return(std::vector{
+          test::make_fill("BROKER_D1", "AAPL", v1::Side::BUY, 4.0, 150.0)}));
+
+  EXPECT_CALL(*store, apply_fills(ElementsAre(AllOf(
+                          Field(&FillUpdate::delta_qty, 4_qty),
+                          Field(&FillUpdate::new_status, OrderStatus::FILLED)))));
+
+  manager->process_fills();
+
+  auto pos = manager->get_position("AAPL");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), 4.0);
+}
+
+TEST_F(OrderManagerFixture, ProcessFillsAccumulatesSeveralFillsInOneBatch) {
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"BROKER_M1"}));
+  auto submit = manager->processSignal(test::make_signal("TEST", "AAPL",
+                                                         v1::Side::BUY, 10.0));
+  ASSERT_TRUE(submit.has_value());
+
+  ON_CALL(*store, get_order(*submit))
+      .WillByDefault(Return(test::make_stored_order(
+          *submit, "AAPL", v1::Side::BUY, 10.0, OrderStatus::SUBMITTED,
+          "BROKER_M1")));
+  ON_CALL(*gw, get_fills())
+      .WillByDefault(Return(std::vector{
+          test::make_fill("BROKER_M1", "AAPL", v1::Side::BUY, 3.0, 150.0),
+          test::make_fill("BROKER_M1", "AAPL", v1::Side::BUY, 7.0, 151.0)}));
+
   EXPECT_CALL(*store,
-              update_order_status(local_id, OrderStatus::PARTIALLY_FILLED));
+              apply_fills(ElementsAre(
+                  Field(&FillUpdate::new_status, OrderStatus::PARTIALLY_FILLED),
+                  Field(&FillUpdate::new_status, OrderStatus::FILLED))));
 
   manager->process_fills();
 }
@@ -222,6 +550,43 @@ TEST_F(OrderManagerFixture, ProcessFillsUnknownBrokerIDIsSkipped) {
   EXPECT_NO_THROW(manager->process_fills());
 }
 
+TEST_F(OrderManagerFixture, ProcessFillsRetriesFillThatRacedAheadOfMapping) {
+  // A push gateway can report the fill before submit_order() has returned.
+  auto fill = test::make_fill("BROKER_EARLY", "AAPL", v1::Side::BUY, 10.0,
+                              150.0);
+  EXPECT_CALL(*gw, get_fills())
+      .WillOnce(Return(std::vector{fill}))
+      .WillRepeatedly(Return(std::vector<v1::ExecutionReport>{}));
+  manager->process_fills();
+  EXPECT_FALSE(manager->get_position("AAPL").has_value());
+
+  ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_broker_id(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_order_status(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*gw, submit_order(_))
+      .WillByDefault(Return(std::string{"BROKER_EARLY"}));
+
+  auto submit = manager->processSignal(test::make_signal());
+  ASSERT_TRUE(submit.has_value());
+  ON_CALL(*store, get_order(*submit))
+      .WillByDefault(Return(test::make_stored_order(
+          *submit, "AAPL", v1::Side::BUY, 10.0, OrderStatus::SUBMITTED,
+          "BROKER_EARLY")));
+
+  manager->process_fills();
+
+  auto pos = manager->get_position("AAPL");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), 10.0);
+}
+
+TEST_F(OrderManagerFixture, SetFillListenerForwardsToGateway) {
+  EXPECT_CALL(*gw, set_fill_listener(_)).WillOnce(Return(true));
+  EXPECT_TRUE(manager->set_fill_listener([] {}));
+}
+
 TEST_F(OrderManagerFixture, CancelAllCancelsEveryOpenOrder) {
   auto o1 = test::make_stored_order("L1", "AAPL", v1::Side::BUY, 5.0,
                                     OrderStatus::SUBMITTED, "B1");
@@ -236,4 +601,251 @@ TEST_F(OrderManagerFixture, CancelAllCancelsEveryOpenOrder) {
   manager->cancel_all("emergency", "risk_system");
 }
 
+TEST_F(OrderManagerFixture, CheckpointSavesCurrentPositions) {
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"BROKER_S1"}));
+  auto submit = manager->processSignal(test::make_signal("TEST", "AAPL",
+                                                         v1::Side::BUY, 10.0));
+  ASSERT_TRUE(submit.has_value());
+  ON_CALL(*store, get_order(*submit))
+      .WillByDefault(Return(test::make_stored_order(
+          *submit, "AAPL", v1::Side::BUY, 10.0, OrderStatus::SUBMITTED,
+          "BROKER_S1")));
+  ON_CALL(*gw, get_fills())
+      .WillByDefault(Return(std::vector{
+          test::make_fill("BROKER_S1", "AAPL", v1::Side::BUY, 10.0, 150.0)}));
+  manager->process_fills();
+
+  ON_CALL(*journal, last_id()).WillByDefault(Return(7));
+  EXPECT_CALL(*store,
+              save_position_snapshot(AllOf(
+                  Field(&PositionSnapshot::journal_id, Optional(7u)),
+                  Field(&PositionSnapshot::positions,
+                        ElementsAre(AllOf(
+                            Field(&PositionSnapshot::Entry::symbol, "AAPL"),
+                            Field(&PositionSnapshot::Entry::quantity, 10_qty),
+                            Field(&PositionSnapshot::Entry::avg_price,
+                                  150_px)))))))
+      .WillOnce(Return(std::monostate{}));
+
+  EXPECT_TRUE(manager->checkpoint().has_value());
+}
+
+// ---------------------------------------------------------------------------
+// Recovery
+// ---------------------------------------------------------------------------
+
+// Mocks are configured before CreateOrderManager() runs recovery
+struct RecoveryFixture : public Test {
+  std::unique_ptr<NiceMock<MockExecutionGateway>> gw_owned =
+      std::make_unique<NiceMock<MockExecutionGateway>>();
+  std::unique_ptr<NiceMock<MockJournal>> jn_owned =
+      std::make_unique<NiceMock<MockJournal>>();
+  std::unique_ptr<NiceMock<MockOrderStore>> os_owned =
+      std::make_unique<NiceMock<MockOrderStore>>();
+
+  MockExecutionGateway *gw = gw_owned.get();
+  MockJournal *journal = jn_owned.get();
+  MockOrderStore *store = os_owned.get();
+
+  void SetUp() override {
+    SymbolTable::global().intern("AAPL");
+    ON_CALL(*store, load_position_snapshot())
+        .WillByDefault(Return(std::unexpected(
+            Error{"No position snapshot stored", ErrorType::Error})));
+  }
+
+  std::unique_ptr<OrderManager> create() {
+    return OrderManager::CreateOrderManager(
+        std::make_unique<PositionKeeper>(), std::move(gw_owned),
+        std::move(jn_owned), std::move(os_owned),
+        std::make_unique<RiskManager>());
+  }
+
+  static LogEntry fill_entry(Timestamp ts, const std::string &data,
+                             std::uint64_t id = 0) {
+    LogEntry entry;
+    entry.id = id;
+    entry.timestamp = ts;
+    entry.event_type = Event::ORDER_FILLED;
+    entry.data = data;
+    entry.correlation_id = "L1";
+    return entry;
+  }
+};
+
+TEST_F(RecoveryFixture, OpenOrdersAreMappedBackToBrokerIds) {
+  auto open = test::make_stored_order("L1", "AAPL", v1::Side::BUY, 10.0,
+                                      OrderStatus::SUBMITTED, "B1");
+  ON_CALL(*store, get_open_orders()).WillByDefault(Return(std::vector{open}));
+  ON_CALL(*store, get_order("L1")).WillByDefault(Return(open));
+  ON_CALL(*gw, get_fills())
+      .WillByDefault(Return(std::vector{
+          test::make_fill("B1", "AAPL", v1::Side::BUY, 10.0, 150.0)}));
+
+  auto manager = create();
+
+  // The fill resolves instead of being dropped as an unknown broker order
+  EXPECT_CALL(*store, apply_fills(ElementsAre(
+                          Field(&FillUpdate::local_id, "L1"))));
+  manager->process_fills();
+
+  v1::CancelSignal cancel;
+  cancel.set_order_id("L1");
+  EXPECT_CALL(*gw, cancel_order("B1")).Times(0); // filled: mapping removed
+  EXPECT_FALSE(manager->processSignal(cancel).has_value());
+}
+
+TEST_F(RecoveryFixture, NewIdsSortAfterRecoveredOnes) {
+  // Issued "in the future", as if the clock had since stepped back
+  const auto now = OrderIdGenerator{}.next();
+  const CompactOrderId recovered(now.millis() + 60'000, 0, 5);
+  auto open = test::make_stored_order(recovered.to_string(), "AAPL",
+                                      v1::Side::BUY, 10.0,
+                                      OrderStatus::SUBMITTED, "B1");
+  ON_CALL(*store, get_open_orders()).WillByDefault(Return(std::vector{open}));
+  ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_order_status(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*store, update_broker_id(_, _))
+      .WillByDefault(Return(std::monostate{}));
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B2"}));
+
+  auto manager = create();
+  auto local_id = manager->processSignal(test::make_signal());
+  ASSERT_TRUE(local_id.has_value());
+  auto id = CompactOrderId::parse(*local_id);
+  ASSERT_TRUE(id);
+  EXPECT_GT(*id, recovered);
+}
+
+TEST_F(RecoveryFixture, PositionsComeFromSnapshotPlusJournalTail) {
+  const auto taken_at = LogEntry::now() - std::chrono::minutes{1};
+  PositionSnapshot snapshot;
+  snapshot.taken_at = taken_at;
+  snapshot.positions.push_back({"AAPL", 10_qty, 100_px, 0_money});
+  ON_CALL(*store, load_position_snapshot()).WillByDefault(Return(snapshot));
+
+  EXPECT_CALL(*journal, get_history(taken_at, _, _))
+      .WillOnce(Return(std::vector{
+          // Already part of the snapshot
+          fill_entry(taken_at, "Filled: BUY 10 AAPL @ 100 (10 / 10)"),
+          fill_entry(taken_at + std::chrono::seconds{1},
+                     "Filled: BUY 10 AAPL @ 200 (10 / 10)"),
+          fill_entry(taken_at + std::chrono::seconds{2},
+                     "Filled: SELL 4 MSFT @ 50 (4 / 4)"),
+      }));
+
+  auto manager = create();
+
+  auto aapl = manager->get_position("AAPL");
+  ASSERT_TRUE(aapl.has_value());
+  EXPECT_DOUBLE_EQ(aapl->quantity(), 20.0);
+  EXPECT_DOUBLE_EQ(aapl->avg_price(), 150.0);
+
+  auto msft = manager->get_position("MSFT");
+  ASSERT_TRUE(msft.has_value());
+  EXPECT_DOUBLE_EQ(msft->quantity(), -4.0);
+}
+
+TEST_F(RecoveryFixture, ResumesAfterTheSnapshotsJournalEntry) {
+  // A simulated clock stamps everything in one tick alike, including the
+  // checkpoint and fills that came after it
+  const auto tick = LogEntry::now() - std::chrono::minutes{1};
+  PositionSnapshot snapshot;
+  snapshot.taken_at = tick;
+  snapshot.journal_id = 2;
+  snapshot.positions.push_back({"AAPL", 10_qty, 100_px, 0_money});
+  ON_CALL(*store, load_position_snapshot()).WillByDefault(Return(snapshot));
+
+  EXPECT_CALL(*journal, get_history(tick, _, _))
+      .WillOnce(Return(std::vector{
+          fill_entry(tick, "Filled: BUY 10 AAPL @ 100 (10 / 10)", 2),
+          fill_entry(tick, "Filled: BUY 10 AAPL @ 200 (10 / 10)", 3),
+      }));
+
+  auto manager = create();
+
+  auto aapl = manager->get_position("AAPL");
+  ASSERT_TRUE(aapl.has_value());
+  EXPECT_DOUBLE_EQ(aapl->quantity(), 20.0);
+  EXPECT_DOUBLE_EQ(aapl->avg_price(), 150.0);
+}
+
+TEST_F(RecoveryFixture, ReappliesJournaledFillsTheStoreMissed) {
+  // The store saw the first fill but not the two journaled after it
+  auto open = test::make_stored_order("L1", "AAPL", v1::Side::BUY, 10.0,
+                                      OrderStatus::PARTIALLY_FILLED, "B1");
+  open.filled_quantity = 4_qty;
+  ON_CALL(*store, get_open_orders()).WillByDefault(Return(std::vector{open}));
+  const auto ts = LogEntry::now();
+  ON_CALL(*journal, get_order_history("L1"))
+      .WillByDefault(Return(std::vector{
+          fill_entry(ts, "Filled: BUY 4 AAPL @ 100 (4 / 10)", 1),
+          fill_entry(ts, "Filled: BUY 5 AAPL @ 101 (9 / 10)", 2),
+          fill_entry(ts, "Filled: BUY 1 AAPL @ 102 (10 / 10)", 3),
+      }));
+
+  EXPECT_CALL(*store,
+              apply_fills(ElementsAre(
+                  AllOf(Field(&FillUpdate::delta_qty, 5_qty),
+                        Field(&FillUpdate::price, 101_px),
+                        Field(&FillUpdate::new_status,
+                              OrderStatus::PARTIALLY_FILLED)),
+                  AllOf(Field(&FillUpdate::delta_qty, 1_qty),
+                        Field(&FillUpdate::price, 102_px),
+                        Field(&FillUpdate::new_status, OrderStatus::FILLED)))))
+      .WillOnce(Return(std::monostate{}));
+  auto manager = create();
+
+  // Filled according to the journal, so it is no longer mapped
+  v1::CancelSignal cancel;
+  cancel.set_order_id("L1");
+  EXPECT_CALL(*gw, cancel_order(_)).Times(0);
+  EXPECT_FALSE(manager->processSignal(cancel).has_value());
+}
+
+TEST_F(RecoveryFixture, ReplaysEveryJournaledFillWithoutSnapshot) {
+  // Capture what a first run journals for a fill...
+  std::vector<LogEntry> logged;
+  {
+    auto first_gw = std::make_unique<NiceMock<MockExecutionGateway>>();
+    auto first_jn = std::make_unique<NiceMock<MockJournal>>();
+    auto first_os = std::make_unique<NiceMock<MockOrderStore>>();
+    auto open = test::make_stored_order("L1", "AAPL", v1::Side::SELL, 5.0,
+                                        OrderStatus::SUBMITTED, "B1");
+    ON_CALL(*first_os, get_open_orders())
+        .WillByDefault(Return(std::vector{open}));
+    ON_CALL(*first_os, get_order("L1")).WillByDefault(Return(open));
+    ON_CALL(*first_gw, get_fills())
+        .WillByDefault(Return(std::vector{
+            test::make_fill("B1", "AAPL", v1::Side::SELL, 2.5, 101.25)}));
+    ON_CALL(*first_jn, log(_, _, _))
+        .WillByDefault([&](Event event, const std::string &data,
+                           const std::string &correlation_id) {
+          LogEntry entry;
+          entry.timestamp = LogEntry::now();
+          entry.event_type = event;
+          entry.data = data;
+          entry.correlation_id = correlation_id;
+          logged.push_back(entry);
+        });
+
+    auto first = OrderManager::CreateOrderManager(
+        std::make_unique<PositionKeeper>(), std::move(first_gw),
+        std::move(first_jn), std::move(first_os),
+        std::make_unique<RiskManager>());
+    first->process_fills();
+  }
+
+  // ...and recover from it
+  EXPECT_CALL(*journal, get_history(Timestamp{}, _, _))
+      .WillOnce(Return(logged));
+  auto manager = create();
+
+  auto pos = manager->get_position("AAPL");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), -2.5);
+  EXPECT_DOUBLE_EQ(pos->avg_price(), 101.25);
+}
+
 } // namespace quarcc
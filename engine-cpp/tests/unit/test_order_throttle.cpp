@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+#include <trading/core/order_throttle.h>
+
+#include "helpers/proto_builders.h"
+
+#include <thread>
+#include <vector>
+
+namespace quarcc {
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+static const Clock::time_point kStart = Clock::time_point{} + 1h;
+
+TEST(RateLimiterTest, ZeroRateIsUnlimited) {
+  RateLimiter limiter({});
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_TRUE(limiter.try_acquire(kStart));
+}
+
+TEST(RateLimiterTest, AllowsBurstThenRefillsAtRate) {
+  RateLimiter limiter({.per_second = 10, .burst = 3});
+  EXPECT_TRUE(limiter.try_acquire(kStart));
+  EXPECT_TRUE(limiter.try_acquire(kStart));
+  EXPECT_TRUE(limiter.try_acquire(kStart));
+  EXPECT_FALSE(limiter.try_acquire(kStart));
+
+  // One token every 100 ms
+  EXPECT_FALSE(limiter.try_acquire(kStart + 99ms));
+  EXPECT_TRUE(limiter.try_acquire(kStart + 100ms));
+  EXPECT_FALSE(limiter.try_acquire(kStart + 100ms));
+
+  // Idle long enough and the full burst is back, but no more
+  int granted = 0;
+  while (limiter.try_acquire(kStart + 10s))
+    ++granted;
+  EXPECT_EQ(granted, 3);
+}
+
+TEST(RateLimiterTest, RefundGivesTheTokenBack) {
+  RateLimiter limiter({.per_second = 10, .burst = 1});
+  EXPECT_TRUE(limiter.try_acquire(kStart));
+  limiter.refund();
+  EXPECT_TRUE(limiter.try_acquire(kStart));
+  EXPECT_FALSE(limiter.try_acquire(kStart));
+}
+
+TEST(RateLimiterTest, ConcurrentCallersNeverExceedTheBurst) {
+  RateLimiter limiter({.per_second = 1, .burst = 100});
+  std::atomic<int> granted{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i)
+        if (limiter.try_acquire(kStart))
+          ++granted;
+    });
+  for (auto &t : threads)
+    t.join();
+  EXPECT_EQ(granted.load(), 100);
+}
+
+TEST(ReplaceRatioWindowTest, LimitsReplacesPerOrder) {
+  ReplaceRatioWindow window;
+  for (int i = 0; i < 4; ++i)
+    window.record_order(kStart);
+
+  // 2 per order plus an allowance of 1: nine replaces
+  int replaces = 0;
+  while (window.try_replace(kStart + 50ms, 2.0, 1))
+    ++replaces;
+  EXPECT_EQ(replaces, 9);
+}
+
+TEST(ReplaceRatioWindowTest, OldSlotsAgeOut) {
+  ReplaceRatioWindow window;
+  window.record_order(kStart);
+  EXPECT_TRUE(window.try_replace(kStart, 1.0, 0));
+  EXPECT_FALSE(window.try_replace(kStart + 500ms, 1.0, 0));
+
+  // A second later neither the order nor the replace counts
+  EXPECT_FALSE(window.try_replace(kStart + 1100ms, 1.0, 0));
+  window.record_order(kStart + 1100ms);
+  EXPECT_TRUE(window.try_replace(kStart + 1100ms, 1.0, 0));
+}
+
+struct OrderThrottleTest : public testing::Test {
+  SymbolTable symbols;
+
+  // Symbols already traded; others share the unknown-symbol bucket
+  void SetUp() override {
+    for (const char *symbol : {"AAPL", "MSFT", "GOOG"})
+      symbols.intern(symbol);
+  }
+
+  static v1::ReplaceSignal replace(const std::string &symbol = "AAPL") {
+    v1::ReplaceSignal signal;
+    signal.set_strategy_id("TEST");
+    signal.set_symbol(symbol);
+    signal.set_order_id("ORD_1");
+    return signal;
+  }
+  static v1::CancelSignal cancel() {
+    v1::CancelSignal signal;
+    signal.set_strategy_id("TEST");
+    signal.set_order_id("ORD_1");
+    return signal;
+  }
+};
+
+TEST_F(OrderThrottleTest, DefaultConfigThrottlesNothing) {
+  OrderThrottle throttle({}, symbols);
+  throttle.add_strategy("TEST");
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(throttle.check(test::make_signal(), kStart));
+    EXPECT_TRUE(throttle.check(replace(), kStart));
+    EXPECT_TRUE(throttle.check(cancel(), kStart));
+  }
+}
+
+TEST_F(OrderThrottleTest, StrategyOrderRateCoversEverySymbol) {
+  ThrottleConfig config;
+  config.per_strategy.orders = {.per_second = 1, .burst = 2};
+  OrderThrottle throttle(config, symbols);
+  throttle.add_strategy("TEST");
+
+  EXPECT_TRUE(throttle.check(test::make_signal("TEST", "AAPL"), kStart));
+  EXPECT_TRUE(throttle.check(test::make_signal("TEST", "MSFT"), kStart));
+  auto r = throttle.check(test::make_signal("TEST", "GOOG"), kStart);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().type_, ErrorType::Throttled);
+  EXPECT_EQ(r.error().message_, "Throttled: strategy TEST over 1 orders/s");
+
+  // Replaces draw from the same budget
+  EXPECT_FALSE(throttle.check(replace(), kStart));
+  EXPECT_TRUE(throttle.check(replace(), kStart + 1s));
+
+  // Other strategies have their own
+  throttle.add_strategy("OTHER");
+  EXPECT_TRUE(throttle.check(test::make_signal("OTHER"), kStart + 1s));
+}
+
+TEST_F(OrderThrottleTest, SymbolOrderRateIsSharedAcrossStrategies) {
+  ThrottleConfig config;
+  config.per_symbol.orders = {.per_second = 2.5, .burst = 1};
+  OrderThrottle throttle(config, symbols);
+  throttle.add_strategy("A");
+  throttle.add_strategy("B");
+
+  EXPECT_TRUE(throttle.check(test::make_signal("A", "AAPL"), kStart));
+  auto r = throttle.check(test::make_signal("B", "AAPL"), kStart);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "Throttled: AAPL over 2.5 orders/s");
+  EXPECT_TRUE(throttle.check(test::make_signal("B", "MSFT"), kStart));
+  EXPECT_TRUE(throttle.check(test::make_signal("B", "AAPL"), kStart + 400ms));
+}
+
+TEST_F(OrderThrottleTest, CancelRateIsPerStrategy) {
+  ThrottleConfig config;
+  config.per_strategy.cancels = {.per_second = 1, .burst = 1};
+  OrderThrottle throttle(config, symbols);
+  throttle.add_strategy("TEST");
+
+  EXPECT_TRUE(throttle.check(cancel(), kStart));
+  auto r = throttle.check(cancel(), kStart);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "Throttled: strategy TEST over 1 cancels/s");
+  EXPECT_TRUE(throttle.check(test::make_signal(), kStart)); // orders unaffected
+}
+
+TEST_F(OrderThrottleTest, ReplaceRatio) {
+  ThrottleConfig config;
+  config.per_strategy.max_replace_ratio = 1.0;
+  config.per_strategy.replace_allowance = 0;
+  OrderThrottle throttle(config, symbols);
+  throttle.add_strategy("TEST");
+
+  EXPECT_FALSE(throttle.check(replace(), kStart));
+  EXPECT_TRUE(throttle.check(test::make_signal(), kStart));
+  EXPECT_TRUE(throttle.check(replace(), kStart));
+  auto r = throttle.check(replace(), kStart);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_,
+            "Throttled: strategy TEST over 1 replaces per order");
+}
+
+TEST_F(OrderThrottleTest, MessagesRefusedPerSymbolCostTheStrategyNothing) {
+  ThrottleConfig config;
+  config.per_strategy.orders = {.per_second = 1, .burst = 2};
+  config.per_symbol.orders = {.per_second = 1, .burst = 1};
+  OrderThrottle throttle(config, symbols);
+  throttle.add_strategy("TEST");
+
+  EXPECT_TRUE(throttle.check(test::make_signal("TEST", "AAPL"), kStart));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FALSE(throttle.check(test::make_signal("TEST", "AAPL"), kStart));
+    EXPECT_FALSE(throttle.check(replace("AAPL"), kStart));
+  }
+  EXPECT_TRUE(throttle.check(test::make_signal("TEST", "MSFT"), kStart));
+}
+
+TEST_F(OrderThrottleTest, ReplacesRefusedByRatioCostNoOrderTokens) {
+  ThrottleConfig config;
+  config.per_strategy.orders = {.per_second = 1, .burst = 1};
+  config.per_symbol.max_replace_ratio = 1.0;
+  config.per_symbol.replace_allowance = 0;
+  OrderThrottle throttle(config, symbols);
+  throttle.add_strategy("TEST");
+
+  auto r = throttle.check(replace("AAPL"), kStart);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "Throttled: AAPL over 1 replaces per order");
+  EXPECT_TRUE(throttle.check(test::make_signal("TEST", "AAPL"), kStart));
+}
+
+TEST_F(OrderThrottleTest, UnregisteredStrategiesAreOnlyLimitedPerSymbol) {
+  ThrottleConfig config;
+  config.per_strategy.orders = {.per_second = 1, .burst = 1};
+  config.per_symbol.orders = {.per_second = 1, .burst = 2};
+  OrderThrottle throttle(config, symbols);
+
+  EXPECT_TRUE(throttle.check(test::make_signal("X"), kStart));
+  EXPECT_TRUE(throttle.check(test::make_signal("X"), kStart));
+  EXPECT_FALSE(throttle.check(test::make_signal("X"), kStart));
+}
+
+TEST_F(OrderThrottleTest, UnknownSymbolsShareOneBucketAndAreNotInterned) {
+  ThrottleConfig config;
+  config.per_symbol.orders = {.per_second = 1, .burst = 2};
+  OrderThrottle throttle(config, symbols);
+  throttle.add_strategy("TEST");
+
+  EXPECT_TRUE(throttle.check(test::make_signal("TEST", "NEW1"), kStart));
+  EXPECT_TRUE(throttle.check(test::make_signal("TEST", "NEW2"), kStart));
+  auto r = throttle.check(test::make_signal("TEST", "NEW3"), kStart);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "Throttled: NEW3 over 1 orders/s");
+  EXPECT_FALSE(throttle.check(replace("NEW4"), kStart));
+
+  // Known symbols keep their own budget
+  EXPECT_TRUE(throttle.check(test::make_signal("TEST", "AAPL"), kStart));
+  EXPECT_EQ(symbols.size(), 3u);
+  EXPECT_FALSE(symbols.find("NEW1"));
+}
+
+} // namespace quarcc
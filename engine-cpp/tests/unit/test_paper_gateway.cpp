@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <trading/core/mark_price_cache.h>
+#include <trading/gateways/paper_trading_gateway.h>
+
+#include "helpers/proto_builders.h"
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+using namespace std::chrono_literals;
+using test::make_order;
+
+inline v1::Order limit_order(v1::Side side, double qty, double price) {
+  v1::Order order = make_order("ORD", "PAPER_TEST", side, qty);
+  order.set_type(v1::LIMIT);
+  order.set_price(price);
+  return order;
+}
+
+struct PaperGatewayTest : public testing::Test {
+  SymbolTable symbols;
+  PaperGateway gateway{PaperGatewayOptions{.venue = {},
+                                           .reference_prices = {
+                                               {"PAPER_TEST", 150_px}}},
+                       symbols};
+};
+
+TEST_F(PaperGatewayTest, MarketOrderFillsAtQuotedPrice) {
+  int notified = 0;
+  ASSERT_TRUE(gateway.set_fill_listener([&] { ++notified; }));
+
+  auto id = gateway.submit_order(make_order("ORD", "PAPER_TEST", v1::BUY, 10));
+  ASSERT_TRUE(id);
+  EXPECT_EQ(notified, 1);
+
+  const auto fills = gateway.get_fills();
+  ASSERT_EQ(fills.size(), 1u);
+  EXPECT_EQ(fills[0].broker_order_id(), *id);
+  EXPECT_EQ(fills[0].symbol(), "PAPER_TEST");
+  EXPECT_EQ(fills[0].side(), v1::BUY);
+  EXPECT_DOUBLE_EQ(fills[0].filled_quantity(), 10.0);
+  EXPECT_DOUBLE_EQ(fills[0].avg_fill_price(), 150.01);
+  EXPECT_FALSE(fills[0].execution_id().empty());
+  EXPECT_TRUE(gateway.get_fills().empty());
+
+  // Filled orders can no longer be cancelled
+  EXPECT_FALSE(gateway.cancel_order(*id));
+}
+
+TEST_F(PaperGatewayTest, RestingLimitCanBeCancelledOnce) {
+  auto id = gateway.submit_order(limit_order(v1::BUY, 5, 149.0));
+  ASSERT_TRUE(id);
+  EXPECT_TRUE(gateway.get_fills().empty());
+
+  EXPECT_TRUE(gateway.cancel_order(*id));
+  EXPECT_TRUE(gateway.get_fills().empty());
+  EXPECT_FALSE(gateway.cancel_order(*id));
+}
+
+TEST_F(PaperGatewayTest, ReplaceCancelsOldOrderAndSubmitsNew) {
+  auto old_id = gateway.submit_order(limit_order(v1::SELL, 5, 151.0));
+  ASSERT_TRUE(old_id);
+
+  auto new_id = gateway.replace_order(*old_id, limit_order(v1::SELL, 5, 150.0));
+  ASSERT_TRUE(new_id);
+  EXPECT_NE(*new_id, *old_id);
+  EXPECT_FALSE(gateway.cancel_order(*old_id));
+
+  // The replacement is now the best offer
+  gateway.submit_order(make_order("ORD", "PAPER_TEST", v1::BUY, 2));
+  const auto fills = gateway.get_fills();
+  ASSERT_EQ(fills.size(), 2u);
+  EXPECT_EQ(fills[1].broker_order_id(), *new_id);
+  EXPECT_DOUBLE_EQ(fills[1].avg_fill_price(), 150.0);
+}
+
+TEST_F(PaperGatewayTest, RefusesUnknownIdsAndBadOrders) {
+  EXPECT_FALSE(gateway.cancel_order("not-an-id"));
+  EXPECT_FALSE(gateway.replace_order("0000000000000",
+                                     limit_order(v1::BUY, 1, 150.0)));
+
+  auto bad = make_order("ORD", "PAPER_TEST", v1::BUY, 1);
+  bad.set_type(v1::LIMIT);
+  const auto result = gateway.submit_order(bad);
+  ASSERT_FALSE(result);
+  EXPECT_EQ(result.error().type_, ErrorType::FailedOrder);
+}
+
+TEST_F(PaperGatewayTest, RefusesSymbolsMissingFromTheTable) {
+  const auto result =
+      gateway.submit_order(make_order("ORD", "NOT_LISTED", v1::BUY, 1));
+  ASSERT_FALSE(result);
+  EXPECT_EQ(result.error().message_, "Unknown symbol NOT_LISTED");
+  EXPECT_FALSE(symbols.find("NOT_LISTED"));
+}
+
+TEST(PaperGateway, DoesNotPushWhenTheVenueMovesOnItsOwn) {
+  SymbolTable symbols;
+  PaperGatewayOptions options;
+  options.venue.order_latency.base = 1ms;
+  PaperGateway gateway{options, symbols};
+
+  EXPECT_FALSE(gateway.set_fill_listener([] {}));
+}
+
+TEST(PaperGateway, ReportsFillPricesToOnPrice) {
+  SymbolTable symbols;
+  MarkPriceCache marks;
+  PaperGateway gateway{
+      PaperGatewayOptions{.venue = {},
+                          .reference_prices = {{"PAPER_TEST", 150_px}},
+                          .on_price = [&](SymbolId symbol, Price price) {
+                            marks.update(symbol, price);
+                          }},
+      symbols};
+
+  ASSERT_TRUE(gateway.submit_order(make_order("ORD", "PAPER_TEST", v1::BUY,
+                                              10)));
+  const SymbolId symbol = *symbols.find("PAPER_TEST");
+  EXPECT_FALSE(marks.get(symbol)); // not until the fill is reported
+
+  ASSERT_EQ(gateway.get_fills().size(), 1u);
+  EXPECT_EQ(marks.get(symbol), 150.01_px);
+}
+
+} // namespace quarcc
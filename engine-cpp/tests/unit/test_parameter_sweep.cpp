@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <trading/backtest/parameter_sweep.h>
+#include <trading/persistence/sqlite_journal.h>
+#include <trading/persistence/sqlite_order_store.h>
+
+#include "helpers/proto_builders.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+using test::make_signal;
+
+namespace {
+
+constexpr std::int64_t kOpen = 1704205800000000000; // 2024-01-02T14:30:00Z
+
+// Buys `size` when flat and sells once the mid is `target` above the entry
+struct ProfitTarget {
+  double target;
+  double size = 10;
+
+  void operator()(BacktestDriver &driver, const TickRecord &tick,
+                  SymbolId symbol) const {
+    if (tick.kind != TickKind::Quote)
+      return;
+    const double mid = (tick.bid().to_double() + tick.ask().to_double()) / 2;
+    const auto position = driver.positions().getPosition(symbol);
+    const bool flat = !position || position->quantity() == 0;
+    if (!flat && mid < position->avg_price() + target - 1e-9)
+      return;
+    driver.submit(
+        make_signal("BACKTEST", "SW", flat ? v1::BUY : v1::SELL, size));
+  }
+};
+
+} // namespace
+
+struct ParameterSweepTest : public testing::Test {
+  std::filesystem::path path;
+  std::shared_ptr<const TickFile> ticks;
+
+  void SetUp() override {
+    const auto *info = testing::UnitTest::GetInstance()->current_test_info();
+    path = std::filesystem::path(testing::TempDir()) /
+           (std::string("sweep_") + info->name() + ".bin");
+
+    // A slow saw-tooth a penny either side of the mid
+    TickFileWriter writer;
+    std::int64_t t = kOpen;
+    for (int i = 0; i < 400; ++i) {
+      const double mid = 100.0 + 0.05 * (i % 8) - 0.02 * (i % 5);
+      writer.add_quote(t, "SW", Price::from_double(mid - 0.01), 100_qty,
+                       Price::from_double(mid + 0.01), 100_qty);
+      t += 1'000'000;
+    }
+    writer.write(path);
+    ticks = std::make_shared<const TickFile>(path);
+  }
+
+  void TearDown() override {
+    ticks.reset();
+    std::filesystem::remove(path);
+  }
+
+  static std::vector<SweepRun> grid() {
+    std::vector<SweepRun> runs;
+    for (double target : {0.02, 0.05, 0.10, 0.15, 0.20, 0.30})
+      runs.push_back({"target=" + std::to_string(target).substr(0, 4),
+                      ProfitTarget{target},
+                      {}});
+    return runs;
+  }
+};
+
+TEST_F(ParameterSweepTest, MatchesSeparateRunsOnSQLiteBackends) {
+  const auto results = run_sweep(ticks, grid(), {.threads = 3});
+  const auto runs = grid();
+  ASSERT_EQ(results.size(), runs.size());
+
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    SymbolTable symbols;
+    SimulatedClock clock;
+    BacktestDriver driver{ticks,
+                          clock,
+                          std::make_unique<SQLiteJournal>(
+                              ":memory:", JournalOptions{}, clock),
+                          std::make_unique<SQLiteOrderStore>(":memory:", clock),
+                          runs[i].strategy,
+                          {},
+                          symbols};
+    const auto stats = driver.run();
+
+    const auto &result = results[i];
+    EXPECT_EQ(result.name, runs[i].name);
+    EXPECT_TRUE(result.error.empty()) << result.error;
+    EXPECT_EQ(result.stats.ticks, 400u);
+    EXPECT_EQ(result.stats.orders, stats.orders) << result.name;
+    EXPECT_EQ(result.stats.fills, stats.fills) << result.name;
+    EXPECT_EQ(result.pnl, driver.pnl()) << result.name;
+    EXPECT_EQ(result.volume, Quantity::from_double(10.0 * stats.fills))
+        << result.name;
+  }
+  // The grid is wide enough to tell the parameters apart
+  EXPECT_NE(results.front().stats.fills, results.back().stats.fills);
+}
+
+TEST_F(ParameterSweepTest, ResultsDoNotDependOnThreadCount) {
+  const auto serial = run_sweep(ticks, grid(), {.threads = 1});
+  const auto parallel = run_sweep(ticks, grid(), {.threads = 4});
+
+  ASSERT_EQ(serial.size(), parallel.size());
+  for (std::size_t i = 0; i < serial.size(); ++i) {
+    EXPECT_EQ(serial[i].name, parallel[i].name);
+    EXPECT_EQ(serial[i].stats.orders, parallel[i].stats.orders);
+    EXPECT_EQ(serial[i].stats.fills, parallel[i].stats.fills);
+    EXPECT_EQ(serial[i].volume, parallel[i].volume);
+    EXPECT_EQ(serial[i].pnl, parallel[i].pnl);
+  }
+}
+
+TEST_F(ParameterSweepTest, AFailingRunDoesNotStopTheOthers) {
+  auto runs = grid();
+  runs.insert(runs.begin() + 1,
+              {"broken",
+               [](BacktestDriver &driver, const TickRecord &, SymbolId) {
+                 if (driver.stats().ticks == 10)
+                   throw std::runtime_error("strategy failed");
+               },
+               {}});
+
+  const auto results = run_sweep(ticks, std::move(runs));
+  ASSERT_EQ(results.size(), 7u);
+  EXPECT_EQ(results[1].name, "broken");
+  EXPECT_EQ(results[1].error, "strategy failed");
+  EXPECT_EQ(results[1].stats.ticks, 10u);
+  for (std::size_t i : {0u, 2u, 6u}) {
+    EXPECT_TRUE(results[i].error.empty()) << results[i].name;
+    EXPECT_EQ(results[i].stats.ticks, 400u);
+  }
+}
+
+TEST_F(ParameterSweepTest, SummaryTableHasARowPerRun) {
+  SweepResult result;
+  result.name = "fast";
+  result.stats = {.ticks = 400, .orders = 12, .rejected = 1, .fills = 11};
+  result.pnl = -1.5_money;
+  result.volume = 110_qty;
+  result.error = "halted";
+
+  const auto table = format_sweep_table({result});
+  const auto newline = table.find('\n');
+  ASSERT_NE(newline, std::string::npos);
+  const auto header = table.substr(0, newline);
+  const auto row = table.substr(newline + 1);
+  EXPECT_EQ(header.rfind("run ", 0), 0u);
+  EXPECT_NE(header.find("pnl"), std::string::npos);
+  EXPECT_EQ(row.rfind("fast", 0), 0u);
+  EXPECT_NE(row.find("  400  "), std::string::npos);
+  EXPECT_NE(row.find("  110  "), std::string::npos);
+  EXPECT_NE(row.find("-1.50"), std::string::npos);
+  EXPECT_NE(row.find("halted\n"), std::string::npos);
+}
+
+} // namespace quarcc
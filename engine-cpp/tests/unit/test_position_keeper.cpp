@@ -1,18 +1,30 @@
 #include <gtest/gtest.h>
 #include <trading/core/position_keeper.h>
 
+#include <atomic>
+#include <string>
+#include <thread>
+
 namespace quarcc {
 
+using namespace fixed_point_literals;
+
 // ---- helpers ----
 
+static SymbolId id(const std::string &sym) {
+  return SymbolTable::global().intern(sym);
+}
+
 static void buy(PositionKeeper &pk, const std::string &sym, double qty,
                 double price) {
-  pk.on_fill(sym, qty, price, v1::Side::BUY);
+  pk.on_fill(id(sym), Quantity::from_double(qty), Price::from_double(price),
+             v1::Side::BUY);
 }
 
 static void sell(PositionKeeper &pk, const std::string &sym, double qty,
                  double price) {
-  pk.on_fill(sym, qty, price, v1::Side::SELL);
+  pk.on_fill(id(sym), Quantity::from_double(qty), Price::from_double(price),
+             v1::Side::SELL);
 }
 
 // ---- tests ----
@@ -79,7 +91,7 @@ TEST(PositionKeeper, SellBeyondFlatFlipsToShort) {
 
 TEST(PositionKeeper, ZeroFillQtyIsIgnored) {
   PositionKeeper pk;
-  pk.on_fill("AAPL", 0.0, 150.0, v1::Side::BUY);
+  pk.on_fill(id("AAPL"), 0_qty, 150_px, v1::Side::BUY);
   EXPECT_FALSE(pk.getPosition("AAPL").has_value());
 }
 
@@ -87,7 +99,7 @@ TEST(PositionKeeper, ZeroFillPriceUpdatesQtyOnly) {
   PositionKeeper pk;
   buy(pk, "AAPL", 10.0, 150.0);
   // Paper gateway may omit price; qty should update, avg must not change
-  pk.on_fill("AAPL", 5.0, 0.0, v1::Side::BUY);
+  pk.on_fill(id("AAPL"), 5_qty, 0_px, v1::Side::BUY);
 
   auto pos = pk.getPosition("AAPL");
   ASSERT_TRUE(pos.has_value());
@@ -114,4 +126,130 @@ TEST(PositionKeeper, ShortPositionFromScratch) {
   EXPECT_DOUBLE_EQ(pos->avg_price(), 200.0);
 }
 
+TEST(PositionKeeper, RestorePositionOverwritesValue) {
+  PositionKeeper pk;
+  buy(pk, "AAPL", 10.0, 150.0);
+  pk.restore_position(id("AAPL"), -3_qty, 90_px);
+  pk.restore_position(id("MSFT"), 7_qty, 300_px);
+
+  auto pos = pk.getPosition("AAPL");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), -3.0);
+  EXPECT_DOUBLE_EQ(pos->avg_price(), 90.0);
+  EXPECT_EQ(pk.getAllPositions().positions_size(), 2);
+}
+
+TEST(PositionKeeper, LookupByIdMatchesLookupByName) {
+  PositionKeeper pk;
+  buy(pk, "NVDA", 4.0, 500.0);
+
+  auto by_id = pk.getPosition(id("NVDA"));
+  ASSERT_TRUE(by_id.has_value());
+  EXPECT_EQ(by_id->symbol(), "NVDA");
+  EXPECT_DOUBLE_EQ(by_id->quantity(), 4.0);
+
+  // Unknown names are not interned by a read
+  const auto interned = SymbolTable::global().size();
+  EXPECT_FALSE(pk.getPosition("NEVER_SEEN_SYMBOL").has_value());
+  EXPECT_EQ(SymbolTable::global().size(), interned);
+}
+
+TEST(PositionKeeper, ManySymbolsSpanSeveralChunks) {
+  PositionKeeper pk;
+  for (int i = 0; i < 3000; ++i)
+    buy(pk, "SYM" + std::to_string(i), i + 1.0, 10.0);
+
+  EXPECT_EQ(pk.getAllPositions().positions_size(), 3000);
+  for (int i = 0; i < 3000; ++i) {
+    auto pos = pk.getPosition("SYM" + std::to_string(i));
+    ASSERT_TRUE(pos.has_value()) << i;
+    EXPECT_DOUBLE_EQ(pos->quantity(), i + 1.0);
+  }
+}
+
+TEST(PositionKeeper, ConcurrentReadersSeeConsistentPositions) {
+  PositionKeeper pk;
+  std::atomic<bool> done{false};
+  std::atomic<int> inconsistent{0};
+
+  // Every fill is 1 @ 100, so avg stays 100 while qty > 0
+  std::thread reader([&] {
+    while (!done.load(std::memory_order_acquire)) {
+      const auto all = pk.getAllPositions();
+      for (const auto &pos : all.positions())
+        if (pos.quantity() > 0.0 && pos.avg_price() != 100.0)
+          inconsistent.fetch_add(1);
+      if (auto pos = pk.getPosition("SYM0");
+          pos && pos->quantity() > 0.0 && pos->avg_price() != 100.0)
+        inconsistent.fetch_add(1);
+    }
+  });
+
+  for (int round = 0; round < 200; ++round)
+    for (int s = 0; s < 100; ++s)
+      buy(pk, "SYM" + std::to_string(s), 1.0, 100.0);
+  done.store(true, std::memory_order_release);
+  reader.join();
+
+  EXPECT_EQ(inconsistent.load(), 0);
+  auto pos = pk.getPosition("SYM99");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), 200.0);
+}
+
+TEST(PositionKeeper, ReducingFillRealizesPnl) {
+  PositionKeeper pk;
+  buy(pk, "PNL1", 10.0, 100.0);
+  sell(pk, "PNL1", 4.0, 110.0); // closes 4 at +10
+
+  auto pos = pk.getPosition("PNL1");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->realized_pnl(), 40.0);
+
+  buy(pk, "PNL1", 5.0, 90.0); // adding never realizes
+  EXPECT_DOUBLE_EQ(pk.getPosition("PNL1")->realized_pnl(), 40.0);
+}
+
+TEST(PositionKeeper, FlipRealizesOnlyTheClosedQuantity) {
+  PositionKeeper pk;
+  sell(pk, "PNL2", 5.0, 100.0);
+  buy(pk, "PNL2", 8.0, 90.0); // covers 5 short at +10, opens 3 long @ 90
+
+  auto pos = pk.getPosition("PNL2");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), 3.0);
+  EXPECT_DOUBLE_EQ(pos->avg_price(), 90.0);
+  EXPECT_DOUBLE_EQ(pos->realized_pnl(), 50.0);
+}
+
+TEST(PositionKeeper, UnrealizedPnlUsesTheMarkCache) {
+  SymbolTable symbols;
+  MarkPriceCache marks;
+  PositionKeeper pk{nullptr, &marks, symbols};
+  const SymbolId aapl = symbols.intern("AAPL");
+
+  pk.on_fill(aapl, 10_qty, 100_px, v1::Side::BUY);
+  EXPECT_DOUBLE_EQ(pk.getPosition(aapl)->unrealized_pnl(), 0.0); // no mark
+
+  marks.update(aapl, 104.5_px);
+  EXPECT_DOUBLE_EQ(pk.getPosition(aapl)->unrealized_pnl(), 45.0);
+
+  pk.on_fill(aapl, 20_qty, 101_px, v1::Side::SELL); // now short 10 @ 101
+  EXPECT_DOUBLE_EQ(pk.getPosition(aapl)->unrealized_pnl(), -35.0);
+  EXPECT_DOUBLE_EQ(pk.getPosition(aapl)->realized_pnl(), 10.0);
+}
+
+TEST(PositionKeeper, ManySmallFillsDoNotDrift) {
+  PositionKeeper pk;
+  for (int i = 0; i < 1000; ++i)
+    buy(pk, "DRIFT", 0.1, 10.1);
+  sell(pk, "DRIFT", 100.0, 10.1);
+
+  auto pos = pk.getPosition("DRIFT");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_EQ(pos->quantity(), 0.0); // exactly flat, not 1e-12
+  EXPECT_EQ(pos->avg_price(), 0.0);
+  EXPECT_EQ(pos->realized_pnl(), 0.0);
+}
+
 } // namespace quarcc
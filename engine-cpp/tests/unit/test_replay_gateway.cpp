@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <trading/gateways/replay_gateway.h>
+
+#include "helpers/proto_builders.h"
+
+#include <filesystem>
+#include <vector>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+using namespace std::chrono_literals;
+using test::make_order;
+
+constexpr std::int64_t kOpen = 1704205800000000000; // 2024-01-02T14:30:00Z
+
+struct ReplayGatewayTest : public testing::Test {
+  std::filesystem::path path;
+  SymbolTable symbols;
+  std::vector<std::pair<SymbolId, Price>> prices;
+
+  void SetUp() override {
+    const auto *info = testing::UnitTest::GetInstance()->current_test_info();
+    path = std::filesystem::path(testing::TempDir()) /
+           (std::string("replay_") + info->name() + ".bin");
+
+    TickFileWriter writer;
+    writer.add_quote(kOpen, "AAPL", 100_px, 10_qty, 100.02_px, 10_qty);
+    writer.add_trade(kOpen + 1'000'000, "AAPL", 100.01_px, 5_qty);
+    writer.add_quote(kOpen + 2'000'000, "AAPL", 99.9_px, 10_qty, 99.95_px,
+                     10_qty);
+    writer.add_trade(kOpen + 3'000'000, "AAPL", 99.9_px, 50_qty);
+    writer.write(path);
+  }
+
+  void TearDown() override { std::filesystem::remove(path); }
+
+  ReplayGateway make_gateway() {
+    ReplayGatewayOptions options;
+    options.on_price = [this](SymbolId symbol, Price price) {
+      prices.emplace_back(symbol, price);
+    };
+    return ReplayGateway{std::make_shared<const TickFile>(path),
+                         std::move(options), symbols};
+  }
+
+  static v1::Order limit_order(v1::Side side, double qty, double price) {
+    v1::Order order = make_order("ORD", "AAPL", side, qty);
+    order.set_type(v1::LIMIT);
+    order.set_time_in_force(v1::GTC);
+    order.set_price(price);
+    return order;
+  }
+};
+
+TEST_F(ReplayGatewayTest, ClockMovesOnlyWithTheReplay) {
+  auto gateway = make_gateway();
+  EXPECT_EQ(gateway.time(), VenueTime{kOpen});
+  EXPECT_EQ(gateway.next_time(), VenueTime{kOpen});
+
+  EXPECT_TRUE(gateway.step());
+  EXPECT_EQ(gateway.time(), VenueTime{kOpen});
+  EXPECT_EQ(gateway.replay_until(VenueTime{kOpen} + 2500us), 2u);
+  EXPECT_EQ(gateway.time(), VenueTime{kOpen} + 2500us);
+  EXPECT_EQ(gateway.next_time(), VenueTime{kOpen} + 3ms);
+
+  EXPECT_TRUE(gateway.step());
+  EXPECT_FALSE(gateway.step());
+  EXPECT_TRUE(gateway.done());
+  EXPECT_FALSE(gateway.next_time());
+
+  const SymbolId aapl = symbols.intern("AAPL");
+  ASSERT_EQ(prices.size(), 4u);
+  EXPECT_EQ(prices[0], std::make_pair(aapl, 100.01_px));
+  EXPECT_EQ(prices[1], std::make_pair(aapl, 100.01_px));
+  EXPECT_EQ(prices[2], std::make_pair(aapl, 99.925_px));
+  EXPECT_EQ(prices[3], std::make_pair(aapl, 99.9_px));
+}
+
+TEST_F(ReplayGatewayTest, OneSidedQuotesReportNoMid) {
+  TickFileWriter writer;
+  writer.add_quote(kOpen, "AAPL", 100_px, 10_qty, 100.02_px, 10_qty);
+  writer.add_quote(kOpen + 1'000'000, "AAPL", 100.01_px, 10_qty, Price{},
+                   Quantity{});
+  writer.add_quote(kOpen + 2'000'000, "AAPL", Price{}, Quantity{}, 100.03_px,
+                   10_qty);
+  writer.write(path);
+
+  auto gateway = make_gateway();
+  while (gateway.step()) {
+  }
+
+  EXPECT_EQ(gateway.time(), VenueTime{kOpen} + 2ms);
+  ASSERT_EQ(prices.size(), 1u);
+  EXPECT_EQ(prices[0].second, 100.01_px);
+}
+
+TEST_F(ReplayGatewayTest, MarketOrderFillsAtReplayedQuote) {
+  auto gateway = make_gateway();
+
+  // Nothing to trade with before the first quote
+  auto early = gateway.submit_order(make_order("ORD", "AAPL", v1::BUY, 1));
+  ASSERT_TRUE(early);
+  EXPECT_TRUE(gateway.get_fills().empty());
+
+  int notified = 0;
+  ASSERT_TRUE(gateway.set_fill_listener([&] { ++notified; }));
+  gateway.step();
+  auto id = gateway.submit_order(make_order("ORD", "AAPL", v1::BUY, 4));
+  ASSERT_TRUE(id);
+  EXPECT_EQ(notified, 1);
+
+  const auto fills = gateway.get_fills();
+  ASSERT_EQ(fills.size(), 1u);
+  EXPECT_EQ(fills[0].broker_order_id(), *id);
+  EXPECT_DOUBLE_EQ(fills[0].avg_fill_price(), 100.02);
+  EXPECT_DOUBLE_EQ(fills[0].filled_quantity(), 4.0);
+  EXPECT_EQ(fills[0].fill_time(), "2024-01-02T14:30:00.000000000Z");
+}
+
+TEST_F(ReplayGatewayTest, RestingOrdersFillOnPrintsThroughThem) {
+  auto gateway = make_gateway();
+  int notified = 0;
+  ASSERT_TRUE(gateway.set_fill_listener([&] { ++notified; }));
+  gateway.step();
+
+  auto bid = gateway.submit_order(limit_order(v1::BUY, 20, 99.92));
+  ASSERT_TRUE(bid);
+  EXPECT_TRUE(gateway.get_fills().empty());
+
+  // Inside the 99.9/99.95 quote the bid is not marketable, but the 99.9
+  // print goes through it
+  gateway.replay_until(VenueTime{kOpen} + 3ms);
+  EXPECT_EQ(notified, 1);
+  const auto fills = gateway.get_fills();
+  ASSERT_EQ(fills.size(), 1u);
+  EXPECT_EQ(fills[0].broker_order_id(), *bid);
+  EXPECT_DOUBLE_EQ(fills[0].avg_fill_price(), 99.92);
+  EXPECT_DOUBLE_EQ(fills[0].filled_quantity(), 20.0);
+  EXPECT_EQ(fills[0].fill_time(), "2024-01-02T14:30:00.003000000Z");
+  EXPECT_FALSE(gateway.cancel_order(*bid));
+}
+
+TEST_F(ReplayGatewayTest, StopsTriggerOnReplayedTrades) {
+  auto gateway = make_gateway();
+  gateway.step();
+
+  v1::Order stop = make_order("ORD", "AAPL", v1::SELL, 5);
+  stop.set_type(v1::STOP);
+  stop.set_price(99.97);
+  ASSERT_TRUE(gateway.submit_order(stop));
+
+  // The quote moves the mid below the trigger, but only a trade fires it
+  gateway.step();
+  gateway.step();
+  EXPECT_TRUE(gateway.get_fills().empty());
+  gateway.step();
+  const auto fills = gateway.get_fills();
+  ASSERT_EQ(fills.size(), 1u);
+  EXPECT_DOUBLE_EQ(fills[0].avg_fill_price(), 99.9);
+}
+
+} // namespace quarcc
@@ -0,0 +1,306 @@
+#include <gtest/gtest.h>
+#include <trading/core/risk_manager.h>
+
+#include "helpers/proto_builders.h"
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+
+struct RiskFixture : public testing::Test {
+  SymbolTable symbols;
+  MarkPriceCache marks;
+  AggregatePositionBook book{&marks, symbols};
+  PositionKeeper mine{&book, &marks, symbols};
+  PositionKeeper other{&book, &marks, symbols};
+  SharedRiskLimits limits;
+  RiskManager risk{"ALPHA", limits, &mine, &book, &marks, symbols};
+
+  SymbolId id(const std::string &symbol) { return symbols.intern(symbol); }
+
+  Result<std::monostate> order(const std::string &symbol, v1::Side side,
+                               double qty, double price = 0.0) {
+    auto o = test::make_order("L1", symbol, side, qty);
+    o.set_price(price);
+    return risk.check(o);
+  }
+};
+
+TEST_F(RiskFixture, DefaultLimitsLetEverythingThrough) {
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 1e9));
+  EXPECT_TRUE(order("AAPL", v1::Side::SELL, 1e9));
+}
+
+TEST_F(RiskFixture, ManagerWithoutLimitsLetsEverythingThrough) {
+  RiskManager permissive;
+  EXPECT_TRUE(permissive.check(test::make_order("L1", "AAPL", v1::Side::BUY,
+                                                -5.0)));
+}
+
+TEST_F(RiskFixture, InvalidQuantityIsRejected) {
+  for (double qty : {0.0, -1.0, std::nan(""), 1e300}) {
+    auto r = order("AAPL", v1::Side::BUY, qty);
+    ASSERT_FALSE(r) << qty;
+    EXPECT_EQ(r.error().type_, ErrorType::RiskRejected);
+  }
+}
+
+TEST_F(RiskFixture, MaxOrderQuantityPerSymbol) {
+  RiskLimits l;
+  l.set_symbol(id("AAPL"), {.max_order_quantity = 100_qty});
+  limits.publish(l);
+
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 100));
+  auto r = order("AAPL", v1::Side::SELL, 100.5);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().type_, ErrorType::RiskRejected);
+  EXPECT_EQ(r.error().message_, "Risk check failed for AAPL: order quantity "
+                                "100.5 exceeds limit 100");
+  EXPECT_TRUE(order("MSFT", v1::Side::BUY, 1000)); // default: no limit
+}
+
+TEST_F(RiskFixture, UnknownSymbolsAreCheckedWithoutBeingInterned) {
+  RiskLimits l;
+  l.default_symbol.max_order_quantity = 100_qty;
+  limits.publish(l);
+
+  EXPECT_TRUE(order("NEWCO", v1::Side::BUY, 100));
+  EXPECT_FALSE(order("NEWCO", v1::Side::BUY, 101));
+  EXPECT_FALSE(symbols.find("NEWCO"));
+}
+
+TEST_F(RiskFixture, MaxOrderNotionalUsesLimitPriceThenMark) {
+  RiskLimits l;
+  l.default_symbol.max_order_notional = 10'000_money;
+  limits.publish(l);
+
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 100, 100.0));
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 100, 100.01));
+
+  // Market order: nothing to value it with until a mark arrives
+  auto unpriced = order("AAPL", v1::Side::BUY, 1);
+  ASSERT_FALSE(unpriced);
+  EXPECT_NE(unpriced.error().message_.find("no reference price"),
+            std::string::npos);
+
+  marks.update(id("AAPL"), 250_px);
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 40));
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 41));
+
+  // Fat-finger sizes are refused rather than overflowing
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 1e14, 1e6));
+}
+
+TEST_F(RiskFixture, FirmPositionLimitCountsEveryStrategy) {
+  RiskLimits l;
+  l.default_symbol.max_position = 100_qty;
+  limits.publish(l);
+
+  other.on_fill(id("AAPL"), 80_qty, 10_px, v1::Side::BUY);
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 20));
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 21));
+  EXPECT_TRUE(order("AAPL", v1::Side::SELL, 180)); // to -100
+  EXPECT_FALSE(order("AAPL", v1::Side::SELL, 181));
+}
+
+TEST_F(RiskFixture, StrategyPositionLimitOnlyCountsThisStrategy) {
+  RiskLimits l;
+  l.default_strategy.max_position = 1000_qty;
+  l.strategies["ALPHA"] = {.max_position = 50_qty};
+  limits.publish(l);
+
+  other.on_fill(id("AAPL"), 500_qty, 10_px, v1::Side::BUY);
+  mine.on_fill(id("AAPL"), 30_qty, 10_px, v1::Side::SELL);
+  EXPECT_TRUE(order("AAPL", v1::Side::SELL, 20));
+  EXPECT_FALSE(order("AAPL", v1::Side::SELL, 21));
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 80));
+}
+
+TEST_F(RiskFixture, PositionLimitsCountWorkingOrdersOnTheOrdersSide) {
+  RiskLimits l;
+  l.default_symbol.max_position = 100_qty;
+  l.default_strategy.max_position = 50_qty;
+  limits.publish(l);
+
+  mine.add_working(id("AAPL"), v1::Side::BUY, 40_qty);
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 10));
+  auto r = order("AAPL", v1::Side::BUY, 11);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "Risk check failed for AAPL: strategy "
+                                "position would be 51, limit 50");
+  // Working buys do not offset a sell
+  EXPECT_TRUE(order("AAPL", v1::Side::SELL, 50));
+  EXPECT_FALSE(order("AAPL", v1::Side::SELL, 51));
+
+  other.add_working(id("AAPL"), v1::Side::BUY, 55_qty);
+  r = order("AAPL", v1::Side::BUY, 10);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "Risk check failed for AAPL: firm "
+                                "position would be 105, limit 100");
+}
+
+TEST_F(RiskFixture, ReducingAPositionOverTheLimitIsAllowed) {
+  mine.on_fill(id("AAPL"), 200_qty, 10_px, v1::Side::BUY);
+
+  RiskLimits l;
+  l.default_symbol.max_position = 100_qty;
+  l.default_strategy.max_position = 100_qty;
+  limits.publish(l);
+
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 1));
+  EXPECT_TRUE(order("AAPL", v1::Side::SELL, 50)); // still over, but closer
+  EXPECT_FALSE(order("AAPL", v1::Side::SELL, 450)); // flips to -250
+}
+
+TEST_F(RiskFixture, GrossExposureCap) {
+  RiskLimits l;
+  l.max_gross_exposure = 10'000_money;
+  limits.publish(l);
+
+  marks.update(id("AAPL"), 100_px);
+  marks.update(id("MSFT"), 200_px);
+  other.on_fill(id("AAPL"), 50_qty, 100_px, v1::Side::BUY);  // 5000 long
+  other.on_fill(id("MSFT"), 10_qty, 200_px, v1::Side::SELL); // 2000 short
+
+  EXPECT_EQ(book.exposure().gross, 7'000_money);
+  EXPECT_EQ(book.exposure().net, 3'000_money);
+
+  EXPECT_TRUE(order("MSFT", v1::Side::SELL, 15));  // gross 10000
+  EXPECT_FALSE(order("MSFT", v1::Side::SELL, 16)); // gross 10200
+  EXPECT_TRUE(order("AAPL", v1::Side::SELL, 50));  // flattening reduces it
+}
+
+TEST_F(RiskFixture, NetExposureCap) {
+  RiskLimits l;
+  l.max_net_exposure = 1'000_money;
+  limits.publish(l);
+
+  marks.update(id("AAPL"), 10_px);
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 100));
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 101));
+  EXPECT_FALSE(order("AAPL", v1::Side::SELL, 101));
+
+  other.on_fill(id("AAPL"), 100_qty, 10_px, v1::Side::BUY);
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 1));
+  EXPECT_TRUE(order("AAPL", v1::Side::SELL, 200));
+}
+
+TEST_F(RiskFixture, PublishedLimitsApplyToTheNextCheck) {
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 500));
+
+  RiskLimits strict;
+  strict.default_symbol.max_order_quantity = 10_qty;
+  strict.strategies["ALPHA"] = {.max_position = 5_qty};
+  limits.publish(strict);
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 11));
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 6)); // strategy entry re-resolved
+
+  limits.publish(RiskLimits{});
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 500));
+}
+
+struct AlwaysReject final : IRiskCheck {
+  Result<std::monostate> check(const RiskOrder &,
+                               const RiskContext &) const override {
+    return std::unexpected(Error{"closed", ErrorType::RiskRejected});
+  }
+};
+
+TEST_F(RiskFixture, CustomChecksRunAfterBuiltIns) {
+  risk.add_check(std::make_unique<AlwaysReject>());
+  auto r = order("AAPL", v1::Side::BUY, 1);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "Risk check failed for AAPL: closed");
+}
+
+// Counts its calls; passes unless told to reject
+struct CountingCheck {
+  int *calls;
+  bool pass = true;
+  Result<std::monostate> check(const RiskOrder &, const RiskContext &) const {
+    ++*calls;
+    if (pass)
+      return std::monostate{};
+    return std::unexpected(Error{"counted", ErrorType::RiskRejected});
+  }
+};
+
+TEST_F(RiskFixture, StaticPipelineStopsAtFirstRejection) {
+  int first = 0, second = 0, third = 0;
+  RiskPipeline<CountingCheck, CountingCheck, CountingCheck> pipeline(
+      {&first}, {&second, false}, {&third});
+  const RiskLimits &l = limits.current();
+  RiskContext context{l, l.default_symbol, l.default_strategy, {}, {}, {}, {},
+                      {}};
+
+  auto r = pipeline.check(RiskOrder{}, context);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "counted");
+  EXPECT_EQ(first, 1);
+  EXPECT_EQ(second, 1);
+  EXPECT_EQ(third, 0);
+
+  EXPECT_TRUE(RiskPipeline<>{}.check(RiskOrder{}, context));
+}
+
+TEST_F(RiskFixture, SetChecksReplacesTheDefaultPipeline) {
+  RiskLimits l;
+  l.default_symbol.max_order_quantity = 10_qty;
+  l.default_symbol.max_position = 5_qty;
+  limits.publish(l);
+
+  // Quantity check only: the position limit no longer applies
+  risk.set_checks(std::make_unique<RiskPipeline<MaxOrderQuantityCheck>>());
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 10));
+  EXPECT_FALSE(order("AAPL", v1::Side::BUY, 11));
+
+  // Same checks chosen at runtime
+  auto dynamic = std::make_unique<DynamicRiskPipeline>();
+  dynamic->add(SymbolPositionCheck{});
+  risk.set_checks(std::move(dynamic));
+  EXPECT_TRUE(order("AAPL", v1::Side::BUY, 5));
+  auto r = order("AAPL", v1::Side::BUY, 6);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_,
+            "Risk check failed for AAPL: firm position would be 6, limit 5");
+}
+
+TEST(RiskChecks, SumsThatOverflowAreRejected) {
+  // Limits are left at max() where possible, so only the overflow rejects.
+  // The exposure checks are skipped entirely without a limit.
+  RiskLimits l;
+  l.max_gross_exposure = Money::max() - 1_money;
+  l.max_net_exposure = Money::max() - 1_money;
+  const Quantity near_max = Quantity::max() - 1_qty;
+  const Money rich = Money::max() - 1_money;
+  RiskContext context{l,        l.default_symbol, l.default_strategy,
+                      near_max, near_max,         rich,
+                      rich,     rich};
+
+  RiskOrder order;
+  order.side = v1::Side::BUY;
+  order.quantity = 10_qty;
+  order.reference_price = 1_px;
+
+  auto r = SymbolPositionCheck{}.check(order, context);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "firm position overflows");
+  r = StrategyPositionCheck{}.check(order, context);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "strategy position overflows");
+  r = GrossExposureCheck{}.check(order, context);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "gross exposure overflows");
+  r = NetExposureCheck{}.check(order, context);
+  ASSERT_FALSE(r);
+  EXPECT_EQ(r.error().message_, "net exposure overflows");
+
+  // Selling back down from the edge does not overflow
+  order.side = v1::Side::SELL;
+  EXPECT_TRUE(SymbolPositionCheck{}.check(order, context));
+  EXPECT_TRUE(StrategyPositionCheck{}.check(order, context));
+  EXPECT_TRUE(GrossExposureCheck{}.check(order, context));
+  EXPECT_TRUE(NetExposureCheck{}.check(order, context));
+}
+
+} // namespace quarcc
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <trading/utils/seqlock.h>
+
+#include <thread>
+#include <vector>
+
+namespace quarcc {
+
+namespace {
+struct Triple {
+  std::int64_t a = 0;
+  std::int64_t b = 0;
+  double c = 0.0;
+};
+} // namespace
+
+TEST(Seqlocked, LoadReturnsLastStore) {
+  Seqlocked<Triple> cell;
+  EXPECT_EQ(cell.load().a, 0);
+  EXPECT_EQ(cell.version(), 0u);
+
+  cell.store({1, 2, 3.5});
+  auto v = cell.load();
+  EXPECT_EQ(v.a, 1);
+  EXPECT_EQ(v.b, 2);
+  EXPECT_DOUBLE_EQ(v.c, 3.5);
+  EXPECT_EQ(cell.version(), 1u);
+}
+
+TEST(Seqlocked, ReadersNeverSeeTornValues) {
+  Seqlocked<Triple> cell;
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> readers;
+  std::atomic<int> torn{0};
+  for (int r = 0; r < 3; ++r) {
+    readers.emplace_back([&] {
+      while (!done.load(std::memory_order_acquire)) {
+        auto v = cell.load();
+        if (v.b != -v.a || v.c != static_cast<double>(v.a) * 2)
+          torn.fetch_add(1);
+      }
+    });
+  }
+
+  for (std::int64_t i = 1; i <= 200'000; ++i)
+    cell.store({i, -i, static_cast<double>(i) * 2});
+  done.store(true, std::memory_order_release);
+
+  for (auto &t : readers)
+    t.join();
+  EXPECT_EQ(torn.load(), 0);
+  EXPECT_EQ(cell.load().a, 200'000);
+}
+
+} // namespace quarcc
@@ -0,0 +1,329 @@
+#include <gtest/gtest.h>
+#include <trading/gateways/simulated_venue.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+using namespace std::chrono_literals;
+
+constexpr SymbolId kSymbol = 0;
+
+// Quotes 99/98 and 101/102, 10 each, around a mid of 100
+inline SimulatedVenueOptions small_market() {
+  SimulatedVenueOptions options;
+  options.market.reference_price = 100_px;
+  options.market.tick = 1_px;
+  options.market.levels = 2;
+  options.market.level_size = 10_qty;
+  return options;
+}
+
+inline VenueOrder order(v1::Side side, v1::OrderType type, Quantity quantity,
+                        Price price = {}, v1::TimeInForce tif = v1::DAY) {
+  return VenueOrder{.symbol = kSymbol,
+                    .side = side,
+                    .type = type,
+                    .time_in_force = tif,
+                    .quantity = quantity,
+                    .price = price};
+}
+
+struct SimulatedVenueTest : public testing::Test {
+  SimulatedVenue venue{small_market()};
+  std::uint64_t next_tag = 1;
+
+  VenueOrderId send(const VenueOrder &o, VenueTime now = {}) {
+    auto id = venue.submit(o, next_tag++, now);
+    EXPECT_TRUE(id.has_value());
+    venue.advance(now);
+    return id.value_or(0);
+  }
+
+  std::vector<VenueReport> reports(VenueTime now = VenueTime::max()) {
+    std::vector<VenueReport> out;
+    venue.drain(now, out);
+    return out;
+  }
+};
+
+TEST_F(SimulatedVenueTest, MarketOrderWalksTheBook) {
+  send(order(v1::BUY, v1::MARKET, 15_qty));
+
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_EQ(r[0].kind, VenueReport::Kind::Fill);
+  EXPECT_EQ(r[0].price, 101_px);
+  EXPECT_EQ(r[0].quantity, 10_qty);
+  EXPECT_EQ(r[0].leaves, 5_qty);
+  EXPECT_EQ(r[1].price, 102_px);
+  EXPECT_EQ(r[1].quantity, 5_qty);
+  EXPECT_TRUE(r[1].closes());
+  EXPECT_LT(r[0].execution_id, r[1].execution_id);
+  EXPECT_EQ(venue.last_price(kSymbol), 102_px);
+}
+
+TEST_F(SimulatedVenueTest, ReferencePriceIsTheStartingMidUntilATrade) {
+  venue.set_reference_price(kSymbol + 1, 50_px);
+  EXPECT_EQ(venue.reference_price(kSymbol), 100_px);
+  EXPECT_EQ(venue.reference_price(kSymbol + 1), 50_px);
+  EXPECT_FALSE(venue.last_price(kSymbol + 1));
+
+  send(order(v1::BUY, v1::MARKET, 15_qty));
+  reports();
+  EXPECT_EQ(venue.reference_price(kSymbol), 102_px);
+}
+
+TEST_F(SimulatedVenueTest, MarketRemainderIsCancelled) {
+  const auto id = send(order(v1::SELL, v1::MARKET, 25_qty));
+
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 3u);
+  EXPECT_EQ(r[2].kind, VenueReport::Kind::Cancelled);
+  EXPECT_EQ(r[2].quantity, 5_qty);
+  EXPECT_FALSE(venue.is_open(id));
+}
+
+TEST_F(SimulatedVenueTest, RestingLimitTradesWithLaterOrder) {
+  const auto maker = send(order(v1::SELL, v1::LIMIT, 5_qty, 100_px, v1::GTC));
+  EXPECT_TRUE(reports().empty());
+  EXPECT_EQ(venue.book(kSymbol)->best_ask(), 100_px);
+
+  const auto taker = send(order(v1::BUY, v1::MARKET, 3_qty));
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_EQ(r[0].order, taker);
+  EXPECT_EQ(r[0].price, 100_px);
+  EXPECT_EQ(r[1].order, maker);
+  EXPECT_EQ(r[1].tag, 1u);
+  EXPECT_EQ(r[1].side, v1::SELL);
+  EXPECT_EQ(r[1].leaves, 2_qty);
+  EXPECT_EQ(venue.leaves(maker), 2_qty);
+}
+
+TEST_F(SimulatedVenueTest, MarketableLimitFillsAtBookPrices) {
+  const auto id = send(order(v1::BUY, v1::LIMIT, 15_qty, 101_px));
+
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 1u);
+  EXPECT_EQ(r[0].price, 101_px);
+  EXPECT_EQ(r[0].quantity, 10_qty);
+  // The rest joins the bids at its limit
+  EXPECT_EQ(venue.leaves(id), 5_qty);
+  EXPECT_EQ(venue.book(kSymbol)->best_bid(), 101_px);
+}
+
+TEST_F(SimulatedVenueTest, IocCancelsWhatDoesNotFill) {
+  send(order(v1::BUY, v1::LIMIT, 15_qty, 101_px, v1::IOC));
+
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_EQ(r[0].quantity, 10_qty);
+  EXPECT_EQ(r[1].kind, VenueReport::Kind::Cancelled);
+  EXPECT_EQ(r[1].quantity, 5_qty);
+}
+
+TEST_F(SimulatedVenueTest, FokFillsCompletelyOrNotAtAll) {
+  send(order(v1::BUY, v1::LIMIT, 15_qty, 101_px, v1::FOK));
+  auto r = reports();
+  ASSERT_EQ(r.size(), 1u);
+  EXPECT_EQ(r[0].kind, VenueReport::Kind::Cancelled);
+  EXPECT_EQ(r[0].quantity, 15_qty);
+  EXPECT_EQ(venue.book(kSymbol)->depth(v1::SELL, 101_px), 10_qty);
+
+  send(order(v1::BUY, v1::LIMIT, 15_qty, 102_px, v1::FOK));
+  r = reports();
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_TRUE(r[1].closes());
+  EXPECT_EQ(r[1].kind, VenueReport::Kind::Fill);
+}
+
+TEST_F(SimulatedVenueTest, StopTriggersOnLastTrade) {
+  const auto stop = send(order(v1::BUY, v1::STOP, 5_qty, 101_px));
+  EXPECT_TRUE(reports().empty());
+  EXPECT_TRUE(venue.is_open(stop));
+
+  // Trades at 101, which fires the stop into what is left at 102
+  send(order(v1::BUY, v1::MARKET, 10_qty));
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_EQ(r[1].order, stop);
+  EXPECT_EQ(r[1].price, 102_px);
+  EXPECT_EQ(r[1].quantity, 5_qty);
+  EXPECT_FALSE(venue.is_open(stop));
+}
+
+TEST_F(SimulatedVenueTest, StopLimitRestsWhatItCannotFill) {
+  const auto stop = send(order(v1::SELL, v1::STOP_LIMIT, 15_qty, 99_px));
+  send(order(v1::SELL, v1::MARKET, 5_qty));
+
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_EQ(r[1].order, stop);
+  EXPECT_EQ(r[1].price, 99_px);
+  EXPECT_EQ(r[1].quantity, 5_qty);
+  EXPECT_EQ(venue.leaves(stop), 10_qty);
+  EXPECT_EQ(venue.book(kSymbol)->best_ask(), 99_px);
+}
+
+TEST_F(SimulatedVenueTest, StopAlreadyThroughItsTriggerExecutesOnArrival) {
+  send(order(v1::SELL, v1::STOP, 5_qty, 100_px));
+
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 1u);
+  EXPECT_EQ(r[0].price, 99_px);
+}
+
+TEST_F(SimulatedVenueTest, CancelClosesRestingOrder) {
+  const auto id = send(order(v1::BUY, v1::LIMIT, 5_qty, 97_px));
+  ASSERT_TRUE(venue.cancel(id, {}));
+  venue.advance({});
+
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 1u);
+  EXPECT_EQ(r[0].kind, VenueReport::Kind::Cancelled);
+  EXPECT_EQ(r[0].quantity, 5_qty);
+  EXPECT_EQ(venue.book(kSymbol)->depth(v1::BUY, 97_px), Quantity{});
+  EXPECT_FALSE(venue.cancel(id, {}));
+}
+
+TEST_F(SimulatedVenueTest, EndSessionExpiresDayOrdersOnly) {
+  const auto day = send(order(v1::BUY, v1::LIMIT, 5_qty, 97_px));
+  const auto gtc = send(order(v1::BUY, v1::LIMIT, 5_qty, 97_px, v1::GTC));
+  const auto stop = send(order(v1::BUY, v1::STOP, 5_qty, 110_px));
+
+  venue.end_session({});
+  EXPECT_FALSE(venue.is_open(day));
+  EXPECT_FALSE(venue.is_open(stop));
+  EXPECT_TRUE(venue.is_open(gtc));
+  EXPECT_EQ(reports().size(), 2u);
+}
+
+TEST_F(SimulatedVenueTest, RefusesMalformedOrders) {
+  EXPECT_FALSE(venue.submit(order(v1::BUY, v1::LIMIT, 5_qty), 1, {}));
+  EXPECT_FALSE(venue.submit(order(v1::BUY, v1::MARKET, Quantity{}), 1, {}));
+  EXPECT_FALSE(venue.submit(order(v1::UNKNOWN_SIDE, v1::MARKET, 5_qty), 1, {}));
+  EXPECT_FALSE(
+      venue.submit(order(v1::BUY, v1::UNKNOWN_TYPE, 5_qty, 100_px), 1, {}));
+  EXPECT_EQ(venue.in_flight(), 0u);
+}
+
+TEST_F(SimulatedVenueTest, QuoteReplacesSyntheticLiquidity) {
+  venue.quote(kSymbol, 110_px, 3_qty, 112_px, 4_qty, {});
+  EXPECT_EQ(venue.book(kSymbol)->best_bid(), 110_px);
+  EXPECT_EQ(venue.book(kSymbol)->best_ask(), 112_px);
+  EXPECT_EQ(venue.last_price(kSymbol), 111_px);
+
+  // Only the quoted size is there, and it is not refilled
+  send(order(v1::BUY, v1::MARKET, 5_qty));
+  auto r = reports();
+  ASSERT_EQ(r.size(), 2u);
+  EXPECT_EQ(r[0].price, 112_px);
+  EXPECT_EQ(r[0].quantity, 4_qty);
+  EXPECT_EQ(r[1].kind, VenueReport::Kind::Cancelled);
+  EXPECT_FALSE(venue.book(kSymbol)->best_ask());
+
+  venue.quote(kSymbol, 111_px, 3_qty, 113_px, 4_qty, 1s);
+  EXPECT_EQ(venue.book(kSymbol)->best_ask(), 113_px);
+}
+
+TEST_F(SimulatedVenueTest, TradeFillsOrdersItPrintsThrough) {
+  venue.quote(kSymbol, 100_px, 10_qty, 102_px, 10_qty, {});
+  const auto at = send(order(v1::BUY, v1::LIMIT, 5_qty, 101_px, v1::GTC));
+  const auto through =
+      send(order(v1::BUY, v1::LIMIT, 5_qty, 101.5_px, v1::GTC));
+
+  // Orders at the print keep waiting; those priced better fill at their limit
+  venue.trade(kSymbol, 101_px, 3_qty, 1s);
+  const auto r = reports();
+  ASSERT_EQ(r.size(), 1u);
+  EXPECT_EQ(r[0].order, through);
+  EXPECT_EQ(r[0].price, 101.5_px);
+  EXPECT_EQ(r[0].quantity, 3_qty);
+  EXPECT_TRUE(venue.is_open(at));
+  EXPECT_EQ(venue.last_price(kSymbol), 101_px);
+}
+
+TEST(SimulatedVenue, RejectsBadOptions) {
+  auto options = small_market();
+  options.market.tick = Price{};
+  EXPECT_THROW(SimulatedVenue{options}, std::runtime_error);
+
+  options = small_market();
+  options.market.half_spread_ticks = 0;
+  EXPECT_THROW(SimulatedVenue{options}, std::runtime_error);
+}
+
+TEST(SimulatedVenue, LatencyDelaysArrivalAndReports) {
+  auto options = small_market();
+  options.order_latency.base = 1ms;
+  options.report_latency.base = 500us;
+  SimulatedVenue venue{options};
+
+  ASSERT_TRUE(venue.submit(order(v1::BUY, v1::MARKET, 5_qty), 1, {}));
+  venue.advance(999us);
+  EXPECT_EQ(venue.in_flight(), 1u);
+  EXPECT_EQ(venue.undelivered(), 0u);
+
+  venue.advance(1ms);
+  EXPECT_EQ(venue.in_flight(), 0u);
+  std::vector<VenueReport> out;
+  EXPECT_EQ(venue.drain(1499us, out), 0u);
+  EXPECT_EQ(venue.drain(1500us, out), 1u);
+  EXPECT_EQ(out[0].time, 1ms);
+}
+
+TEST(SimulatedVenue, JitterNeverReordersMessages) {
+  auto options = small_market();
+  options.order_latency.jitter = 1ms;
+  SimulatedVenue venue{options};
+
+  const auto id = venue.submit(order(v1::BUY, v1::LIMIT, 5_qty, 97_px), 1, {});
+  ASSERT_TRUE(id);
+  ASSERT_TRUE(venue.cancel(*id, {}));
+  venue.advance(1ms);
+
+  std::vector<VenueReport> out;
+  venue.drain(VenueTime::max(), out);
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0].kind, VenueReport::Kind::Cancelled);
+}
+
+// Runs a random-walk market with a resting bid under it until something fills
+static std::vector<VenueReport> walk(std::uint64_t seed) {
+  auto options = small_market();
+  options.market.step_interval = 1ms;
+  options.order_latency.jitter = 100us;
+  options.seed = seed;
+  SimulatedVenue venue{options};
+
+  EXPECT_TRUE(venue.submit(order(v1::BUY, v1::LIMIT, 5_qty, 100_px, v1::GTC),
+                           1, {}));
+  EXPECT_TRUE(venue.submit(order(v1::SELL, v1::STOP, 5_qty, 96_px), 2, {}));
+  venue.advance(1s);
+
+  std::vector<VenueReport> out;
+  venue.drain(VenueTime::max(), out);
+  return out;
+}
+
+TEST(SimulatedVenue, RandomWalkIsReproducibleFromSeed) {
+  const auto a = walk(42);
+  const auto b = walk(42);
+  ASSERT_FALSE(a.empty());
+  ASSERT_EQ(a.size(), b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].order, b[i].order);
+    EXPECT_EQ(a[i].price, b[i].price);
+    EXPECT_EQ(a[i].quantity, b[i].quantity);
+    EXPECT_EQ(a[i].time, b[i].time);
+  }
+
+  // The walk crosses the resting bid, which fills at its limit
+  EXPECT_EQ(a[0].tag, 1u);
+  EXPECT_EQ(a[0].price, 100_px);
+}
+
+} // namespace quarcc
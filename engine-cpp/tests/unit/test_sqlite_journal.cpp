@@ -4,9 +4,13 @@
 
 #include <gtest/gtest.h>
 #include <trading/persistence/sqlite_journal.h>
+#include <trading/persistence/sqlite_schema.h>
 
 #include <chrono>
+#include <cstdio>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace quarcc {
 
@@ -64,11 +68,7 @@ TEST_F(JournalFixture, FlushDoesNotThrow) {
 
 TEST_F(JournalFixture, MultipleEntriesAreOrderedByInsertionId) {
   journal.log(Event::ORDER_CREATED, "1", "ORD_SEQ");
-  // Small sleep to guarantee distinct timestamps (journal has UNIQUE constraint
-  // on timestamp+correlation_id+event_type)
-  std::this_thread::sleep_for(std::chrono::milliseconds{10});
   journal.log(Event::ORDER_SUBMITTED, "2", "ORD_SEQ");
-  std::this_thread::sleep_for(std::chrono::milliseconds{10});
   journal.log(Event::ORDER_FILLED, "3", "ORD_SEQ");
 
   auto entries = journal.get_order_history("ORD_SEQ");
@@ -78,6 +78,24 @@ TEST_F(JournalFixture, MultipleEntriesAreOrderedByInsertionId) {
   EXPECT_EQ(entries[2].event_type, Event::ORDER_FILLED);
 }
 
+TEST(SQLiteJournal, KeepsIdenticalEntriesLoggedAtOneSimulatedInstant) {
+  SimulatedClock clock{LogEntry::from_nanos(1704164645'000'000'000)};
+  for (bool async : {false, true}) {
+    SQLiteJournal journal{":memory:", JournalOptions{.async = async}, clock};
+    for (const char *fill : {"qty=1", "qty=2", "qty=3"})
+      journal.log(Event::ORDER_PARTIALLY_FILLED, fill, "L1");
+
+    auto entries = journal.get_order_history("L1");
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].data, "qty=1");
+    EXPECT_EQ(entries[1].data, "qty=2");
+    EXPECT_EQ(entries[2].data, "qty=3");
+    EXPECT_EQ(entries[0].timestamp, entries[2].timestamp);
+    EXPECT_LT(entries[0].id, entries[1].id);
+    EXPECT_LT(entries[1].id, entries[2].id);
+  }
+}
+
 TEST_F(JournalFixture, LogWithoutCorrelationIdSucceeds) {
   EXPECT_NO_THROW(journal.log(Event::SYSTEM_STARTED, "no correlation id"));
 
@@ -87,4 +105,220 @@ TEST_F(JournalFixture, LogWithoutCorrelationIdSucceeds) {
   EXPECT_FALSE(entries.empty());
 }
 
+// ---------------------------------------------------------------------------
+// Async (group commit) mode
+// ---------------------------------------------------------------------------
+
+struct AsyncJournalFixture : public testing::Test {
+  SQLiteJournal journal{":memory:", JournalOptions{.async = true}};
+};
+
+TEST_F(AsyncJournalFixture, LastIdCountsQueuedEntries) {
+  EXPECT_EQ(journal.last_id(), 0u);
+  journal.log(Event::ORDER_CREATED, "created", "ORD_ASYNC");
+  journal.log(Event::ORDER_SUBMITTED, "submitted", "ORD_ASYNC");
+  EXPECT_EQ(journal.last_id(), 2u);
+}
+
+TEST_F(AsyncJournalFixture, ReadsSeeEntriesLoggedBeforeThem) {
+  journal.log(Event::ORDER_CREATED, "created", "ORD_ASYNC");
+  journal.log(Event::ORDER_SUBMITTED, "submitted", "ORD_ASYNC");
+
+  auto entries = journal.get_order_history("ORD_ASYNC");
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].event_type, Event::ORDER_CREATED);
+  EXPECT_EQ(entries[1].event_type, Event::ORDER_SUBMITTED);
+}
+
+TEST_F(AsyncJournalFixture, FlushCommitsEverythingLogged) {
+  for (int i = 0; i < 100; ++i)
+    journal.log(Event::ORDER_CREATED, std::to_string(i),
+                "ORD_" + std::to_string(i));
+  journal.flush();
+
+  auto from = LogEntry::now() - std::chrono::seconds{5};
+  auto to = LogEntry::now() + std::chrono::seconds{5};
+  EXPECT_EQ(journal.get_history(from, to).size(), 100u);
+}
+
+TEST(AsyncJournal, LogBlocksInsteadOfDroppingWhenQueueIsFull) {
+  SQLiteJournal journal{":memory:", JournalOptions{.async = true,
+                                                   .queue_capacity = 4,
+                                                   .max_batch = 2}};
+  for (int i = 0; i < 200; ++i)
+    journal.log(Event::ORDER_CREATED, std::to_string(i),
+                "ORD_" + std::to_string(i));
+
+  auto from = LogEntry::now() - std::chrono::seconds{5};
+  auto to = LogEntry::now() + std::chrono::seconds{5};
+  EXPECT_EQ(journal.get_history(from, to).size(), 200u);
+}
+
+TEST(AsyncJournal, ConcurrentProducersAllCommitted) {
+  SQLiteJournal journal{":memory:", JournalOptions{.async = true,
+                                                   .queue_capacity = 64}};
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 250;
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; ++t) {
+    producers.emplace_back([&journal, t] {
+      for (int i = 0; i < kPerThread; ++i)
+        journal.log(Event::ORDER_CREATED, "x",
+                    "T" + std::to_string(t) + "_" + std::to_string(i));
+    });
+  }
+  for (auto &p : producers)
+    p.join();
+
+  auto from = LogEntry::now() - std::chrono::seconds{5};
+  auto to = LogEntry::now() + std::chrono::seconds{5};
+  EXPECT_EQ(journal.get_history(from, to).size(),
+            static_cast<std::size_t>(kThreads * kPerThread));
+}
+
+TEST(AsyncJournal, DestructorCommitsPendingEntries) {
+  const std::string path = testing::TempDir() + "async_journal_drain.db";
+  std::remove(path.c_str());
+
+  {
+    SQLiteJournal journal{path, JournalOptions{.async = true,
+                                               .max_delay =
+                                                   std::chrono::seconds{10}}};
+    for (int i = 0; i < 10; ++i)
+      journal.log(Event::ORDER_CREATED, "x", "ORD_" + std::to_string(i));
+  }
+
+  SQLiteJournal reopened{path};
+  auto from = LogEntry::now() - std::chrono::seconds{5};
+  auto to = LogEntry::now() + std::chrono::seconds{5};
+  EXPECT_EQ(reopened.get_history(from, to).size(), 10u);
+
+  std::remove(path.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Timestamps
+// ---------------------------------------------------------------------------
+
+TEST_F(JournalFixture, TimestampsKeepFullPrecision) {
+  const auto before = LogEntry::now();
+  journal.log(Event::ORDER_CREATED, "precise", "ORD_NS");
+  const auto after = LogEntry::now();
+
+  auto entries = journal.get_order_history("ORD_NS");
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_GE(entries[0].timestamp, before);
+  EXPECT_LE(entries[0].timestamp, after);
+
+  // Range bounds compare at full precision too
+  EXPECT_EQ(journal.get_history(before, after).size(), 1u);
+  EXPECT_TRUE(journal
+                  .get_history(entries[0].timestamp + std::chrono::nanoseconds{1},
+                               after + std::chrono::seconds{1})
+                  .empty());
+}
+
+TEST(LogEntryTimestamps, StringFormIsUtcWithPaddedMilliseconds) {
+  // 2024-01-02 03:04:05.007 UTC
+  const auto ts = LogEntry::from_nanos(1704164645'007'000'000);
+  EXPECT_EQ(LogEntry::timestamp_to_string(ts), "2024-01-02 03:04:05.007");
+  EXPECT_EQ(LogEntry::string_to_timestamp("2024-01-02 03:04:05.007"), ts);
+  // Older builds wrote the millisecond count unpadded
+  EXPECT_EQ(LogEntry::string_to_timestamp("2024-01-02 03:04:05.7"), ts);
+  EXPECT_EQ(LogEntry::string_to_timestamp("2024-01-02 03:04:05"),
+            ts - std::chrono::milliseconds{7});
+}
+
+TEST(SQLiteJournalMigration, ConvertsLegacyTextTimestamps) {
+  const std::string path = testing::TempDir() + "legacy_journal.db";
+  std::remove(path.c_str());
+
+  {
+    sqlite3 *db = nullptr;
+    ASSERT_EQ(sqlite3_open(path.c_str(), &db), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(db, R"(
+      CREATE TABLE journal (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        timestamp TEXT NOT NULL,
+        event_type INTEGER NOT NULL,
+        data TEXT NOT NULL,
+        correlation_id TEXT,
+        UNIQUE(timestamp, correlation_id, event_type)
+      );
+      CREATE INDEX idx_timestamp ON journal(timestamp);
+      INSERT INTO journal (timestamp, event_type, data, correlation_id)
+        VALUES ('2024-01-02 03:04:05.7', 0, 'created', 'ORD_OLD'),
+               ('2024-01-02 03:04:06.250', 3, 'submitted', 'ORD_OLD');
+    )",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    sqlite3_close(db);
+  }
+
+  {
+    SQLiteJournal journal{path};
+    auto entries = journal.get_order_history("ORD_OLD");
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].timestamp,
+              LogEntry::string_to_timestamp("2024-01-02 03:04:05.007"));
+    EXPECT_EQ(entries[1].timestamp,
+              LogEntry::string_to_timestamp("2024-01-02 03:04:06.250"));
+
+    const auto from = LogEntry::string_to_timestamp("2024-01-02 03:04:06");
+    auto ranged = journal.get_history(from, from + std::chrono::seconds{1});
+    ASSERT_EQ(ranged.size(), 1u);
+    EXPECT_EQ(ranged[0].data, "submitted");
+
+    // New rows keep ids after the migrated ones
+    journal.log(Event::ORDER_FILLED, "filled", "ORD_OLD");
+    EXPECT_EQ(journal.get_order_history("ORD_OLD").back().id, 3u);
+  }
+
+  // Reopening a migrated db is a no-op
+  SQLiteJournal reopened{path};
+  EXPECT_EQ(reopened.get_order_history("ORD_OLD").size(), 3u);
+
+  std::remove(path.c_str());
+}
+
+TEST(SQLiteJournalMigration, DropsTheVersion1UniqueConstraint) {
+  const std::string path = testing::TempDir() + "v1_journal.db";
+  std::remove(path.c_str());
+
+  {
+    sqlite3 *db = nullptr;
+    ASSERT_EQ(sqlite3_open(path.c_str(), &db), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(db, R"(
+      CREATE TABLE journal (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        timestamp INTEGER NOT NULL,
+        event_type INTEGER NOT NULL,
+        data TEXT NOT NULL,
+        correlation_id TEXT,
+        UNIQUE(timestamp, correlation_id, event_type)
+      );
+      CREATE INDEX idx_timestamp ON journal(timestamp);
+      INSERT INTO journal (timestamp, event_type, data, correlation_id)
+        VALUES (1000, 18, 'first', 'L1');
+      PRAGMA user_version = 1;
+    )",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+    sqlite3_close(db);
+  }
+
+  SimulatedClock clock{LogEntry::from_nanos(1000)};
+  SQLiteJournal journal{path, {}, clock};
+  journal.log(Event::ORDER_PARTIALLY_FILLED, "second", "L1");
+
+  auto entries = journal.get_order_history("L1");
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].id, 1u);
+  EXPECT_EQ(entries[1].data, "second");
+  EXPECT_EQ(entries[0].timestamp, entries[1].timestamp);
+
+  std::remove(path.c_str());
+}
+
 } // namespace quarcc
@@ -3,10 +3,14 @@
 #include <gtest/gtest.h>
 #include <trading/persistence/sqlite_order_store.h>
 
+#include <cstdio>
+
 #include "helpers/proto_builders.h"
 
 namespace quarcc {
 
+using namespace fixed_point_literals;
+
 struct OrderStoreFixture : public testing::Test {
   SQLiteOrderStore store{":memory:"};
 };
@@ -23,6 +27,16 @@ TEST_F(OrderStoreFixture, StoreAndRetrieveOrder) {
   EXPECT_DOUBLE_EQ(fetched->order.quantity(), 10.0);
 }
 
+TEST_F(OrderStoreFixture, OrdersWithUnrepresentableValuesAreRefused) {
+  auto stored =
+      test::make_stored_order("L_NAN", "AAPL", v1::Side::BUY, std::nan(""));
+  EXPECT_FALSE(store.store_order(stored).has_value());
+  stored.order.set_quantity(10.0);
+  stored.order.set_price(1e300);
+  EXPECT_FALSE(store.store_order(stored).has_value());
+  EXPECT_FALSE(store.get_order("L_NAN").has_value());
+}
+
 TEST_F(OrderStoreFixture, GetOrderUnknownIdReturnsError) {
   auto result = store.get_order("NO_SUCH_ID");
   EXPECT_FALSE(result.has_value());
@@ -56,13 +70,57 @@ TEST_F(OrderStoreFixture, UpdateBrokerIdSetsBrokerId) {
 TEST_F(OrderStoreFixture, UpdateFillInfoSetsFillFields) {
   store.store_order(test::make_stored_order("L4"));
 
-  auto result = store.update_fill_info("L4", 7.5, 152.25);
+  auto result = store.update_fill_info("L4", 7.5_qty, 152.25_px);
   ASSERT_TRUE(result.has_value());
 
   auto fetched = store.get_order("L4");
   ASSERT_TRUE(fetched.has_value());
-  EXPECT_DOUBLE_EQ(fetched->filled_quantity, 7.5);
-  EXPECT_DOUBLE_EQ(fetched->avg_fill_price, 152.25);
+  EXPECT_EQ(fetched->filled_quantity, 7.5_qty);
+  EXPECT_EQ(fetched->avg_fill_price, 152.25_px);
+}
+
+TEST_F(OrderStoreFixture, ApplyFillAccumulatesQuantityAndWeightsPrice) {
+  store.store_order(test::make_stored_order("L_AF"));
+
+  ASSERT_TRUE(store.apply_fill("L_AF", 4_qty, 100_px,
+                               OrderStatus::PARTIALLY_FILLED));
+  ASSERT_TRUE(store.apply_fill("L_AF", 6_qty, 110_px, OrderStatus::FILLED));
+
+  auto fetched = store.get_order("L_AF");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->filled_quantity, 10_qty);
+  EXPECT_EQ(fetched->avg_fill_price, 106_px);
+  EXPECT_EQ(fetched->status, OrderStatus::FILLED);
+  EXPECT_TRUE(fetched->updated_at.has_value());
+}
+
+TEST_F(OrderStoreFixture, ApplyFillsAppliesWholeBatchInOrder) {
+  store.store_order(test::make_stored_order("L_B1"));
+  store.store_order(test::make_stored_order("L_B2"));
+
+  auto result = store.apply_fills({
+      {"L_B1", 5_qty, 100_px, OrderStatus::PARTIALLY_FILLED},
+      {"L_B2", 10_qty, 50_px, OrderStatus::FILLED},
+      {"L_B1", 5_qty, 102_px, OrderStatus::FILLED},
+  });
+  ASSERT_TRUE(result.has_value());
+
+  auto b1 = store.get_order("L_B1");
+  ASSERT_TRUE(b1.has_value());
+  EXPECT_EQ(b1->filled_quantity, 10_qty);
+  EXPECT_EQ(b1->avg_fill_price, 101_px);
+  EXPECT_EQ(b1->status, OrderStatus::FILLED);
+
+  auto b2 = store.get_order("L_B2");
+  ASSERT_TRUE(b2.has_value());
+  EXPECT_EQ(b2->filled_quantity, 10_qty);
+  EXPECT_EQ(b2->status, OrderStatus::FILLED);
+
+  EXPECT_TRUE(store.get_open_orders().empty());
+}
+
+TEST_F(OrderStoreFixture, ApplyFillsEmptyBatchIsNoOp) {
+  EXPECT_TRUE(store.apply_fills({}).has_value());
 }
 
 TEST_F(OrderStoreFixture, GetOpenOrdersReturnsOnlyNonTerminalOrders) {
@@ -109,4 +167,212 @@ TEST_F(OrderStoreFixture, GetOpenOrdersEmptyOnFreshStore) {
   EXPECT_TRUE(open.empty());
 }
 
+TEST_F(OrderStoreFixture, TimestampsRoundTripAtFullPrecision) {
+  auto stored = test::make_stored_order("L_TS");
+  stored.created_at = LogEntry::from_nanos(1704164645'123'456'789);
+  store.store_order(stored);
+
+  auto fetched = store.get_order("L_TS");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->created_at, stored.created_at);
+  EXPECT_FALSE(fetched->updated_at.has_value());
+
+  const auto before = LogEntry::now();
+  store.update_order_status("L_TS", OrderStatus::ACCEPTED);
+  fetched = store.get_order("L_TS");
+  ASSERT_TRUE(fetched->updated_at.has_value());
+  EXPECT_GE(*fetched->updated_at, before);
+}
+
+TEST(SQLiteOrderStoreMigration, ConvertsLegacyTextTimestamps) {
+  const std::string path = testing::TempDir() + "legacy_orders.db";
+  std::remove(path.c_str());
+
+  const auto order = test::make_order("L_OLD");
+  std::string blob;
+  order.SerializeToString(&blob);
+
+  {
+    sqlite3 *db = nullptr;
+    ASSERT_EQ(sqlite3_open(path.c_str(), &db), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(db, R"(
+      CREATE TABLE orders (
+        local_id TEXT PRIMARY KEY,
+        broker_id TEXT UNIQUE,
+        symbol TEXT NOT NULL,
+        side INTEGER NOT NULL,
+        quantity REAL NOT NULL,
+        price REAL,
+        order_type INTEGER NOT NULL,
+        status INTEGER NOT NULL,
+        time_in_force INTEGER NOT NULL,
+        account_id TEXT NOT NULL,
+        strategy_id TEXT NOT NULL,
+        created_at TEXT NOT NULL,
+        updated_at TEXT,
+        filled_quantity REAL DEFAULT 0.0,
+        avg_fill_price REAL DEFAULT 0.0,
+        order_proto BLOB NOT NULL
+      );
+      CREATE INDEX idx_status ON orders(status);
+      CREATE INDEX idx_created_at ON orders(created_at);
+    )",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+
+    sqlite3_stmt *stmt = nullptr;
+    sqlite3_prepare_v2(db, R"(
+      INSERT INTO orders VALUES ('L_OLD', 'B_OLD', 'AAPL', 0, 10, 0, 0, 2, 0,
+                                 'acct', 'TEST', '2024-01-02 03:04:05.7',
+                                 '2024-01-02 03:05:00', 4, 150.5, ?)
+    )",
+                       -1, &stmt, nullptr);
+    sqlite3_bind_blob(stmt, 1, blob.data(), static_cast<int>(blob.size()),
+                      SQLITE_TRANSIENT);
+    ASSERT_EQ(sqlite3_step(stmt), SQLITE_DONE);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+  }
+
+  SQLiteOrderStore store{path};
+  auto fetched = store.get_order("L_OLD");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->broker_id, "B_OLD");
+  EXPECT_EQ(fetched->status, OrderStatus::ACCEPTED);
+  EXPECT_EQ(fetched->filled_quantity, 4_qty);
+  EXPECT_EQ(fetched->avg_fill_price, 150.5_px);
+  EXPECT_EQ(fetched->order.id(), "L_OLD");
+  EXPECT_EQ(fetched->created_at,
+            LogEntry::string_to_timestamp("2024-01-02 03:04:05.007"));
+  ASSERT_TRUE(fetched->updated_at.has_value());
+  EXPECT_EQ(*fetched->updated_at,
+            LogEntry::string_to_timestamp("2024-01-02 03:05:00"));
+  EXPECT_EQ(store.get_open_orders().size(), 1u);
+
+  std::remove(path.c_str());
+}
+
+TEST(SQLiteOrderStoreMigration, ConvertsRealColumnsToFixedPoint) {
+  const std::string path = testing::TempDir() + "real_orders.db";
+  std::remove(path.c_str());
+
+  const auto order = test::make_order("L_V1");
+  std::string blob;
+  order.SerializeToString(&blob);
+
+  {
+    sqlite3 *db = nullptr;
+    ASSERT_EQ(sqlite3_open(path.c_str(), &db), SQLITE_OK);
+    ASSERT_EQ(sqlite3_exec(db, R"(
+      CREATE TABLE orders (
+        local_id TEXT PRIMARY KEY,
+        broker_id TEXT UNIQUE,
+        symbol TEXT NOT NULL,
+        side INTEGER NOT NULL,
+        quantity REAL NOT NULL,
+        price REAL,
+        order_type INTEGER NOT NULL,
+        status INTEGER NOT NULL,
+        time_in_force INTEGER NOT NULL,
+        account_id TEXT NOT NULL,
+        strategy_id TEXT NOT NULL,
+        created_at INTEGER NOT NULL,
+        updated_at INTEGER,
+        filled_quantity REAL DEFAULT 0.0,
+        avg_fill_price REAL DEFAULT 0.0,
+        order_proto BLOB NOT NULL
+      );
+      CREATE TABLE position_snapshot (
+        symbol TEXT PRIMARY KEY,
+        quantity REAL NOT NULL,
+        avg_price REAL NOT NULL
+      );
+      CREATE TABLE position_snapshot_meta (
+        id INTEGER PRIMARY KEY CHECK (id = 1),
+        taken_at INTEGER NOT NULL
+      );
+      INSERT INTO position_snapshot VALUES ('AAPL', 0.3, 150.0001);
+      INSERT INTO position_snapshot_meta VALUES (1, 5000);
+      PRAGMA user_version = 1;
+    )",
+                           nullptr, nullptr, nullptr),
+              SQLITE_OK);
+
+    sqlite3_stmt *stmt = nullptr;
+    sqlite3_prepare_v2(db, R"(
+      INSERT INTO orders VALUES ('L_V1', 'B_V1', 'AAPL', 0, 10, NULL, 0, 3, 0,
+                                 'acct', 'TEST', 1000, NULL, 0.1 + 0.2,
+                                 99.99, ?)
+    )",
+                       -1, &stmt, nullptr);
+    sqlite3_bind_blob(stmt, 1, blob.data(), static_cast<int>(blob.size()),
+                      SQLITE_TRANSIENT);
+    ASSERT_EQ(sqlite3_step(stmt), SQLITE_DONE);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+  }
+
+  SQLiteOrderStore store{path};
+  auto fetched = store.get_order("L_V1");
+  ASSERT_TRUE(fetched.has_value());
+  EXPECT_EQ(fetched->filled_quantity, 0.3_qty); // not 0.30000000000000004
+  EXPECT_EQ(fetched->avg_fill_price, 99.99_px);
+  EXPECT_EQ(fetched->created_at, LogEntry::from_nanos(1000));
+
+  // Later fills keep accumulating exactly
+  ASSERT_TRUE(store.apply_fill("L_V1", 0.7_qty, 100.01_px,
+                               OrderStatus::PARTIALLY_FILLED));
+  fetched = store.get_order("L_V1");
+  EXPECT_EQ(fetched->filled_quantity, 1_qty);
+  EXPECT_EQ(fetched->avg_fill_price, 100.004_px);
+
+  auto snapshot = store.load_position_snapshot();
+  ASSERT_TRUE(snapshot.has_value());
+  EXPECT_EQ(snapshot->taken_at, LogEntry::from_nanos(5000));
+  EXPECT_FALSE(snapshot->journal_id);
+  ASSERT_EQ(snapshot->positions.size(), 1u);
+  EXPECT_EQ(snapshot->positions[0].quantity, 0.3_qty);
+  EXPECT_EQ(snapshot->positions[0].avg_price, 150.0001_px);
+  EXPECT_EQ(snapshot->positions[0].realized_pnl, 0_money);
+
+  std::remove(path.c_str());
+}
+
+TEST_F(OrderStoreFixture, PositionSnapshotMissingUntilSaved) {
+  EXPECT_FALSE(store.load_position_snapshot().has_value());
+}
+
+TEST_F(OrderStoreFixture, PositionSnapshotIsReplacedOnSave) {
+  PositionSnapshot first;
+  first.taken_at = LogEntry::from_nanos(1'000);
+  first.positions = {{"AAPL", 10_qty, 150_px, 0_money},
+                     {"MSFT", -5_qty, 300_px, 0_money}};
+  ASSERT_TRUE(store.save_position_snapshot(first).has_value());
+
+  PositionSnapshot second;
+  second.taken_at = LogEntry::from_nanos(2'000);
+  second.journal_id = 42;
+  second.positions = {{"AAPL", 12.5_qty, 151_px, -42.5_money}};
+  ASSERT_TRUE(store.save_position_snapshot(second).has_value());
+
+  auto loaded = store.load_position_snapshot();
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(loaded->taken_at, second.taken_at);
+  EXPECT_EQ(loaded->journal_id, 42u);
+  ASSERT_EQ(loaded->positions.size(), 1u);
+  EXPECT_EQ(loaded->positions[0].symbol, "AAPL");
+  EXPECT_EQ(loaded->positions[0].quantity, 12.5_qty);
+  EXPECT_EQ(loaded->positions[0].avg_price, 151_px);
+  EXPECT_EQ(loaded->positions[0].realized_pnl, -42.5_money);
+
+  // A flat book still records when it was taken
+  ASSERT_TRUE(store.save_position_snapshot({LogEntry::from_nanos(3'000), {}})
+                  .has_value());
+  loaded = store.load_position_snapshot();
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(loaded->taken_at, LogEntry::from_nanos(3'000));
+  EXPECT_FALSE(loaded->journal_id);
+  EXPECT_TRUE(loaded->positions.empty());
+}
+
 } // namespace quarcc
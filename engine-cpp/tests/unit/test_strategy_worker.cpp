@@ -0,0 +1,167 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <trading/core/strategy_worker.h>
+
+#include "helpers/proto_builders.h"
+#include "mocks/mock_execution_gateway.h"
+#include "mocks/mock_journal.h"
+#include "mocks/mock_order_store.h"
+
+#include <future>
+
+using namespace testing;
+
+namespace quarcc {
+
+struct StrategyWorkerFixture : public Test {
+  MockExecutionGateway *gw{};
+  MockOrderStore *store{};
+  IExecutionGateway::FillListener listener;
+
+  std::unique_ptr<StrategyWorker> worker;
+
+  void SetUp() override {
+    // Orders are only accepted for symbols already in the table
+    SymbolTable::global().intern("AAPL");
+
+    auto gw_owned = std::make_unique<NiceMock<MockExecutionGateway>>();
+    auto os_owned = std::make_unique<NiceMock<MockOrderStore>>();
+    gw = gw_owned.get();
+    store = os_owned.get();
+
+    ON_CALL(*store, store_order(_)).WillByDefault(Return(std::monostate{}));
+    ON_CALL(*store, update_broker_id(_, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*store, update_order_status(_, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*store, update_fill_info(_, _, _))
+        .WillByDefault(Return(std::monostate{}));
+    ON_CALL(*gw, set_fill_listener(_))
+        .WillByDefault(DoAll(SaveArg<0>(&listener), Return(true)));
+
+    worker = std::make_unique<StrategyWorker>(OrderManager::CreateOrderManager(
+        std::make_unique<PositionKeeper>(), std::move(gw_owned),
+        std::make_unique<NiceMock<MockJournal>>(), std::move(os_owned),
+        std::make_unique<RiskManager>()));
+  }
+
+  Result<LocalOrderId> submit(const v1::StrategySignal &signal) {
+    std::promise<Result<LocalOrderId>> p;
+    worker->submit(signal, [&p](auto r) { p.set_value(std::move(r)); });
+    return p.get_future().get();
+  }
+};
+
+TEST_F(StrategyWorkerFixture, SubmitCompletesOnWorkerThread) {
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B1"}));
+
+  std::thread::id caller = std::this_thread::get_id();
+  std::promise<std::thread::id> ran_on;
+  worker->submit(test::make_signal(), [&](auto r) {
+    EXPECT_TRUE(r.has_value());
+    ran_on.set_value(std::this_thread::get_id());
+  });
+
+  EXPECT_NE(ran_on.get_future().get(), caller);
+}
+
+TEST_F(StrategyWorkerFixture, MessagesCompleteInPostingOrder) {
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B1"}));
+
+  std::vector<int> order;
+  for (int i = 0; i < 20; ++i)
+    worker->submit(test::make_signal(), [&order, i](auto) {
+      order.push_back(i);
+    });
+  worker->stop();
+
+  ASSERT_EQ(order.size(), 20u);
+  for (int i = 0; i < 20; ++i)
+    EXPECT_EQ(order[i], i);
+}
+
+TEST_F(StrategyWorkerFixture, CancelRightAfterSubmitSeesTheMapping) {
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B1"}));
+  ON_CALL(*gw, cancel_order(_)).WillByDefault(Return(std::monostate{}));
+
+  auto submitted = submit(test::make_signal());
+  ASSERT_TRUE(submitted.has_value());
+
+  v1::CancelSignal cancel;
+  cancel.set_strategy_id("TEST");
+  cancel.set_order_id(*submitted);
+  std::promise<Result<std::monostate>> cancelled;
+  worker->cancel(cancel, [&](auto r) { cancelled.set_value(std::move(r)); });
+
+  EXPECT_TRUE(cancelled.get_future().get().has_value());
+}
+
+TEST_F(StrategyWorkerFixture, PushedFillUpdatesPosition) {
+  // Expectations must be in place before the worker can call into the mocks.
+  std::atomic<bool> fill_available{false};
+  std::promise<void> fill_delivered;
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B_FILL"}));
+  ON_CALL(*store, get_order(_))
+      .WillByDefault(Return(test::make_stored_order(
+          "L", "AAPL", v1::Side::BUY, 7.0, OrderStatus::SUBMITTED, "B_FILL")));
+  ON_CALL(*gw, get_fills()).WillByDefault(Invoke([&] {
+    std::vector<v1::ExecutionReport> fills;
+    if (fill_available.exchange(false)) {
+      fills.push_back(test::make_fill("B_FILL", "AAPL", v1::Side::BUY, 7.0,
+                                      100.0));
+      fill_delivered.set_value();
+    }
+    return fills;
+  }));
+
+  auto submitted = submit(test::make_signal("TEST", "AAPL", v1::Side::BUY, 7.0));
+  ASSERT_TRUE(submitted.has_value());
+
+  ASSERT_TRUE(listener);
+  fill_available = true;
+  listener();
+  fill_delivered.get_future().wait();
+  worker->stop();
+
+  auto pos = worker->manager().get_position("AAPL");
+  ASSERT_TRUE(pos.has_value());
+  EXPECT_DOUBLE_EQ(pos->quantity(), 7.0);
+}
+
+TEST_F(StrategyWorkerFixture, StopDrainsPendingMessages) {
+  ON_CALL(*gw, submit_order(_)).WillByDefault(Return(std::string{"B2"}));
+
+  int completed = 0;
+  for (int i = 0; i < 10; ++i)
+    worker->submit(test::make_signal(), [&](auto) { ++completed; });
+  worker->stop();
+
+  EXPECT_EQ(completed, 10);
+}
+
+TEST_F(StrategyWorkerFixture, MessagesAfterStopCompleteWithAnError) {
+  worker->stop();
+  EXPECT_CALL(*gw, submit_order(_)).Times(0);
+
+  // Each completes before the call returns, so nobody waits forever
+  auto submitted = submit(test::make_signal());
+  ASSERT_FALSE(submitted.has_value());
+  EXPECT_EQ(submitted.error().message_, "Strategy worker is stopped");
+
+  std::optional<Result<std::monostate>> cancelled;
+  worker->cancel(v1::CancelSignal{}, [&](auto r) { cancelled = r; });
+  ASSERT_TRUE(cancelled);
+  EXPECT_FALSE(cancelled->has_value());
+
+  std::optional<Result<LocalOrderId>> replaced;
+  worker->replace(v1::ReplaceSignal{}, [&](auto r) { replaced = r; });
+  ASSERT_TRUE(replaced);
+  EXPECT_FALSE(replaced->has_value());
+
+  bool cancelled_all = false;
+  worker->cancel_all("reason", "test", [&] { cancelled_all = true; });
+  EXPECT_TRUE(cancelled_all);
+}
+
+} // namespace quarcc
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <trading/utils/symbol_table.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace quarcc {
+
+TEST(SymbolTable, InternAssignsDenseIdsInOrder) {
+  SymbolTable table;
+  EXPECT_EQ(table.intern("AAPL"), 0u);
+  EXPECT_EQ(table.intern("MSFT"), 1u);
+  EXPECT_EQ(table.intern("AAPL"), 0u);
+  EXPECT_EQ(table.size(), 2u);
+
+  EXPECT_EQ(table.name(0), "AAPL");
+  EXPECT_EQ(table.name(1), "MSFT");
+}
+
+TEST(SymbolTable, FindDoesNotIntern) {
+  SymbolTable table;
+  EXPECT_FALSE(table.find("TSLA").has_value());
+  EXPECT_EQ(table.size(), 0u);
+
+  const SymbolId id = table.intern("TSLA");
+  EXPECT_EQ(table.find("TSLA"), id);
+}
+
+TEST(SymbolTable, SurvivesIndexGrowth) {
+  SymbolTable table;
+  for (int i = 0; i < 5000; ++i)
+    EXPECT_EQ(table.intern("SYM" + std::to_string(i)),
+              static_cast<SymbolId>(i));
+
+  for (int i = 0; i < 5000; ++i) {
+    EXPECT_EQ(table.find("SYM" + std::to_string(i)), static_cast<SymbolId>(i));
+    EXPECT_EQ(table.name(static_cast<SymbolId>(i)), "SYM" + std::to_string(i));
+  }
+}
+
+TEST(SymbolTable, ConcurrentInternAgreesOnIds) {
+  SymbolTable table;
+  constexpr int kThreads = 4;
+  constexpr int kSymbols = 2000;
+
+  std::vector<std::vector<SymbolId>> seen(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < kSymbols; ++i)
+        seen[t].push_back(table.intern("SYM" + std::to_string(i)));
+    });
+  }
+  for (auto &th : threads)
+    th.join();
+
+  EXPECT_EQ(table.size(), static_cast<std::size_t>(kSymbols));
+  for (int t = 1; t < kThreads; ++t)
+    EXPECT_EQ(seen[t], seen[0]);
+  for (int i = 0; i < kSymbols; ++i)
+    EXPECT_EQ(table.name(seen[0][i]), "SYM" + std::to_string(i));
+}
+
+} // namespace quarcc
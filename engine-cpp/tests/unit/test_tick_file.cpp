@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <trading/marketdata/csv_ticks.h>
+#include <trading/marketdata/tick_file.h>
+#include <trading/marketdata/tick_replay.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace quarcc {
+
+using namespace fixed_point_literals;
+
+struct TickFileTest : public testing::Test {
+  std::filesystem::path path;
+
+  void SetUp() override {
+    const auto *info = testing::UnitTest::GetInstance()->current_test_info();
+    path = std::filesystem::path(testing::TempDir()) /
+           (std::string("ticks_") + info->name() + ".bin");
+    std::filesystem::remove(path);
+  }
+
+  void TearDown() override { std::filesystem::remove(path); }
+};
+
+TEST_F(TickFileTest, RoundTripsSortedByTimestamp) {
+  TickFileWriter writer;
+  writer.add_trade(300, "MSFT", 410.25_px, 100_qty);
+  writer.add_quote(100, "AAPL", 189.5_px, 200_qty, 189.52_px, 300_qty);
+  writer.add_trade(200, "AAPL", 189.51_px, 50_qty);
+  writer.write(path);
+
+  const TickFile file{path};
+  ASSERT_EQ(file.symbol_count(), 2u);
+  EXPECT_EQ(file.symbol(0), "MSFT");
+  EXPECT_EQ(file.symbol(1), "AAPL");
+
+  const auto records = file.records();
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[0].timestamp_ns, 100);
+  EXPECT_EQ(records[0].kind, TickKind::Quote);
+  EXPECT_EQ(records[0].bid(), 189.5_px);
+  EXPECT_EQ(records[0].bid_size(), 200_qty);
+  EXPECT_EQ(records[0].ask(), 189.52_px);
+  EXPECT_EQ(records[0].ask_size(), 300_qty);
+  EXPECT_EQ(records[1].kind, TickKind::Trade);
+  EXPECT_EQ(records[1].price(), 189.51_px);
+  EXPECT_EQ(records[2].symbol, 0u);
+  EXPECT_EQ(records[2].size(), 100_qty);
+}
+
+TEST_F(TickFileTest, RejectsFilesItDidNotWrite) {
+  std::ofstream(path) << std::string(128, 'x');
+  EXPECT_THROW(TickFile{path}, std::runtime_error);
+
+  std::filesystem::remove(path);
+  EXPECT_THROW(TickFile{path}, std::runtime_error);
+
+  TickFileWriter writer;
+  writer.add_trade(1, "AAPL", 1_px, 1_qty);
+  writer.write(path);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  EXPECT_THROW(TickFile{path}, std::runtime_error);
+}
+
+TEST_F(TickFileTest, ReplayResolvesSymbolsAndSeeks) {
+  TickFileWriter writer;
+  for (int i = 0; i < 10; ++i)
+    writer.add_trade(i * 10, i % 2 ? "B" : "A", 1_px, 1_qty);
+  writer.write(path);
+
+  SymbolTable symbols;
+  const SymbolId b = symbols.intern("B");
+  TickReplay replay{std::make_shared<const TickFile>(path), symbols};
+  EXPECT_EQ(replay.size(), 10u);
+
+  const TickRecord *first = replay.next();
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(symbols.name(replay.symbol(*first)), "A");
+
+  replay.seek(45);
+  const TickRecord *at = replay.next();
+  ASSERT_NE(at, nullptr);
+  EXPECT_EQ(at->timestamp_ns, 50);
+  EXPECT_EQ(replay.symbol(*at), b);
+
+  // Seeking never goes back
+  replay.seek(0);
+  EXPECT_EQ(replay.peek()->timestamp_ns, 60);
+  replay.seek(1000);
+  EXPECT_TRUE(replay.done());
+  EXPECT_EQ(replay.next(), nullptr);
+}
+
+TEST(CsvTicks, ParsesTradesAndQuotes) {
+  std::istringstream csv{"timestamp,symbol,kind,price,size,ask_price,ask_size\n"
+                         "2024-01-02T14:30:00.5Z,AAPL,Q,189.5,200,189.52,300\r\n"
+                         "\n"
+                         "1704205800600000000,AAPL,T,189.51,50\n"};
+  TickFileWriter writer;
+  const auto read = read_csv_ticks(csv, writer);
+  ASSERT_TRUE(read) << read.error().message_;
+  EXPECT_EQ(*read, 2u);
+  EXPECT_EQ(writer.size(), 2u);
+}
+
+TEST(CsvTicks, ReportsTheBadLine) {
+  const auto fails_on = [](const std::string &text) {
+    std::istringstream csv{text};
+    TickFileWriter writer;
+    const auto read = read_csv_ticks(csv, writer);
+    return read ? std::string{} : read.error().message_;
+  };
+  EXPECT_EQ(fails_on("1,AAPL,T,1,1\n2,AAPL,X,1,1\n"),
+            "line 2: kind must be T or Q");
+  EXPECT_EQ(fails_on("1,AAPL,T,1,1\nnope,AAPL,T,1,1\n"),
+            "line 2: bad timestamp");
+  EXPECT_EQ(fails_on("1,AAPL,Q,1,1\n"),
+            "line 1: quotes need ask_price and ask_size");
+  EXPECT_EQ(fails_on("1,AAPL,T,abc,1\n"), "line 1: bad price or size");
+  EXPECT_EQ(fails_on("1,ABCDEFGHIJKLMNOPQ,T,1,1\n"),
+            "line 1: symbol must be 1 to 16 characters");
+  EXPECT_EQ(fails_on("1,AAPL,T,1,1,2,3,4\n"), "line 1: too many fields");
+}
+
+TEST(CsvTicks, ParsesTimestamps) {
+  EXPECT_EQ(parse_timestamp_ns("1704205800000000000"), 1704205800000000000);
+  EXPECT_EQ(parse_timestamp_ns("2024-01-02T14:30:00Z"), 1704205800000000000);
+  EXPECT_EQ(parse_timestamp_ns("2024-01-02 14:30:00.000000001"),
+            1704205800000000001);
+  EXPECT_EQ(parse_timestamp_ns("1970-01-01T00:00:00.25"), 250'000'000);
+
+  EXPECT_FALSE(parse_timestamp_ns(""));
+  EXPECT_FALSE(parse_timestamp_ns("2024-02-30T00:00:00Z"));
+  EXPECT_FALSE(parse_timestamp_ns("2024-01-02T24:00:00Z"));
+  EXPECT_FALSE(parse_timestamp_ns("2024-01-02T14:30:00."));
+  EXPECT_FALSE(parse_timestamp_ns("2024-01-02T14:30:00.1234567891"));
+  EXPECT_FALSE(parse_timestamp_ns("2024-01-02T14:30:00+01:00"));
+}
+
+} // namespace quarcc
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <trading/utils/timer_wheel.h>
+
+#include <vector>
+
+namespace quarcc {
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+struct TimerWheelTest : public testing::Test {
+  const Clock::time_point t0 = Clock::time_point{} + 1h;
+  TimerWheel<int> wheel{10ms, 8, t0};
+  std::vector<int> fired;
+
+  void advance(Clock::duration since_start) {
+    wheel.advance(t0 + since_start, [this](int v) { fired.push_back(v); });
+  }
+};
+
+TEST_F(TimerWheelTest, FiresOnceTheDeadlineTickHasPassed) {
+  wheel.schedule(t0 + 25ms, 1);
+  EXPECT_EQ(wheel.size(), 1u);
+
+  advance(25ms);
+  EXPECT_TRUE(fired.empty());
+  advance(29ms);
+  EXPECT_TRUE(fired.empty());
+  advance(30ms);
+  EXPECT_EQ(fired, std::vector<int>{1});
+  EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST_F(TimerWheelTest, FiresInDeadlineOrderAcrossBuckets) {
+  wheel.schedule(t0 + 35ms, 3);
+  wheel.schedule(t0 + 5ms, 1);
+  wheel.schedule(t0 + 15ms, 2);
+
+  advance(20ms);
+  EXPECT_EQ(fired, (std::vector<int>{1, 2}));
+  advance(40ms);
+  EXPECT_EQ(fired, (std::vector<int>{1, 2, 3}));
+}
+
+TEST_F(TimerWheelTest, DeadlinesPastTheSpanWaitForTheirTurn) {
+  // Span is 80 ms; 100 ms shares a bucket with 20 ms
+  wheel.schedule(t0 + 100ms, 2);
+  wheel.schedule(t0 + 20ms, 1);
+
+  advance(50ms);
+  EXPECT_EQ(fired, std::vector<int>{1});
+  EXPECT_EQ(wheel.size(), 1u);
+  advance(110ms);
+  EXPECT_EQ(fired, (std::vector<int>{1, 2}));
+}
+
+TEST_F(TimerWheelTest, LongGapSweepsEveryBucketOnce) {
+  for (int i = 0; i < 20; ++i)
+    wheel.schedule(t0 + i * 10ms, i);
+
+  advance(1h);
+  EXPECT_EQ(fired.size(), 20u);
+  EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST_F(TimerWheelTest, PastDeadlinesFireOnTheNextTick) {
+  advance(100ms);
+  wheel.schedule(t0, 7);
+  advance(105ms);
+  EXPECT_TRUE(fired.empty());
+  advance(110ms);
+  EXPECT_EQ(fired, std::vector<int>{7});
+}
+
+TEST(TimerWheel, RejectsBadGeometry) {
+  EXPECT_THROW(TimerWheel<int>(0ms, 8), std::runtime_error);
+  EXPECT_THROW(TimerWheel<int>(10ms, 0), std::runtime_error);
+}
+
+} // namespace quarcc
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <trading/utils/work_stealing_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace quarcc {
+
+using namespace std::chrono_literals;
+
+TEST(WorkStealingPool, RunsEveryTaskExactlyOnce) {
+  WorkStealingPool pool{4};
+  EXPECT_EQ(pool.size(), 4u);
+
+  std::vector<std::atomic<int>> runs(1000);
+  for (auto &count : runs)
+    pool.submit([&count] { count.fetch_add(1); });
+  pool.wait();
+
+  for (const auto &count : runs)
+    EXPECT_EQ(count.load(), 1);
+}
+
+TEST(WorkStealingPool, WaitCoversTasksSubmittedByTasks) {
+  WorkStealingPool pool{3};
+  std::atomic<int> leaves{0};
+
+  // A binary fan-out four levels deep, all submitted from inside the pool
+  std::function<void(int)> split = [&](int depth) {
+    if (depth == 0) {
+      leaves.fetch_add(1);
+      return;
+    }
+    pool.submit([&split, depth] { split(depth - 1); });
+    pool.submit([&split, depth] { split(depth - 1); });
+  };
+  pool.submit([&split] { split(4); });
+  pool.wait();
+
+  EXPECT_EQ(leaves.load(), 16);
+}
+
+TEST(WorkStealingPool, IdleWorkersStealFromABusyOne) {
+  constexpr int kTasks = 3;
+  WorkStealingPool pool{kTasks};
+  std::mutex mutex;
+  std::condition_variable cv;
+  int arrived = 0;
+  bool all_met = true;
+
+  // All three land on the submitting worker's own deque, and each waits for
+  // the others: they can only all finish if two of them are stolen
+  pool.submit([&] {
+    for (int i = 0; i < kTasks; ++i)
+      pool.submit([&] {
+        std::unique_lock lock(mutex);
+        ++arrived;
+        cv.notify_all();
+        if (!cv.wait_for(lock, 5s, [&] { return arrived == kTasks; }))
+          all_met = false;
+      });
+  });
+  pool.wait();
+
+  EXPECT_TRUE(all_met);
+  EXPECT_GE(pool.steals(), 2u);
+}
+
+TEST(WorkStealingPool, WaitRethrowsTheFirstTaskException) {
+  WorkStealingPool pool{2};
+  std::atomic<int> ran{0};
+  pool.submit([] { throw std::runtime_error("boom"); });
+  for (int i = 0; i < 10; ++i)
+    pool.submit([&ran] { ran.fetch_add(1); });
+
+  EXPECT_THROW(pool.wait(), std::runtime_error);
+  EXPECT_EQ(ran.load(), 10);
+
+  // Reported once; the pool keeps working
+  pool.submit([&ran] { ran.fetch_add(1); });
+  EXPECT_NO_THROW(pool.wait());
+  EXPECT_EQ(ran.load(), 11);
+}
+
+TEST(WorkStealingPool, DestructorRunsQueuedTasks) {
+  std::atomic<int> ran{0};
+  {
+    WorkStealingPool pool{2};
+    for (int i = 0; i < 100; ++i)
+      pool.submit([&ran] {
+        std::this_thread::sleep_for(10us);
+        ran.fetch_add(1);
+      });
+  }
+  EXPECT_EQ(ran.load(), 100);
+}
+
+} // namespace quarcc